@@ -40,6 +40,7 @@
 #include <stratosphere/fs/fs_speed_emulation.hpp>
 #include <stratosphere/fs/impl/fs_common_mount_name.hpp>
 #include <stratosphere/fs/fs_mount.hpp>
+#include <stratosphere/fs/fs_file_data_cache.hpp>
 #include <stratosphere/fs/fs_path_utility.hpp>
 #include <stratosphere/fs/fs_path.hpp>
 #include <stratosphere/fs/common/fs_directory_path_parser.hpp>
@@ -68,6 +68,7 @@ namespace ams::fs {
             }
         public:
             virtual Result Read(s64 offset, void *buffer, size_t size) override;
+            virtual Result ReadBatch(const ReadRequest *requests, s32 count) override;
             virtual Result Write(s64 offset, const void *buffer, size_t size) override;
             virtual Result Flush() override;
             virtual Result GetSize(s64 *out_size) override;
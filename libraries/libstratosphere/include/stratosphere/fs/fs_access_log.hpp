@@ -32,4 +32,13 @@ namespace ams::fs {
     void SetLocalAccessLog(bool enabled);
     void SetLocalSystemAccessLogForDebug(bool enabled);
 
+    /* NOTE: Atmosphère extension. */
+    void SetLocalAccessLogBinaryMode(bool enabled);
+
+    /* NOTE: Atmosphère extension. */
+    /* Sends binary access log batches to the given function rather than the sd card, so that tests can decode them. */
+    /* NOTE: This must be set before binary mode is first enabled. */
+    using AccessLogBinaryOutputFunctionForTest = void (*)(const void *batch, size_t size);
+    void SetLocalAccessLogBinaryOutputForTest(AccessLogBinaryOutputFunctionForTest func);
+
 }
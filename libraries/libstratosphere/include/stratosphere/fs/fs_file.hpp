@@ -69,6 +69,14 @@ namespace ams::fs {
 
     static_assert(util::is_pod<WriteOption>::value && sizeof(WriteOption) == sizeof(u32));
 
+    /* NOTE: Atmosphère extension. */
+    struct ReadRequest {
+        s64 offset;
+        void *buffer;
+        size_t size;
+    };
+    static_assert(util::is_pod<ReadRequest>::value);
+
     struct FileHandle {
         void *handle;
     };
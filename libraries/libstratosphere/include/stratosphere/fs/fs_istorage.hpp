@@ -27,6 +27,18 @@ namespace ams::fs {
 
             virtual Result Read(s64 offset, void *buffer, size_t size) = 0;
 
+            /* NOTE: Atmosphère extension. */
+            /* Reads every request in the batch; implementations may service the requests concurrently and in any order. */
+            virtual Result ReadBatch(const ReadRequest *requests, s32 count) {
+                AMS_ASSERT(requests != nullptr || count == 0);
+
+                for (s32 i = 0; i < count; ++i) {
+                    R_TRY(this->Read(requests[i].offset, requests[i].buffer, requests[i].size));
+                }
+
+                R_SUCCEED();
+            }
+
             virtual Result Write(s64 offset, const void *buffer, size_t size) = 0;
 
             virtual Result Flush() = 0;
@@ -98,6 +110,10 @@ namespace ams::fs {
                 R_RETURN(m_storage->Read(offset, buffer, size));
             }
 
+            virtual Result ReadBatch(const ReadRequest *requests, s32 count) override {
+                R_RETURN(m_storage->ReadBatch(requests, count));
+            }
+
             virtual Result Flush() override {
                 R_RETURN(m_storage->Flush());
             }
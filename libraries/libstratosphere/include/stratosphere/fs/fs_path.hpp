@@ -457,8 +457,10 @@ namespace ams::fs {
                 /* If we don't have a write-buffer, ensure that we have one. */
                 if (m_write_buffer.Get() == nullptr) {
                     if (const auto len = std::strlen(m_str); len > 0) {
-                        R_TRY(this->Preallocate(len));
-                        util::Strlcpy<char>(m_write_buffer.Get(), m_str, len + 1);
+                        /* NOTE: Preallocate repoints m_str at the new buffer, so we must copy from the original string. */
+                        const char * const str = m_str;
+                        R_TRY(this->Preallocate(len + 1));
+                        util::Strlcpy<char>(m_write_buffer.Get(), str, len + 1);
                     }
                 }
 
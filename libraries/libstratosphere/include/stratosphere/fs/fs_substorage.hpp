@@ -87,6 +87,32 @@ namespace ams::fs {
                 R_RETURN(m_base_storage->Read(m_offset + offset, buffer, size));
             }
 
+            virtual Result ReadBatch(const ReadRequest *requests, s32 count) override {
+                /* Ensure we're initialized. */
+                R_UNLESS(this->IsValid(), fs::ResultNotInitialized());
+
+                /* Translate the requests into our base storage, a chunk at a time. */
+                constexpr s32 TranslatedCountMax = 16;
+                ReadRequest translated[TranslatedCountMax];
+                for (s32 processed = 0; processed < count; /* ... */) {
+                    const s32 cur_count = std::min(count - processed, TranslatedCountMax);
+                    for (s32 i = 0; i < cur_count; ++i) {
+                        const auto &request = requests[processed + i];
+
+                        /* Validate arguments. */
+                        R_UNLESS(request.buffer != nullptr || request.size == 0, fs::ResultNullptrArgument());
+                        R_TRY(IStorage::CheckAccessRange(request.offset, request.size, m_size));
+
+                        translated[i] = { m_offset + request.offset, request.buffer, request.size };
+                    }
+
+                    R_TRY(m_base_storage->ReadBatch(translated, cur_count));
+                    processed += cur_count;
+                }
+
+                R_SUCCEED();
+            }
+
             virtual Result Write(s64 offset, const void *buffer, size_t size) override{
                 /* Ensure we're initialized. */
                 R_UNLESS(this->IsValid(), fs::ResultNotInitialized());
@@ -47,6 +47,31 @@ namespace ams::fs::fsa {
 
             ALWAYS_INLINE Result Read(size_t *out, s64 offset, void *buffer, size_t size) { R_RETURN(this->Read(out, offset, buffer, size, ReadOption::None)); }
 
+            /* NOTE: Atmosphère extension. */
+            /* Reads every request in the batch in full; requests must lie entirely within the file. */
+            Result ReadBatch(const fs::ReadRequest *requests, s32 count, const fs::ReadOption &option) {
+                /* Check that we have requests. */
+                R_UNLESS(count >= 0,                        fs::ResultInvalidArgument());
+                R_UNLESS(requests != nullptr || count == 0, fs::ResultNullptrArgument());
+
+                /* If we have nothing to read, just succeed. */
+                R_SUCCEED_IF(count == 0);
+
+                /* Check that each read is valid. */
+                for (s32 i = 0; i < count; ++i) {
+                    const auto &request = requests[i];
+                    R_UNLESS(request.buffer != nullptr || request.size == 0,                 fs::ResultNullptrArgument());
+                    R_UNLESS(request.offset >= 0,                                            fs::ResultOutOfRange());
+                    R_UNLESS(util::IsIntValueRepresentable<s64>(request.size),               fs::ResultOutOfRange());
+                    R_UNLESS(util::CanAddWithoutOverflow<s64>(request.offset, request.size), fs::ResultOutOfRange());
+                }
+
+                /* Do the read. */
+                R_RETURN(this->DoReadBatch(requests, count, option));
+            }
+
+            ALWAYS_INLINE Result ReadBatch(const fs::ReadRequest *requests, s32 count) { R_RETURN(this->ReadBatch(requests, count, ReadOption::None)); }
+
             Result GetSize(s64 *out) {
                 R_UNLESS(out != nullptr, fs::ResultNullptrArgument());
                 R_RETURN(this->DoGetSize(out));
@@ -139,6 +164,23 @@ namespace ams::fs::fsa {
             virtual Result DoWrite(s64 offset, const void *buffer, size_t size, const fs::WriteOption &option) = 0;
             virtual Result DoSetSize(s64 size) = 0;
             virtual Result DoOperateRange(void *dst, size_t dst_size, fs::OperationId op_id, s64 offset, s64 size, const void *src, size_t src_size) = 0;
+
+            /* NOTE: Atmosphère extension. */
+            virtual Result DoReadBatch(const fs::ReadRequest *requests, s32 count, const fs::ReadOption &option) {
+                for (s32 i = 0; i < count; ++i) {
+                    /* Skip empty requests. */
+                    if (requests[i].size == 0) {
+                        continue;
+                    }
+
+                    /* Read, and check that the whole request was satisfied. */
+                    size_t read_size;
+                    R_TRY(this->DoRead(std::addressof(read_size), requests[i].offset, requests[i].buffer, requests[i].size, option));
+                    R_UNLESS(read_size == requests[i].size, fs::ResultOutOfRange());
+                }
+
+                R_SUCCEED();
+            }
     };
 
 }
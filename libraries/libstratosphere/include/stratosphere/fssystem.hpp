@@ -48,8 +48,12 @@
 #include <stratosphere/fssystem/fssystem_service_context.hpp>
 #include <stratosphere/fssystem/fssystem_alignment_matching_storage_impl.hpp>
 #include <stratosphere/fssystem/fssystem_alignment_matching_storage.hpp>
+#include <stratosphere/fssystem/fssystem_decompression_worker_pool.hpp>
 #include <stratosphere/fssystem/fssystem_compressed_storage.hpp>
+#include <stratosphere/fssystem/fssystem_compressed_storage_writer.hpp>
 #include <stratosphere/fssystem/fssystem_buffered_storage.hpp>
+#include <stratosphere/fssystem/fssystem_buffered_storage_prefetcher.hpp>
+#include <stratosphere/fssystem/fssystem_sharded_block_cache_buffered_storage.hpp>
 #include <stratosphere/fssystem/fssystem_hierarchical_integrity_verification_storage.hpp>
 #include <stratosphere/fssystem/fssystem_integrity_romfs_storage.hpp>
 #include <stratosphere/fssystem/fssystem_sha_hash_generator.hpp>
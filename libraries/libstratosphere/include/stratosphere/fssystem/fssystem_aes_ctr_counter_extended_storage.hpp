@@ -97,6 +97,7 @@ namespace ams::fssystem {
             bool IsInitialized() const { return m_table.IsInitialized(); }
 
             virtual Result Read(s64 offset, void *buffer, size_t size) override;
+            virtual Result ReadBatch(const fs::ReadRequest *requests, s32 count) override;
             virtual Result OperateRange(void *dst, size_t dst_size, fs::OperationId op_id, s64 offset, s64 size, const void *src, size_t src_size) override;
 
             virtual Result GetSize(s64 *out) override {
@@ -127,6 +128,8 @@ namespace ams::fssystem {
             Result GetEntryList(Entry *out_entries, s32 *out_entry_count, s32 entry_count, s64 offset, s64 size);
         private:
             Result Initialize(IAllocator *allocator, const void *key, size_t key_size, u32 secure_value, fs::SubStorage data_storage, fs::SubStorage table_storage);
+
+            Result DecryptInPlace(const BucketTree::Offsets &table_offsets, s64 offset, void *buffer, size_t size);
     };
 
 }
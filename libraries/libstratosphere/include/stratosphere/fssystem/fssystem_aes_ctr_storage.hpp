@@ -39,6 +39,7 @@ namespace ams::fssystem {
             AesCtrStorage(BasePointer base, const void *key, size_t key_size, const void *iv, size_t iv_size);
 
             virtual Result Read(s64 offset, void *buffer, size_t size) override;
+            virtual Result ReadBatch(const fs::ReadRequest *requests, s32 count) override;
             virtual Result Write(s64 offset, const void *buffer, size_t size) override;
 
             virtual Result Flush() override;
@@ -47,6 +48,8 @@ namespace ams::fssystem {
             virtual Result GetSize(s64 *out) override;
 
             virtual Result OperateRange(void *dst, size_t dst_size, fs::OperationId op_id, s64 offset, s64 size, const void *src, size_t src_size) override;
+        private:
+            Result DecryptInPlace(s64 offset, void *buffer, size_t size);
     };
 
     using AesCtrStorageByPointer       = AesCtrStorage<fs::IStorage *>;
@@ -40,11 +40,14 @@ namespace ams::fssystem {
             AesCtrStorageExternal(std::shared_ptr<fs::IStorage> bs, const void *enc_key, size_t enc_key_size, const void *iv, size_t iv_size, DecryptAesCtrFunction df, s32 kidx, s32 kgen);
 
             virtual Result Read(s64 offset, void *buffer, size_t size) override;
+            virtual Result ReadBatch(const fs::ReadRequest *requests, s32 count) override;
             virtual Result OperateRange(void *dst, size_t dst_size, fs::OperationId op_id, s64 offset, s64 size, const void *src, size_t src_size) override;
             virtual Result GetSize(s64 *out) override;
             virtual Result Flush() override;
             virtual Result Write(s64 offset, const void *buffer, size_t size) override;
             virtual Result SetSize(s64 size) override;
+        private:
+            void DecryptInPlace(s64 offset, void *buffer, size_t size);
     };
 
 }
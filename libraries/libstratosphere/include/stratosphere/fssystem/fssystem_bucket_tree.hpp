@@ -29,8 +29,11 @@ namespace ams::fssystem {
 
             static constexpr size_t NodeSizeMin = 1_KB;
             static constexpr size_t NodeSizeMax = 512_KB;
+
+            static constexpr s32 LookupIndexEntrySetCacheCountMax = 8;
         public:
             class Visitor;
+            class Builder;
 
             struct Header {
                 u32 magic;
@@ -77,6 +80,28 @@ namespace ams::fssystem {
                 constexpr OffsetCache() : offsets{ -1, -1 }, mutex(), is_initialized(false) { /* ... */ }
             };
 
+            /* NOTE: The lookup index is an Atmosphère extension. It holds the start offset of every entry set, */
+            /* packed into cache lines, along with a small LRU cache of recently searched entry sets. */
+            struct LookupIndex {
+                static constexpr size_t LineSize          = 0x40;
+                static constexpr s32    OffsetCountPerLine = LineSize / sizeof(s64);
+
+                struct EntrySetCacheSlot {
+                    void *buffer;
+                    s32 entry_set_index;
+                    u32 last_used;
+                };
+
+                s64 *offsets;
+                s32 line_count;
+                EntrySetCacheSlot cache_slots[LookupIndexEntrySetCacheCountMax];
+                s32 cache_slot_count;
+                u32 cache_tick;
+                os::SdkMutex mutex;
+
+                constexpr LookupIndex() : offsets(), line_count(), cache_slots(), cache_slot_count(), cache_tick(), mutex() { /* ... */ }
+            };
+
             class ContinuousReadingInfo {
                 private:
                     size_t m_read_size;
@@ -238,8 +263,9 @@ namespace ams::fssystem {
             s32 m_offset_count;
             s32 m_entry_set_count;
             OffsetCache m_offset_cache;
+            mutable LookupIndex m_lookup_index;
         public:
-            BucketTree() : m_node_storage(), m_entry_storage(), m_node_l1(), m_node_size(), m_entry_size(), m_entry_count(), m_offset_count(), m_entry_set_count(), m_offset_cache() { /* ... */ }
+            BucketTree() : m_node_storage(), m_entry_storage(), m_node_l1(), m_node_size(), m_entry_size(), m_entry_count(), m_offset_count(), m_entry_set_count(), m_offset_cache(), m_lookup_index() { /* ... */ }
             ~BucketTree() { this->Finalize(); }
 
             Result Initialize(IAllocator *allocator, fs::SubStorage node_storage, fs::SubStorage entry_storage, size_t node_size, size_t entry_size, s32 entry_count);
@@ -252,6 +278,11 @@ namespace ams::fssystem {
             Result Find(Visitor *visitor, s64 virtual_address);
             Result InvalidateCache();
 
+            Result InitializeLookupIndex(s32 entry_set_cache_count);
+            void FinalizeLookupIndex();
+
+            bool IsLookupIndexEnabled() const { return m_lookup_index.offsets != nullptr; }
+
             s32 GetEntryCount() const { return m_entry_count; }
             IAllocator *GetAllocator() const { return m_node_l1.GetAllocator(); }
 
@@ -285,6 +316,13 @@ namespace ams::fssystem {
             }
 
             Result EnsureOffsetCache();
+
+            s32 FindEntrySetIndexByLookupIndex(s64 virtual_address) const;
+
+            LookupIndex::EntrySetCacheSlot *FindEntrySetCacheSlot(s32 entry_set_index) const;
+            bool ReadEntrySetCache(void *dst, s32 entry_set_index, size_t offset, size_t size) const;
+            void StoreEntrySetCache(s32 entry_set_index, const void *buffer) const;
+            void ClearEntrySetCache() const;
     };
 
     /* ACCURATE_TO_VERSION: Unknown */
@@ -350,6 +388,52 @@ namespace ams::fssystem {
             Result FindEntry(s64 virtual_address, s32 entry_set_index);
             Result FindEntryWithBuffer(s64 virtual_address, s32 entry_set_index, char *buffer);
             Result FindEntryWithoutBuffer(s64 virtual_address, s32 entry_set_index);
+            Result FindEntryInBuffer(s64 virtual_address, s32 entry_set_index, const char *buffer);
+    };
+
+    class BucketTree::Builder {
+        NON_COPYABLE(Builder);
+        NON_MOVEABLE(Builder);
+        private:
+            NodeBuffer m_l1_node;
+            NodeBuffer m_l2_node;
+            NodeBuffer m_entry_set;
+            fs::SubStorage m_node_storage;
+            fs::SubStorage m_entry_storage;
+            size_t m_node_size;
+            size_t m_entry_size;
+            s32 m_entry_count;
+            s32 m_entries_per_entry_set;
+            s32 m_offsets_per_node;
+            s32 m_entry_set_count;
+            s32 m_l2_node_count;
+            s32 m_current_entry_index;
+            s64 m_current_offset;
+        public:
+            Builder() : m_l1_node(), m_l2_node(), m_entry_set(), m_node_storage(), m_entry_storage(), m_node_size(), m_entry_size(), m_entry_count(), m_entries_per_entry_set(), m_offsets_per_node(), m_entry_set_count(), m_l2_node_count(), m_current_entry_index(), m_current_offset(-1) { /* ... */ }
+            ~Builder() { this->FreeBuffers(); }
+
+            Result Initialize(IAllocator *allocator, fs::SubStorage header_storage, fs::SubStorage node_storage, fs::SubStorage entry_storage, size_t node_size, size_t entry_size, s32 entry_count);
+
+            template<typename EntryType>
+            Result Add(const EntryType &entry) {
+                static_assert(util::is_pod<EntryType>::value);
+                AMS_ASSERT(sizeof(EntryType) == m_entry_size);
+
+                R_RETURN(this->AddEntry(std::addressof(entry), sizeof(EntryType)));
+            }
+
+            Result Finalize(s64 end_offset);
+
+            bool IsInitialized() const { return m_node_size > 0; }
+        private:
+            Result AddEntry(const void *entry, size_t entry_size);
+            Result RegisterEntrySet(s32 entry_set_index, s64 offset);
+
+            Result FinalizePreviousEntrySet(s64 end_offset);
+            Result FinalizePreviousL2Node(s64 end_offset);
+
+            void FreeBuffers();
     };
 
 }
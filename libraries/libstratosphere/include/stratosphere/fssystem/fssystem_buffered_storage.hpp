@@ -22,10 +22,23 @@
 
 namespace ams::fssystem {
 
+    class BufferedStoragePrefetcher;
+
     /* ACCURATE_TO_VERSION: Unknown */
     class BufferedStorage : public ::ams::fs::IStorage {
         NON_COPYABLE(BufferedStorage);
         NON_MOVEABLE(BufferedStorage);
+        friend class BufferedStoragePrefetcher;
+        public:
+            static constexpr s32 ReadAheadWindowMax = 16;
+
+            struct ReadAheadStatistics {
+                u64 hit_count;
+                u64 miss_count;
+                u64 request_count;
+                u64 prefetch_count;
+                u64 prefetch_waste_count;
+            };
         private:
             class Cache;
             class UniqueCache;
@@ -39,8 +52,18 @@ namespace ams::fssystem {
             s32 m_cache_count;
             Cache *m_next_acquire_cache;
             Cache *m_next_fetch_cache;
-            os::SdkMutex m_mutex;
+            mutable os::SdkMutex m_mutex;
             bool m_bulk_read_enabled;
+            BufferedStoragePrefetcher *m_prefetcher;
+            s32 m_read_ahead_window;
+            s32 m_sequential_read_count;
+            s64 m_sequential_next_offset;
+            s64 m_read_ahead_end_offset;
+            std::atomic<u64> m_hit_count;
+            std::atomic<u64> m_miss_count;
+            std::atomic<u64> m_request_count;
+            std::atomic<u64> m_prefetch_count;
+            std::atomic<u64> m_prefetch_waste_count;
         public:
             BufferedStorage();
             virtual ~BufferedStorage();
@@ -51,6 +74,7 @@ namespace ams::fssystem {
             bool IsInitialized() const { return m_caches != nullptr; }
 
             virtual Result Read(s64 offset, void *buffer, size_t size) override;
+            virtual Result ReadBatch(const fs::ReadRequest *requests, s32 count) override;
             virtual Result Write(s64 offset, const void *buffer, size_t size) override;
 
             virtual Result GetSize(s64 *out) override;
@@ -65,6 +89,15 @@ namespace ams::fssystem {
             fs::IBufferManager *GetBufferManager() const { return m_buffer_manager; }
 
             void EnableBulkRead() { m_bulk_read_enabled = true; }
+
+            void EnableReadAhead(BufferedStoragePrefetcher *prefetcher, s32 window_block_count);
+            void DisableReadAhead();
+
+            s32 GetReadAheadWindow() const {
+                std::scoped_lock lk(m_mutex);
+                return m_read_ahead_window;
+            }
+            void GetReadAheadStatistics(ReadAheadStatistics *out) const;
         private:
             Result PrepareAllocation();
             Result ControlDirtiness();
@@ -76,6 +109,9 @@ namespace ams::fssystem {
             Result BulkRead(s64 offset, void *buffer, size_t size, bool head_cache_needed, bool tail_cache_needed);
 
             Result WriteCore(s64 offset, const void *buffer, size_t size);
+
+            void DetectSequentialRead(s64 offset, size_t size);
+            Result Prefetch(s64 offset, s32 block_count);
     };
 
 }
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <vapours.hpp>
+#include <stratosphere/os.hpp>
+
+namespace ams::fssystem {
+
+    class BufferedStorage;
+
+    class BufferedStoragePrefetcher {
+        NON_COPYABLE(BufferedStoragePrefetcher);
+        NON_MOVEABLE(BufferedStoragePrefetcher);
+        public:
+            static constexpr s32 RequestCountMax = 8;
+        private:
+            struct PrefetchRequest {
+                BufferedStorage *storage;
+                s64 offset;
+                s32 block_count;
+            };
+        private:
+            os::ThreadType m_thread;
+            os::SdkMutex m_mutex;
+            os::SdkConditionVariable m_request_cv;
+            os::SdkConditionVariable m_idle_cv;
+            PrefetchRequest m_requests[RequestCountMax];
+            s32 m_request_head;
+            s32 m_request_count;
+            BufferedStorage *m_current_storage;
+            bool m_is_initialized;
+            bool m_is_exiting;
+        public:
+            BufferedStoragePrefetcher() : m_mutex(), m_request_cv(), m_idle_cv(), m_requests(), m_request_head(0), m_request_count(0), m_current_storage(nullptr), m_is_initialized(false), m_is_exiting(false) { /* ... */ }
+
+            ~BufferedStoragePrefetcher() {
+                this->Finalize();
+            }
+
+            Result Initialize(void *stack, size_t stack_size, s32 priority);
+            void Finalize();
+
+            bool IsInitialized() const { return m_is_initialized; }
+
+            /* Queues a read-ahead of block_count blocks starting at offset; returns false if the request was dropped. */
+            bool Post(BufferedStorage *storage, s64 offset, s32 block_count);
+
+            /* Discards queued requests for the storage, and waits for any in-flight request for it to complete. */
+            void Cancel(BufferedStorage *storage);
+
+            /* Waits until every queued request has been performed. */
+            void WaitForIdle();
+        private:
+            static void ThreadFunction(void *arg);
+
+            void ThreadFunctionImpl();
+    };
+
+    /* NOTE: Atmosphère extension. */
+    /* The registered prefetcher is used for read-ahead on storages which the nca driver creates. */
+    /* It must be registered before any such storage is opened, and outlive them all. */
+    void RegisterBufferedStoragePrefetcher(BufferedStoragePrefetcher *prefetcher);
+    BufferedStoragePrefetcher *GetRegisteredBufferedStoragePrefetcher();
+
+}
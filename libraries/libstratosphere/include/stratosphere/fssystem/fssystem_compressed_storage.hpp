@@ -18,6 +18,7 @@
 #include <stratosphere/fssystem/fssystem_asynchronous_access.hpp>
 #include <stratosphere/fssystem/fssystem_bucket_tree.hpp>
 #include <stratosphere/fssystem/fssystem_compression_common.hpp>
+#include <stratosphere/fssystem/fssystem_decompression_worker_pool.hpp>
 #include <stratosphere/fs/fs_i_buffer_manager.hpp>
 #include <stratosphere/fssystem/impl/fssystem_block_cache_manager.hpp>
 
@@ -62,14 +63,15 @@ namespace ams::fssystem {
                     BucketTree m_table;
                     fs::SubStorage m_data_storage;
                     GetDecompressorFunction m_get_decompressor_function;
+                    DecompressionWorkerPool *m_worker_pool;
                 public:
-                    CompressedStorageCore() : m_table(), m_data_storage() { /* ... */ }
+                    CompressedStorageCore() : m_table(), m_data_storage(), m_worker_pool() { /* ... */ }
 
                     ~CompressedStorageCore() {
                         this->Finalize();
                     }
                 public:
-                    Result Initialize(MemoryResource *bktr_allocator, fs::SubStorage data_storage, fs::SubStorage node_storage, fs::SubStorage entry_storage, s32 bktr_entry_count, size_t block_size_max, size_t continuous_reading_size_max, GetDecompressorFunction get_decompressor) {
+                    Result Initialize(MemoryResource *bktr_allocator, fs::SubStorage data_storage, fs::SubStorage node_storage, fs::SubStorage entry_storage, s32 bktr_entry_count, size_t block_size_max, size_t continuous_reading_size_max, GetDecompressorFunction get_decompressor, DecompressionWorkerPool *worker_pool) {
                         /* Check pre-conditions. */
                         AMS_ASSERT(bktr_allocator != nullptr);
                         AMS_ASSERT(0 < block_size_max);
@@ -84,6 +86,7 @@ namespace ams::fssystem {
                         m_continuous_reading_size_max = continuous_reading_size_max;
                         m_data_storage                = data_storage;
                         m_get_decompressor_function   = get_decompressor;
+                        m_worker_pool                 = worker_pool;
 
                         R_SUCCEED();
                     }
@@ -484,7 +487,8 @@ namespace ams::fssystem {
                         R_SUCCEED();
                     }
                 public:
-                    using ReadImplFunction = util::IFunction<Result(void *, size_t)>;
+                    /* NOTE: The final argument indicates whether the destination remains valid until Read() returns, allowing work to be deferred. */
+                    using ReadImplFunction = util::IFunction<Result(void *, size_t, bool)>;
                     using ReadFunction     = util::IFunction<Result(size_t, const ReadImplFunction &)>;
                 public:
                     Result Read(s64 offset, s64 size, const ReadFunction &read_func) {
@@ -510,6 +514,19 @@ namespace ams::fssystem {
                         s64 required_access_physical_offset = 0;
                         s64 required_access_physical_size   = 0;
 
+                        /* Declare deferred decompression state, used when we have a worker pool. */
+                        constexpr int DeferredJobCountMax = 0x20;
+                        DecompressionWorkerPool::Job jobs[DeferredJobCountMax];
+                        s32 job_count = 0;
+
+                        auto PerformDeferredDecompression = [&]() -> Result {
+                            /* Decompress all pending jobs, in parallel. */
+                            const s32 cur_job_count = job_count;
+                            job_count = 0;
+
+                            R_RETURN(m_worker_pool->Decompress(jobs, cur_job_count));
+                        };
+
                         auto PerformRequiredRead = [&]() -> Result {
                             /* If there are no entries, we have nothing to do. */
                             R_SUCCEED_IF(entry_count == 0);
@@ -570,68 +587,97 @@ namespace ams::fssystem {
 
                                         /* Decompress the data. */
                                         size_t buffer_offset;
-                                        for (buffer_offset = 0; entry_idx < entry_count && ((static_cast<size_t>(entries[entry_idx].physical_size) + static_cast<size_t>(entries[entry_idx].gap_from_prev)) == 0 || buffer_offset < cur_read_size); buffer_offset += entries[entry_idx++].physical_size) {
-                                            /* Advance by the relevant gap. */
-                                            buffer_offset += entries[entry_idx].gap_from_prev;
-
-                                            const auto compression_type = entries[entry_idx].compression_type;
-                                            switch (compression_type) {
-                                                case CompressionType_None:
-                                                    {
-                                                        /* Check that we can remain within bounds. */
-                                                        AMS_ASSERT(buffer_offset + entries[entry_idx].virtual_size <= cur_read_size);
-
-                                                        /* Perform no decompression. */
-                                                        R_TRY(read_func(entries[entry_idx].virtual_size, util::MakeIFunction([&] (void *dst, size_t dst_size) -> Result {
-                                                            /* Check that the size is valid. */
-                                                            AMS_ASSERT(dst_size == entries[entry_idx].virtual_size);
-                                                            AMS_UNUSED(dst_size);
-
-                                                            /* We have no compression, so just copy the data out. */
-                                                            std::memcpy(dst, buffer + buffer_offset, entries[entry_idx].virtual_size);
-                                                            R_SUCCEED();
-                                                        })));
-                                                    }
-                                                    break;
-                                                case CompressionType_Zeros:
-                                                    {
-                                                        /* Check that we can remain within bounds. */
-                                                        AMS_ASSERT(buffer_offset <= cur_read_size);
-
-                                                        /* Zero the memory. */
-                                                        R_TRY(read_func(entries[entry_idx].virtual_size, util::MakeIFunction([&] (void *dst, size_t dst_size) -> Result {
-                                                            /* Check that the size is valid. */
-                                                            AMS_ASSERT(dst_size == entries[entry_idx].virtual_size);
-                                                            AMS_UNUSED(dst_size);
-
-                                                            /* The data is zeroes, so zero the buffer. */
-                                                            std::memset(dst, 0, entries[entry_idx].virtual_size);
-                                                            R_SUCCEED();
-                                                        })));
-                                                    }
-                                                    break;
-                                                default:
-                                                    {
-                                                        /* Check that we can remain within bounds. */
-                                                        AMS_ASSERT(buffer_offset + entries[entry_idx].physical_size <= cur_read_size);
-
-                                                        /* Get the decompressor. */
-                                                        const auto decompressor = this->GetDecompressor(compression_type);
-                                                        R_UNLESS(decompressor != nullptr, fs::ResultUnexpectedInCompressedStorageB());
-
-                                                        /* Decompress the data. */
-                                                        R_TRY(read_func(entries[entry_idx].virtual_size, util::MakeIFunction([&] (void *dst, size_t dst_size) -> Result {
-                                                            /* Check that the size is valid. */
-                                                            AMS_ASSERT(dst_size == entries[entry_idx].virtual_size);
-                                                            AMS_UNUSED(dst_size);
-
-                                                            /* Perform the decompression. */
-                                                            R_RETURN(decompressor(dst, entries[entry_idx].virtual_size, buffer + buffer_offset, entries[entry_idx].physical_size));
-                                                        })));
-                                                    }
-                                                    break;
+                                        const Result decompress_result = [&] () -> Result {
+                                            for (buffer_offset = 0; entry_idx < entry_count && ((static_cast<size_t>(entries[entry_idx].physical_size) + static_cast<size_t>(entries[entry_idx].gap_from_prev)) == 0 || buffer_offset < cur_read_size); buffer_offset += entries[entry_idx++].physical_size) {
+                                                /* Advance by the relevant gap. */
+                                                buffer_offset += entries[entry_idx].gap_from_prev;
+
+                                                const auto compression_type = entries[entry_idx].compression_type;
+                                                switch (compression_type) {
+                                                    case CompressionType_None:
+                                                        {
+                                                            /* Check that we can remain within bounds. */
+                                                            AMS_ASSERT(buffer_offset + entries[entry_idx].virtual_size <= cur_read_size);
+
+                                                            /* Perform no decompression. */
+                                                            R_TRY(read_func(entries[entry_idx].virtual_size, util::MakeIFunction([&] (void *dst, size_t dst_size, bool is_deferrable) -> Result {
+                                                                /* Check that the size is valid. */
+                                                                AMS_ASSERT(dst_size == entries[entry_idx].virtual_size);
+                                                                AMS_UNUSED(dst_size, is_deferrable);
+
+                                                                /* We have no compression, so just copy the data out. */
+                                                                std::memcpy(dst, buffer + buffer_offset, entries[entry_idx].virtual_size);
+                                                                R_SUCCEED();
+                                                            })));
+                                                        }
+                                                        break;
+                                                    case CompressionType_Zeros:
+                                                        {
+                                                            /* Check that we can remain within bounds. */
+                                                            AMS_ASSERT(buffer_offset <= cur_read_size);
+
+                                                            /* Zero the memory. */
+                                                            R_TRY(read_func(entries[entry_idx].virtual_size, util::MakeIFunction([&] (void *dst, size_t dst_size, bool is_deferrable) -> Result {
+                                                                /* Check that the size is valid. */
+                                                                AMS_ASSERT(dst_size == entries[entry_idx].virtual_size);
+                                                                AMS_UNUSED(dst_size, is_deferrable);
+
+                                                                /* The data is zeroes, so zero the buffer. */
+                                                                std::memset(dst, 0, entries[entry_idx].virtual_size);
+                                                                R_SUCCEED();
+                                                            })));
+                                                        }
+                                                        break;
+                                                    default:
+                                                        {
+                                                            /* Check that we can remain within bounds. */
+                                                            AMS_ASSERT(buffer_offset + entries[entry_idx].physical_size <= cur_read_size);
+
+                                                            /* Get the decompressor. */
+                                                            const auto decompressor = this->GetDecompressor(compression_type);
+                                                            R_UNLESS(decompressor != nullptr, fs::ResultUnexpectedInCompressedStorageB());
+
+                                                            /* Decompress the data. */
+                                                            R_TRY(read_func(entries[entry_idx].virtual_size, util::MakeIFunction([&] (void *dst, size_t dst_size, bool is_deferrable) -> Result {
+                                                                /* Check that the size is valid. */
+                                                                AMS_ASSERT(dst_size == entries[entry_idx].virtual_size);
+                                                                AMS_UNUSED(dst_size);
+
+                                                                /* If we can, defer the decompression so that it can be performed in parallel. */
+                                                                if (is_deferrable && m_worker_pool != nullptr) {
+                                                                    /* If we have no space for the job, run the pending jobs first. */
+                                                                    if (job_count == DeferredJobCountMax) {
+                                                                        R_TRY(PerformDeferredDecompression());
+                                                                    }
+
+                                                                    jobs[job_count++] = {
+                                                                        .decompressor = decompressor,
+                                                                        .dst          = dst,
+                                                                        .dst_size     = entries[entry_idx].virtual_size,
+                                                                        .src          = buffer + buffer_offset,
+                                                                        .src_size     = entries[entry_idx].physical_size,
+                                                                        .result       = ResultSuccess(),
+                                                                    };
+                                                                    R_SUCCEED();
+                                                                }
+
+                                                                /* Perform the decompression. */
+                                                                R_RETURN(decompressor(dst, entries[entry_idx].virtual_size, buffer + buffer_offset, entries[entry_idx].physical_size));
+                                                            })));
+                                                        }
+                                                        break;
+                                                }
                                             }
+
+                                            R_SUCCEED();
+                                        }();
+
+                                        /* Perform any deferred decompression before our buffer is reused. */
+                                        /* NOTE: Deferred jobs precede any entry that failed, so their errors take priority. */
+                                        if (job_count > 0) {
+                                            R_TRY(PerformDeferredDecompression());
                                         }
+                                        R_TRY(decompress_result);
 
                                         /* Check that we processed the correct amount of data. */
                                         AMS_ASSERT(buffer_offset == cur_read_size);
@@ -641,10 +687,10 @@ namespace ams::fssystem {
                                         required_access_physical_size   -= entries[entry_idx].gap_from_prev;
 
                                         /* We don't need the buffer (as the data is uncompressed), so just execute the read. */
-                                        R_TRY(read_func(cur_read_size, util::MakeIFunction([&] (void *dst, size_t dst_size) -> Result {
+                                        R_TRY(read_func(cur_read_size, util::MakeIFunction([&] (void *dst, size_t dst_size, bool is_deferrable) -> Result {
                                             /* Check that the size is valid. */
                                             AMS_ASSERT(dst_size == cur_read_size);
-                                            AMS_UNUSED(dst_size);
+                                            AMS_UNUSED(dst_size, is_deferrable);
 
                                             /* Perform the read. */
                                             R_RETURN(m_data_storage.Read(required_access_physical_offset, dst, cur_read_size));
@@ -662,10 +708,10 @@ namespace ams::fssystem {
                                 R_SUCCEED();
                             } else {
                                 /* We don't need a buffer, so just execute the read. */
-                                R_TRY(read_func(total_required_size, util::MakeIFunction([&] (void *dst, size_t dst_size) -> Result {
+                                R_TRY(read_func(total_required_size, util::MakeIFunction([&] (void *dst, size_t dst_size, bool is_deferrable) -> Result {
                                     /* Check that the size is valid. */
                                     AMS_ASSERT(dst_size == total_required_size);
-                                    AMS_UNUSED(dst_size);
+                                    AMS_UNUSED(dst_size, is_deferrable);
 
                                     /* Perform the read. */
                                     R_RETURN(m_data_storage.Read(required_access_physical_offset, dst, total_required_size));
@@ -759,10 +805,10 @@ namespace ams::fssystem {
                                     };
                                 } else {
                                     /* We have no entries, so we can just perform the read. */
-                                    R_TRY(read_func(static_cast<size_t>(read_size), util::MakeIFunction([&] (void *dst, size_t dst_size) -> Result {
+                                    R_TRY(read_func(static_cast<size_t>(read_size), util::MakeIFunction([&] (void *dst, size_t dst_size, bool is_deferrable) -> Result {
                                         /* Check the space we should zero is correct. */
                                         AMS_ASSERT(dst_size == static_cast<size_t>(read_size));
-                                        AMS_UNUSED(dst_size);
+                                        AMS_UNUSED(dst_size, is_deferrable);
 
                                         /* Zero the memory. */
                                         std::memset(dst, 0, read_size);
@@ -790,7 +836,8 @@ namespace ams::fssystem {
                 private:
                     DecompressorFunction GetDecompressor(CompressionType type) const {
                         /* Check that we can get a decompressor for the type. */
-                        if (CompressionTypeUtility::IsUnknownType(type)) {
+                        /* NOTE: Atmosphère extension types are left to the configuration, which only supports them when explicitly enabled. */
+                        if (CompressionTypeUtility::IsUnknownType(type) && !CompressionTypeUtility::IsExtensionType(type)) {
                             return nullptr;
                         }
 
@@ -1031,7 +1078,7 @@ namespace ams::fssystem {
                                 AMS_ASSERT(size_buffer_required <= cur_size);
 
                                 /* Perform the read. */
-                                R_TRY(read_impl(cur_dst, size_buffer_required));
+                                R_TRY(read_impl(cur_dst, size_buffer_required, true));
 
                                 /* Advance. */
                                 cur_dst    += size_buffer_required;
@@ -1057,7 +1104,7 @@ namespace ams::fssystem {
                                 pooled_buffer.Allocate(size_buffer_required, size_buffer_required);
 
                                 /* Perform read. */
-                                R_TRY(read_impl(pooled_buffer.GetBuffer(), size_buffer_required));
+                                R_TRY(read_impl(pooled_buffer.GetBuffer(), size_buffer_required, false));
 
                                 /* Copy the data we read to the destination. */
                                 const size_t skip_size = cur_offset - unaligned_range->virtual_offset;
@@ -1365,9 +1412,9 @@ namespace ams::fssystem {
             CompressedStorage() = default;
             virtual ~CompressedStorage() { this->Finalize(); }
 
-            Result Initialize(MemoryResource *bktr_allocator, fs::IBufferManager *cache_allocator, fs::SubStorage data_storage, fs::SubStorage node_storage, fs::SubStorage entry_storage, s32 bktr_entry_count, size_t block_size_max, size_t continuous_reading_size_max, GetDecompressorFunction get_decompressor, size_t cache_size_0, size_t cache_size_1, s32 max_cache_entries) {
+            Result Initialize(MemoryResource *bktr_allocator, fs::IBufferManager *cache_allocator, fs::SubStorage data_storage, fs::SubStorage node_storage, fs::SubStorage entry_storage, s32 bktr_entry_count, size_t block_size_max, size_t continuous_reading_size_max, GetDecompressorFunction get_decompressor, size_t cache_size_0, size_t cache_size_1, s32 max_cache_entries, DecompressionWorkerPool *worker_pool = nullptr) {
                 /* Initialize our core. */
-                R_TRY(m_core.Initialize(bktr_allocator, data_storage, node_storage, entry_storage, bktr_entry_count, block_size_max, continuous_reading_size_max, get_decompressor));
+                R_TRY(m_core.Initialize(bktr_allocator, data_storage, node_storage, entry_storage, bktr_entry_count, block_size_max, continuous_reading_size_max, get_decompressor, worker_pool));
 
                 /* Get our core size. */
                 s64 core_size = 0;
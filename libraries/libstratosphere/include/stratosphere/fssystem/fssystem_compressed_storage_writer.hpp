@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <vapours.hpp>
+#include <stratosphere/fs/fs_istorage.hpp>
+#include <stratosphere/fs/fs_substorage.hpp>
+#include <stratosphere/fssystem/fssystem_bucket_tree.hpp>
+#include <stratosphere/fssystem/fssystem_compressed_storage.hpp>
+#include <stratosphere/fssystem/fssystem_compression_common.hpp>
+
+namespace ams::fssystem {
+
+    /* Builds the data and bucket tree table consumed by CompressedStorage. This is intended for host-side tooling. */
+    class CompressedStorageWriter {
+        public:
+            static constexpr size_t BlockSizeDefault = 64_KB;
+            static constexpr size_t BlockSizeMax     = 64_KB;
+        public:
+            static constexpr s32 QueryEntryCount(s64 data_size, size_t block_size) {
+                AMS_ASSERT(data_size >= 0);
+                AMS_ASSERT(block_size > 0);
+
+                return static_cast<s32>(util::DivideUp(data_size, static_cast<s64>(block_size)));
+            }
+
+            static constexpr s64 QueryTableStorageSize(s32 entry_count) {
+                return CompressedStorage::QueryNodeStorageSize(entry_count) + CompressedStorage::QueryEntryStorageSize(entry_count);
+            }
+
+            static constexpr s64 QueryDataStorageSizeMax(s64 data_size, size_t block_size) {
+                /* Each block is stored uncompressed if compression does not help, and is padded to the block alignment. */
+                return util::AlignUp(data_size, CompressionBlockAlignment) + QueryEntryCount(data_size, block_size) * CompressionBlockAlignment;
+            }
+        public:
+            static Result Write(s64 *out_data_size, fs::SubStorage header_storage, fs::SubStorage table_storage, fs::SubStorage data_storage, fs::IStorage *src_storage, s64 src_size, size_t block_size, CompressionType compression_type, MemoryResource *allocator);
+    };
+
+}
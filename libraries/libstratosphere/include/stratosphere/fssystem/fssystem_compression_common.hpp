@@ -25,11 +25,18 @@ namespace ams::fssystem {
         CompressionType_2       = 2,
         CompressionType_Lz4     = 3,
         CompressionType_Unknown = 4,
+
+        /* NOTE: Atmosphère extension. */
+        /* This is deliberately far outside the official range, so that it cannot collide with future official types. */
+        /* It is only decompressed when the compression configuration in use explicitly enables extension types. */
+        CompressionType_Zstd    = 0x80,
     };
 
     using DecompressorFunction    = Result (*)(void *, size_t, const void *, size_t);
     using GetDecompressorFunction = DecompressorFunction (*)(CompressionType);
 
+    using CompressorFunction      = size_t (*)(void *, size_t, const void *, size_t);
+
     constexpr s64 CompressionBlockAlignment = 0x10;
 
     namespace CompressionTypeUtility {
@@ -50,6 +57,11 @@ namespace ams::fssystem {
             return type >= CompressionType_Unknown;
         }
 
+        /* NOTE: Atmosphère extension. */
+        constexpr bool IsExtensionType(CompressionType type) {
+            return type == CompressionType_Zstd;
+        }
+
     }
 
 }
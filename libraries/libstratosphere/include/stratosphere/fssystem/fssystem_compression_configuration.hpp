@@ -21,4 +21,10 @@ namespace ams::fssystem {
 
     const ::ams::fssystem::NcaCompressionConfiguration *GetNcaCompressionConfiguration();
 
+    /* NOTE: Atmosphère extension. */
+    /* This additionally decompresses extension types (e.g. CompressionType_Zstd), and is intended for host tooling which produces such images. */
+    const ::ams::fssystem::NcaCompressionConfiguration *GetNcaCompressionConfigurationWithExtensions();
+
+    CompressorFunction GetNcaCompressorFunction(CompressionType type);
+
 }
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <vapours.hpp>
+#include <stratosphere/os.hpp>
+#include <stratosphere/fssystem/fssystem_compression_common.hpp>
+
+namespace ams::fssystem {
+
+    class DecompressionWorkerPool {
+        NON_COPYABLE(DecompressionWorkerPool);
+        NON_MOVEABLE(DecompressionWorkerPool);
+        public:
+            static constexpr s32 WorkerCountMax = 4;
+
+            struct Job {
+                DecompressorFunction decompressor;
+                void *dst;
+                size_t dst_size;
+                const void *src;
+                size_t src_size;
+                Result result;
+            };
+        private:
+            os::ThreadType m_threads[WorkerCountMax];
+            s32 m_worker_count;
+            os::SdkMutex m_submit_mutex;
+            os::SdkMutex m_mutex;
+            os::SdkConditionVariable m_job_cv;
+            os::SdkConditionVariable m_done_cv;
+            Job *m_jobs;
+            s32 m_job_count;
+            s32 m_next_job_index;
+            s32 m_completed_job_count;
+            bool m_is_exiting;
+        public:
+            DecompressionWorkerPool() : m_worker_count(0), m_submit_mutex(), m_mutex(), m_job_cv(), m_done_cv(), m_jobs(nullptr), m_job_count(0), m_next_job_index(0), m_completed_job_count(0), m_is_exiting(false) { /* ... */ }
+
+            ~DecompressionWorkerPool() {
+                this->Finalize();
+            }
+
+            Result Initialize(void *stack, size_t stack_size, s32 worker_count, s32 priority);
+            void Finalize();
+
+            bool IsInitialized() const { return m_worker_count > 0; }
+
+            /* Runs the jobs concurrently, and returns the result of the first job (in order) to fail. */
+            Result Decompress(Job *jobs, s32 job_count);
+        private:
+            static void WorkerThreadFunction(void *arg);
+
+            void WorkerThreadImpl();
+            Job *AcquireJobUnsafe();
+            void CompleteJob();
+    };
+
+}
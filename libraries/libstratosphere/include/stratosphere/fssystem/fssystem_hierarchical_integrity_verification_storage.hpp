@@ -21,6 +21,7 @@
 #include <stratosphere/fs/fs_storage_type.hpp>
 #include <stratosphere/fssystem/fssystem_integrity_verification_storage.hpp>
 #include <stratosphere/fssystem/fssystem_block_cache_buffered_storage.hpp>
+#include <stratosphere/fssystem/fssystem_sharded_block_cache_buffered_storage.hpp>
 
 namespace ams::fssystem {
 
@@ -151,6 +152,8 @@ namespace ams::fssystem {
             os::SdkRecursiveMutex *m_mutex;
             IntegrityVerificationStorage m_verify_storages[MaxLayers - 1];
             BlockCacheBufferedStorage    m_buffer_storages[MaxLayers - 1];
+            /* NOTE: Atmosphère extension. Read-only storages cache their data layer in independently locked shards, so that concurrent reads don't serialize. */
+            ShardedBlockCacheBufferedStorage m_sharded_data_buffer_storage;
             os::Semaphore *m_read_semaphore;
             os::Semaphore *m_write_semaphore;
             s64 m_data_size;
@@ -195,6 +198,11 @@ namespace ams::fssystem {
                 }
             }
 
+            /* NOTE: Atmosphère extension. */
+            bool IsDataBufferStorageSharded() const {
+                return m_sharded_data_buffer_storage.IsInitialized();
+            }
+
             s64 GetL1HashVerificationBlockSize() const {
                 return m_verify_storages[m_max_layers - 2].GetBlockSize();
             }
@@ -206,6 +214,16 @@ namespace ams::fssystem {
             static constexpr s8 GetDefaultDataCacheBufferLevel(u32 max_layers) {
                 return 16 + max_layers - 2;
             }
+        private:
+            fs::IStorage *GetDataBufferStorage() {
+                if (this->IsDataBufferStorageSharded()) {
+                    return std::addressof(m_sharded_data_buffer_storage);
+                } else {
+                    return std::addressof(m_buffer_storages[m_max_layers - 2]);
+                }
+            }
+
+            Result FlushBufferStorages();
     };
 
 }
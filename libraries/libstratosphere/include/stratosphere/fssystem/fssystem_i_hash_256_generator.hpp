@@ -72,9 +72,46 @@ namespace ams::fssystem {
 
                 return this->DoGenerateHash(dst, dst_size, src, src_size);
             }
+
+            Result GenerateHashes(void *dst, size_t dst_size, const void *prefix, size_t prefix_size, const void *src, size_t block_size, size_t block_count) {
+                /* Check pre-conditions. */
+                AMS_ASSERT(dst != nullptr);
+                AMS_ASSERT(src != nullptr);
+                AMS_ASSERT(prefix != nullptr || prefix_size == 0);
+                AMS_ASSERT(dst_size >= IHash256Generator::HashSize * block_count);
+
+                return this->DoGenerateHashes(dst, dst_size, prefix, prefix_size, src, block_size, block_count);
+            }
         protected:
             virtual Result DoCreate(std::unique_ptr<IHash256Generator> *out) = 0;
             virtual void DoGenerateHash(void *dst, size_t dst_size, const void *src, size_t src_size) = 0;
+
+            virtual Result DoGenerateHashes(void *dst, size_t dst_size, const void *prefix, size_t prefix_size, const void *src, size_t block_size, size_t block_count) {
+                AMS_UNUSED(dst_size);
+
+                u8 *dst8 = static_cast<u8 *>(dst);
+                const u8 *src8 = static_cast<const u8 *>(src);
+
+                if (prefix_size == 0) {
+                    /* If we have no prefix, we can hash each block directly. */
+                    for (size_t i = 0; i < block_count; ++i) {
+                        this->DoGenerateHash(dst8 + i * IHash256Generator::HashSize, IHash256Generator::HashSize, src8 + i * block_size, block_size);
+                    }
+                } else {
+                    /* Otherwise, we need a generator to hash the prefix before each block. */
+                    std::unique_ptr<IHash256Generator> generator = nullptr;
+                    R_TRY(this->DoCreate(std::addressof(generator)));
+
+                    for (size_t i = 0; i < block_count; ++i) {
+                        generator->Initialize();
+                        generator->Update(prefix, prefix_size);
+                        generator->Update(src8 + i * block_size, block_size);
+                        generator->GetHash(dst8 + i * IHash256Generator::HashSize, IHash256Generator::HashSize);
+                    }
+                }
+
+                R_SUCCEED();
+            }
     };
 
     /* ACCURATE_TO_VERSION: 14.3.0.0 */
@@ -116,6 +116,11 @@ namespace ams::fssystem {
                 R_RETURN(m_table.Initialize(allocator, node_storage, entry_storage, NodeSize, sizeof(Entry), entry_count));
             }
 
+            /* NOTE: Atmosphère extension. */
+            Result InitializeLookupIndex(s32 entry_set_cache_count) {
+                R_RETURN(m_table.InitializeLookupIndex(entry_set_cache_count));
+            }
+
             void SetStorage(s32 idx, fs::SubStorage storage) {
                 AMS_ASSERT(0 <= idx && idx < StorageCount);
                 m_data_storage[idx] = storage;
@@ -155,6 +160,26 @@ namespace ams::fssystem {
                 AMS_UNUSED(size);
                 R_THROW(fs::ResultUnsupportedSetSizeForIndirectStorage());
             }
+        protected:
+            /* NOTE: Atmosphère extension. */
+            /* Gathers the fragments of a read by data storage, so each storage sees one batched read. */
+            class ReadRequestBatch {
+                NON_COPYABLE(ReadRequestBatch);
+                NON_MOVEABLE(ReadRequestBatch);
+                public:
+                    static constexpr s32 RequestCountMax = 16;
+                private:
+                    fs::IStorage *m_storages[StorageCount];
+                    fs::ReadRequest m_requests[StorageCount][RequestCountMax];
+                    s32 m_request_counts[StorageCount];
+                public:
+                    ReadRequestBatch() : m_storages(), m_request_counts() { /* ... */ }
+
+                    Result Add(fs::IStorage *storage, s64 offset, void *buffer, size_t size);
+                    Result Submit();
+                private:
+                    Result Submit(s32 index);
+            };
         protected:
             BucketTree &GetEntryTable() { return m_table; }
 
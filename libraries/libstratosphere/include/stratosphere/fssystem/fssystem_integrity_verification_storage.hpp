@@ -66,19 +66,15 @@ namespace ams::fssystem {
             virtual Result OperateRange(void *dst, size_t dst_size, fs::OperationId op_id, s64 offset, s64 size, const void *src, size_t src_size) override;
             using IStorage::OperateRange;
 
-            void CalcBlockHash(BlockHash *out, const void *buffer, std::unique_ptr<fssystem::IHash256Generator> &generator) const {
-                return this->CalcBlockHash(out, buffer, static_cast<size_t>(m_verification_block_size), generator);
-            }
-
             s64 GetBlockSize() const {
                 return m_verification_block_size;
             }
         private:
             Result ReadBlockSignature(void *dst, size_t dst_size, s64 offset, size_t size);
             Result WriteBlockSignature(const void *src, size_t src_size, s64 offset, size_t size);
-            Result VerifyHash(const void *buf, BlockHash *hash, std::unique_ptr<fssystem::IHash256Generator> &generator);
+            Result VerifyHash(BlockHash *hash, const BlockHash &calc_hash);
 
-            void CalcBlockHash(BlockHash *out, const void *buffer, size_t block_size, std::unique_ptr<fssystem::IHash256Generator> &generator) const;
+            Result CalcBlockHashes(BlockHash *out, const void *buffer, size_t block_count) const;
 
             Result IsCleared(bool *is_cleared, const BlockHash &hash);
         private:
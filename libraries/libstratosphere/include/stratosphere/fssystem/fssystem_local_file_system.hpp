@@ -82,4 +82,10 @@ namespace ams::fssystem {
             Result DeleteDirectoryRecursivelyInternal(const NativeCharacterType *path, bool delete_top);
     };
 
+    #if defined(ATMOSPHERE_OS_LINUX)
+    /* NOTE: Atmosphère extension. */
+    /* Stops batched reads from using io_uring, so that tests can check the preadv path against it. */
+    void SetLocalFileIoUringEnabledForTest(bool enabled);
+    #endif
+
 }
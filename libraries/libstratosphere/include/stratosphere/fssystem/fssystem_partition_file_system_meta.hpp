@@ -85,8 +85,11 @@ namespace ams::fssystem {
             size_t m_meta_data_size;
             MemoryResource *m_allocator;
             char *m_buffer;
+            s32 *m_index_table;
+            size_t m_index_table_size;
+            u32 m_index_bucket_count;
         public:
-            PartitionFileSystemMetaCore() : m_initialized(false), m_allocator(nullptr), m_buffer(nullptr) { /* ... */ }
+            PartitionFileSystemMetaCore() : m_initialized(false), m_allocator(nullptr), m_buffer(nullptr), m_index_table(nullptr), m_index_table_size(0), m_index_bucket_count(0) { /* ... */ }
             ~PartitionFileSystemMetaCore();
 
             Result Initialize(fs::IStorage *storage, MemoryResource *allocator);
@@ -102,6 +105,13 @@ namespace ams::fssystem {
             static Result QueryMetaDataSize(size_t *out_size, fs::IStorage *storage);
         protected:
             void DeallocateBuffer();
+
+            /* NOTE: Atmosphère extension. */
+            void BuildIndexTable();
+            void DeallocateIndexTable();
+        private:
+            s32 GetEntryIndexByIndexTable(const char *name) const;
+            s32 GetEntryIndexByLinearSearch(const char *name) const;
     };
 
     using PartitionFileSystemMeta = PartitionFileSystemMetaCore<impl::PartitionFileSystemFormat>;
@@ -67,6 +67,15 @@ namespace ams::fssystem {
                 virtual void DoGenerateHash(void *dst, size_t dst_size, const void *src, size_t src_size) override {
                     Traits::Generate(dst, dst_size, src, src_size);
                 }
+
+                virtual Result DoGenerateHashes(void *dst, size_t dst_size, const void *prefix, size_t prefix_size, const void *src, size_t block_size, size_t block_count) override {
+                    if constexpr (Traits::SupportsGenerateMultiple) {
+                        Traits::GenerateMultiple(dst, dst_size, prefix, prefix_size, src, block_size, block_count);
+                        R_SUCCEED();
+                    } else {
+                        R_RETURN(IHash256GeneratorFactory::DoGenerateHashes(dst, dst_size, prefix, prefix_size, src, block_size, block_count));
+                    }
+                }
         };
 
         struct Sha256Traits {
@@ -75,6 +84,12 @@ namespace ams::fssystem {
             static ALWAYS_INLINE void Generate(void *dst, size_t dst_size, const void *src, size_t src_size) {
                 return crypto::GenerateSha256(dst, dst_size, src, src_size);
             }
+
+            static constexpr bool SupportsGenerateMultiple = true;
+
+            static ALWAYS_INLINE void GenerateMultiple(void *dst, size_t dst_size, const void *prefix, size_t prefix_size, const void *src, size_t block_size, size_t block_count) {
+                return crypto::GenerateSha256Multiple(dst, dst_size, prefix, prefix_size, src, block_size, block_count);
+            }
         };
 
         struct Sha3256Traits {
@@ -83,6 +98,8 @@ namespace ams::fssystem {
             static ALWAYS_INLINE void Generate(void *dst, size_t dst_size, const void *src, size_t src_size) {
                 return crypto::GenerateSha3256(dst, dst_size, src, src_size);
             }
+
+            static constexpr bool SupportsGenerateMultiple = false;
         };
     }
 
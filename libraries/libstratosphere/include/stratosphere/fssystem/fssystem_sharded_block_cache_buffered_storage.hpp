@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <vapours.hpp>
+#include <stratosphere/os.hpp>
+#include <stratosphere/fs/fs_istorage.hpp>
+#include <stratosphere/fs/fs_memory_management.hpp>
+#include <stratosphere/fssystem/buffers/fssystem_file_system_buffer_manager.hpp>
+
+namespace ams::fssystem {
+
+    /* NOTE: This is an Atmosphère extension, with no official counterpart. */
+    /* It behaves as BlockCacheBufferedStorage, but caches single verification blocks in shards which are */
+    /* selected by a hash of the block's offset, so that readers of different blocks do not contend on one lock. */
+    class ShardedBlockCacheBufferedStorage : public ::ams::fs::IStorage {
+        NON_COPYABLE(ShardedBlockCacheBufferedStorage);
+        NON_MOVEABLE(ShardedBlockCacheBufferedStorage);
+        public:
+            static constexpr s32 DefaultShardCount = 4;
+            static constexpr s32 ShardCountMax     = 16;
+        private:
+            using MemoryRange = fs::IBufferManager::MemoryRange;
+            using CacheIndex  = s32;
+
+            static constexpr CacheIndex InvalidCacheIndex = -1;
+
+            struct CacheEntry {
+                s64 offset;
+                fs::IBufferManager::CacheHandle handle;
+                uintptr_t memory_address;
+                size_t memory_size;
+                u32 last_access;
+                bool is_valid;
+                bool is_write_back;
+            };
+            static_assert(util::is_pod<CacheEntry>::value);
+
+            struct Shard {
+                os::SdkMutex mutex;
+                CacheEntry *entries;
+                CacheIndex *index_table;
+                u32 access_tick;
+                u32 generation;
+                s32 direct_access_count;
+            };
+
+            /* Blocks are loaded from the data storage without holding the shard's lock. */
+            /* A load may only be stored if the shard's generation is unchanged since the load began, and no direct access was in progress then, */
+            /* as otherwise the data storage may have been written while it was being read. */
+            struct LoadTicket {
+                u32 generation;
+                bool is_storable;
+            };
+        private:
+            IStorage *m_data_storage;
+            fs::IBufferManager *m_buffer_manager;
+            s64 m_data_size;
+            size_t m_verification_block_size;
+            size_t m_verification_block_shift;
+            s32 m_buffer_level;
+            s32 m_shard_count;
+            s32 m_shard_entry_count;
+            s32 m_index_table_size;
+            Shard m_shards[ShardCountMax];
+            std::unique_ptr<CacheEntry[], fs::impl::Deleter> m_entries;
+            std::unique_ptr<CacheIndex[], fs::impl::Deleter> m_index_tables;
+            os::SdkMutex m_last_result_mutex;
+            Result m_last_result;
+            bool m_is_keep_burst_mode;
+            bool m_is_writable;
+        public:
+            ShardedBlockCacheBufferedStorage();
+            virtual ~ShardedBlockCacheBufferedStorage() override;
+
+            Result Initialize(fs::IBufferManager *bm, IStorage *data, s64 data_size, size_t verif_block_size, s32 max_cache_entries, s32 shard_count, s8 buffer_level, bool is_keep_burst_mode, bool is_writable);
+            void Finalize();
+
+            bool IsInitialized() const { return m_entries != nullptr; }
+
+            virtual Result Read(s64 offset, void *buffer, size_t size) override;
+            virtual Result Write(s64 offset, const void *buffer, size_t size) override;
+
+            virtual Result SetSize(s64) override { R_THROW(fs::ResultUnsupportedSetSizeForBlockCacheBufferedStorage()); }
+            virtual Result GetSize(s64 *out) override;
+
+            virtual Result Flush() override;
+
+            virtual Result OperateRange(void *dst, size_t dst_size, fs::OperationId op_id, s64 offset, s64 size, const void *src, size_t src_size) override;
+            using IStorage::OperateRange;
+
+            Result Commit();
+            Result OnRollback();
+
+            bool IsEnabledKeepBurstMode() const { return m_is_keep_burst_mode; }
+            void SetKeepBurstMode(bool en) { m_is_keep_burst_mode = en; }
+        private:
+            Result FillZeroImpl(s64 offset, s64 size);
+            Result DestroySignatureImpl(s64 offset, s64 size);
+            Result InvalidateImpl();
+            Result QueryRangeImpl(void *dst, size_t dst_size, s64 offset, s64 size);
+
+            void BeginDirectAccess();
+            void EndDirectAccess();
+
+            LoadTicket BeginLoad(const Shard &shard) const;
+            bool IsLoadStorable(const Shard &shard, const LoadTicket &ticket) const;
+
+            Result ReadBlock(s64 block_offset, size_t offset_in_block, void *buffer, size_t size);
+            Result WriteBlock(s64 block_offset, size_t offset_in_block, const void *buffer, size_t size);
+
+            Shard &GetShard(s64 block_offset);
+            s32 GetIndexSlot(s64 block_offset) const;
+
+            CacheIndex FindCacheEntry(Shard &shard, s64 block_offset) const;
+            void InsertIndex(Shard &shard, CacheIndex index);
+            void EraseIndex(Shard &shard, CacheIndex index);
+
+            bool AcquireCacheEntryMemory(MemoryRange *out_range, Shard &shard, CacheIndex index);
+            void InvalidateCacheEntry(Shard &shard, CacheIndex index);
+            Result StoreCacheEntry(Shard &shard, s64 block_offset, const MemoryRange &range, bool is_write_back);
+            Result FlushCacheEntry(Shard &shard, CacheIndex index, bool invalidate);
+
+            Result AllocateBuffer(MemoryRange *out_range);
+            Result PrepareAllocation();
+
+            Result FlushRangeCacheEntries(s64 offset, s64 size, bool invalidate);
+            Result FlushAllCacheEntries();
+            Result InvalidateAllCacheEntries();
+            Result ControlDirtiness(Shard &shard);
+
+            Result GetLastResult();
+            Result UpdateLastResult(Result result);
+    };
+
+}
@@ -25,6 +25,10 @@ namespace ams::lmem {
         CreateOption_ZeroClear  = (1 << 0),
         CreateOption_DebugFill  = (1 << 1),
         CreateOption_ThreadSafe = (1 << 2),
+
+        /* NOTE: Atmosphère extension. */
+        /* Index free blocks by size class, for constant-time allocation and coalescing in exp heaps. */
+        CreateOption_SegregatedFit = (1 << 3),
     };
 
     enum FillType {
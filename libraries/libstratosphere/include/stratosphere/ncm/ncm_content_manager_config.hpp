@@ -23,6 +23,10 @@ namespace ams::ncm {
         bool import_database_from_system_on_sd;
         bool enable_integrated_system_content;
 
+        /* NOTE: Atmosphère extension. The number of file handles each content storage keeps open; zero selects the default. */
+        u8 content_file_cache_count;
+        u8 placeholder_file_cache_count;
+
         bool HasAnyConfig() const {
             return this->ShouldBuildDatabase() || this->import_database_from_system_on_sd || this->enable_integrated_system_content;
         }
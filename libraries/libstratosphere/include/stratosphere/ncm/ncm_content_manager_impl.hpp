@@ -104,8 +104,11 @@ namespace ams::ncm {
                 StorageId storage_id;
                 util::optional<ContentStorageConfig> config;
                 sf::SharedPointer<IContentStorage> content_storage;
+                /* NOTE: Atmosphère extension. */
+                u8 content_file_cache_count;
+                u8 placeholder_file_cache_count;
 
-                ContentStorageRoot() : mount_name(), path(), storage_id(), config(util::nullopt), content_storage() { /* ... */ }
+                ContentStorageRoot() : mount_name(), path(), storage_id(), config(util::nullopt), content_storage(), content_file_cache_count(), placeholder_file_cache_count() { /* ... */ }
             };
 
             struct IntegratedContentStorageRoot {
@@ -206,6 +209,7 @@ namespace ams::ncm {
             u32 m_num_configs{0};
             RightsIdCache m_rights_id_cache{};
             RegisteredHostContent m_registered_host_content{};
+            ContentManagerConfig m_manager_config{};
         public:
             ContentManagerImpl() = default;
             ~ContentManagerImpl();
@@ -263,6 +267,9 @@ namespace ams::ncm {
             Result InvalidateRightsIdCache();
             Result GetMemoryReport(sf::Out<MemoryReport> out);
             Result ActivateFsContentStorage(fs::ContentStorageId fs_content_storage_id);
+
+            /* Atmosphère extensions. */
+            Result AtmosphereGetFileCacheReport(sf::Out<FileCacheReport> out);
     };
     static_assert(IsIContentManager<ContentManagerImpl>);
 
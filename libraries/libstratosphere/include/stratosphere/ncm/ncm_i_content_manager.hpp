@@ -35,6 +35,7 @@
     AMS_SF_METHOD_INFO(C, H, 12, Result, InactivateContentMetaDatabase,    (ncm::StorageId storage_id),                                                            (storage_id),      hos::Version_2_0_0)                     \
     AMS_SF_METHOD_INFO(C, H, 13, Result, InvalidateRightsIdCache,          (),                                                                                     (),                hos::Version_9_0_0)                     \
     AMS_SF_METHOD_INFO(C, H, 14, Result, GetMemoryReport,                  (sf::Out<ncm::MemoryReport> out),                                                       (out),             hos::Version_10_0_0)                    \
-    AMS_SF_METHOD_INFO(C, H, 15, Result, ActivateFsContentStorage,         (fs::ContentStorageId fs_storage_id),                                                   (fs_storage_id)) /* Technically min 16.0.0, but used. */
+    AMS_SF_METHOD_INFO(C, H, 15, Result, ActivateFsContentStorage,         (fs::ContentStorageId fs_storage_id),                                                   (fs_storage_id)) /* Technically min 16.0.0, but used. */ \
+    AMS_SF_METHOD_INFO(C, H, 65000, Result, AtmosphereGetFileCacheReport, (sf::Out<ncm::FileCacheReport> out),                                                    (out))
 
 AMS_SF_DEFINE_INTERFACE(ams::ncm, IContentManager, AMS_NCM_I_CONTENT_MANAGER_INTERFACE_INFO, 0xFDB4FFE1);
@@ -56,4 +56,39 @@ namespace ams::ncm {
 
     HeapState &GetHeapState();
 
+    /* NOTE: Atmosphère extension. */
+    struct FileCacheState {
+        u64 hit_count;
+        u64 miss_count;
+        u64 eviction_count;
+    };
+
+    struct FileCacheReport {
+        FileCacheState content_file_cache_state;
+        FileCacheState placeholder_file_cache_state;
+    };
+
+    static_assert(sizeof(FileCacheReport) == 0x30);
+    static_assert(util::is_pod<FileCacheReport>::value);
+
+    class FileCacheStatistics {
+        private:
+            std::atomic<u64> m_hit_count;
+            std::atomic<u64> m_miss_count;
+            std::atomic<u64> m_eviction_count;
+        public:
+            constexpr FileCacheStatistics() : m_hit_count(0), m_miss_count(0), m_eviction_count(0) { /* ... */ }
+
+            void Hit()   { m_hit_count.fetch_add(1, std::memory_order_relaxed); }
+            void Miss()  { m_miss_count.fetch_add(1, std::memory_order_relaxed); }
+            void Evict() { m_eviction_count.fetch_add(1, std::memory_order_relaxed); }
+
+            void GetFileCacheState(FileCacheState *out) const;
+    };
+
+    FileCacheStatistics &GetContentFileCacheStatistics();
+    FileCacheStatistics &GetPlaceHolderFileCacheStatistics();
+
+    void GetFileCacheReport(FileCacheReport *out);
+
 }
@@ -24,6 +24,13 @@ namespace ams::os {
         class MultiWaitImpl;
         struct MultiWaitHolderImpl;
 
+        #if defined(ATMOSPHERE_OS_LINUX)
+        /* NOTE: Atmosphère extension; the linux target also holds an epoll instance and a pointer to its table of linked handles. */
+        constexpr inline size_t MultiWaitTargetImplStorageSize = 2 * sizeof(NativeHandle) + sizeof(void *);
+        #else
+        constexpr inline size_t MultiWaitTargetImplStorageSize = sizeof(NativeHandle);
+        #endif
+
     }
 
     struct MultiWaitType {
@@ -34,7 +41,7 @@ namespace ams::os {
 
         u8 state;
         bool is_waiting;
-        util::TypedStorage<impl::MultiWaitImpl, util::AlignUp(sizeof(util::IntrusiveListNode) + sizeof(impl::InternalCriticalSection) + 2 * sizeof(void *) + sizeof(NativeHandle), alignof(void *)), alignof(void *)> impl_storage;
+        util::TypedStorage<impl::MultiWaitImpl, util::AlignUp(sizeof(util::IntrusiveListNode) + sizeof(impl::InternalCriticalSection) + 2 * sizeof(void *) + impl::MultiWaitTargetImplStorageSize, alignof(void *)), alignof(void *)> impl_storage;
     };
     static_assert(std::is_trivial<MultiWaitType>::value);
 
@@ -24,4 +24,8 @@ namespace ams::os {
 
     Result SdkReplyAndReceive(os::MultiWaitHolderType **out, NativeHandle reply_target, MultiWaitType *multi_wait);
 
+    /* NOTE: Atmosphère extension. */
+    /* Host transports can't tell a session from any other descriptor, so sessions which ReplyAndReceive should receive from must be marked. */
+    void SdkInitializeMultiWaitHolderForSession(MultiWaitHolderType *holder, NativeHandle session_handle);
+
 }
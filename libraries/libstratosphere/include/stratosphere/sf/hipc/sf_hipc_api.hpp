@@ -45,5 +45,14 @@ namespace ams::sf::hipc {
 
     Result CreateSession(os::NativeHandle *out_server_handle, os::NativeHandle *out_client_handle);
 
+    #if defined(ATMOSPHERE_OS_LINUX)
+    /* NOTE: Atmosphère extension. */
+    /* The linux host transport has no kernel to provide ports or a client send path, so they are provided alongside sessions. */
+    Result CreatePort(os::NativeHandle *out_server_handle, os::NativeHandle *out_client_handle, s32 max_sessions);
+    Result ConnectToPort(os::NativeHandle *out_session_handle, os::NativeHandle client_port_handle);
+    Result AcceptSession(os::NativeHandle *out_session_handle, os::NativeHandle server_port_handle);
+
+    Result SendSyncRequest(os::NativeHandle session_handle, const cmif::PointerAndSize &message_buffer);
+    #endif
 
 }
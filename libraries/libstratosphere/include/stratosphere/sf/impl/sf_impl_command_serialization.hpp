@@ -145,7 +145,7 @@ namespace ams::sf {
 }
 
 
-#if defined(ATMOSPHERE_OS_HORIZON)
+#if defined(ATMOSPHERE_OS_HORIZON) || defined(ATMOSPHERE_OS_LINUX)
 namespace ams::sf::impl {
 
     /* Machinery for filtering type lists. */
@@ -1277,18 +1277,6 @@ namespace ams::sf::impl {
     }
 
 
-}
-#elif defined(ATMOSPHERE_OS_LINUX)
-namespace ams::sf::impl {
-
-    template<auto ServiceCommandImpl, typename Return, typename ClassType, typename... Arguments>
-    inline Result InvokeServiceCommandImpl(CmifOutHeader **out_header_ptr, cmif::ServiceDispatchContext &ctx, const cmif::PointerAndSize &in_raw_data) {
-        /* TODO: Is some kind of emulated serialization interesting/desirable? */
-        AMS_UNUSED(out_header_ptr, ctx, in_raw_data);
-        AMS_ABORT("HIPC serialization not currently supported on Linux.");
-    }
-
-
 }
 #elif defined(ATMOSPHERE_OS_MACOS)
 namespace ams::sf::impl {
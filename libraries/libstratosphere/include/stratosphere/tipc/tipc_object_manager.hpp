@@ -37,28 +37,104 @@ namespace ams::tipc {
             Entry *m_entries_start{};
             Entry *m_entries_end{};
             os::MultiWaitType *m_multi_wait{};
+            /* NOTE: Atmosphère extension. */
+            /* Entries are indexed by handle via an open-addressed (linear probing) table of entry index + 1, */
+            /* and unused entries are kept on a free stack, so that no lookup needs to scan every entry. */
+            u16 *m_handle_index{};
+            size_t m_handle_index_mask{};
+            u16 *m_free_entries{};
+            size_t m_num_free_entries{};
         private:
+            static ALWAYS_INLINE size_t HashHandle(tipc::NativeHandle handle) {
+                using HandleValueType = std::conditional<sizeof(tipc::NativeHandle) == sizeof(u64), u64, u32>::type;
+                static_assert(sizeof(HandleValueType) == sizeof(tipc::NativeHandle));
+
+                const u64 value = std::bit_cast<HandleValueType>(handle);
+
+                /* Handles differ mostly in their low bits, so mix them multiplicatively before masking. */
+                return static_cast<size_t>((value * UINT64_C(0x9E3779B97F4A7C15)) >> 32);
+            }
+
+            ALWAYS_INLINE size_t GetHandleIndexSlot(tipc::NativeHandle handle) const {
+                return HashHandle(handle) & m_handle_index_mask;
+            }
+
+            ALWAYS_INLINE size_t GetNextHandleIndexSlot(size_t slot) const {
+                return (slot + 1) & m_handle_index_mask;
+            }
+
+            ALWAYS_INLINE Entry *GetHandleIndexEntry(size_t slot) const {
+                return m_entries_start + (m_handle_index[slot] - 1);
+            }
+
             Entry *FindEntry(tipc::NativeHandle handle) {
-                for (Entry *cur = m_entries_start; cur != m_entries_end; ++cur) {
-                    if (GetReference(cur->object).GetHandle() == handle) {
-                        return cur;
+                /* NOTE: The index is always at least twice as large as the entry count, so probing always reaches an empty slot. */
+                for (size_t slot = this->GetHandleIndexSlot(handle); m_handle_index[slot] != 0; slot = this->GetNextHandleIndexSlot(slot)) {
+                    if (Entry *entry = this->GetHandleIndexEntry(slot); GetReference(entry->object).GetHandle() == handle) {
+                        return entry;
                     }
                 }
                 return nullptr;
             }
 
             Entry *FindEntry(os::MultiWaitHolderType *holder) {
-                for (Entry *cur = m_entries_start; cur != m_entries_end; ++cur) {
-                    if (std::addressof(cur->multi_wait_holder) == holder) {
-                        return cur;
+                /* Our holders lie at a fixed stride within the entry array; any other holder (e.g. a message queue's) isn't ours. */
+                const uintptr_t holder_address = reinterpret_cast<uintptr_t>(holder);
+                const uintptr_t first_address  = reinterpret_cast<uintptr_t>(std::addressof(m_entries_start->multi_wait_holder));
+                if (holder_address < first_address) {
+                    return nullptr;
+                }
+
+                const uintptr_t offset = holder_address - first_address;
+                const size_t index     = offset / sizeof(Entry);
+                if (offset % sizeof(Entry) != 0 || index >= static_cast<size_t>(m_entries_end - m_entries_start)) {
+                    return nullptr;
+                }
+
+                return m_entries_start + index;
+            }
+
+            void InsertIntoHandleIndex(Entry *entry) {
+                /* Find the first empty slot in the handle's probe sequence. */
+                size_t slot = this->GetHandleIndexSlot(GetReference(entry->object).GetHandle());
+                while (m_handle_index[slot] != 0) {
+                    slot = this->GetNextHandleIndexSlot(slot);
+                }
+
+                /* Set the slot. */
+                m_handle_index[slot] = static_cast<u16>((entry - m_entries_start) + 1);
+            }
+
+            void RemoveFromHandleIndex(Entry *entry) {
+                /* Find the entry's slot. */
+                const u16 value = static_cast<u16>((entry - m_entries_start) + 1);
+                size_t hole = this->GetHandleIndexSlot(GetReference(entry->object).GetHandle());
+                while (m_handle_index[hole] != value) {
+                    AMS_ASSERT(m_handle_index[hole] != 0);
+                    hole = this->GetNextHandleIndexSlot(hole);
+                }
+
+                /* Shift back any following entries whose probe sequence passes through the hole, so that no tombstones are needed. */
+                for (size_t cur = this->GetNextHandleIndexSlot(hole); m_handle_index[cur] != 0; cur = this->GetNextHandleIndexSlot(cur)) {
+                    const size_t home = this->GetHandleIndexSlot(GetReference(this->GetHandleIndexEntry(cur)->object).GetHandle());
+                    if (((cur - home) & m_handle_index_mask) >= ((cur - hole) & m_handle_index_mask)) {
+                        m_handle_index[hole] = m_handle_index[cur];
+                        hole = cur;
                     }
                 }
-                return nullptr;
+
+                /* Clear the final hole. */
+                m_handle_index[hole] = 0;
             }
         public:
             constexpr ObjectManagerBase() = default;
 
-            void InitializeImpl(os::MultiWaitType *multi_wait, Entry *entries, size_t max_objects) {
+            void InitializeImpl(os::MultiWaitType *multi_wait, Entry *entries, size_t max_objects, u16 *handle_index, size_t handle_index_size, u16 *free_entries) {
+                /* Validate the index storage. */
+                AMS_ASSERT(max_objects < std::numeric_limits<u16>::max());
+                AMS_ASSERT(util::IsPowerOfTwo(handle_index_size));
+                AMS_ASSERT(handle_index_size >= 2 * max_objects);
+
                 /* Set our multi wait. */
                 m_multi_wait = multi_wait;
 
@@ -70,21 +146,38 @@ namespace ams::tipc {
                 for (size_t i = 0; i < max_objects; ++i) {
                     util::ConstructAt(m_entries_start[i].object);
                 }
+
+                /* Setup the handle index. */
+                m_handle_index      = handle_index;
+                m_handle_index_mask = handle_index_size - 1;
+                std::memset(m_handle_index, 0, sizeof(*m_handle_index) * handle_index_size);
+
+                /* Setup the free entry stack, such that lower entries are used first. */
+                m_free_entries     = free_entries;
+                m_num_free_entries = max_objects;
+                for (size_t i = 0; i < max_objects; ++i) {
+                    m_free_entries[i] = static_cast<u16>(max_objects - 1 - i);
+                }
             }
 
             void AddObject(ObjectHolder &object) {
                 /* Lock ourselves. */
                 std::scoped_lock lk(m_mutex);
 
-                /* Find an empty entry. */
-                auto *entry = this->FindEntry(tipc::InvalidNativeHandle);
-                AMS_ABORT_UNLESS(entry != nullptr);
+                /* Take an empty entry. */
+                AMS_ABORT_UNLESS(m_num_free_entries > 0);
+                auto *entry = m_entries_start + m_free_entries[--m_num_free_entries];
 
                 /* Set the entry's object. */
                 GetReference(entry->object) = object;
+                this->InsertIntoHandleIndex(entry);
 
                 /* Setup the entry's holder. */
-                os::InitializeMultiWaitHolder(std::addressof(entry->multi_wait_holder), object.GetHandle());
+                if (object.GetType() == ObjectHolder::ObjectType_Session) {
+                    os::SdkInitializeMultiWaitHolderForSession(std::addressof(entry->multi_wait_holder), object.GetHandle());
+                } else {
+                    os::InitializeMultiWaitHolder(std::addressof(entry->multi_wait_holder), object.GetHandle());
+                }
                 os::LinkMultiWaitHolder(m_multi_wait, std::addressof(entry->multi_wait_holder));
             }
 
@@ -100,8 +193,29 @@ namespace ams::tipc {
                 os::UnlinkMultiWaitHolder(std::addressof(entry->multi_wait_holder));
                 os::FinalizeMultiWaitHolder(std::addressof(entry->multi_wait_holder));
 
+                /* Remove the entry from the handle index. */
+                this->RemoveFromHandleIndex(entry);
+
                 /* Destroy the object. */
                 GetReference(entry->object).Destroy();
+
+                /* Return the entry to the free stack. */
+                m_free_entries[m_num_free_entries++] = static_cast<u16>(entry - m_entries_start);
+            }
+
+            /* NOTE: Atmosphère extension. */
+            /* Gets the object registered for a handle, so that tests can check the handle index's lookups. */
+            bool GetObjectForTest(ObjectHolder *out, tipc::NativeHandle handle) {
+                /* Lock ourselves. */
+                std::scoped_lock lk(m_mutex);
+
+                /* Find the matching entry. */
+                if (auto *entry = this->FindEntry(handle); entry != nullptr) {
+                    *out = GetReference(entry->object);
+                    return true;
+                }
+
+                return false;
             }
 
             Result ReplyAndReceive(os::MultiWaitHolderType **out_holder, ObjectHolder *out_object, tipc::NativeHandle reply_target, os::MultiWaitType *multi_wait) {
@@ -196,13 +310,19 @@ namespace ams::tipc {
 
     template<size_t MaxObjects>
     class ObjectManager : public ObjectManagerBase {
+        private:
+            static_assert(MaxObjects < std::numeric_limits<u16>::max());
+
+            static constexpr size_t HandleIndexSize = util::CeilingPowerOfTwo<size_t>(2 * MaxObjects);
         private:
             Entry m_entries_storage[MaxObjects]{};
+            u16 m_handle_index_storage[HandleIndexSize]{};
+            u16 m_free_entries_storage[MaxObjects]{};
         public:
             constexpr ObjectManager() = default;
 
             void Initialize(os::MultiWaitType *multi_wait) {
-                this->InitializeImpl(multi_wait, m_entries_storage, MaxObjects);
+                this->InitializeImpl(multi_wait, m_entries_storage, MaxObjects, m_handle_index_storage, HandleIndexSize, m_free_entries_storage);
             }
     };
 
@@ -39,6 +39,25 @@ namespace ams::fs {
         R_RETURN(m_base_file->Read(std::addressof(read_size), offset, buffer, size));
     }
 
+    Result FileStorage::ReadBatch(const ReadRequest *requests, s32 count) {
+        /* Immediately succeed if there's nothing to read. */
+        R_SUCCEED_IF(count == 0);
+
+        /* Validate requests. */
+        R_UNLESS(requests != nullptr, fs::ResultNullptrArgument());
+
+        /* Ensure our size is valid. */
+        R_TRY(this->UpdateSize());
+
+        /* Ensure our accesses are valid. */
+        for (s32 i = 0; i < count; ++i) {
+            R_UNLESS(requests[i].buffer != nullptr || requests[i].size == 0, fs::ResultNullptrArgument());
+            R_TRY(IStorage::CheckAccessRange(requests[i].offset, requests[i].size, m_size));
+        }
+
+        R_RETURN(m_base_file->ReadBatch(requests, count));
+    }
+
     Result FileStorage::Write(s64 offset, const void *buffer, size_t size) {
         /* Immediately succeed if there's nothing to write. */
         R_SUCCEED_IF(size == 0);
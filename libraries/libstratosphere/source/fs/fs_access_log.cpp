@@ -597,7 +597,331 @@ namespace ams::fs::impl {
             }
         }
 
+        constinit AccessLogBinaryOutputFunctionForTest g_binary_access_log_output_for_test = nullptr;
+
+        /* NOTE: Atmosphère extension. */
+        /* Binary access log: accesses are captured as fixed-size records in a lock-free ring, and batched out by a drainer thread. */
+        /* Batches are rendered back into the text format offline, by utilities/fs_access_log_decoder.py. */
+        class BinaryAccessLog {
+            NON_COPYABLE(BinaryAccessLog);
+            NON_MOVEABLE(BinaryAccessLog);
+            public:
+                static constexpr u32 BatchMagic   = util::FourCC<'F','S','B','L'>::Code;
+                static constexpr u16 BatchVersion = 1;
+
+                static constexpr size_t RecordCount    = 512;
+                static constexpr size_t NameCountMax   = 0xFF;
+                static constexpr size_t NameLengthMax  = 62;
+                static constexpr size_t BatchRecordMax = 128;
+
+                static constexpr u8 InvalidNameId = 0xFF;
+
+                static constexpr size_t ThreadStackSize = 8_KB;
+
+                static constexpr TimeSpan DrainInterval = TimeSpan::FromMilliSeconds(100);
+
+                enum RecordFlag : u8 {
+                    RecordFlag_HasOffset = (1 << 0),
+                    RecordFlag_HasSize   = (1 << 1),
+                };
+
+                struct Record {
+                    s64 start_tick;
+                    s64 end_tick;
+                    u64 handle;
+                    s64 offset;
+                    u64 size;
+                    u32 result;
+                    u8 function_id;
+                    u8 priority_id;
+                    u8 flags;
+                    u8 reserved;
+                };
+                static_assert(util::is_pod<Record>::value && sizeof(Record) == 0x30);
+
+                struct BatchHeader {
+                    u32 magic;
+                    u16 version;
+                    u16 name_count;
+                    u32 record_count;
+                    u32 dropped_count;
+                    s64 tick_frequency;
+                };
+                static_assert(util::is_pod<BatchHeader>::value && sizeof(BatchHeader) == 0x18);
+
+                struct NameEntry {
+                    u16 id;
+                    char name[NameLengthMax];
+                };
+                static_assert(util::is_pod<NameEntry>::value && sizeof(NameEntry) == 0x40);
+
+                static constexpr size_t BatchBufferSize = sizeof(BatchHeader) + BatchRecordMax * sizeof(Record) + NameCountMax * sizeof(NameEntry);
+            private:
+                struct Slot {
+                    std::atomic<u64> sequence;
+                    Record record;
+                };
+            private:
+                std::atomic<bool> m_enabled;
+                std::atomic<bool> m_initialized;
+                os::SdkMutex m_initialization_mutex;
+                Slot *m_slots;
+                std::atomic<u64> m_enqueue_position;
+                std::atomic<u64> m_dequeue_position;
+                std::atomic<u32> m_dropped_count;
+                os::SdkMutex m_name_mutex;
+                std::atomic<size_t> m_name_count;
+                u32 m_name_hashes[NameCountMax];
+                char m_names[NameCountMax][NameLengthMax];
+                size_t m_emitted_name_count;
+                u8 *m_batch_buffer;
+                os::EventType m_event;
+                os::ThreadType m_thread;
+            public:
+                constexpr BinaryAccessLog() : m_enabled(false), m_initialized(false), m_initialization_mutex(), m_slots(nullptr), m_enqueue_position(0), m_dequeue_position(0), m_dropped_count(0), m_name_mutex(), m_name_count(0), m_name_hashes(), m_names(), m_emitted_name_count(0), m_batch_buffer(nullptr), m_event(), m_thread() { /* ... */ }
+
+                bool IsEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+                void SetEnabled(bool en) {
+                    /* Set up the ring and drainer on first enable. */
+                    if (en && !m_initialized.load(std::memory_order_acquire)) {
+                        std::scoped_lock lk(m_initialization_mutex);
+                        if (!m_initialized.load(std::memory_order_relaxed)) {
+                            if (!this->Initialize()) {
+                                return;
+                            }
+                            m_initialized.store(true, std::memory_order_release);
+                        }
+                    }
+
+                    m_enabled = en;
+
+                    /* Flush promptly when disabling. */
+                    if (!en && m_initialized.load(std::memory_order_acquire)) {
+                        os::SignalEvent(std::addressof(m_event));
+                    }
+                }
+
+                void Push(Result result, const char *priority, os::Tick start, os::Tick end, const char *name, const void *handle, const char *format, std::va_list vl) {
+                    /* Build the record. */
+                    Record record = {
+                        .start_tick  = start.GetInt64Value(),
+                        .end_tick    = end.GetInt64Value(),
+                        .handle      = static_cast<u64>(reinterpret_cast<uintptr_t>(handle)),
+                        .offset      = 0,
+                        .size        = 0,
+                        .result      = result.GetValue(),
+                        .function_id = this->GetNameId(name),
+                        .priority_id = this->GetNameId(priority),
+                        .flags       = 0,
+                        .reserved    = 0,
+                    };
+
+                    /* Capture the offset and size of accesses which have them; other arguments are only available in the text log. */
+                    constexpr const char OffsetAndSizeFormat[] = AMS_FS_IMPL_ACCESS_LOG_FORMAT_OFFSET_AND_SIZE;
+                    constexpr const char SizeFormat[]          = AMS_FS_IMPL_ACCESS_LOG_FORMAT_SIZE;
+                    if (std::strncmp(format, OffsetAndSizeFormat, sizeof(OffsetAndSizeFormat) - 1) == 0) {
+                        record.offset = va_arg(vl, s64);
+                        record.size   = va_arg(vl, size_t);
+                        record.flags  = RecordFlag_HasOffset | RecordFlag_HasSize;
+                    } else if (std::strncmp(format, SizeFormat, sizeof(SizeFormat) - 1) == 0) {
+                        record.size   = static_cast<u64>(va_arg(vl, s64));
+                        record.flags  = RecordFlag_HasSize;
+                    }
+
+                    /* Claim a slot. */
+                    u64 position = m_enqueue_position.load(std::memory_order_relaxed);
+                    Slot *slot;
+                    while (true) {
+                        slot = std::addressof(m_slots[position % RecordCount]);
+
+                        const u64 sequence = slot->sequence.load(std::memory_order_acquire);
+                        if (sequence == position) {
+                            if (m_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                                break;
+                            }
+                        } else if (sequence < position) {
+                            /* The ring is full; drop the record rather than stall the access. */
+                            m_dropped_count.fetch_add(1, std::memory_order_relaxed);
+                            return;
+                        } else {
+                            position = m_enqueue_position.load(std::memory_order_relaxed);
+                        }
+                    }
+
+                    /* Publish the record. */
+                    slot->record = record;
+                    slot->sequence.store(position + 1, std::memory_order_release);
+
+                    /* Wake the drainer once the ring is half full. */
+                    if (position - m_dequeue_position.load(std::memory_order_relaxed) == RecordCount / 2) {
+                        os::SignalEvent(std::addressof(m_event));
+                    }
+                }
+            private:
+                bool Initialize() {
+                    /* Allocate the ring, the batch buffer, and the drainer's stack together. */
+                    constexpr size_t SlotsSize  = util::AlignUp(sizeof(Slot) * RecordCount, os::ThreadStackAlignment);
+                    constexpr size_t BatchSize  = util::AlignUp(BatchBufferSize, os::ThreadStackAlignment);
+                    constexpr size_t MemorySize = SlotsSize + BatchSize + ThreadStackSize + os::ThreadStackAlignment;
+
+                    void *memory = fs::impl::Allocate(MemorySize);
+                    if (memory == nullptr) {
+                        return false;
+                    }
+                    auto memory_guard = SCOPE_GUARD { fs::impl::Deallocate(memory, MemorySize); };
+
+                    u8 *aligned = reinterpret_cast<u8 *>(util::AlignUp(reinterpret_cast<uintptr_t>(memory), os::ThreadStackAlignment));
+
+                    /* Set up the ring. */
+                    m_slots = reinterpret_cast<Slot *>(aligned);
+                    for (size_t i = 0; i < RecordCount; ++i) {
+                        std::construct_at(std::addressof(m_slots[i].sequence), i);
+                    }
+
+                    m_batch_buffer = aligned + SlotsSize;
+
+                    /* Start the drainer. */
+                    os::InitializeEvent(std::addressof(m_event), false, os::EventClearMode_AutoClear);
+                    if (R_FAILED(os::CreateThread(std::addressof(m_thread), DrainThreadEntry, this, aligned + SlotsSize + BatchSize, ThreadStackSize, os::LowestThreadPriority))) {
+                        os::FinalizeEvent(std::addressof(m_event));
+                        return false;
+                    }
+                    os::SetThreadNamePointer(std::addressof(m_thread), "fs.AccessLogDrainer");
+                    os::StartThread(std::addressof(m_thread));
+
+                    /* The memory lives for the rest of the process. */
+                    memory_guard.Cancel();
+                    return true;
+                }
+
+                static u32 HashName(const char *name) {
+                    /* FNV-1a, over as much of the name as we store. */
+                    u32 hash = 0x811C9DC5;
+                    for (size_t i = 0; i < NameLengthMax - 1 && name[i] != '\x00'; ++i) {
+                        hash = (hash ^ static_cast<u8>(name[i])) * 0x01000193;
+                    }
+                    return hash;
+                }
+
+                s32 FindNameId(const char *name, u32 hash, size_t start, size_t end) const {
+                    for (size_t i = start; i < end; ++i) {
+                        if (m_name_hashes[i] == hash && std::strncmp(m_names[i], name, NameLengthMax - 1) == 0) {
+                            return static_cast<s32>(i);
+                        }
+                    }
+
+                    return -1;
+                }
+
+                u8 GetNameId(const char *name) {
+                    /* Names may live in temporary buffers (e.g. priorities formatted by IdString), so intern them by content. */
+                    const u32 hash = HashName(name);
+
+                    /* Registered names are never modified, so they can be searched without the lock. */
+                    const size_t count = m_name_count.load(std::memory_order_acquire);
+                    if (const s32 id = this->FindNameId(name, hash, 0, count); id >= 0) {
+                        return static_cast<u8>(id);
+                    }
+
+                    /* Register the name, unless another thread beat us to it. */
+                    std::scoped_lock lk(m_name_mutex);
+
+                    const size_t cur_count = m_name_count.load(std::memory_order_relaxed);
+                    if (const s32 id = this->FindNameId(name, hash, count, cur_count); id >= 0) {
+                        return static_cast<u8>(id);
+                    }
+
+                    if (cur_count >= NameCountMax) {
+                        return InvalidNameId;
+                    }
+
+                    m_name_hashes[cur_count] = hash;
+                    util::Strlcpy(m_names[cur_count], name, static_cast<int>(NameLengthMax));
+                    m_name_count.store(cur_count + 1, std::memory_order_release);
+
+                    return static_cast<u8>(cur_count);
+                }
+
+                static void DrainThreadEntry(void *arg) {
+                    static_cast<BinaryAccessLog *>(arg)->DrainThreadFunction();
+                }
+
+                void DrainThreadFunction() {
+                    while (true) {
+                        os::TimedWaitEvent(std::addressof(m_event), DrainInterval);
+
+                        /* Output batches until the ring is empty. */
+                        while (this->Drain()) {
+                            /* ... */
+                        }
+                    }
+                }
+
+                bool Drain() {
+                    /* Build the batch: header, then records, then any names the decoder hasn't seen yet. */
+                    auto *header  = reinterpret_cast<BatchHeader *>(m_batch_buffer);
+                    auto *records = reinterpret_cast<Record *>(header + 1);
+
+                    /* Take as many records as fit in a batch. */
+                    u64 position = m_dequeue_position.load(std::memory_order_relaxed);
+                    u32 record_count = 0;
+                    while (record_count < BatchRecordMax) {
+                        Slot &slot = m_slots[position % RecordCount];
+                        if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+                            break;
+                        }
+
+                        records[record_count++] = slot.record;
+                        slot.sequence.store(position + RecordCount, std::memory_order_release);
+                        m_dequeue_position.store(++position, std::memory_order_relaxed);
+                    }
+
+                    const u32 dropped_count = m_dropped_count.exchange(0, std::memory_order_relaxed);
+                    if (record_count == 0 && dropped_count == 0) {
+                        return false;
+                    }
+
+                    /* Names are interned before the records that use them are published, so every name we need is visible now. */
+                    auto *names = reinterpret_cast<NameEntry *>(records + record_count);
+                    u16 name_count = 0;
+                    const size_t registered_name_count = m_name_count.load(std::memory_order_acquire);
+                    while (m_emitted_name_count < registered_name_count) {
+                        auto &entry = names[name_count++];
+                        entry.id = static_cast<u16>(m_emitted_name_count);
+                        std::memcpy(entry.name, m_names[m_emitted_name_count++], sizeof(entry.name));
+                    }
+
+                    *header = {
+                        .magic          = BatchMagic,
+                        .version        = BatchVersion,
+                        .name_count     = name_count,
+                        .record_count   = record_count,
+                        .dropped_count  = dropped_count,
+                        .tick_frequency = os::GetSystemTickFrequency(),
+                    };
+
+                    /* Output the batch. */
+                    const size_t batch_size = sizeof(BatchHeader) + record_count * sizeof(Record) + name_count * sizeof(NameEntry);
+                    if (const auto output_for_test = g_binary_access_log_output_for_test; output_for_test != nullptr) {
+                        output_for_test(m_batch_buffer, batch_size);
+                    } else if ((g_global_access_log_mode & AccessLogMode_SdCard) != 0) {
+                        static_cast<void>(OutputAccessLogToSdCardImpl(reinterpret_cast<const char *>(m_batch_buffer), batch_size));
+                    }
+
+                    return record_count == BatchRecordMax;
+                }
+        };
+
+        constinit BinaryAccessLog g_binary_access_log;
+
         void OutputAccessLog(Result result, const char *priority, os::Tick start, os::Tick end, const char *name, const void *handle, const char *format, std::va_list vl) {
+            /* If we're logging in binary, just capture a record. */
+            if (g_binary_access_log.IsEnabled()) {
+                g_binary_access_log.Push(result, priority, start, end, name, handle, format, vl);
+                return;
+            }
+
             /* Create a buffer to hold the log's input string. */
             int str_buffer_size = 1_KB;
             auto str_buffer = fs::impl::MakeUnique<char[]>(str_buffer_size);
@@ -908,3 +1232,15 @@ namespace ams::fs::impl {
     }
 
 }
+
+namespace ams::fs {
+
+    void SetLocalAccessLogBinaryMode(bool enabled) {
+        impl::g_binary_access_log.SetEnabled(enabled);
+    }
+
+    void SetLocalAccessLogBinaryOutputForTest(AccessLogBinaryOutputFunctionForTest func) {
+        impl::g_binary_access_log_output_for_test = func;
+    }
+
+}
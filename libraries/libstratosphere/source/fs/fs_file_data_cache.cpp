@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+#include "fs_file_data_cache.hpp"
+
+namespace ams::fs::impl {
+
+    namespace {
+
+        constexpr s32 InvalidIndex = -1;
+
+        constinit FileDataCache g_global_file_data_cache;
+
+    }
+
+    FileDataCache &GetGlobalFileDataCache() {
+        return g_global_file_data_cache;
+    }
+
+    void FileDataCache::Enable(void *buffer, size_t size) {
+        AMS_ABORT_UNLESS(buffer != nullptr);
+
+        std::scoped_lock lk(m_mutex);
+        AMS_ABORT_UNLESS(!this->IsEnabled());
+
+        /* Determine how many pages we can hold; each page needs its data, an entry, and at most two buckets. */
+        constexpr size_t PageCostSize = PageSize + sizeof(Entry) + 2 * sizeof(s32);
+        const size_t page_count = size > alignof(Entry) ? (size - alignof(Entry)) / PageCostSize : 0;
+        AMS_ABORT_UNLESS(0 < page_count && page_count <= static_cast<size_t>(std::numeric_limits<s32>::max() / 2));
+
+        /* Lay out the buffer as pages, then entries, then buckets. */
+        const uintptr_t pages   = reinterpret_cast<uintptr_t>(buffer);
+        const uintptr_t entries = util::AlignUp(pages + page_count * PageSize, alignof(Entry));
+        const uintptr_t buckets = entries + page_count * sizeof(Entry);
+
+        m_page_count   = static_cast<s32>(page_count);
+        m_bucket_count = static_cast<s32>(util::CeilingPowerOfTwo(page_count));
+        AMS_ASSERT(buckets + m_bucket_count * sizeof(s32) <= pages + size);
+
+        m_pages   = reinterpret_cast<u8 *>(pages);
+        m_entries = reinterpret_cast<Entry *>(entries);
+        m_buckets = reinterpret_cast<s32 *>(buckets);
+
+        /* Initialize the tables. */
+        for (s32 i = 0; i < m_page_count; ++i) {
+            std::construct_at(m_entries + i);
+            m_entries[i].next          = InvalidIndex;
+            m_entries[i].is_valid      = false;
+            m_entries[i].is_referenced = false;
+            m_entries[i].is_loading    = false;
+        }
+        std::fill(m_buckets, m_buckets + m_bucket_count, InvalidIndex);
+
+        m_clock_hand = 0;
+        ++m_generation;
+        m_is_enabled = true;
+    }
+
+    void FileDataCache::Disable() {
+        std::scoped_lock lk(m_mutex);
+        AMS_ABORT_UNLESS(this->IsEnabled());
+
+        /* Stop new reads from using the cache, and wait for any pages being loaded. */
+        m_is_enabled = false;
+        ++m_generation;
+        while (m_loading_count > 0) {
+            m_loading_cv.Wait(m_mutex);
+        }
+
+        /* Forget the buffer. */
+        m_pages        = nullptr;
+        m_entries      = nullptr;
+        m_buckets      = nullptr;
+        m_page_count   = 0;
+        m_bucket_count = 0;
+    }
+
+    Result FileDataCache::Read(size_t *out, fsa::IFile *file, const FileSystemAccessor *file_system, const FilePathHash &path_hash, s64 offset, void *buffer, size_t size, const ReadOption &option) {
+        AMS_ASSERT(out != nullptr);
+        AMS_ASSERT(file != nullptr);
+
+        /* Large reads gain little from the cache, and would evict everything else. */
+        if (size > ReadSizeMax) {
+            R_RETURN(file->Read(out, offset, buffer, size, option));
+        }
+
+        /* Validate the offset, as the file would. */
+        R_UNLESS(offset >= 0, fs::ResultOutOfRange());
+
+        /* Read page by page. */
+        u8 *dst = static_cast<u8 *>(buffer);
+        s64 cur_offset = offset;
+        size_t remaining = size;
+        while (remaining > 0) {
+            const s64 page_index     = cur_offset / static_cast<s64>(PageSize);
+            const size_t page_offset = static_cast<size_t>(cur_offset % static_cast<s64>(PageSize));
+            const size_t cur_size    = std::min(remaining, PageSize - page_offset);
+
+            size_t read_size;
+            R_TRY(this->ReadPage(std::addressof(read_size), file, file_system, path_hash, page_index, page_offset, dst, cur_size, option));
+
+            dst        += read_size;
+            cur_offset += read_size;
+            remaining  -= read_size;
+
+            /* A short read means we've reached the end of the file. */
+            if (read_size < cur_size) {
+                break;
+            }
+        }
+
+        *out = size - remaining;
+        R_SUCCEED();
+    }
+
+    Result FileDataCache::ReadPage(size_t *out, fsa::IFile *file, const FileSystemAccessor *file_system, const FilePathHash &path_hash, s64 page_index, size_t page_offset, void *buffer, size_t size, const ReadOption &option) {
+        const s64 page_file_offset = page_index * static_cast<s64>(PageSize);
+
+        /* Copies cached page data to the output, checking the offset as the file would. */
+        auto copy_from_page = [&](const u8 *page, size_t data_size) ALWAYS_INLINE_LAMBDA -> Result {
+            R_UNLESS(page_offset <= data_size, fs::ResultOutOfRange());
+
+            const size_t copy_size = std::min(size, data_size - page_offset);
+            std::memcpy(buffer, page + page_offset, copy_size);
+            *out = copy_size;
+            R_SUCCEED();
+        };
+
+        s32 index = InvalidIndex;
+        u64 generation = 0;
+        {
+            std::scoped_lock lk(m_mutex);
+
+            /* The cache may have been disabled since the caller checked. */
+            if (this->IsEnabled()) {
+                /* Serve hits under the lock, so that the page can't be evicted while we copy. */
+                if (const s32 found = this->Find(file_system, path_hash, page_index); found != InvalidIndex) {
+                    m_entries[found].is_referenced = true;
+                    R_RETURN(copy_from_page(this->GetPage(found), m_entries[found].data_size));
+                }
+
+                /* Get a page to load into, marking it as loading so that it isn't evicted. */
+                index = this->AcquireVictim();
+                if (index != InvalidIndex) {
+                    auto &entry = m_entries[index];
+                    entry.file_system = file_system;
+                    entry.path_hash   = path_hash;
+                    entry.page_index  = page_index;
+                    entry.is_loading  = true;
+                    ++m_loading_count;
+
+                    generation = m_generation;
+                }
+            }
+        }
+
+        /* If we couldn't get a page, read directly. */
+        if (index == InvalidIndex) {
+            R_RETURN(file->Read(out, page_file_offset + page_offset, buffer, size, option));
+        }
+
+        /* Load the page without holding the lock. */
+        size_t data_size = 0;
+        const Result result = file->Read(std::addressof(data_size), page_file_offset, this->GetPage(index), PageSize, option);
+
+        std::scoped_lock lk(m_mutex);
+
+        /* Release the page. */
+        auto &entry = m_entries[index];
+        entry.is_loading = false;
+        if ((--m_loading_count) == 0) {
+            m_loading_cv.Broadcast();
+        }
+
+        R_TRY(result);
+
+        /* Publish the page, unless it was invalidated while we loaded it or another thread beat us to it. */
+        if (generation == m_generation && this->Find(file_system, path_hash, page_index) == InvalidIndex) {
+            entry.data_size     = static_cast<u32>(data_size);
+            entry.is_referenced = true;
+            this->Insert(index);
+        }
+
+        /* Copy out the data we read. */
+        R_RETURN(copy_from_page(this->GetPage(index), data_size));
+    }
+
+    void FileDataCache::Invalidate(const FileSystemAccessor *file_system, const FilePathHash &path_hash, s64 offset, s64 size) {
+        AMS_ASSERT(offset >= 0);
+        AMS_ASSERT(size >= 0);
+
+        std::scoped_lock lk(m_mutex);
+
+        /* Ensure that any page being loaded is discarded. */
+        ++m_generation;
+        if (!this->IsEnabled() || size == 0) {
+            return;
+        }
+
+        /* If the range covers more pages than we hold, invalidate the whole file. */
+        const s64 begin_page = offset / static_cast<s64>(PageSize);
+        const s64 end_page   = util::DivideUp(offset + size, static_cast<s64>(PageSize));
+        if (end_page - begin_page > m_page_count) {
+            for (s32 i = 0; i < m_page_count; ++i) {
+                if (m_entries[i].is_valid && m_entries[i].file_system == file_system && m_entries[i].path_hash == path_hash) {
+                    this->Remove(i);
+                }
+            }
+        } else {
+            for (s64 page = begin_page; page < end_page; ++page) {
+                if (const s32 index = this->Find(file_system, path_hash, page); index != InvalidIndex) {
+                    this->Remove(index);
+                }
+            }
+        }
+    }
+
+    void FileDataCache::Invalidate(const FileSystemAccessor *file_system, const FilePathHash &path_hash) {
+        std::scoped_lock lk(m_mutex);
+
+        /* Ensure that any page being loaded is discarded. */
+        ++m_generation;
+
+        for (s32 i = 0; i < m_page_count; ++i) {
+            if (m_entries[i].is_valid && m_entries[i].file_system == file_system && m_entries[i].path_hash == path_hash) {
+                this->Remove(i);
+            }
+        }
+    }
+
+    void FileDataCache::Purge(const FileSystemAccessor *file_system) {
+        std::scoped_lock lk(m_mutex);
+
+        /* Ensure that any page being loaded is discarded. */
+        ++m_generation;
+
+        for (s32 i = 0; i < m_page_count; ++i) {
+            if (m_entries[i].is_valid && m_entries[i].file_system == file_system) {
+                this->Remove(i);
+            }
+        }
+    }
+
+    s32 FileDataCache::GetBucketIndex(const FileSystemAccessor *file_system, const FilePathHash &path_hash, s64 page_index) const {
+        AMS_ASSERT(m_bucket_count > 0);
+
+        u64 key;
+        std::memcpy(std::addressof(key), path_hash.data, sizeof(key));
+        key ^= static_cast<u64>(reinterpret_cast<uintptr_t>(file_system));
+        key ^= static_cast<u64>(page_index) * UINT64_C(0x9E3779B97F4A7C15);
+        key *= UINT64_C(0xBF58476D1CE4E5B9);
+
+        return static_cast<s32>((key >> 32) & static_cast<u64>(m_bucket_count - 1));
+    }
+
+    s32 FileDataCache::Find(const FileSystemAccessor *file_system, const FilePathHash &path_hash, s64 page_index) const {
+        AMS_ASSERT(m_mutex.IsLockedByCurrentThread());
+
+        for (s32 index = m_buckets[this->GetBucketIndex(file_system, path_hash, page_index)]; index != InvalidIndex; index = m_entries[index].next) {
+            const auto &entry = m_entries[index];
+            if (entry.page_index == page_index && entry.file_system == file_system && entry.path_hash == path_hash) {
+                return index;
+            }
+        }
+
+        return InvalidIndex;
+    }
+
+    void FileDataCache::Insert(s32 index) {
+        AMS_ASSERT(m_mutex.IsLockedByCurrentThread());
+
+        auto &entry = m_entries[index];
+        AMS_ASSERT(!entry.is_valid);
+
+        s32 &bucket = m_buckets[this->GetBucketIndex(entry.file_system, entry.path_hash, entry.page_index)];
+        entry.next     = bucket;
+        entry.is_valid = true;
+        bucket         = index;
+    }
+
+    void FileDataCache::Remove(s32 index) {
+        AMS_ASSERT(m_mutex.IsLockedByCurrentThread());
+
+        auto &entry = m_entries[index];
+        AMS_ASSERT(entry.is_valid);
+
+        /* Unlink the entry from its bucket. */
+        s32 *link = std::addressof(m_buckets[this->GetBucketIndex(entry.file_system, entry.path_hash, entry.page_index)]);
+        while (*link != index) {
+            AMS_ASSERT(*link != InvalidIndex);
+            link = std::addressof(m_entries[*link].next);
+        }
+        *link = entry.next;
+
+        entry.next          = InvalidIndex;
+        entry.is_valid      = false;
+        entry.is_referenced = false;
+    }
+
+    s32 FileDataCache::AcquireVictim() {
+        AMS_ASSERT(m_mutex.IsLockedByCurrentThread());
+
+        /* Sweep the clock at most twice: the first pass may only clear reference bits. */
+        for (s32 i = 0; i < 2 * m_page_count; ++i) {
+            const s32 index = m_clock_hand;
+            m_clock_hand = (m_clock_hand + 1 < m_page_count) ? m_clock_hand + 1 : 0;
+
+            auto &entry = m_entries[index];
+            if (entry.is_loading) {
+                continue;
+            }
+
+            if (!entry.is_valid) {
+                return index;
+            }
+
+            if (entry.is_referenced) {
+                entry.is_referenced = false;
+                continue;
+            }
+
+            this->Remove(index);
+            return index;
+        }
+
+        return InvalidIndex;
+    }
+
+}
+
+namespace ams::fs {
+
+    void EnableGlobalFileDataCache(void *buffer, size_t size) {
+        impl::GetGlobalFileDataCache().Enable(buffer, size);
+    }
+
+    void DisableGlobalFileDataCache() {
+        impl::GetGlobalFileDataCache().Disable();
+    }
+
+}
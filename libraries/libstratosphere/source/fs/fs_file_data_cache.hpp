@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include "fs_file_path_hash.hpp"
+
+namespace ams::fs::impl {
+
+    class FileSystemAccessor;
+
+    /* NOTE: Atmosphère extension. */
+    /* Page-granular cache of file data, shared by every mount which allows data caching. */
+    class FileDataCache {
+        NON_COPYABLE(FileDataCache);
+        NON_MOVEABLE(FileDataCache);
+        public:
+            static constexpr size_t PageSize    = 16_KB;
+            static constexpr size_t ReadSizeMax = 4 * PageSize;
+        private:
+            struct Entry {
+                const FileSystemAccessor *file_system;
+                FilePathHash path_hash;
+                s64 page_index;
+                s32 next;
+                u32 data_size;
+                bool is_valid;
+                bool is_referenced;
+                bool is_loading;
+            };
+        private:
+            mutable os::SdkMutex m_mutex;
+            os::SdkConditionVariable m_loading_cv;
+            u8 *m_pages;
+            Entry *m_entries;
+            s32 *m_buckets;
+            s32 m_page_count;
+            s32 m_bucket_count;
+            s32 m_clock_hand;
+            s32 m_loading_count;
+            u64 m_generation;
+            std::atomic<bool> m_is_enabled;
+        public:
+            constexpr FileDataCache() : m_mutex(), m_loading_cv(), m_pages(nullptr), m_entries(nullptr), m_buckets(nullptr), m_page_count(0), m_bucket_count(0), m_clock_hand(0), m_loading_count(0), m_generation(0), m_is_enabled(false) { /* ... */ }
+
+            void Enable(void *buffer, size_t size);
+            void Disable();
+
+            bool IsEnabled() const { return m_is_enabled.load(std::memory_order_relaxed); }
+
+            Result Read(size_t *out, fsa::IFile *file, const FileSystemAccessor *file_system, const FilePathHash &path_hash, s64 offset, void *buffer, size_t size, const ReadOption &option);
+
+            void Invalidate(const FileSystemAccessor *file_system, const FilePathHash &path_hash, s64 offset, s64 size);
+            void Invalidate(const FileSystemAccessor *file_system, const FilePathHash &path_hash);
+            void Purge(const FileSystemAccessor *file_system);
+        private:
+            Result ReadPage(size_t *out, fsa::IFile *file, const FileSystemAccessor *file_system, const FilePathHash &path_hash, s64 page_index, size_t page_offset, void *buffer, size_t size, const ReadOption &option);
+
+            u8 *GetPage(s32 index) const {
+                AMS_ASSERT(0 <= index && index < m_page_count);
+                return m_pages + static_cast<size_t>(index) * PageSize;
+            }
+
+            s32 GetBucketIndex(const FileSystemAccessor *file_system, const FilePathHash &path_hash, s64 page_index) const;
+            s32 Find(const FileSystemAccessor *file_system, const FilePathHash &path_hash, s64 page_index) const;
+            void Insert(s32 index);
+            void Remove(s32 index);
+            s32 AcquireVictim();
+    };
+
+    FileDataCache &GetGlobalFileDataCache();
+
+}
@@ -18,7 +18,8 @@
 
 namespace ams::fs::impl {
 
-    constexpr inline size_t FilePathHashSize = 4;
+    /* NOTE: Atmosphère uses a wider hash than official, as the global file data cache trusts it to identify a file. */
+    constexpr inline size_t FilePathHashSize = 16;
 
     struct FilePathHash : public Newable {
         u8 data[FilePathHashSize];
@@ -33,4 +34,12 @@ namespace ams::fs::impl {
         return !(lhs == rhs);
     }
 
+    inline void GenerateFilePathHash(FilePathHash *out, const char *path) {
+        u8 hash[crypto::Sha256Generator::HashSize];
+        crypto::GenerateSha256(hash, sizeof(hash), path, std::strlen(path));
+
+        static_assert(FilePathHashSize <= sizeof(hash));
+        std::memcpy(out->data, hash, FilePathHashSize);
+    }
+
 }
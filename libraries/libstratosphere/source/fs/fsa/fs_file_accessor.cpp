@@ -16,13 +16,14 @@
 #include <stratosphere.hpp>
 #include "../fs_scoped_setter.hpp"
 #include "../fs_file_path_hash.hpp"
+#include "../fs_file_data_cache.hpp"
 #include "fs_file_accessor.hpp"
 #include "fs_filesystem_accessor.hpp"
 
 namespace ams::fs::impl {
 
     FileAccessor::FileAccessor(std::unique_ptr<fsa::IFile>&& f, FileSystemAccessor *p, OpenMode mode)
-        : m_impl(std::move(f)), m_parent(p), m_write_state(WriteState::None), m_write_result(ResultSuccess()), m_open_mode(mode)
+        : m_impl(std::move(f)), m_parent(p), m_write_state(WriteState::None), m_write_result(ResultSuccess()), m_open_mode(mode), m_file_path_hash(), m_path_hash_index(-1)
     {
         /* ... */
     }
@@ -39,10 +40,20 @@ namespace ams::fs::impl {
         }
     }
 
+    void FileAccessor::SetFilePathHash(std::unique_ptr<FilePathHash>&& file_path_hash, s32 index) {
+        m_file_path_hash  = std::move(file_path_hash);
+        m_path_hash_index = index;
+    }
+
     Result FileAccessor::ReadWithCacheAccessLog(size_t *out, s64 offset, void *buf, size_t size, const ReadOption &option, bool use_path_cache, bool use_data_cache) {
-        /* TODO */
-        AMS_UNUSED(out, offset, buf, size, option, use_path_cache, use_data_cache);
-        AMS_ABORT();
+        AMS_ASSERT(use_path_cache && use_data_cache);
+        AMS_UNUSED(use_path_cache, use_data_cache);
+
+        /* Get a handle to this file for use in logging. */
+        FileHandle handle = { this };
+
+        /* Read through the global file data cache. */
+        R_RETURN(AMS_FS_IMPL_ACCESS_LOG_WITH_NAME(GetGlobalFileDataCache().Read(out, m_impl.get(), m_parent, *m_file_path_hash, offset, buf, size, option), handle, "ReadFile", AMS_FS_IMPL_ACCESS_LOG_FORMAT_READ_FILE(out, offset, size)));
     }
 
     Result FileAccessor::ReadWithoutCacheAccessLog(size_t *out, s64 offset, void *buf, size_t size, const ReadOption &option) {
@@ -56,12 +67,11 @@ namespace ams::fs::impl {
         /* Fail after a write fails. */
         R_UNLESS(R_SUCCEEDED(m_write_result), AMS_FS_IMPL_ACCESS_LOG_WITH_NAME(m_write_result, handle, "ReadFile", AMS_FS_IMPL_ACCESS_LOG_FORMAT_READ_FILE(out, offset, size)));
 
-        /* TODO: Support cache. */
+        /* Determine whether we can read via the cache. */
         const bool use_path_cache = m_parent != nullptr && m_file_path_hash != nullptr;
-        const bool use_data_cache = /* TODO */false && m_parent != nullptr && m_parent->IsFileDataCacheAttachable();
+        const bool use_data_cache = m_parent != nullptr && m_parent->IsFileDataCacheAttachable() && GetGlobalFileDataCache().IsEnabled();
 
-        if (use_path_cache && use_data_cache && false) {
-            /* TODO */
+        if (use_path_cache && use_data_cache) {
             R_RETURN(this->ReadWithCacheAccessLog(out, offset, buf, size, option, use_path_cache, use_data_cache));
         } else {
             R_RETURN(AMS_FS_IMPL_ACCESS_LOG_WITH_NAME(this->ReadWithoutCacheAccessLog(out, offset, buf, size, option), handle, "ReadFile", AMS_FS_IMPL_ACCESS_LOG_FORMAT_READ_FILE(out, offset, size)));
@@ -72,12 +82,32 @@ namespace ams::fs::impl {
         /* Fail after a write fails. */
         R_TRY(m_write_result);
 
+        /* If the write may extend the file, determine where the file currently ends. */
+        /* The cached page holding the old end of file is short, and becomes stale once the file grows past it. */
+        const bool use_data_cache = m_file_path_hash != nullptr && GetGlobalFileDataCache().IsEnabled();
+        s64 old_size = -1;
+        if (use_data_cache && (m_open_mode & OpenMode_AllowAppend) != 0) {
+            if (R_FAILED(m_impl->GetSize(std::addressof(old_size)))) {
+                old_size = -1;
+            }
+        }
+
         auto setter = MakeScopedSetter(m_write_state, WriteState::Failed);
-        if (m_file_path_hash != nullptr && /* TODO */ false) {
-            /* TODO */
-            AMS_ABORT();
-        } else {
-            R_TRY(this->UpdateLastResult(m_impl->Write(offset, buf, size, option)));
+        R_TRY(this->UpdateLastResult(m_impl->Write(offset, buf, size, option)));
+
+        /* Invalidate any cached data for the range we wrote. */
+        if (m_file_path_hash != nullptr) {
+            auto &cache = GetGlobalFileDataCache();
+            cache.Invalidate(m_parent, *m_file_path_hash, offset, static_cast<s64>(size));
+
+            /* If the file may have grown, also invalidate the old end of file page (or, if we don't know where that was, the whole file). */
+            if ((m_open_mode & OpenMode_AllowAppend) != 0) {
+                if (old_size < 0) {
+                    cache.Invalidate(m_parent, *m_file_path_hash);
+                } else if (offset + static_cast<s64>(size) > old_size) {
+                    cache.Invalidate(m_parent, *m_file_path_hash, old_size, 1);
+                }
+            }
         }
 
         setter.Set(option.HasFlushFlag() ? WriteState::None : WriteState::NeedsFlush);
@@ -105,8 +135,9 @@ namespace ams::fs::impl {
 
         R_TRY(this->UpdateLastResult(m_impl->SetSize(size)));
 
+        /* Invalidate any cached data for the file. */
         if (m_file_path_hash != nullptr) {
-            /* TODO: invalidate path cache */
+            GetGlobalFileDataCache().Invalidate(m_parent, *m_file_path_hash);
         }
 
         setter.Set(old_write_state);
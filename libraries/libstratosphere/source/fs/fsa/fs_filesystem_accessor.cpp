@@ -17,6 +17,8 @@
 #include "fs_file_accessor.hpp"
 #include "fs_directory_accessor.hpp"
 #include "fs_filesystem_accessor.hpp"
+#include "../fs_file_path_hash.hpp"
+#include "../fs_file_data_cache.hpp"
 
 namespace ams::fs::impl {
 
@@ -77,6 +79,9 @@ namespace ams::fs::impl {
         if (m_path_cache_attached) {
             /* TODO: Invalidate path cache */
         }
+
+        /* Ensure no cached data outlives us. */
+        this->PurgeFileDataCache();
     }
 
     Result FileSystemAccessor::GetCommonMountName(char *dst, size_t dst_size) const {
@@ -101,6 +106,21 @@ namespace ams::fs::impl {
         Remove(m_open_dir_list, d);
     }
 
+    void FileSystemAccessor::InvalidateFileDataCache(const fs::Path &path) {
+        if (m_data_cache_attachable) {
+            FilePathHash path_hash;
+            GenerateFilePathHash(std::addressof(path_hash), path.GetString());
+
+            GetGlobalFileDataCache().Invalidate(this, path_hash);
+        }
+    }
+
+    void FileSystemAccessor::PurgeFileDataCache() {
+        if (m_data_cache_attachable) {
+            GetGlobalFileDataCache().Purge(this);
+        }
+    }
+
     Result FileSystemAccessor::SetUpPath(fs::Path *out, const char *p) {
         /* Initialize the path appropriately. */
         bool normalized;
@@ -145,6 +165,7 @@ namespace ams::fs::impl {
         fs::Path normalized_path;
         R_TRY(this->SetUpPath(std::addressof(normalized_path), path));
 
+        ON_SCOPE_EXIT { this->InvalidateFileDataCache(normalized_path); };
         R_RETURN(m_impl->DeleteFile(normalized_path));
     }
 
@@ -169,6 +190,7 @@ namespace ams::fs::impl {
         fs::Path normalized_path;
         R_TRY(this->SetUpPath(std::addressof(normalized_path), path));
 
+        ON_SCOPE_EXIT { this->PurgeFileDataCache(); };
         R_RETURN(m_impl->DeleteDirectoryRecursively(normalized_path));
     }
 
@@ -179,6 +201,11 @@ namespace ams::fs::impl {
         R_TRY(this->SetUpPath(std::addressof(normalized_old_path), old_path));
         R_TRY(this->SetUpPath(std::addressof(normalized_new_path), new_path));
 
+        ON_SCOPE_EXIT {
+            this->InvalidateFileDataCache(normalized_old_path);
+            this->InvalidateFileDataCache(normalized_new_path);
+        };
+
         if (m_path_cache_attached) {
             /* TODO: Path cache */
             R_TRY(m_impl->RenameFile(normalized_old_path, normalized_new_path));
@@ -196,6 +223,8 @@ namespace ams::fs::impl {
         R_TRY(this->SetUpPath(std::addressof(normalized_old_path), old_path));
         R_TRY(this->SetUpPath(std::addressof(normalized_new_path), new_path));
 
+        ON_SCOPE_EXIT { this->PurgeFileDataCache(); };
+
         if (m_path_cache_attached) {
             /* TODO: Path cache */
             R_TRY(m_impl->RenameDirectory(normalized_old_path, normalized_new_path));
@@ -238,6 +267,15 @@ namespace ams::fs::impl {
             }
         }
 
+        /* If our data may be cached, identify the file by its path. */
+        if (m_data_cache_attachable) {
+            std::unique_ptr<FilePathHash> file_path_hash(new FilePathHash);
+            if (file_path_hash != nullptr) {
+                GenerateFilePathHash(file_path_hash.get(), normalized_path.GetString());
+                accessor->SetFilePathHash(std::move(file_path_hash), -1);
+            }
+        }
+
         out_file->reset(accessor);
         R_SUCCEED();
     }
@@ -291,6 +329,7 @@ namespace ams::fs::impl {
         fs::Path normalized_path;
         R_TRY(this->SetUpPath(std::addressof(normalized_path), path));
 
+        ON_SCOPE_EXIT { this->PurgeFileDataCache(); };
         R_RETURN(m_impl->CleanDirectoryRecursively(normalized_path));
     }
 
@@ -94,6 +94,9 @@ namespace ams::fs::impl {
         private:
             void NotifyCloseFile(FileAccessor *f);
             void NotifyCloseDirectory(DirectoryAccessor *d);
+
+            void InvalidateFileDataCache(const fs::Path &path);
+            void PurgeFileDataCache();
         public:
             Result SetUpPath(fs::Path *out, const char *p);
     };
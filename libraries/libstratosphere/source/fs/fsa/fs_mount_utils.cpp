@@ -17,6 +17,7 @@
 #include "fs_filesystem_accessor.hpp"
 #include "fs_mount_utils.hpp"
 #include "fs_user_mount_table.hpp"
+#include "../fs_file_data_cache.hpp"
 
 namespace ams::fs::impl {
 
@@ -133,7 +134,7 @@ namespace ams::fs::impl {
         R_TRY(impl::Find(std::addressof(accessor), name));
 
         if (accessor->IsFileDataCacheAttachable()) {
-            /* TODO: Data cache purge */
+            impl::GetGlobalFileDataCache().Purge(accessor);
         }
 
         impl::Unregister(name);
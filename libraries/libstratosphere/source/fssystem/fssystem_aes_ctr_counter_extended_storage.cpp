@@ -191,69 +191,44 @@ namespace ams::fssystem {
         /* Read the data. */
         R_TRY(m_data_storage.Read(offset, buffer, size));
 
-        /* Temporarily increase our thread priority. */
-        ScopedThreadPriorityChanger cp(+1, ScopedThreadPriorityChanger::Mode::Relative);
-
-        /* Find the offset in our tree. */
-        BucketTree::Visitor visitor;
-        R_TRY(m_table.Find(std::addressof(visitor), offset));
-        {
-            const auto entry_offset = visitor.Get<Entry>()->GetOffset();
-            R_UNLESS(util::IsAligned(entry_offset, BlockSize),                   fs::ResultInvalidAesCtrCounterExtendedEntryOffset());
-            R_UNLESS(0 <= entry_offset && table_offsets.IsInclude(entry_offset), fs::ResultInvalidAesCtrCounterExtendedEntryOffset());
-        }
+        /* Decrypt the data. */
+        R_RETURN(this->DecryptInPlace(table_offsets, offset, buffer, size));
+    }
 
-        /* Prepare to read in chunks. */
-        u8 *cur_data = static_cast<u8 *>(buffer);
-        auto cur_offset = offset;
-        const auto end_offset = offset + static_cast<s64>(size);
+    Result AesCtrCounterExtendedStorage::ReadBatch(const fs::ReadRequest *requests, s32 count) {
+        /* Validate preconditions. */
+        AMS_ASSERT(this->IsInitialized());
 
-        while (cur_offset < end_offset) {
-            /* Get the current entry. */
-            const auto cur_entry = *visitor.Get<Entry>();
+        /* Allow empty batches. */
+        R_SUCCEED_IF(count == 0);
+        R_UNLESS(requests != nullptr, fs::ResultNullptrArgument());
 
-            /* Get and validate the entry's offset. */
-            const auto cur_entry_offset = cur_entry.GetOffset();
-            R_UNLESS(cur_entry_offset <= cur_offset, fs::ResultInvalidAesCtrCounterExtendedEntryOffset());
+        BucketTree::Offsets table_offsets;
+        R_TRY(m_table.GetOffsets(std::addressof(table_offsets)));
 
-            /* Get and validate the next entry offset. */
-            s64 next_entry_offset;
-            if (visitor.CanMoveNext()) {
-                R_TRY(visitor.MoveNext());
-                next_entry_offset = visitor.Get<Entry>()->GetOffset();
-                R_UNLESS(table_offsets.IsInclude(next_entry_offset), fs::ResultInvalidAesCtrCounterExtendedEntryOffset());
-            } else {
-                next_entry_offset = table_offsets.end_offset;
+        /* Validate each request, as Read would. */
+        for (s32 i = 0; i < count; ++i) {
+            const auto &request = requests[i];
+            if (request.size == 0) {
+                continue;
             }
-            R_UNLESS(util::IsAligned(next_entry_offset, BlockSize), fs::ResultInvalidAesCtrCounterExtendedEntryOffset());
-            R_UNLESS(cur_offset < next_entry_offset,                fs::ResultInvalidAesCtrCounterExtendedEntryOffset());
-
-            /* Get the offset of the entry in the data we read. */
-            const auto data_offset = cur_offset - cur_entry_offset;
-            const auto data_size   = (next_entry_offset - cur_entry_offset) - data_offset;
-            AMS_ASSERT(data_size > 0);
 
-            /* Determine how much is left. */
-            const auto remaining_size = end_offset - cur_offset;
-            const auto cur_size       = static_cast<size_t>(std::min(remaining_size, data_size));
-            AMS_ASSERT(cur_size <= size);
+            AMS_ASSERT(request.offset >= 0);
+            R_UNLESS(request.buffer != nullptr,                  fs::ResultNullptrArgument());
+            R_UNLESS(util::IsAligned(request.offset, BlockSize), fs::ResultInvalidOffset());
+            R_UNLESS(util::IsAligned(request.size, BlockSize),   fs::ResultInvalidSize());
 
-            /* If necessary, perform decryption. */
-            if (cur_entry.encryption_value == Entry::Encryption::Encrypted) {
-                /* Make the CTR for the data we're decrypting. */
-                const auto counter_offset = m_counter_offset + cur_entry_offset + data_offset;
-                NcaAesCtrUpperIv upper_iv = { .part = { .generation = static_cast<u32>(cur_entry.generation), .secure_value = m_secure_value } };
+            R_UNLESS(table_offsets.IsInclude(request.offset, request.size), fs::ResultOutOfRange());
+        }
 
-                u8 iv[IvSize];
-                AesCtrStorageByPointer::MakeIv(iv, IvSize, upper_iv.value, counter_offset);
+        /* Read all the data at once. */
+        R_TRY(m_data_storage.ReadBatch(requests, count));
 
-                /* Decrypt. */
-                m_decryptor->Decrypt(cur_data, cur_size, m_key, KeySize, iv, IvSize);
+        /* Decrypt each request. */
+        for (s32 i = 0; i < count; ++i) {
+            if (requests[i].size > 0) {
+                R_TRY(this->DecryptInPlace(table_offsets, requests[i].offset, requests[i].buffer, requests[i].size));
             }
-
-            /* Advance. */
-            cur_data   += cur_size;
-            cur_offset += cur_size;
         }
 
         R_SUCCEED();
@@ -361,4 +336,73 @@ namespace ams::fssystem {
         }
     }
 
+    Result AesCtrCounterExtendedStorage::DecryptInPlace(const BucketTree::Offsets &table_offsets, s64 offset, void *buffer, size_t size) {
+        /* Temporarily increase our thread priority. */
+        ScopedThreadPriorityChanger cp(+1, ScopedThreadPriorityChanger::Mode::Relative);
+
+        /* Find the offset in our tree. */
+        BucketTree::Visitor visitor;
+        R_TRY(m_table.Find(std::addressof(visitor), offset));
+        {
+            const auto entry_offset = visitor.Get<Entry>()->GetOffset();
+            R_UNLESS(util::IsAligned(entry_offset, BlockSize),                   fs::ResultInvalidAesCtrCounterExtendedEntryOffset());
+            R_UNLESS(0 <= entry_offset && table_offsets.IsInclude(entry_offset), fs::ResultInvalidAesCtrCounterExtendedEntryOffset());
+        }
+
+        /* Prepare to read in chunks. */
+        u8 *cur_data = static_cast<u8 *>(buffer);
+        auto cur_offset = offset;
+        const auto end_offset = offset + static_cast<s64>(size);
+
+        while (cur_offset < end_offset) {
+            /* Get the current entry. */
+            const auto cur_entry = *visitor.Get<Entry>();
+
+            /* Get and validate the entry's offset. */
+            const auto cur_entry_offset = cur_entry.GetOffset();
+            R_UNLESS(cur_entry_offset <= cur_offset, fs::ResultInvalidAesCtrCounterExtendedEntryOffset());
+
+            /* Get and validate the next entry offset. */
+            s64 next_entry_offset;
+            if (visitor.CanMoveNext()) {
+                R_TRY(visitor.MoveNext());
+                next_entry_offset = visitor.Get<Entry>()->GetOffset();
+                R_UNLESS(table_offsets.IsInclude(next_entry_offset), fs::ResultInvalidAesCtrCounterExtendedEntryOffset());
+            } else {
+                next_entry_offset = table_offsets.end_offset;
+            }
+            R_UNLESS(util::IsAligned(next_entry_offset, BlockSize), fs::ResultInvalidAesCtrCounterExtendedEntryOffset());
+            R_UNLESS(cur_offset < next_entry_offset,                fs::ResultInvalidAesCtrCounterExtendedEntryOffset());
+
+            /* Get the offset of the entry in the data we read. */
+            const auto data_offset = cur_offset - cur_entry_offset;
+            const auto data_size   = (next_entry_offset - cur_entry_offset) - data_offset;
+            AMS_ASSERT(data_size > 0);
+
+            /* Determine how much is left. */
+            const auto remaining_size = end_offset - cur_offset;
+            const auto cur_size       = static_cast<size_t>(std::min(remaining_size, data_size));
+            AMS_ASSERT(cur_size <= size);
+
+            /* If necessary, perform decryption. */
+            if (cur_entry.encryption_value == Entry::Encryption::Encrypted) {
+                /* Make the CTR for the data we're decrypting. */
+                const auto counter_offset = m_counter_offset + cur_entry_offset + data_offset;
+                NcaAesCtrUpperIv upper_iv = { .part = { .generation = static_cast<u32>(cur_entry.generation), .secure_value = m_secure_value } };
+
+                u8 iv[IvSize];
+                AesCtrStorageByPointer::MakeIv(iv, IvSize, upper_iv.value, counter_offset);
+
+                /* Decrypt. */
+                m_decryptor->Decrypt(cur_data, cur_size, m_key, KeySize, iv, IvSize);
+            }
+
+            /* Advance. */
+            cur_data   += cur_size;
+            cur_offset += cur_size;
+        }
+
+        R_SUCCEED();
+    }
+
 }
@@ -58,17 +58,37 @@ namespace ams::fssystem {
         /* Read the data. */
         R_TRY(m_base_storage->Read(offset, buffer, size));
 
-        /* Prepare to decrypt the data, with temporarily increased priority. */
-        ScopedThreadPriorityChanger cp(+1, ScopedThreadPriorityChanger::Mode::Relative);
+        /* Decrypt the data. */
+        R_RETURN(this->DecryptInPlace(offset, buffer, size));
+    }
 
-        /* Setup the counter. */
-        char ctr[IvSize];
-        std::memcpy(ctr, m_iv, IvSize);
-        AddCounter(ctr, IvSize, offset / BlockSize);
+    template<fs::PointerToStorage BasePointer>
+    Result AesCtrStorage<BasePointer>::ReadBatch(const fs::ReadRequest *requests, s32 count) {
+        /* Allow empty batches. */
+        R_SUCCEED_IF(count == 0);
+        R_UNLESS(requests != nullptr, fs::ResultNullptrArgument());
+
+        /* Validate each request, as Read would. */
+        for (s32 i = 0; i < count; ++i) {
+            const auto &request = requests[i];
+            if (request.size == 0) {
+                continue;
+            }
 
-        /* Decrypt, ensure we decrypt correctly. */
-        auto dec_size = crypto::DecryptAes128Ctr(buffer, size, m_key, KeySize, ctr, IvSize, buffer, size);
-        R_UNLESS(size == dec_size, fs::ResultUnexpectedInAesCtrStorageA());
+            R_UNLESS(request.buffer != nullptr,                  fs::ResultNullptrArgument());
+            R_UNLESS(util::IsAligned(request.offset, BlockSize), fs::ResultInvalidArgument());
+            R_UNLESS(util::IsAligned(request.size, BlockSize),   fs::ResultInvalidArgument());
+        }
+
+        /* Read all the data at once. */
+        R_TRY(m_base_storage->ReadBatch(requests, count));
+
+        /* Decrypt each request. */
+        for (s32 i = 0; i < count; ++i) {
+            if (requests[i].size > 0) {
+                R_TRY(this->DecryptInPlace(requests[i].offset, requests[i].buffer, requests[i].size));
+            }
+        }
 
         R_SUCCEED();
     }
@@ -189,6 +209,23 @@ namespace ams::fssystem {
         R_SUCCEED();
     }
 
+    template<fs::PointerToStorage BasePointer>
+    Result AesCtrStorage<BasePointer>::DecryptInPlace(s64 offset, void *buffer, size_t size) {
+        /* Prepare to decrypt the data, with temporarily increased priority. */
+        ScopedThreadPriorityChanger cp(+1, ScopedThreadPriorityChanger::Mode::Relative);
+
+        /* Setup the counter. */
+        char ctr[IvSize];
+        std::memcpy(ctr, m_iv, IvSize);
+        AddCounter(ctr, IvSize, offset / BlockSize);
+
+        /* Decrypt, ensure we decrypt correctly. */
+        auto dec_size = crypto::DecryptAes128Ctr(buffer, size, m_key, KeySize, ctr, IvSize, buffer, size);
+        R_UNLESS(size == dec_size, fs::ResultUnexpectedInAesCtrStorageA());
+
+        R_SUCCEED();
+    }
+
     template class AesCtrStorage<fs::IStorage *>;
     template class AesCtrStorage<std::shared_ptr<fs::IStorage>>;
 
@@ -41,40 +41,35 @@ namespace ams::fssystem {
         /* Read the data. */
         R_TRY(m_base_storage->Read(offset, buffer, size));
 
-        /* Temporarily increase our thread priority. */
-        ScopedThreadPriorityChanger cp(+1, ScopedThreadPriorityChanger::Mode::Relative);
-
-        /* Allocate a pooled buffer for decryption. */
-        PooledBuffer pooled_buffer;
-        pooled_buffer.AllocateParticularlyLarge(size, BlockSize);
-        AMS_ASSERT(pooled_buffer.GetSize() >= BlockSize);
-
-        /* Setup the counter. */
-        u8 ctr[IvSize];
-        std::memcpy(ctr, m_iv, IvSize);
-        AddCounter(ctr, IvSize, offset / BlockSize);
-
-        /* Setup tracking. */
-        size_t remaining_size = size;
-        s64 cur_offset = 0;
+        /* Decrypt the data. */
+        this->DecryptInPlace(offset, buffer, size);
+        R_SUCCEED();
+    }
 
-        while (remaining_size > 0) {
-            /* Get the current size to process. */
-            size_t cur_size = std::min(pooled_buffer.GetSize(), remaining_size);
-            char *dst = static_cast<char *>(buffer) + cur_offset;
+    Result AesCtrStorageExternal::ReadBatch(const fs::ReadRequest *requests, s32 count) {
+        /* Allow empty batches. */
+        R_SUCCEED_IF(count == 0);
+        R_UNLESS(requests != nullptr, fs::ResultNullptrArgument());
 
-            /* Decrypt into the temporary buffer */
-            m_decrypt_function(pooled_buffer.GetBuffer(), cur_size, m_key_index, m_key_generation, m_encrypted_key, KeySize, ctr, IvSize, dst, cur_size);
+        /* Validate each request, as Read would. */
+        for (s32 i = 0; i < count; ++i) {
+            const auto &request = requests[i];
+            if (request.size == 0) {
+                continue;
+            }
 
-            /* Copy to the destination. */
-            std::memcpy(dst, pooled_buffer.GetBuffer(), cur_size);
+            R_UNLESS(request.buffer != nullptr,                  fs::ResultNullptrArgument());
+            R_UNLESS(util::IsAligned(request.offset, BlockSize), fs::ResultInvalidArgument());
+            R_UNLESS(util::IsAligned(request.size,   BlockSize), fs::ResultInvalidArgument());
+        }
 
-            /* Update tracking. */
-            cur_offset     += cur_size;
-            remaining_size -= cur_size;
+        /* Read all the data at once. */
+        R_TRY(m_base_storage->ReadBatch(requests, count));
 
-            if (remaining_size > 0) {
-                AddCounter(ctr, IvSize, cur_size / BlockSize);
+        /* Decrypt each request. */
+        for (s32 i = 0; i < count; ++i) {
+            if (requests[i].size > 0) {
+                this->DecryptInPlace(requests[i].offset, requests[i].buffer, requests[i].size);
             }
         }
 
@@ -127,4 +122,43 @@ namespace ams::fssystem {
         R_THROW(fs::ResultUnsupportedSetSizeForAesCtrStorageExternal());
     }
 
+    void AesCtrStorageExternal::DecryptInPlace(s64 offset, void *buffer, size_t size) {
+        /* Temporarily increase our thread priority. */
+        ScopedThreadPriorityChanger cp(+1, ScopedThreadPriorityChanger::Mode::Relative);
+
+        /* Allocate a pooled buffer for decryption. */
+        PooledBuffer pooled_buffer;
+        pooled_buffer.AllocateParticularlyLarge(size, BlockSize);
+        AMS_ASSERT(pooled_buffer.GetSize() >= BlockSize);
+
+        /* Setup the counter. */
+        u8 ctr[IvSize];
+        std::memcpy(ctr, m_iv, IvSize);
+        AddCounter(ctr, IvSize, offset / BlockSize);
+
+        /* Setup tracking. */
+        size_t remaining_size = size;
+        s64 cur_offset = 0;
+
+        while (remaining_size > 0) {
+            /* Get the current size to process. */
+            size_t cur_size = std::min(pooled_buffer.GetSize(), remaining_size);
+            char *dst = static_cast<char *>(buffer) + cur_offset;
+
+            /* Decrypt into the temporary buffer */
+            m_decrypt_function(pooled_buffer.GetBuffer(), cur_size, m_key_index, m_key_generation, m_encrypted_key, KeySize, ctr, IvSize, dst, cur_size);
+
+            /* Copy to the destination. */
+            std::memcpy(dst, pooled_buffer.GetBuffer(), cur_size);
+
+            /* Update tracking. */
+            cur_offset     += cur_size;
+            remaining_size -= cur_size;
+
+            if (remaining_size > 0) {
+                AddCounter(ctr, IvSize, cur_size / BlockSize);
+            }
+        }
+    }
+
 }
@@ -210,6 +210,8 @@ namespace ams::fssystem {
 
     void BucketTree::Finalize() {
         if (this->IsInitialized()) {
+            this->FinalizeLookupIndex();
+
             m_node_storage    = fs::SubStorage();
             m_entry_storage   = fs::SubStorage();
             m_node_l1.Free(m_node_size);
@@ -250,9 +252,108 @@ namespace ams::fssystem {
         /* Reset our offsets. */
         m_offset_cache.is_initialized = false;
 
+        /* Discard any entry sets we've cached, since they may have been read from corrupted storage. */
+        if (this->IsLookupIndexEnabled()) {
+            this->ClearEntrySetCache();
+        }
+
         R_SUCCEED();
     }
 
+    Result BucketTree::InitializeLookupIndex(s32 entry_set_cache_count) {
+        AMS_ASSERT(this->IsInitialized());
+        AMS_ASSERT(!this->IsLookupIndexEnabled());
+        AMS_ASSERT(0 <= entry_set_cache_count && entry_set_cache_count <= LookupIndexEntrySetCacheCountMax);
+
+        /* Empty trees have nothing to index. */
+        R_SUCCEED_IF(this->IsEmpty());
+
+        IAllocator * const allocator = this->GetAllocator();
+
+        /* Allocate the offset table, padded out to whole cache lines. */
+        const s32 line_count    = util::DivideUp(m_entry_set_count, LookupIndex::OffsetCountPerLine);
+        const size_t table_size = line_count * LookupIndex::LineSize;
+
+        s64 * const offsets = static_cast<s64 *>(allocator->Allocate(table_size, LookupIndex::LineSize));
+        R_UNLESS(offsets != nullptr, fs::ResultBufferAllocationFailed());
+        ON_RESULT_FAILURE { allocator->Deallocate(offsets, table_size, LookupIndex::LineSize); };
+
+        /* Gather the start offset of each entry set from the L1 and L2 nodes. */
+        const auto * const node_l1 = m_node_l1.Get<Node>();
+        if (!this->IsExistL2()) {
+            /* The L1 node holds the entry set offsets directly. */
+            R_UNLESS(node_l1->GetCount() == m_entry_set_count, fs::ResultInvalidBucketTreeNodeEntryCount());
+            std::copy(node_l1->GetBegin(), node_l1->GetEnd(), offsets);
+        } else {
+            /* Entry sets which don't fit in the L2 nodes have their offsets stored after the L1 node's. */
+            if (this->IsExistOffsetL2OnL1()) {
+                std::copy(node_l1->GetEnd(), node_l1->GetBegin() + m_offset_count, offsets);
+            }
+
+            /* Read each L2 node, and copy its offsets. */
+            NodeBuffer node_l2;
+            R_UNLESS(node_l2.Allocate(allocator, m_node_size), fs::ResultBufferAllocationFailed());
+            ON_SCOPE_EXIT { node_l2.Free(m_node_size); };
+
+            for (s32 node_index = 0; node_index < node_l1->GetCount(); ++node_index) {
+                R_TRY(m_node_storage.Read((node_index + 1) * static_cast<s64>(m_node_size), node_l2.Get(), m_node_size));
+                R_TRY(node_l2->Verify(node_index, m_node_size, sizeof(s64)));
+
+                const auto * const node = node_l2.Get<Node>();
+                const s64 entry_set_index = this->GetEntrySetIndex(node_index, 0);
+                R_UNLESS(entry_set_index + node->GetCount() <= m_entry_set_count, fs::ResultInvalidBucketTreeNodeEntryCount());
+
+                std::copy(node->GetBegin(), node->GetEnd(), offsets + entry_set_index);
+            }
+        }
+
+        /* Validate that the offsets are strictly increasing, so that we can search them. */
+        R_UNLESS(offsets[0] == m_offset_cache.offsets.start_offset, fs::ResultInvalidBucketTreeEntrySetOffset());
+        for (s32 i = 1; i < m_entry_set_count; ++i) {
+            R_UNLESS(offsets[i - 1] < offsets[i], fs::ResultInvalidBucketTreeEntrySetOffset());
+        }
+        R_UNLESS(offsets[m_entry_set_count - 1] < m_offset_cache.offsets.end_offset, fs::ResultInvalidBucketTreeEntrySetOffset());
+
+        /* Pad the final line, so that it can always be compared in full. */
+        std::fill(offsets + m_entry_set_count, offsets + line_count * LookupIndex::OffsetCountPerLine, std::numeric_limits<s64>::max());
+
+        /* Allocate the entry set cache. Failing to do so isn't fatal; we'll just cache fewer entry sets. */
+        s32 cache_slot_count = 0;
+        for (s32 i = 0; i < entry_set_cache_count; ++i) {
+            void * const buffer = allocator->Allocate(m_node_size, sizeof(s64));
+            if (buffer == nullptr) {
+                break;
+            }
+
+            m_lookup_index.cache_slots[cache_slot_count++] = { buffer, -1, 0 };
+        }
+
+        /* Set the index. */
+        m_lookup_index.offsets          = offsets;
+        m_lookup_index.line_count       = line_count;
+        m_lookup_index.cache_slot_count = cache_slot_count;
+        m_lookup_index.cache_tick       = 0;
+
+        R_SUCCEED();
+    }
+
+    void BucketTree::FinalizeLookupIndex() {
+        if (this->IsLookupIndexEnabled()) {
+            IAllocator * const allocator = this->GetAllocator();
+
+            for (s32 i = 0; i < m_lookup_index.cache_slot_count; ++i) {
+                allocator->Deallocate(m_lookup_index.cache_slots[i].buffer, m_node_size, sizeof(s64));
+                m_lookup_index.cache_slots[i] = {};
+            }
+
+            allocator->Deallocate(m_lookup_index.offsets, m_lookup_index.line_count * LookupIndex::LineSize, LookupIndex::LineSize);
+
+            m_lookup_index.offsets          = nullptr;
+            m_lookup_index.line_count       = 0;
+            m_lookup_index.cache_slot_count = 0;
+        }
+    }
+
     Result BucketTree::EnsureOffsetCache() {
         /* If we already have an offset cache, we're good. */
         R_SUCCEED_IF(m_offset_cache.is_initialized);
@@ -288,6 +389,108 @@ namespace ams::fssystem {
         R_SUCCEED();
     }
 
+    s32 BucketTree::FindEntrySetIndexByLookupIndex(s64 virtual_address) const {
+        AMS_ASSERT(this->IsLookupIndexEnabled());
+
+        constexpr s32 LineOffsetCount = LookupIndex::OffsetCountPerLine;
+        const s64 * const offsets     = m_lookup_index.offsets;
+
+        /* Find the last line whose first offset is at most the address. */
+        s32 line  = 0;
+        s32 count = m_lookup_index.line_count;
+        while (count > 1) {
+            const s32 half = count / 2;
+            if (offsets[(line + half) * LineOffsetCount] <= virtual_address) {
+                line  += half;
+                count -= half;
+            } else {
+                count = half;
+            }
+        }
+
+        if (offsets[line * LineOffsetCount] > virtual_address) {
+            return -1;
+        }
+
+        /* Count the offsets in the line which are at most the address. This is a fixed-width, branch-free loop */
+        /* over a single cache line, so that the compiler emits vector compares for it. */
+        const s64 * const line_offsets = offsets + line * LineOffsetCount;
+        s32 match_count = 0;
+        for (s32 i = 0; i < LineOffsetCount; ++i) {
+            match_count += static_cast<s32>(line_offsets[i] <= virtual_address);
+        }
+
+        return line * LineOffsetCount + match_count - 1;
+    }
+
+    BucketTree::LookupIndex::EntrySetCacheSlot *BucketTree::FindEntrySetCacheSlot(s32 entry_set_index) const {
+        AMS_ASSERT(m_lookup_index.mutex.IsLockedByCurrentThread());
+
+        for (s32 i = 0; i < m_lookup_index.cache_slot_count; ++i) {
+            if (auto &slot = m_lookup_index.cache_slots[i]; slot.entry_set_index == entry_set_index) {
+                slot.last_used = ++m_lookup_index.cache_tick;
+                return std::addressof(slot);
+            }
+        }
+
+        return nullptr;
+    }
+
+    bool BucketTree::ReadEntrySetCache(void *dst, s32 entry_set_index, size_t offset, size_t size) const {
+        AMS_ASSERT(offset + size <= m_node_size);
+
+        if (!this->IsLookupIndexEnabled()) {
+            return false;
+        }
+
+        std::scoped_lock lk(m_lookup_index.mutex);
+
+        const auto *slot = this->FindEntrySetCacheSlot(entry_set_index);
+        if (slot == nullptr) {
+            return false;
+        }
+
+        std::memcpy(dst, static_cast<const char *>(slot->buffer) + offset, size);
+        return true;
+    }
+
+    void BucketTree::StoreEntrySetCache(s32 entry_set_index, const void *buffer) const {
+        AMS_ASSERT(this->IsLookupIndexEnabled());
+
+        std::scoped_lock lk(m_lookup_index.mutex);
+
+        /* If someone else has already cached the entry set, there's nothing to do. */
+        if (this->FindEntrySetCacheSlot(entry_set_index) != nullptr) {
+            return;
+        }
+
+        /* Replace the least recently used slot. */
+        LookupIndex::EntrySetCacheSlot *victim = nullptr;
+        for (s32 i = 0; i < m_lookup_index.cache_slot_count; ++i) {
+            auto &slot = m_lookup_index.cache_slots[i];
+            if (victim == nullptr || slot.entry_set_index < 0 || static_cast<u32>(m_lookup_index.cache_tick - victim->last_used) < static_cast<u32>(m_lookup_index.cache_tick - slot.last_used)) {
+                victim = std::addressof(slot);
+                if (slot.entry_set_index < 0) {
+                    break;
+                }
+            }
+        }
+
+        if (victim != nullptr) {
+            std::memcpy(victim->buffer, buffer, m_node_size);
+            victim->entry_set_index = entry_set_index;
+            victim->last_used       = ++m_lookup_index.cache_tick;
+        }
+    }
+
+    void BucketTree::ClearEntrySetCache() const {
+        std::scoped_lock lk(m_lookup_index.mutex);
+
+        for (s32 i = 0; i < m_lookup_index.cache_slot_count; ++i) {
+            m_lookup_index.cache_slots[i].entry_set_index = -1;
+        }
+    }
+
     Result BucketTree::Visitor::Initialize(const BucketTree *tree, const BucketTree::Offsets &offsets) {
         AMS_ASSERT(tree != nullptr);
         AMS_ASSERT(m_tree == nullptr || m_tree == tree);
@@ -319,7 +522,9 @@ namespace ams::fssystem {
             const auto entry_set_size   = m_tree->m_node_size;
             const auto entry_set_offset = entry_set_index * static_cast<s64>(entry_set_size);
 
-            R_TRY(m_tree->m_entry_storage.Read(entry_set_offset, std::addressof(m_entry_set), sizeof(EntrySetHeader)));
+            if (!m_tree->ReadEntrySetCache(std::addressof(m_entry_set), entry_set_index, 0, sizeof(EntrySetHeader))) {
+                R_TRY(m_tree->m_entry_storage.Read(entry_set_offset, std::addressof(m_entry_set), sizeof(EntrySetHeader)));
+            }
             R_TRY(m_entry_set.header.Verify(entry_set_index, entry_set_size, m_tree->m_entry_size));
 
             R_UNLESS(m_entry_set.info.start == end && m_entry_set.info.start < m_entry_set.info.end, fs::ResultInvalidBucketTreeEntrySetOffset());
@@ -331,8 +536,10 @@ namespace ams::fssystem {
 
         /* Read the new entry. */
         const auto entry_size   = m_tree->m_entry_size;
-        const auto entry_offset = impl::GetBucketTreeEntryOffset(m_entry_set.info.index, m_tree->m_node_size, entry_size, entry_index);
-        R_TRY(m_tree->m_entry_storage.Read(entry_offset, m_entry, entry_size));
+        if (!m_tree->ReadEntrySetCache(m_entry, m_entry_set.info.index, impl::GetBucketTreeEntryOffset(0, entry_size, entry_index), entry_size)) {
+            const auto entry_offset = impl::GetBucketTreeEntryOffset(m_entry_set.info.index, m_tree->m_node_size, entry_size, entry_index);
+            R_TRY(m_tree->m_entry_storage.Read(entry_offset, m_entry, entry_size));
+        }
 
         /* Note that we changed index. */
         m_entry_index = entry_index;
@@ -355,7 +562,9 @@ namespace ams::fssystem {
             const auto entry_set_index  = m_entry_set.info.index - 1;
             const auto entry_set_offset = entry_set_index * static_cast<s64>(entry_set_size);
 
-            R_TRY(m_tree->m_entry_storage.Read(entry_set_offset, std::addressof(m_entry_set), sizeof(EntrySetHeader)));
+            if (!m_tree->ReadEntrySetCache(std::addressof(m_entry_set), entry_set_index, 0, sizeof(EntrySetHeader))) {
+                R_TRY(m_tree->m_entry_storage.Read(entry_set_offset, std::addressof(m_entry_set), sizeof(EntrySetHeader)));
+            }
             R_TRY(m_entry_set.header.Verify(entry_set_index, entry_set_size, m_tree->m_entry_size));
 
             R_UNLESS(m_entry_set.info.end == start && m_entry_set.info.start < m_entry_set.info.end, fs::ResultInvalidBucketTreeEntrySetOffset());
@@ -369,8 +578,10 @@ namespace ams::fssystem {
 
         /* Read the new entry. */
         const auto entry_size   = m_tree->m_entry_size;
-        const auto entry_offset = impl::GetBucketTreeEntryOffset(m_entry_set.info.index, m_tree->m_node_size, entry_size, entry_index);
-        R_TRY(m_tree->m_entry_storage.Read(entry_offset, m_entry, entry_size));
+        if (!m_tree->ReadEntrySetCache(m_entry, m_entry_set.info.index, impl::GetBucketTreeEntryOffset(0, entry_size, entry_index), entry_size)) {
+            const auto entry_offset = impl::GetBucketTreeEntryOffset(m_entry_set.info.index, m_tree->m_node_size, entry_size, entry_index);
+            R_TRY(m_tree->m_entry_storage.Read(entry_offset, m_entry, entry_size));
+        }
 
         /* Note that we changed index. */
         m_entry_index = entry_index;
@@ -386,7 +597,10 @@ namespace ams::fssystem {
 
         /* Get the entry set index. */
         s32 entry_set_index = -1;
-        if (m_tree->IsExistOffsetL2OnL1() && virtual_address < node->GetBeginOffset()) {
+        if (m_tree->IsLookupIndexEnabled()) {
+            entry_set_index = m_tree->FindEntrySetIndexByLookupIndex(virtual_address);
+            R_UNLESS(entry_set_index >= 0, fs::ResultOutOfRange());
+        } else if (m_tree->IsExistOffsetL2OnL1() && virtual_address < node->GetBeginOffset()) {
             const auto start = node->GetEnd();
             const auto end   = node->GetBegin() + m_tree->m_offset_count;
 
@@ -484,9 +698,25 @@ namespace ams::fssystem {
     Result BucketTree::Visitor::FindEntry(s64 virtual_address, s32 entry_set_index) {
         const auto entry_set_size = m_tree->m_node_size;
 
+        /* If we have the entry set cached, search it in place. */
+        if (m_tree->IsLookupIndexEnabled()) {
+            std::scoped_lock lk(m_tree->m_lookup_index.mutex);
+
+            if (const auto *slot = m_tree->FindEntrySetCacheSlot(entry_set_index); slot != nullptr) {
+                R_RETURN(this->FindEntryInBuffer(virtual_address, entry_set_index, static_cast<const char *>(slot->buffer)));
+            }
+        }
+
         PooledBuffer pool(entry_set_size, 1);
         if (entry_set_size <= pool.GetSize()) {
-            R_RETURN(this->FindEntryWithBuffer(virtual_address, entry_set_index, pool.GetBuffer()));
+            R_TRY(this->FindEntryWithBuffer(virtual_address, entry_set_index, pool.GetBuffer()));
+
+            /* Cache the entry set we read, so that nearby lookups don't need to read it again. */
+            if (m_tree->IsLookupIndexEnabled()) {
+                m_tree->StoreEntrySetCache(entry_set_index, pool.GetBuffer());
+            }
+
+            R_SUCCEED();
         } else {
             pool.Deallocate();
             R_RETURN(this->FindEntryWithoutBuffer(virtual_address, entry_set_index));
@@ -495,7 +725,6 @@ namespace ams::fssystem {
 
     Result BucketTree::Visitor::FindEntryWithBuffer(s64 virtual_address, s32 entry_set_index, char *buffer) {
         /* Calculate entry set extents. */
-        const auto entry_size       = m_tree->m_entry_size;
         const auto entry_set_size   = m_tree->m_node_size;
         const auto entry_set_offset = entry_set_index * static_cast<s64>(entry_set_size);
         fs::SubStorage &storage     = m_tree->m_entry_storage;
@@ -503,6 +732,15 @@ namespace ams::fssystem {
         /* Read the entry set. */
         R_TRY(storage.Read(entry_set_offset, buffer, entry_set_size));
 
+        /* Find the entry. */
+        R_RETURN(this->FindEntryInBuffer(virtual_address, entry_set_index, buffer));
+    }
+
+    Result BucketTree::Visitor::FindEntryInBuffer(s64 virtual_address, s32 entry_set_index, const char *buffer) {
+        /* Calculate entry set extents. */
+        const auto entry_size     = m_tree->m_entry_size;
+        const auto entry_set_size = m_tree->m_node_size;
+
         /* Validate the entry_set. */
         EntrySetHeader entry_set;
         std::memcpy(std::addressof(entry_set), buffer, sizeof(EntrySetHeader));
@@ -554,4 +792,188 @@ namespace ams::fssystem {
         R_SUCCEED();
     }
 
+    Result BucketTree::Builder::Initialize(IAllocator *allocator, fs::SubStorage header_storage, fs::SubStorage node_storage, fs::SubStorage entry_storage, size_t node_size, size_t entry_size, s32 entry_count) {
+        /* Validate preconditions. */
+        AMS_ASSERT(allocator != nullptr);
+        AMS_ASSERT(entry_size >= sizeof(s64));
+        AMS_ASSERT(node_size >= entry_size + sizeof(NodeHeader));
+        AMS_ASSERT(NodeSizeMin <= node_size && node_size <= NodeSizeMax);
+        AMS_ASSERT(util::IsPowerOfTwo(node_size));
+        AMS_ASSERT(!this->IsInitialized());
+
+        /* Ensure valid entry count. */
+        R_UNLESS(entry_count >= 0, fs::ResultInvalidArgument());
+
+        /* Write the header. */
+        {
+            Header header;
+            header.Format(entry_count);
+            R_TRY(header_storage.Write(0, std::addressof(header), sizeof(header)));
+        }
+
+        /* If we have no entries, there are no nodes to build. */
+        if (entry_count > 0) {
+            /* Check that our storages are large enough. */
+            s64 node_storage_size, entry_storage_size;
+            R_TRY(node_storage.GetSize(std::addressof(node_storage_size)));
+            R_TRY(entry_storage.GetSize(std::addressof(entry_storage_size)));
+            R_UNLESS(node_storage_size  >= QueryNodeStorageSize(node_size, entry_size, entry_count),  fs::ResultInvalidSize());
+            R_UNLESS(entry_storage_size >= QueryEntryStorageSize(node_size, entry_size, entry_count), fs::ResultInvalidSize());
+
+            /* Allocate our node buffers. */
+            ON_RESULT_FAILURE {
+                m_l1_node.Free(node_size);
+                m_l2_node.Free(node_size);
+                m_entry_set.Free(node_size);
+            };
+            R_UNLESS(m_l1_node.Allocate(allocator, node_size),   fs::ResultBufferAllocationFailed());
+            R_UNLESS(m_l2_node.Allocate(allocator, node_size),   fs::ResultBufferAllocationFailed());
+            R_UNLESS(m_entry_set.Allocate(allocator, node_size), fs::ResultBufferAllocationFailed());
+
+            m_l1_node.FillZero(node_size);
+            m_l2_node.FillZero(node_size);
+            m_entry_set.FillZero(node_size);
+        }
+
+        /* Set member variables. */
+        m_node_storage          = node_storage;
+        m_entry_storage         = entry_storage;
+        m_node_size             = node_size;
+        m_entry_size            = entry_size;
+        m_entry_count           = entry_count;
+        m_entries_per_entry_set = GetEntryCount(node_size, entry_size);
+        m_offsets_per_node      = GetOffsetCount(node_size);
+        m_entry_set_count       = GetEntrySetCount(node_size, entry_size, entry_count);
+        m_l2_node_count         = entry_count > 0 ? GetNodeL2Count(node_size, entry_size, entry_count) : 0;
+        m_current_entry_index   = 0;
+        m_current_offset        = -1;
+
+        R_SUCCEED();
+    }
+
+    Result BucketTree::Builder::AddEntry(const void *entry, size_t entry_size) {
+        /* Validate preconditions. */
+        AMS_ASSERT(this->IsInitialized());
+        AMS_ASSERT(entry != nullptr);
+        AMS_ASSERT(entry_size == m_entry_size);
+
+        /* Check that we can add an entry. */
+        R_UNLESS(m_current_entry_index < m_entry_count, fs::ResultOutOfRange());
+
+        /* Check that entries are added in increasing virtual order. */
+        s64 offset;
+        std::memcpy(std::addressof(offset), entry, sizeof(s64));
+        R_UNLESS(offset >= 0 && offset > m_current_offset, fs::ResultInvalidOffset());
+
+        /* If we're starting a new entry set, finalize the previous one and register the new one. */
+        const s32 entry_set_index = m_current_entry_index / m_entries_per_entry_set;
+        const s32 entry_index     = m_current_entry_index % m_entries_per_entry_set;
+        if (entry_index == 0) {
+            if (m_current_entry_index > 0) {
+                R_TRY(this->FinalizePreviousEntrySet(offset));
+            }
+
+            R_TRY(this->RegisterEntrySet(entry_set_index, offset));
+        }
+
+        /* Copy the entry into the current entry set. */
+        std::memcpy(reinterpret_cast<char *>(m_entry_set.Get()) + impl::GetBucketTreeEntryOffset(0, m_entry_size, entry_index), entry, entry_size);
+        ++m_entry_set->count;
+
+        /* Advance. */
+        m_current_offset = offset;
+        ++m_current_entry_index;
+
+        R_SUCCEED();
+    }
+
+    Result BucketTree::Builder::RegisterEntrySet(s32 entry_set_index, s64 offset) {
+        /* Prepare the entry set. */
+        m_entry_set.FillZero(m_node_size);
+        m_entry_set->index = entry_set_index;
+
+        /* If we have no L2 nodes, the entry set is referenced directly by L1. */
+        s64 * const l1_offsets = reinterpret_cast<s64 *>(m_l1_node.Get() + 1);
+        if (m_l2_node_count == 0) {
+            l1_offsets[entry_set_index] = offset;
+            R_SUCCEED();
+        }
+
+        /* The first entry sets are referenced from the tail of L1, after the offsets of the L2 nodes. */
+        const s32 entry_set_count_on_l1 = m_offsets_per_node - m_l2_node_count;
+        if (entry_set_index < entry_set_count_on_l1) {
+            l1_offsets[m_l2_node_count + entry_set_index] = offset;
+            R_SUCCEED();
+        }
+
+        /* Otherwise, the entry set is referenced by an L2 node. */
+        const s32 node_index   = (entry_set_index - entry_set_count_on_l1) / m_offsets_per_node;
+        const s32 offset_index = (entry_set_index - entry_set_count_on_l1) % m_offsets_per_node;
+        if (offset_index == 0) {
+            if (node_index > 0) {
+                R_TRY(this->FinalizePreviousL2Node(offset));
+            }
+
+            /* Prepare the L2 node, and reference it from L1. */
+            m_l2_node.FillZero(m_node_size);
+            m_l2_node->index = node_index;
+            l1_offsets[node_index] = offset;
+        }
+
+        reinterpret_cast<s64 *>(m_l2_node.Get() + 1)[offset_index] = offset;
+        ++m_l2_node->count;
+
+        R_SUCCEED();
+    }
+
+    Result BucketTree::Builder::FinalizePreviousEntrySet(s64 end_offset) {
+        /* Set the entry set's end offset, and write it out. */
+        m_entry_set->offset = end_offset;
+        R_RETURN(m_entry_storage.Write(m_entry_set->index * static_cast<s64>(m_node_size), m_entry_set.Get(), m_node_size));
+    }
+
+    Result BucketTree::Builder::FinalizePreviousL2Node(s64 end_offset) {
+        /* Set the node's end offset, and write it out after L1. */
+        m_l2_node->offset = end_offset;
+        R_RETURN(m_node_storage.Write((m_l2_node->index + 1) * static_cast<s64>(m_node_size), m_l2_node.Get(), m_node_size));
+    }
+
+    Result BucketTree::Builder::Finalize(s64 end_offset) {
+        /* Validate preconditions. */
+        AMS_ASSERT(this->IsInitialized());
+
+        /* Check that all entries were added, and that the end offset is valid. */
+        R_UNLESS(m_current_entry_index == m_entry_count, fs::ResultOutOfRange());
+        R_UNLESS(end_offset > m_current_offset,          fs::ResultInvalidOffset());
+
+        /* Write our nodes, if we have any. */
+        if (m_entry_count > 0) {
+            /* Write the last entry set. */
+            R_TRY(this->FinalizePreviousEntrySet(end_offset));
+
+            /* Write the last L2 node, if we have one. */
+            if (m_l2_node_count > 0) {
+                R_TRY(this->FinalizePreviousL2Node(end_offset));
+            }
+
+            /* Write L1. */
+            m_l1_node->index  = 0;
+            m_l1_node->count  = m_l2_node_count > 0 ? m_l2_node_count : m_entry_set_count;
+            m_l1_node->offset = end_offset;
+            R_TRY(m_node_storage.Write(0, m_l1_node.Get(), m_node_size));
+        }
+
+        /* We're done building. */
+        this->FreeBuffers();
+        m_node_size = 0;
+
+        R_SUCCEED();
+    }
+
+    void BucketTree::Builder::FreeBuffers() {
+        m_l1_node.Free(m_node_size);
+        m_l2_node.Free(m_node_size);
+        m_entry_set.Free(m_node_size);
+    }
+
 }
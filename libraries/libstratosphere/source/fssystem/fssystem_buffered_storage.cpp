@@ -22,6 +22,8 @@ namespace ams::fssystem {
         constexpr inline uintptr_t InvalidAddress = 0;
         constexpr inline s64 InvalidOffset = std::numeric_limits<s64>::max();
 
+        constexpr inline s32 SequentialReadCountThreshold = 2;
+
     }
 
     class BufferedStorage::Cache : public ::ams::fs::impl::Newable {
@@ -39,12 +41,13 @@ namespace ams::fssystem {
             s64 m_offset;
             std::atomic<bool> m_is_valid;
             std::atomic<bool> m_is_dirty;
-            u8 m_reserved[2];
+            std::atomic<bool> m_is_prefetched;
+            u8 m_reserved[1];
             s32 m_reference_count;
             Cache *m_next;
             Cache *m_prev;
         public:
-            Cache() : m_buffered_storage(nullptr), m_memory_range(InvalidAddress, 0), m_cache_handle(), m_offset(InvalidOffset), m_is_valid(false), m_is_dirty(false), m_reference_count(1), m_next(nullptr), m_prev(nullptr) {
+            Cache() : m_buffered_storage(nullptr), m_memory_range(InvalidAddress, 0), m_cache_handle(), m_offset(InvalidOffset), m_is_valid(false), m_is_dirty(false), m_is_prefetched(false), m_reference_count(1), m_next(nullptr), m_prev(nullptr) {
                 /* ... */
             }
 
@@ -84,6 +87,7 @@ namespace ams::fssystem {
                 m_offset           = InvalidOffset;
                 m_is_valid         = false;
                 m_is_dirty         = false;
+                m_is_prefetched    = false;
                 m_next             = nullptr;
                 m_prev             = nullptr;
             }
@@ -134,6 +138,7 @@ namespace ams::fssystem {
                     if (!this->IsValid()) {
                         m_offset = InvalidOffset;
                         m_is_dirty = false;
+                        this->DiscardPrefetched();
                     }
 
                     /* Ensure our buffer state is coherent. */
@@ -253,6 +258,7 @@ namespace ams::fssystem {
                 if (m_reference_count == 1) {
                     result.first = this->Flush();
                     if (R_SUCCEEDED(result.first)) {
+                        this->DiscardPrefetched();
                         m_is_valid = false;
                         m_reference_count = 0;
                         result.second = true;
@@ -334,15 +340,31 @@ namespace ams::fssystem {
                 } else {
                     m_memory_range = m_buffered_storage->m_buffer_manager->AcquireCache(m_cache_handle);
                     m_is_valid = m_memory_range.first != InvalidAddress;
+                    if (!m_is_valid) {
+                        this->DiscardPrefetched();
+                    }
                     return m_is_valid;
                 }
             }
 
             void Invalidate() {
                 AMS_ASSERT(m_buffered_storage != nullptr);
+                this->DiscardPrefetched();
                 m_is_valid = false;
             }
 
+            void SetPrefetched() {
+                AMS_ASSERT(m_buffered_storage != nullptr);
+                m_is_prefetched = true;
+            }
+
+            void ConsumePrefetched() {
+                AMS_ASSERT(m_buffered_storage != nullptr);
+                if (m_is_prefetched.load(std::memory_order_relaxed)) {
+                    m_is_prefetched = false;
+                }
+            }
+
             bool IsValid() const {
                 AMS_ASSERT(m_buffered_storage != nullptr);
                 return m_is_valid || m_reference_count > 0;
@@ -359,6 +381,13 @@ namespace ams::fssystem {
                 return (offset < m_offset + block_size) && (m_offset < offset + size);
             }
         private:
+            void DiscardPrefetched() {
+                /* A prefetched block that's dropped before anyone reads it was wasted work. */
+                if (m_is_prefetched.exchange(false)) {
+                    ++m_buffered_storage->m_prefetch_waste_count;
+                }
+            }
+
             Result AllocateFetchBuffer() {
                 fs::IBufferManager *buffer_manager = m_buffered_storage->m_buffer_manager;
                 AMS_ASSERT(buffer_manager->AcquireCache(m_cache_handle).first == InvalidAddress);
@@ -508,11 +537,13 @@ namespace ams::fssystem {
             void Read(s64 offset, void *buffer, size_t size) {
                 AMS_ASSERT(m_cache != nullptr);
                 m_cache->Read(offset, buffer, size);
+                m_cache->ConsumePrefetched();
             }
 
             void Write(s64 offset, const void *buffer, size_t size) {
                 AMS_ASSERT(m_cache != nullptr);
                 m_cache->Write(offset, buffer, size);
+                m_cache->ConsumePrefetched();
             }
 
             Result Flush() {
@@ -529,6 +560,11 @@ namespace ams::fssystem {
                 AMS_ASSERT(m_cache != nullptr);
                 return m_cache->Hits(offset, size);
             }
+
+            bool IsDirty() const {
+                AMS_ASSERT(m_cache != nullptr);
+                return m_cache->IsDirty();
+            }
         private:
             void Release() {
                 if (m_cache != nullptr) {
@@ -581,9 +617,16 @@ namespace ams::fssystem {
                 R_TRY(m_cache->FetchFromBuffer(offset, buffer, buffer_size));
                 R_SUCCEED();
             }
+
+            Result Prefetch(s64 offset) {
+                AMS_ASSERT(m_cache != nullptr);
+                R_TRY(m_cache->Fetch(offset));
+                m_cache->SetPrefetched();
+                R_SUCCEED();
+            }
     };
 
-    BufferedStorage::BufferedStorage() : m_base_storage(), m_buffer_manager(), m_block_size(), m_base_storage_size(), m_caches(), m_cache_count(), m_next_acquire_cache(), m_next_fetch_cache(), m_mutex(), m_bulk_read_enabled() {
+    BufferedStorage::BufferedStorage() : m_base_storage(), m_buffer_manager(), m_block_size(), m_base_storage_size(), m_caches(), m_cache_count(), m_next_acquire_cache(), m_next_fetch_cache(), m_mutex(), m_bulk_read_enabled(), m_prefetcher(), m_read_ahead_window(), m_sequential_read_count(), m_sequential_next_offset(InvalidOffset), m_read_ahead_end_offset(), m_hit_count(), m_miss_count(), m_request_count(), m_prefetch_count(), m_prefetch_waste_count() {
         /* ... */
     }
 
@@ -620,6 +663,8 @@ namespace ams::fssystem {
     }
 
     void BufferedStorage::Finalize() {
+        this->DisableReadAhead();
+
         m_base_storage = fs::SubStorage();
         m_base_storage_size = 0;
         m_caches.reset();
@@ -641,6 +686,70 @@ namespace ams::fssystem {
         R_SUCCEED();
     }
 
+    Result BufferedStorage::ReadBatch(const fs::ReadRequest *requests, s32 count) {
+        AMS_ASSERT(this->IsInitialized());
+
+        /* Succeed if there's nothing to read. */
+        R_SUCCEED_IF(count == 0);
+
+        /* Validate arguments. */
+        R_UNLESS(requests != nullptr, fs::ResultNullptrArgument());
+
+        /* Bulk reads go through the head and tail caches, so service those a request at a time. */
+        if (m_bulk_read_enabled) {
+            R_RETURN(IStorage::ReadBatch(requests, count));
+        }
+
+        /* Requests which ReadCore would send straight to the base storage are gathered into a single batch; the rest go through the cache. */
+        constexpr s32 DirectCountMax = 16;
+        fs::ReadRequest direct_requests[DirectCountMax];
+        s32 direct_count = 0;
+
+        for (s32 i = 0; i < count; ++i) {
+            const auto &request = requests[i];
+
+            /* Skip empty requests. */
+            if (request.size == 0) {
+                continue;
+            }
+
+            /* Validate arguments. */
+            R_UNLESS(request.buffer != nullptr, fs::ResultNullptrArgument());
+
+            const bool is_direct = request.offset >= 0 && util::IsAligned(request.offset, m_block_size) && util::IsAligned(request.size, m_block_size) && request.size > m_block_size && request.offset + static_cast<s64>(request.size) <= m_base_storage_size;
+            if (!is_direct) {
+                R_TRY(this->ReadCore(request.offset, request.buffer, request.size));
+                continue;
+            }
+
+            /* Let the prefetcher know about the read. */
+            this->DetectSequentialRead(request.offset, request.size);
+
+            /* Write back and drop any caches over the range, as ReadCore does. */
+            {
+                SharedCache cache(this);
+                while (cache.AcquireNextOverlappedCache(request.offset, request.size)) {
+                    R_TRY(cache.Flush());
+                    cache.Invalidate();
+                }
+            }
+
+            /* Add the request to the batch, reading it if it's full. */
+            direct_requests[direct_count++] = request;
+            if (direct_count == DirectCountMax) {
+                R_TRY(m_base_storage.ReadBatch(direct_requests, direct_count));
+                direct_count = 0;
+            }
+        }
+
+        /* Read whatever remains of the batch. */
+        if (direct_count > 0) {
+            R_TRY(m_base_storage.ReadBatch(direct_requests, direct_count));
+        }
+
+        R_SUCCEED();
+    }
+
     Result BufferedStorage::Write(s64 offset, const void *buffer, size_t size) {
         AMS_ASSERT(this->IsInitialized());
 
@@ -737,6 +846,124 @@ namespace ams::fssystem {
         }
     }
 
+    void BufferedStorage::EnableReadAhead(BufferedStoragePrefetcher *prefetcher, s32 window_block_count) {
+        AMS_ASSERT(this->IsInitialized());
+        AMS_ASSERT(prefetcher != nullptr);
+        AMS_ASSERT(0 < window_block_count && window_block_count <= ReadAheadWindowMax);
+
+        std::scoped_lock lk(m_mutex);
+
+        /* Leave at least half of the caches for demand fetches, so that read-ahead can't thrash the working set. */
+        m_prefetcher             = prefetcher;
+        m_read_ahead_window      = std::max(1, std::min(window_block_count, m_cache_count / 2));
+        m_sequential_read_count  = 0;
+        m_sequential_next_offset = InvalidOffset;
+        m_read_ahead_end_offset  = 0;
+    }
+
+    void BufferedStorage::DisableReadAhead() {
+        BufferedStoragePrefetcher *prefetcher;
+        {
+            std::scoped_lock lk(m_mutex);
+
+            prefetcher          = m_prefetcher;
+            m_prefetcher        = nullptr;
+            m_read_ahead_window = 0;
+        }
+
+        /* Requests are only posted under our lock, so once cancelled the prefetcher can no longer reference us. */
+        if (prefetcher != nullptr) {
+            prefetcher->Cancel(this);
+        }
+    }
+
+    void BufferedStorage::GetReadAheadStatistics(ReadAheadStatistics *out) const {
+        AMS_ASSERT(out != nullptr);
+
+        out->hit_count            = m_hit_count;
+        out->miss_count           = m_miss_count;
+        out->request_count        = m_request_count;
+        out->prefetch_count       = m_prefetch_count;
+        out->prefetch_waste_count = m_prefetch_waste_count;
+    }
+
+    void BufferedStorage::DetectSequentialRead(s64 offset, size_t size) {
+        std::scoped_lock lk(m_mutex);
+
+        /* Check that read-ahead is still enabled. */
+        if (m_prefetcher == nullptr) {
+            return;
+        }
+
+        const s64 block_size = static_cast<s64>(m_block_size);
+        const s64 end_offset = std::min(offset + static_cast<s64>(size), m_base_storage_size);
+
+        /* A read which starts where the previous one ended (or skips less than a block past it) continues the run. */
+        /* NOTE: Until we've seen a read, there's no run to continue, so the first read (even at offset zero) starts one. */
+        const bool is_sequential = m_sequential_next_offset != InvalidOffset && m_sequential_next_offset <= offset && offset - m_sequential_next_offset < block_size;
+        if (is_sequential) {
+            m_sequential_read_count = std::min(m_sequential_read_count + 1, SequentialReadCountThreshold);
+        } else {
+            m_sequential_read_count = 0;
+            m_read_ahead_end_offset = 0;
+        }
+        m_sequential_next_offset = end_offset;
+
+        /* Reads larger than a block bypass the caches (and would invalidate anything we fetched), so only small reads trigger read-ahead. */
+        if (m_sequential_read_count < SequentialReadCountThreshold || static_cast<s64>(size) > block_size) {
+            return;
+        }
+
+        /* Refill the window once less than half of it remains ahead of the reader, so that requests are batched. */
+        const s64 window_offset     = util::AlignUp(end_offset, m_block_size);
+        const s64 window_offset_end = std::min(window_offset + m_read_ahead_window * block_size, m_base_storage_size);
+        const s64 prefetch_offset   = std::max(window_offset, m_read_ahead_end_offset);
+        if (prefetch_offset >= window_offset_end || (prefetch_offset - window_offset) > (m_read_ahead_window / 2) * block_size) {
+            return;
+        }
+
+        const s32 block_count = static_cast<s32>(util::DivideUp(window_offset_end - prefetch_offset, block_size));
+        if (m_prefetcher->Post(this, prefetch_offset, block_count)) {
+            m_read_ahead_end_offset = window_offset_end;
+            ++m_request_count;
+        }
+    }
+
+    Result BufferedStorage::Prefetch(s64 offset, s32 block_count) {
+        AMS_ASSERT(util::IsAligned(offset, m_block_size));
+        AMS_ASSERT(block_count > 0);
+
+        for (s32 i = 0; i < block_count; ++i) {
+            const s64 cur_offset = offset + static_cast<s64>(m_block_size) * i;
+            R_SUCCEED_IF(cur_offset >= m_base_storage_size);
+
+            /* Read-ahead is speculative, so stop before we'd cause the foreground to start flushing. */
+            const auto prefetch_threshold = m_buffer_manager->GetTotalSize() / 4;
+            R_SUCCEED_IF(m_buffer_manager->GetTotalAllocatableSize() < prefetch_threshold);
+
+            /* Skip blocks which are already cached. */
+            SharedCache cache(this);
+            if (cache.AcquireNextOverlappedCache(cur_offset, 1)) {
+                continue;
+            }
+
+            /* Don't write back dirty data for a speculative fetch. */
+            R_SUCCEED_IF(!cache.AcquireFetchableCache());
+            R_SUCCEED_IF(cache.IsDirty());
+
+            /* If someone else is using the cache, give up; the reader will fetch on demand. */
+            UniqueCache fetch_cache(this);
+            const auto upgrade_result = fetch_cache.Upgrade(cache);
+            R_TRY(upgrade_result.first);
+            R_SUCCEED_IF(!upgrade_result.second);
+
+            R_TRY(fetch_cache.Prefetch(cur_offset));
+            ++m_prefetch_count;
+        }
+
+        R_SUCCEED();
+    }
+
     Result BufferedStorage::PrepareAllocation() {
         const auto flush_threshold = m_buffer_manager->GetTotalSize() / 8;
         if (m_buffer_manager->GetTotalAllocatableSize() < flush_threshold) {
@@ -774,6 +1001,9 @@ namespace ams::fssystem {
         s64 cur_offset        = offset;
         s64 buf_offset        = 0;
 
+        /* Let the prefetcher know about the read. This checks whether read-ahead is enabled under our lock, as it may be toggled concurrently. */
+        this->DetectSequentialRead(offset, remaining_size);
+
         /* Determine what caches are needed, if we have bulk read set. */
         if (m_bulk_read_enabled) {
             /* Check head cache. */
@@ -820,6 +1050,7 @@ namespace ams::fssystem {
             if (cur_size <= m_block_size) {
                 SharedCache cache(this);
                 if (!cache.AcquireNextOverlappedCache(cur_offset, cur_size)) {
+                    ++m_miss_count;
                     R_TRY(this->PrepareAllocation());
                     while (true) {
                         R_UNLESS(cache.AcquireFetchableCache(), fs::ResultOutOfResource());
@@ -833,6 +1064,8 @@ namespace ams::fssystem {
                         }
                     }
                     R_TRY(this->ControlDirtiness());
+                } else {
+                    ++m_hit_count;
                 }
                 cache.Read(cur_offset, cur_dst, cur_size);
             } else {
@@ -878,6 +1111,7 @@ namespace ams::fssystem {
             if (!cache.AcquireNextOverlappedCache(*offset, cur_size)) {
                 break;
             }
+            ++m_hit_count;
 
             cache.Read(*offset, static_cast<u8 *>(buffer) + *buffer_offset, cur_size);
             *offset        += cur_size;
@@ -915,6 +1149,7 @@ namespace ams::fssystem {
             if (!cache.AcquireNextOverlappedCache(cur_offset, cur_size)) {
                 break;
             }
+            ++m_hit_count;
 
             cache.Read(cur_offset, static_cast<u8 *>(buffer) + buffer_offset + cur_offset - offset, cur_size);
             *size          -= cur_size;
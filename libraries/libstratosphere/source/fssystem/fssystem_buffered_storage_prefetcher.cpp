@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+
+namespace ams::fssystem {
+
+    namespace {
+
+        constinit BufferedStoragePrefetcher *g_registered_prefetcher = nullptr;
+
+    }
+
+    void RegisterBufferedStoragePrefetcher(BufferedStoragePrefetcher *prefetcher) {
+        AMS_ASSERT(g_registered_prefetcher == nullptr);
+        AMS_ASSERT(prefetcher != nullptr && prefetcher->IsInitialized());
+
+        g_registered_prefetcher = prefetcher;
+    }
+
+    BufferedStoragePrefetcher *GetRegisteredBufferedStoragePrefetcher() {
+        return g_registered_prefetcher;
+    }
+
+    Result BufferedStoragePrefetcher::Initialize(void *stack, size_t stack_size, s32 priority) {
+        /* Validate pre-conditions. */
+        AMS_ASSERT(!this->IsInitialized());
+        AMS_ASSERT(stack != nullptr);
+        AMS_ASSERT(util::IsAligned(reinterpret_cast<uintptr_t>(stack), os::ThreadStackAlignment));
+        AMS_ASSERT(util::IsAligned(stack_size, os::ThreadStackAlignment));
+
+        /* Reset our state. */
+        m_request_head    = 0;
+        m_request_count   = 0;
+        m_current_storage = nullptr;
+        m_is_exiting      = false;
+
+        /* Create and start the prefetch thread. */
+        R_TRY(os::CreateThread(std::addressof(m_thread), ThreadFunction, this, stack, stack_size, priority));
+        os::SetThreadNamePointer(std::addressof(m_thread), "FsBufferedStoragePrefetcher");
+        os::StartThread(std::addressof(m_thread));
+
+        m_is_initialized = true;
+        R_SUCCEED();
+    }
+
+    void BufferedStoragePrefetcher::Finalize() {
+        /* If we're not initialized, there's nothing to do. */
+        if (!this->IsInitialized()) {
+            return;
+        }
+
+        /* Tell the thread to exit, discarding anything still queued. */
+        {
+            std::scoped_lock lk(m_mutex);
+            m_is_exiting    = true;
+            m_request_count = 0;
+            m_request_cv.Signal();
+            m_idle_cv.Broadcast();
+        }
+
+        /* Wait for and destroy the thread. */
+        os::WaitThread(std::addressof(m_thread));
+        os::DestroyThread(std::addressof(m_thread));
+
+        m_is_initialized = false;
+    }
+
+    bool BufferedStoragePrefetcher::Post(BufferedStorage *storage, s64 offset, s32 block_count) {
+        AMS_ASSERT(storage != nullptr);
+        AMS_ASSERT(offset >= 0);
+        AMS_ASSERT(block_count > 0);
+
+        std::scoped_lock lk(m_mutex);
+
+        /* Read-ahead is only a hint, so drop the request rather than block the reader when we're saturated. */
+        if (!m_is_initialized || m_is_exiting || m_request_count >= RequestCountMax) {
+            return false;
+        }
+
+        m_requests[(m_request_head + m_request_count) % RequestCountMax] = { storage, offset, block_count };
+        ++m_request_count;
+
+        m_request_cv.Signal();
+        return true;
+    }
+
+    void BufferedStoragePrefetcher::Cancel(BufferedStorage *storage) {
+        AMS_ASSERT(storage != nullptr);
+
+        std::scoped_lock lk(m_mutex);
+
+        /* Remove any queued requests for the storage, preserving the order of the rest. */
+        s32 kept_count = 0;
+        for (s32 i = 0; i < m_request_count; ++i) {
+            const auto &request = m_requests[(m_request_head + i) % RequestCountMax];
+            if (request.storage != storage) {
+                m_requests[(m_request_head + kept_count++) % RequestCountMax] = request;
+            }
+        }
+        m_request_count = kept_count;
+        m_idle_cv.Broadcast();
+
+        /* Wait for the thread to finish with the storage, if it's using it. */
+        while (m_current_storage == storage) {
+            m_idle_cv.Wait(m_mutex);
+        }
+    }
+
+    void BufferedStoragePrefetcher::WaitForIdle() {
+        std::scoped_lock lk(m_mutex);
+
+        while (m_request_count > 0 || m_current_storage != nullptr) {
+            m_idle_cv.Wait(m_mutex);
+        }
+    }
+
+    void BufferedStoragePrefetcher::ThreadFunction(void *arg) {
+        static_cast<BufferedStoragePrefetcher *>(arg)->ThreadFunctionImpl();
+    }
+
+    void BufferedStoragePrefetcher::ThreadFunctionImpl() {
+        while (true) {
+            /* Wait for a request. */
+            PrefetchRequest request;
+            {
+                std::scoped_lock lk(m_mutex);
+
+                while (!m_is_exiting && m_request_count == 0) {
+                    m_request_cv.Wait(m_mutex);
+                }
+
+                if (m_is_exiting) {
+                    return;
+                }
+
+                request = m_requests[m_request_head];
+                m_request_head = (m_request_head + 1) % RequestCountMax;
+                --m_request_count;
+
+                m_current_storage = request.storage;
+            }
+
+            /* Perform the read-ahead. Failure here is harmless, as the reader will simply fetch on demand. */
+            static_cast<void>(request.storage->Prefetch(request.offset, request.block_count));
+
+            /* Let anyone waiting to cancel know we're done with the storage. */
+            {
+                std::scoped_lock lk(m_mutex);
+                m_current_storage = nullptr;
+                m_idle_cv.Broadcast();
+            }
+        }
+    }
+
+}
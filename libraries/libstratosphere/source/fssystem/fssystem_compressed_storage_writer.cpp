@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+
+namespace ams::fssystem {
+
+    Result CompressedStorageWriter::Write(s64 *out_data_size, fs::SubStorage header_storage, fs::SubStorage table_storage, fs::SubStorage data_storage, fs::IStorage *src_storage, s64 src_size, size_t block_size, CompressionType compression_type, MemoryResource *allocator) {
+        /* Validate preconditions. */
+        AMS_ASSERT(out_data_size != nullptr);
+        AMS_ASSERT(src_storage != nullptr);
+        AMS_ASSERT(allocator != nullptr);
+        AMS_ASSERT(0 < block_size && block_size <= BlockSizeMax);
+        AMS_ASSERT(util::IsAligned(block_size, CompressionBlockAlignment));
+
+        /* Validate arguments. */
+        R_UNLESS(src_size > 0, fs::ResultInvalidSize());
+        R_UNLESS(CompressionTypeUtility::IsBlockAlignmentRequired(compression_type), fs::ResultInvalidArgument());
+
+        /* Get the compressor. */
+        const auto compressor = GetNcaCompressorFunction(compression_type);
+        R_UNLESS(compressor != nullptr, fs::ResultInvalidArgument());
+
+        /* Determine the table extents. */
+        const s32 entry_count = QueryEntryCount(src_size, block_size);
+        const s64 node_size   = CompressedStorage::QueryNodeStorageSize(entry_count);
+        const s64 entry_size  = CompressedStorage::QueryEntryStorageSize(entry_count);
+
+        /* Allocate our work buffers. */
+        /* NOTE: The compression buffer comfortably exceeds the worst-case bound of any supported compressor. */
+        const size_t compressed_buffer_size = 2 * block_size;
+        auto * const src_buffer = static_cast<u8 *>(allocator->Allocate(block_size));
+        R_UNLESS(src_buffer != nullptr, fs::ResultAllocationMemoryFailedNew());
+        ON_SCOPE_EXIT { allocator->Deallocate(src_buffer, block_size); };
+
+        auto * const compressed_buffer = static_cast<u8 *>(allocator->Allocate(compressed_buffer_size));
+        R_UNLESS(compressed_buffer != nullptr, fs::ResultAllocationMemoryFailedNew());
+        ON_SCOPE_EXIT { allocator->Deallocate(compressed_buffer, compressed_buffer_size); };
+
+        /* Initialize the table builder. */
+        BucketTree::Builder builder;
+        R_TRY(builder.Initialize(allocator, header_storage, fs::SubStorage(std::addressof(table_storage), 0, node_size), fs::SubStorage(std::addressof(table_storage), node_size, entry_size), CompressedStorage::NodeSize, sizeof(CompressedStorage::Entry), entry_count));
+
+        /* Compress each block. */
+        s64 phys_offset = 0;
+        for (s64 virt_offset = 0; virt_offset < src_size; virt_offset += block_size) {
+            /* Read the block. */
+            const size_t cur_size = static_cast<size_t>(std::min<s64>(block_size, src_size - virt_offset));
+            R_TRY(src_storage->Read(virt_offset, src_buffer, cur_size));
+
+            /* Compress the block, and only keep the result if it actually saves space once aligned. */
+            const size_t compressed_size = compressor(compressed_buffer, compressed_buffer_size, src_buffer, cur_size);
+            const bool is_compressed = 0 < compressed_size && util::AlignUp(compressed_size, CompressionBlockAlignment) < cur_size;
+
+            /* Determine what we'll store. */
+            u8 * const phys_data  = is_compressed ? compressed_buffer : src_buffer;
+            const size_t phys_size = is_compressed ? compressed_size : cur_size;
+            const size_t write_size = util::AlignUp(phys_size, CompressionBlockAlignment);
+            std::memset(phys_data + phys_size, 0, write_size - phys_size);
+
+            /* Add the entry. */
+            const CompressedStorage::Entry entry = {
+                .virt_offset      = virt_offset,
+                .phys_offset      = phys_offset,
+                .compression_type = is_compressed ? compression_type : CompressionType_None,
+                .phys_size        = static_cast<s32>(phys_size),
+            };
+            R_TRY(builder.Add(entry));
+
+            /* Write the data. */
+            R_TRY(data_storage.Write(phys_offset, phys_data, write_size));
+            phys_offset += write_size;
+        }
+
+        /* Finalize the table. */
+        R_TRY(builder.Finalize(src_size));
+
+        /* Set the output. */
+        *out_data_size = phys_offset;
+        R_SUCCEED();
+    }
+
+}
@@ -25,6 +25,22 @@ namespace ams::fssystem {
             R_SUCCEED();
         }
 
+        Result DecompressZstd(void *dst, size_t dst_size, const void *src, size_t src_size) {
+            R_UNLESS(util::DecompressZstd(dst, dst_size, dst_size, src, src_size), fs::ResultUnexpectedInCompressedStorageC());
+            R_SUCCEED();
+        }
+
+        size_t CompressLz4(void *dst, size_t dst_size, const void *src, size_t src_size) {
+            /* LZ4 returns zero if the data does not fit in the destination. */
+            return static_cast<size_t>(std::max(util::CompressLZ4(dst, dst_size, src, src_size), 0));
+        }
+
+        size_t CompressZstd(void *dst, size_t dst_size, const void *src, size_t src_size) {
+            /* Zstd returns an error code (which is always larger than the destination) on failure. */
+            const size_t compressed_size = util::CompressZstd(dst, dst_size, src, src_size);
+            return compressed_size <= dst_size ? compressed_size : 0;
+        }
+
         constexpr DecompressorFunction GetNcaDecompressorFunction(CompressionType type) {
             switch (type) {
                 case CompressionType_Lz4:
@@ -34,14 +50,42 @@ namespace ams::fssystem {
             }
         }
 
+        constexpr DecompressorFunction GetNcaDecompressorFunctionWithExtensions(CompressionType type) {
+            switch (type) {
+                case CompressionType_Zstd:
+                    return DecompressZstd;
+                default:
+                    return GetNcaDecompressorFunction(type);
+            }
+        }
+
         constexpr NcaCompressionConfiguration g_nca_compression_configuration {
             .get_decompressor = GetNcaDecompressorFunction,
         };
 
+        constexpr NcaCompressionConfiguration g_nca_compression_configuration_with_extensions {
+            .get_decompressor = GetNcaDecompressorFunctionWithExtensions,
+        };
+
     }
 
     const ::ams::fssystem::NcaCompressionConfiguration *GetNcaCompressionConfiguration() {
         return std::addressof(g_nca_compression_configuration);
     }
 
+    const ::ams::fssystem::NcaCompressionConfiguration *GetNcaCompressionConfigurationWithExtensions() {
+        return std::addressof(g_nca_compression_configuration_with_extensions);
+    }
+
+    CompressorFunction GetNcaCompressorFunction(CompressionType type) {
+        switch (type) {
+            case CompressionType_Lz4:
+                return CompressLz4;
+            case CompressionType_Zstd:
+                return CompressZstd;
+            default:
+                return nullptr;
+        }
+    }
+
 }
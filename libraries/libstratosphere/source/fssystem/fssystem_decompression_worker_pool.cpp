@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+
+namespace ams::fssystem {
+
+    namespace {
+
+        ALWAYS_INLINE void RunJob(DecompressionWorkerPool::Job *job) {
+            job->result = job->decompressor(job->dst, job->dst_size, job->src, job->src_size);
+        }
+
+    }
+
+    Result DecompressionWorkerPool::Initialize(void *stack, size_t stack_size, s32 worker_count, s32 priority) {
+        /* Validate pre-conditions. */
+        AMS_ASSERT(!this->IsInitialized());
+        AMS_ASSERT(stack != nullptr);
+        AMS_ASSERT(util::IsAligned(reinterpret_cast<uintptr_t>(stack), os::ThreadStackAlignment));
+        AMS_ASSERT(0 < worker_count && worker_count <= WorkerCountMax);
+
+        /* Each worker gets an equal share of the stack memory. */
+        const size_t stack_size_per_worker = util::AlignDown(stack_size / worker_count, os::ThreadStackAlignment);
+        R_UNLESS(stack_size_per_worker > 0, fs::ResultInvalidSize());
+
+        /* Reset our state. */
+        m_jobs                = nullptr;
+        m_job_count           = 0;
+        m_next_job_index      = 0;
+        m_completed_job_count = 0;
+        m_is_exiting          = false;
+
+        /* Create the worker threads. */
+        s32 created_count = 0;
+        ON_RESULT_FAILURE {
+            for (s32 i = 0; i < created_count; ++i) {
+                os::DestroyThread(std::addressof(m_threads[i]));
+            }
+        };
+
+        for (s32 i = 0; i < worker_count; ++i) {
+            R_TRY(os::CreateThread(std::addressof(m_threads[i]), WorkerThreadFunction, this, static_cast<u8 *>(stack) + stack_size_per_worker * i, stack_size_per_worker, priority));
+            os::SetThreadNamePointer(std::addressof(m_threads[i]), "FsDecompressionWorker");
+            ++created_count;
+        }
+
+        /* Start the worker threads. */
+        for (s32 i = 0; i < worker_count; ++i) {
+            os::StartThread(std::addressof(m_threads[i]));
+        }
+
+        m_worker_count = worker_count;
+        R_SUCCEED();
+    }
+
+    void DecompressionWorkerPool::Finalize() {
+        /* If we're not initialized, there's nothing to do. */
+        if (!this->IsInitialized()) {
+            return;
+        }
+
+        /* Tell the workers to exit. */
+        {
+            std::scoped_lock lk(m_mutex);
+            m_is_exiting = true;
+            m_job_cv.Broadcast();
+        }
+
+        /* Wait for and destroy the workers. */
+        for (s32 i = 0; i < m_worker_count; ++i) {
+            os::WaitThread(std::addressof(m_threads[i]));
+            os::DestroyThread(std::addressof(m_threads[i]));
+        }
+
+        m_worker_count = 0;
+    }
+
+    Result DecompressionWorkerPool::Decompress(Job *jobs, s32 job_count) {
+        /* Validate pre-conditions. */
+        AMS_ASSERT(job_count >= 0);
+        AMS_ASSERT(jobs != nullptr || job_count == 0);
+
+        /* If there's nothing to parallelize, or another batch is in flight, just run the jobs on this thread. */
+        if (job_count > 1 && this->IsInitialized() && m_submit_mutex.TryLock()) {
+            ON_SCOPE_EXIT { m_submit_mutex.Unlock(); };
+
+            /* Publish the batch to the workers. */
+            {
+                std::scoped_lock lk(m_mutex);
+
+                m_jobs                = jobs;
+                m_job_count           = job_count;
+                m_next_job_index      = 0;
+                m_completed_job_count = 0;
+
+                m_job_cv.Broadcast();
+            }
+
+            /* Help the workers with the batch. */
+            while (true) {
+                Job *job;
+                {
+                    std::scoped_lock lk(m_mutex);
+                    job = this->AcquireJobUnsafe();
+                }
+
+                if (job == nullptr) {
+                    break;
+                }
+
+                RunJob(job);
+                this->CompleteJob();
+            }
+
+            /* Wait for the workers to finish the batch. */
+            {
+                std::scoped_lock lk(m_mutex);
+
+                while (m_completed_job_count < m_job_count) {
+                    m_done_cv.Wait(m_mutex);
+                }
+
+                m_jobs      = nullptr;
+                m_job_count = 0;
+            }
+        } else {
+            for (s32 i = 0; i < job_count; ++i) {
+                RunJob(jobs + i);
+            }
+        }
+
+        /* Report the first failure, in order. */
+        for (s32 i = 0; i < job_count; ++i) {
+            R_TRY(jobs[i].result);
+        }
+
+        R_SUCCEED();
+    }
+
+    void DecompressionWorkerPool::WorkerThreadFunction(void *arg) {
+        static_cast<DecompressionWorkerPool *>(arg)->WorkerThreadImpl();
+    }
+
+    void DecompressionWorkerPool::WorkerThreadImpl() {
+        while (true) {
+            /* Wait for a job. */
+            Job *job;
+            {
+                std::scoped_lock lk(m_mutex);
+
+                while (!m_is_exiting && (job = this->AcquireJobUnsafe()) == nullptr) {
+                    m_job_cv.Wait(m_mutex);
+                }
+
+                if (m_is_exiting) {
+                    return;
+                }
+            }
+
+            /* Run the job. */
+            RunJob(job);
+            this->CompleteJob();
+        }
+    }
+
+    DecompressionWorkerPool::Job *DecompressionWorkerPool::AcquireJobUnsafe() {
+        AMS_ASSERT(m_mutex.IsLockedByCurrentThread());
+
+        if (m_jobs == nullptr || m_next_job_index >= m_job_count) {
+            return nullptr;
+        }
+
+        return m_jobs + (m_next_job_index++);
+    }
+
+    void DecompressionWorkerPool::CompleteJob() {
+        std::scoped_lock lk(m_mutex);
+
+        if ((++m_completed_job_count) == m_job_count) {
+            m_done_cv.Signal();
+        }
+    }
+
+}
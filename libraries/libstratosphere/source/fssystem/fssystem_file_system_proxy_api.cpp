@@ -83,6 +83,20 @@ namespace ams::fssystem {
         constinit util::TypedStorage<fssystem::FileSystemBufferManager> g_buffer_manager = {};
         alignas(os::MemoryPageSize) constinit u8 g_buffer_manager_heap[BufferManagerHeapSize] = {};
 
+        /* NOTE: Atmosphère extension. */
+        constexpr size_t BufferedStoragePrefetcherStackSize = 16_KB;
+
+        constinit util::TypedStorage<fssystem::BufferedStoragePrefetcher> g_buffered_storage_prefetcher = {};
+        alignas(os::ThreadStackAlignment) constinit u8 g_buffered_storage_prefetcher_stack[BufferedStoragePrefetcherStackSize] = {};
+
+        void InitializeBufferedStoragePrefetcher() {
+            /* Read-ahead is optional, so if we can't start the prefetcher, we just don't register it. */
+            util::ConstructAt(g_buffered_storage_prefetcher);
+            if (R_SUCCEEDED(GetReference(g_buffered_storage_prefetcher).Initialize(g_buffered_storage_prefetcher_stack, sizeof(g_buffered_storage_prefetcher_stack), os::LowestThreadPriority))) {
+                fssystem::RegisterBufferedStoragePrefetcher(GetPointer(g_buffered_storage_prefetcher));
+            }
+        }
+
         /* FileSystem creators. */
         constinit util::TypedStorage<fssrv::fscreator::RomFileSystemCreator>       g_rom_fs_creator = {};
         constinit util::TypedStorage<fssrv::fscreator::PartitionFileSystemCreator> g_partition_fs_creator = {};
@@ -139,6 +153,9 @@ namespace ams::fssystem {
         R_ASSERT(ibp_res);
         AMS_UNUSED(ibp_res);
 
+        /* Initialize the buffered storage prefetcher. */
+        InitializeBufferedStoragePrefetcher();
+
         /* TODO FS-REIMPL: Create Pooled Threads/Stack Usage Reporter, fssystem::RegisterThreadPool. */
 
         /* TODO FS-REIMPL: fssrv::GetFileSystemProxyServices(), some service creation. */
@@ -245,6 +262,9 @@ namespace ams::fssystem {
         R_ASSERT(ibp_res);
         AMS_UNUSED(ibp_res);
 
+        /* Initialize the buffered storage prefetcher. */
+        InitializeBufferedStoragePrefetcher();
+
         /* TODO FS-REIMPL: Create Pooled Threads/Stack Usage Reporter, fssystem::RegisterThreadPool. */
 
         /* TODO FS-REIMPL: fssrv::GetFileSystemProxyServices(), some service creation. */
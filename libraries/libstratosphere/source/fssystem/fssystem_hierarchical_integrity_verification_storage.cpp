@@ -223,7 +223,12 @@ namespace ams::fssystem {
             m_verify_storages[level + 1].Initialize(buffer_storage, storage[HierarchicalStorageInformation::DataStorage], static_cast<s64>(1) << info.info[level + 1].block_order, static_cast<s64>(1) << info.info[level].block_order, m_buffers->buffers[m_max_layers - 2], hgf, hash_salt, true, is_writable, allow_cleared_blocks);
 
             /* Initialize the buffer storage. */
-            R_TRY(m_buffer_storages[level + 1].Initialize(m_buffers->buffers[level + 1], m_mutex, std::addressof(m_verify_storages[level + 1]), info.info[level + 1].size, static_cast<s64>(1) << info.info[level + 1].block_order, max_data_cache_entries, true, buffer_level, true, is_writable));
+            /* NOTE: Atmosphère extension. Read-only data is cached in shards, since nothing but invalidation can write it back concurrently. */
+            if (is_writable) {
+                R_TRY(m_buffer_storages[level + 1].Initialize(m_buffers->buffers[level + 1], m_mutex, std::addressof(m_verify_storages[level + 1]), info.info[level + 1].size, static_cast<s64>(1) << info.info[level + 1].block_order, max_data_cache_entries, true, buffer_level, true, is_writable));
+            } else {
+                R_TRY(m_sharded_data_buffer_storage.Initialize(m_buffers->buffers[level + 1], std::addressof(m_verify_storages[level + 1]), info.info[level + 1].size, static_cast<s64>(1) << info.info[level + 1].block_order, max_data_cache_entries, ShardedBlockCacheBufferedStorage::DefaultShardCount, buffer_level, true, is_writable));
+            }
         }
 
         /* Set the data size. */
@@ -240,6 +245,7 @@ namespace ams::fssystem {
             m_buffers   = nullptr;
             m_mutex     = nullptr;
 
+            m_sharded_data_buffer_storage.Finalize();
             for (s32 level = m_max_layers - 2; level >= 0; --level) {
                 m_buffer_storages[level].Finalize();
                 m_verify_storages[level].Finalize();
@@ -265,9 +271,7 @@ namespace ams::fssystem {
 
         /* Acquire access to the global read semaphore. */
         if (!g_read_semaphore.TimedAcquire(AccessTimeout)) {
-            for (auto level = m_max_layers - 2; level >= 0; --level) {
-                R_TRY(m_buffer_storages[level].Flush());
-            }
+            R_TRY(this->FlushBufferStorages());
             g_read_semaphore.Acquire();
         }
 
@@ -275,7 +279,7 @@ namespace ams::fssystem {
         ON_SCOPE_EXIT { g_read_semaphore.Release(); };
 
         /* Read the data. */
-        R_RETURN(m_buffer_storages[m_max_layers - 2].Read(offset, buffer, size));
+        R_RETURN(this->GetDataBufferStorage()->Read(offset, buffer, size));
     }
 
     Result HierarchicalIntegrityVerificationStorage::Write(s64 offset, const void *buffer, size_t size) {
@@ -294,9 +298,7 @@ namespace ams::fssystem {
 
         /* Acquire access to the write semaphore. */
         if (!g_write_semaphore.TimedAcquire(AccessTimeout)) {
-            for (auto level = m_max_layers - 2; level >= 0; --level) {
-                R_TRY(m_buffer_storages[level].Flush());
-            }
+            R_TRY(this->FlushBufferStorages());
             g_write_semaphore.Acquire();
         }
 
@@ -304,7 +306,7 @@ namespace ams::fssystem {
         ON_SCOPE_EXIT { g_write_semaphore.Release(); };
 
         /* Write the data. */
-        R_RETURN(m_buffer_storages[m_max_layers - 2].Write(offset, buffer, size));
+        R_RETURN(this->GetDataBufferStorage()->Write(offset, buffer, size));
     }
 
     Result HierarchicalIntegrityVerificationStorage::GetSize(s64 *out) {
@@ -323,13 +325,13 @@ namespace ams::fssystem {
             case fs::OperationId::FillZero:
             case fs::OperationId::DestroySignature:
                 {
-                    R_TRY(m_buffer_storages[m_max_layers - 2].OperateRange(dst, dst_size, op_id, offset, size, src, src_size));
+                    R_TRY(this->GetDataBufferStorage()->OperateRange(dst, dst_size, op_id, offset, size, src, src_size));
                     R_SUCCEED();
                 }
             case fs::OperationId::Invalidate:
             case fs::OperationId::QueryRange:
                 {
-                    R_TRY(m_buffer_storages[m_max_layers - 2].OperateRange(dst, dst_size, op_id, offset, size, src, src_size));
+                    R_TRY(this->GetDataBufferStorage()->OperateRange(dst, dst_size, op_id, offset, size, src, src_size));
                     R_SUCCEED();
                 }
             default:
@@ -338,17 +340,42 @@ namespace ams::fssystem {
     }
 
     Result HierarchicalIntegrityVerificationStorage::Commit() {
-        for (s32 level = m_max_layers - 2; level >= 0; --level) {
+        /* If our data layer is sharded, its block cache storage is unused. */
+        s32 level = m_max_layers - 2;
+        if (this->IsDataBufferStorageSharded()) {
+            R_TRY(m_sharded_data_buffer_storage.Commit());
+            --level;
+        }
+        for (/* ... */; level >= 0; --level) {
             R_TRY(m_buffer_storages[level].Commit());
         }
         R_SUCCEED();
     }
 
     Result HierarchicalIntegrityVerificationStorage::OnRollback() {
-        for (s32 level = m_max_layers - 2; level >= 0; --level) {
+        /* If our data layer is sharded, its block cache storage is unused. */
+        s32 level = m_max_layers - 2;
+        if (this->IsDataBufferStorageSharded()) {
+            R_TRY(m_sharded_data_buffer_storage.OnRollback());
+            --level;
+        }
+        for (/* ... */; level >= 0; --level) {
             R_TRY(m_buffer_storages[level].OnRollback());
         }
         R_SUCCEED();
     }
 
+    Result HierarchicalIntegrityVerificationStorage::FlushBufferStorages() {
+        /* If our data layer is sharded, its block cache storage is unused. */
+        s32 level = m_max_layers - 2;
+        if (this->IsDataBufferStorageSharded()) {
+            R_TRY(m_sharded_data_buffer_storage.Flush());
+            --level;
+        }
+        for (/* ... */; level >= 0; --level) {
+            R_TRY(m_buffer_storages[level].Flush());
+        }
+        R_SUCCEED();
+    }
+
 }
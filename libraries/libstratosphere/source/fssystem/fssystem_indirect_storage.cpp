@@ -113,14 +113,72 @@ namespace ams::fssystem {
         /* Ensure that we have a buffer to read to. */
         R_UNLESS(buffer != nullptr, fs::ResultNullptrArgument());
 
-        R_TRY((this->OperatePerEntry<true, true>(offset, size, [=](fs::IStorage *storage, s64 data_offset, s64 cur_offset, s64 cur_size) -> Result {
-            R_TRY(storage->Read(data_offset, reinterpret_cast<u8 *>(buffer) + (cur_offset - offset), static_cast<size_t>(cur_size)));
+        /* Gather the fragments, and read them in as few batches as possible. */
+        ReadRequestBatch batch;
+        R_TRY((this->OperatePerEntry<true, true>(offset, size, [&](fs::IStorage *storage, s64 data_offset, s64 cur_offset, s64 cur_size) -> Result {
+            R_TRY(batch.Add(storage, data_offset, reinterpret_cast<u8 *>(buffer) + (cur_offset - offset), static_cast<size_t>(cur_size)));
             R_SUCCEED();
         })));
 
+        R_RETURN(batch.Submit());
+    }
+
+    Result IndirectStorage::ReadRequestBatch::Add(fs::IStorage *storage, s64 offset, void *buffer, size_t size) {
+        AMS_ASSERT(storage != nullptr);
+
+        /* Find the slot for the storage, claiming an unused one if we need to. */
+        s32 index = -1;
+        for (s32 i = 0; i < StorageCount; ++i) {
+            if (m_storages[i] == storage) {
+                index = i;
+                break;
+            } else if (index < 0 && m_request_counts[i] == 0) {
+                index = i;
+            }
+        }
+
+        /* If every slot holds requests for another storage, submit them all. */
+        if (index < 0) {
+            R_TRY(this->Submit());
+            index = 0;
+        }
+        m_storages[index] = storage;
+
+        /* If the slot is full, submit it. */
+        if (m_request_counts[index] == RequestCountMax) {
+            R_TRY(this->Submit(index));
+        }
+
+        /* Add the request. */
+        m_requests[index][m_request_counts[index]++] = { offset, buffer, size };
         R_SUCCEED();
     }
 
+    Result IndirectStorage::ReadRequestBatch::Submit() {
+        for (s32 i = 0; i < StorageCount; ++i) {
+            R_TRY(this->Submit(i));
+        }
+        R_SUCCEED();
+    }
+
+    Result IndirectStorage::ReadRequestBatch::Submit(s32 index) {
+        AMS_ASSERT(0 <= index && index < StorageCount);
+
+        /* Succeed if there's nothing to submit. */
+        R_SUCCEED_IF(m_request_counts[index] == 0);
+
+        /* Read, clearing the slot regardless of outcome. */
+        ON_SCOPE_EXIT { m_request_counts[index] = 0; };
+
+        /* A lone request doesn't need the batched path. */
+        if (m_request_counts[index] == 1) {
+            const auto &request = m_requests[index][0];
+            R_RETURN(m_storages[index]->Read(request.offset, request.buffer, request.size));
+        } else {
+            R_RETURN(m_storages[index]->ReadBatch(m_requests[index], m_request_counts[index]));
+        }
+    }
+
     Result IndirectStorage::OperateRange(void *dst, size_t dst_size, fs::OperationId op_id, s64 offset, s64 size, const void *src, size_t src_size) {
         /* Validate pre-conditions. */
         AMS_ASSERT(offset >= 0);
@@ -17,6 +17,12 @@
 
 namespace ams::fssystem {
 
+    namespace {
+
+        constexpr size_t VerificationBatchCountMax = 0x10;
+
+    }
+
     void IntegrityVerificationStorage::Initialize(fs::SubStorage hs, fs::SubStorage ds, s64 verif_block_size, s64 upper_layer_verif_block_size, fs::IBufferManager *bm, fssystem::IHash256GeneratorFactory *hgf, const util::optional<fs::HashSalt> &salt, bool is_real_data, bool is_writable, bool allow_cleared_blocks) {
         /* Validate preconditions. */
         AMS_ASSERT(verif_block_size >= HashSize);
@@ -118,10 +124,6 @@ namespace ams::fssystem {
         /* Verify the signatures. */
         Result verify_hash_result = ResultSuccess();
 
-        /* Create hash generator. */
-        std::unique_ptr<IHash256Generator> generator = nullptr;
-        R_TRY(m_hash_generator_factory->Create(std::addressof(generator)));
-
         /* Prepare to validate the signatures. */
         const auto signature_count = size >> m_verification_block_order;
         PooledBuffer signature_buffer(signature_count * sizeof(BlockHash), sizeof(BlockHash));
@@ -136,15 +138,10 @@ namespace ams::fssystem {
             /* Temporarily increase our priority. */
             ScopedThreadPriorityChanger cp(+1, ScopedThreadPriorityChanger::Mode::Relative);
 
-            /* Loop over each signature we read. */
-            for (size_t i = 0; i < cur_count && R_SUCCEEDED(cur_result); ++i) {
-                const auto verified_size = (verified_count + i) << m_verification_block_order;
-                u8 *cur_buf = static_cast<u8 *>(buffer) + verified_size;
-                cur_result = this->VerifyHash(cur_buf, reinterpret_cast<BlockHash *>(signature_buffer.GetBuffer()) + i, generator);
-
-                /* If the data is corrupted, clear the corrupted parts. */
+            /* Define a helper to clear corrupted blocks, noting the failure if we should. */
+            auto handle_verification_result = [&](u8 *block_buf) {
                 if (fs::ResultIntegrityVerificationStorageCorrupted::Includes(cur_result)) {
-                    std::memset(cur_buf, 0, m_verification_block_size);
+                    std::memset(block_buf, 0, m_verification_block_size);
 
                     /* Set the result if we should. */
                     if (!fs::ResultClearedRealDataVerificationFailed::Includes(cur_result) && !m_allow_cleared_blocks) {
@@ -153,6 +150,51 @@ namespace ams::fssystem {
 
                     cur_result = ResultSuccess();
                 }
+            };
+
+            /* Loop over the signatures we read, hashing a batch of blocks at a time. */
+            BlockHash *signatures = reinterpret_cast<BlockHash *>(signature_buffer.GetBuffer());
+            size_t cur_index = 0;
+            while (cur_index < cur_count && R_SUCCEEDED(cur_result)) {
+                /* Gather a batch, stopping at the first cleared or malformed signature, since such a block can't verify and needn't be hashed. */
+                size_t batch_count = 0;
+                Result stop_result = ResultSuccess();
+                while (batch_count < VerificationBatchCountMax && cur_index + batch_count < cur_count) {
+                    if (m_is_writable) {
+                        bool is_cleared = false;
+                        stop_result = this->IsCleared(std::addressof(is_cleared), signatures[cur_index + batch_count]);
+                        if (R_SUCCEEDED(stop_result) && is_cleared) {
+                            stop_result = fs::ResultClearedRealDataVerificationFailed();
+                        }
+                        if (R_FAILED(stop_result)) {
+                            break;
+                        }
+                    }
+
+                    ++batch_count;
+                }
+
+                u8 *batch_buf = static_cast<u8 *>(buffer) + ((verified_count + cur_index) << m_verification_block_order);
+
+                /* Calculate the hashes for all blocks in the batch, and compare each against its signature. */
+                if (batch_count > 0) {
+                    BlockHash calc_hashes[VerificationBatchCountMax];
+                    cur_result = this->CalcBlockHashes(calc_hashes, batch_buf, batch_count);
+
+                    for (size_t i = 0; i < batch_count && R_SUCCEEDED(cur_result); ++i) {
+                        cur_result = this->VerifyHash(signatures + cur_index + i, calc_hashes[i]);
+                        handle_verification_result(batch_buf + (i << m_verification_block_order));
+                    }
+                }
+
+                /* Handle the block which ended the batch early, if there was one. */
+                if (R_FAILED(stop_result) && R_SUCCEEDED(cur_result)) {
+                    cur_result = stop_result;
+                    handle_verification_result(batch_buf + (batch_count << m_verification_block_order));
+                    ++batch_count;
+                }
+
+                cur_index += batch_count;
             }
 
             /* If we failed, clear and return. */
@@ -221,10 +263,6 @@ namespace ams::fssystem {
             PooledBuffer signature_buffer(signature_count * sizeof(BlockHash), sizeof(BlockHash));
             const auto buffer_count = std::min(signature_count, signature_buffer.GetSize() / sizeof(BlockHash));
 
-            /* Create hash generator. */
-            std::unique_ptr<IHash256Generator> generator = nullptr;
-            R_TRY(m_hash_generator_factory->Create(std::addressof(generator)));
-
             while (updated_count < signature_count) {
                 const auto cur_count = std::min(buffer_count, signature_count - updated_count);
 
@@ -232,9 +270,9 @@ namespace ams::fssystem {
                 {
                     ScopedThreadPriorityChanger cp(+1, ScopedThreadPriorityChanger::Mode::Relative);
 
-                    for (size_t i = 0; i < cur_count; ++i) {
-                        const auto updated_size = (updated_count + i) << m_verification_block_order;
-                        this->CalcBlockHash(reinterpret_cast<BlockHash *>(signature_buffer.GetBuffer()) + i, reinterpret_cast<const u8 *>(buffer) + updated_size, generator);
+                    const auto updated_size = updated_count << m_verification_block_order;
+                    if (R_FAILED((update_result = this->CalcBlockHashes(reinterpret_cast<BlockHash *>(signature_buffer.GetBuffer()), reinterpret_cast<const u8 *>(buffer) + updated_size, cur_count)))) {
+                        break;
                     }
                 }
 
@@ -366,31 +404,23 @@ namespace ams::fssystem {
         }
     }
 
-    void IntegrityVerificationStorage::CalcBlockHash(BlockHash *out, const void *buffer, size_t block_size, std::unique_ptr<fssystem::IHash256Generator> &generator) const {
-        /* Hash procedure depends on whether or not we're writable. */
-        if (m_is_writable) {
-            /* Compute the hash with or without the hash salt, if we have one. */
-            if (m_salt.has_value()) {
-                /* Initialize the generator. */
-                generator->Initialize();
+    Result IntegrityVerificationStorage::CalcBlockHashes(BlockHash *out, const void *buffer, size_t block_count) const {
+        /* Determine whether we should hash the salt before each block. */
+        const bool use_salt = m_is_writable && m_salt.has_value();
+        const void *prefix  = use_salt ? m_salt->value : nullptr;
+        const size_t prefix_size = use_salt ? sizeof(m_salt->value) : 0;
 
-                /* Hash the salt. */
-                generator->Update(m_salt->value, sizeof(m_salt->value));
+        /* Calculate all the hashes at once. */
+        R_TRY(m_hash_generator_factory->GenerateHashes(out, sizeof(*out) * block_count, prefix, prefix_size, buffer, static_cast<size_t>(m_verification_block_size), block_count));
 
-                /* Update with the buffer and get the hash. */
-                generator->Update(buffer, block_size);
-                generator->GetHash(out, sizeof(*out));
-            } else {
-                /* If we have no hash salt, just calculate the hash. */
-                m_hash_generator_factory->GenerateHash(out, sizeof(*out), buffer, block_size);
+        /* If we're writable, set the validation bit on each hash. */
+        if (m_is_writable) {
+            for (size_t i = 0; i < block_count; ++i) {
+                SetValidationBit(out + i);
             }
-
-            /* Set the validation bit. */
-            SetValidationBit(out);
-        } else {
-            /* If we're not writable, just calculate the hash. */
-            m_hash_generator_factory->GenerateHash(out, sizeof(*out), buffer, block_size);
         }
+
+        R_SUCCEED();
     }
 
     Result IntegrityVerificationStorage::ReadBlockSignature(void *dst, size_t dst_size, s64 offset, size_t size) {
@@ -441,25 +471,14 @@ namespace ams::fssystem {
         R_SUCCEED();
     }
 
-    Result IntegrityVerificationStorage::VerifyHash(const void *buf, BlockHash *hash, std::unique_ptr<fssystem::IHash256Generator> &generator) {
+    Result IntegrityVerificationStorage::VerifyHash(BlockHash *hash, const BlockHash &calc_hash) {
         /* Validate preconditions. */
-        AMS_ASSERT(buf != nullptr);
         AMS_ASSERT(hash != nullptr);
 
         /* Get the comparison hash. */
+        /* NOTE: Cleared signatures are checked by Read before the blocks are hashed. */
         auto &cmp_hash = *hash;
 
-        /* If writable, check if the data is uninitialized. */
-        if (m_is_writable) {
-            bool is_cleared = false;
-            R_TRY(this->IsCleared(std::addressof(is_cleared), cmp_hash));
-            R_UNLESS(!is_cleared, fs::ResultClearedRealDataVerificationFailed());
-        }
-
-        /* Get the calculated hash. */
-        BlockHash calc_hash;
-        this->CalcBlockHash(std::addressof(calc_hash), buf, generator);
-
         /* Check that the signatures are equal. */
         if (!crypto::IsSameBytes(std::addressof(cmp_hash), std::addressof(calc_hash), sizeof(BlockHash))) {
             /* Clear the comparison hash. */
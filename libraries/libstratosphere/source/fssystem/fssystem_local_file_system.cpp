@@ -29,6 +29,12 @@
 
 #if defined(ATMOSPHERE_OS_LINUX)
 #include <sys/syscall.h>
+#include <sys/uio.h>
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#include <sys/mman.h>
+#include <linux/io_uring.h>
+#define AMS_FSSYSTEM_LOCAL_FILE_SYSTEM_USE_IO_URING
+#endif
 #elif defined(ATMOSPHERE_OS_MACOS)
 extern "C" ssize_t __getdirentries64(int fd, char *buffer, size_t buffer_size, uintptr_t *basep);
 #endif
@@ -547,6 +553,330 @@ namespace ams::fssystem {
             R_SUCCEED();
         }
 
+        #if defined(ATMOSPHERE_OS_LINUX)
+        Result ReadFullImpl(int handle, s64 offset, void *buffer, size_t size) {
+            u8 *dst = static_cast<u8 *>(buffer);
+            while (size > 0) {
+                const auto read_size = RetryForEIntr([&] () ALWAYS_INLINE_LAMBDA -> ssize_t { return ::pread(handle, dst, size, offset); });
+                R_UNLESS(read_size >= 0, ConvertErrnoToResult(ErrnoSource_Pread));
+
+                /* A batched read must be satisfied in full. */
+                R_UNLESS(read_size > 0, fs::ResultOutOfRange());
+
+                dst    += read_size;
+                offset += read_size;
+                size   -= read_size;
+            }
+
+            R_SUCCEED();
+        }
+
+        Result ReadBatchByPreadv(int handle, const fs::ReadRequest *requests, s32 count) {
+            constexpr s32 IoVectorCountMax = 64;
+            struct iovec iov[IoVectorCountMax];
+
+            s32 i = 0;
+            while (i < count) {
+                /* Gather requests which are contiguous in the file into a single vector. */
+                const s64 start_offset = requests[i].offset;
+                s64 end_offset = start_offset;
+                s32 iov_count = 0;
+                while (i < count && iov_count < IoVectorCountMax && requests[i].offset == end_offset) {
+                    if (requests[i].size > 0) {
+                        iov[iov_count++] = { requests[i].buffer, requests[i].size };
+                        end_offset += requests[i].size;
+                    }
+                    ++i;
+                }
+
+                if (iov_count == 0) {
+                    continue;
+                }
+
+                /* Read the vector. */
+                const auto read_size = RetryForEIntr([&] () ALWAYS_INLINE_LAMBDA -> ssize_t { return ::preadv(handle, iov, iov_count, start_offset); });
+                R_UNLESS(read_size >= 0, ConvertErrnoToResult(ErrnoSource_Pread));
+
+                /* If the read was short, finish whatever remains of each buffer. */
+                if (read_size < end_offset - start_offset) {
+                    s64 cur_offset = start_offset;
+                    s64 remaining  = read_size;
+                    for (s32 j = 0; j < iov_count; ++j) {
+                        const s64 cur_size  = static_cast<s64>(iov[j].iov_len);
+                        const s64 done_size = std::min(remaining, cur_size);
+                        if (done_size < cur_size) {
+                            R_TRY(ReadFullImpl(handle, cur_offset + done_size, static_cast<u8 *>(iov[j].iov_base) + done_size, static_cast<size_t>(cur_size - done_size)));
+                        }
+
+                        remaining  -= done_size;
+                        cur_offset += cur_size;
+                    }
+                }
+            }
+
+            R_SUCCEED();
+        }
+
+        #if defined(AMS_FSSYSTEM_LOCAL_FILE_SYSTEM_USE_IO_URING)
+        class IoUringReader {
+            NON_COPYABLE(IoUringReader);
+            NON_MOVEABLE(IoUringReader);
+            public:
+                static constexpr u32 EntryCount = 64;
+                static constexpr size_t RequestSizeMax = 0x7FFFF000;
+            private:
+                os::SdkMutex m_mutex;
+                bool m_initialized;
+                bool m_available;
+                int m_fd;
+                void *m_sq_ring;
+                size_t m_sq_ring_size;
+                void *m_cq_ring;
+                size_t m_cq_ring_size;
+                struct io_uring_sqe *m_sqes;
+                size_t m_sqes_size;
+                u32 *m_sq_tail;
+                u32 *m_sq_mask;
+                u32 *m_sq_array;
+                u32 *m_cq_head;
+                u32 *m_cq_tail;
+                u32 *m_cq_mask;
+                struct io_uring_cqe *m_cqes;
+                u32 m_sq_entries;
+            public:
+                constexpr IoUringReader() : m_mutex(), m_initialized(false), m_available(false), m_fd(-1), m_sq_ring(nullptr), m_sq_ring_size(0), m_cq_ring(nullptr), m_cq_ring_size(0), m_sqes(nullptr), m_sqes_size(0), m_sq_tail(nullptr), m_sq_mask(nullptr), m_sq_array(nullptr), m_cq_head(nullptr), m_cq_tail(nullptr), m_cq_mask(nullptr), m_cqes(nullptr), m_sq_entries(0) { /* ... */ }
+
+                bool TryAcquire() {
+                    /* If another thread is using the ring, let the caller fall back to synchronous reads. */
+                    if (!m_mutex.TryLock()) {
+                        return false;
+                    }
+
+                    /* Set up the ring on first use. */
+                    if (!m_initialized) {
+                        this->InitializeImpl();
+                    }
+
+                    if (!m_available) {
+                        m_mutex.Unlock();
+                        return false;
+                    }
+
+                    return true;
+                }
+
+                void Release() {
+                    AMS_ASSERT(m_mutex.IsLockedByCurrentThread());
+                    m_mutex.Unlock();
+                }
+
+                Result ReadBatch(int handle, const fs::ReadRequest *requests, s32 count) {
+                    AMS_ASSERT(m_mutex.IsLockedByCurrentThread());
+                    AMS_ASSERT(m_available);
+                    AMS_ASSERT(m_sq_entries <= BITSIZEOF(u64));
+
+                    Result result = ResultSuccess();
+                    for (s32 processed = 0; processed < count; /* ... */) {
+                        /* If the ring failed during an earlier round, read the rest synchronously. */
+                        if (!m_available) {
+                            R_RETURN(ReadBatchByPreadv(handle, requests + processed, count - processed));
+                        }
+
+                        /* Queue as many requests as the submission ring can hold. */
+                        const s32 cur_count = std::min<s32>(count - processed, m_sq_entries);
+                        const fs::ReadRequest *cur_requests = requests + processed;
+
+                        u32 tail = *m_sq_tail;
+                        s32 queued = 0;
+                        u64 pending_mask = 0;
+                        for (s32 i = 0; i < cur_count; ++i) {
+                            const auto &request = cur_requests[i];
+                            if (request.size == 0) {
+                                continue;
+                            }
+
+                            const u32 index = tail & *m_sq_mask;
+                            struct io_uring_sqe *sqe = m_sqes + index;
+                            std::memset(sqe, 0, sizeof(*sqe));
+                            sqe->opcode    = IORING_OP_READ;
+                            sqe->fd        = handle;
+                            sqe->off       = static_cast<u64>(request.offset);
+                            sqe->addr      = reinterpret_cast<uintptr_t>(request.buffer);
+                            sqe->len       = static_cast<u32>(request.size);
+                            sqe->user_data = static_cast<u64>(i);
+
+                            m_sq_array[index] = index;
+                            pending_mask |= (UINT64_C(1) << i);
+                            ++tail;
+                            ++queued;
+                        }
+                        std::atomic_ref<u32>(*m_sq_tail).store(tail, std::memory_order_release);
+
+                        /* Submit, and wait for every submitted request to complete; the kernel owns the buffers until then. */
+                        s32 to_submit = queued;
+                        s32 remaining = queued;
+                        while (remaining > 0) {
+                            const auto submitted = ::syscall(__NR_io_uring_enter, m_fd, static_cast<unsigned int>(to_submit), 1u, IORING_ENTER_GETEVENTS, nullptr, 0);
+                            if (submitted >= 0) {
+                                to_submit -= static_cast<s32>(submitted);
+                            } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                                /* The ring is unusable; withdraw whatever the kernel hasn't consumed, and stop using it. */
+                                std::atomic_ref<u32>(*m_sq_tail).store(tail - to_submit, std::memory_order_release);
+                                remaining -= to_submit;
+                                to_submit  = 0;
+                                m_available = false;
+                            }
+
+                            /* Reap completions. */
+                            u32 head = *m_cq_head;
+                            const u32 cq_tail = std::atomic_ref<u32>(*m_cq_tail).load(std::memory_order_acquire);
+                            for (/* ... */; head != cq_tail; ++head) {
+                                const struct io_uring_cqe &cqe = m_cqes[head & *m_cq_mask];
+                                const auto &request = cur_requests[cqe.user_data];
+
+                                /* Complete failed or short reads synchronously; this also converts any error to a result. */
+                                const size_t done_size = cqe.res > 0 ? static_cast<size_t>(cqe.res) : 0;
+                                if (done_size < request.size && R_SUCCEEDED(result)) {
+                                    result = ReadFullImpl(handle, request.offset + done_size, static_cast<u8 *>(request.buffer) + done_size, request.size - done_size);
+                                }
+
+                                pending_mask &= ~(UINT64_C(1) << cqe.user_data);
+                                --remaining;
+                            }
+                            std::atomic_ref<u32>(*m_cq_head).store(head, std::memory_order_release);
+
+                            /* Without the ring, requests already in flight can only be waited on by watching the completion queue. */
+                            if (!m_available && remaining > 0 && head == std::atomic_ref<u32>(*m_cq_tail).load(std::memory_order_acquire)) {
+                                os::SleepThread(TimeSpan::FromMicroSeconds(100));
+                            }
+                        }
+
+                        R_TRY(result);
+
+                        /* Read anything the ring didn't complete synchronously. */
+                        if (pending_mask != 0) {
+                            fs::ReadRequest fallback_requests[BITSIZEOF(u64)];
+                            s32 fallback_count = 0;
+                            for (s32 i = 0; i < cur_count; ++i) {
+                                if ((pending_mask & (UINT64_C(1) << i)) != 0) {
+                                    fallback_requests[fallback_count++] = cur_requests[i];
+                                }
+                            }
+
+                            R_TRY(ReadBatchByPreadv(handle, fallback_requests, fallback_count));
+                        }
+
+                        processed += cur_count;
+                    }
+
+                    R_SUCCEED();
+                }
+            private:
+                void InitializeImpl() {
+                    AMS_ASSERT(!m_initialized);
+                    m_initialized = true;
+
+                    /* Create the ring. */
+                    struct io_uring_params params;
+                    std::memset(std::addressof(params), 0, sizeof(params));
+
+                    const int fd = static_cast<int>(::syscall(__NR_io_uring_setup, EntryCount, std::addressof(params)));
+                    if (fd < 0) {
+                        return;
+                    }
+
+                    auto fd_guard = SCOPE_GUARD { CloseFileDescriptor(fd); };
+
+                    /* Map the rings. */
+                    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+                    size_t sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+                    size_t cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+                    if (single_mmap) {
+                        sq_ring_size = std::max(sq_ring_size, cq_ring_size);
+                        cq_ring_size = sq_ring_size;
+                    }
+
+                    void *sq_ring = ::mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+                    if (sq_ring == MAP_FAILED) {
+                        return;
+                    }
+                    auto sq_guard = SCOPE_GUARD { ::munmap(sq_ring, sq_ring_size); };
+
+                    void *cq_ring = sq_ring;
+                    if (!single_mmap) {
+                        cq_ring = ::mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+                        if (cq_ring == MAP_FAILED) {
+                            return;
+                        }
+                    }
+                    auto cq_guard = SCOPE_GUARD { if (cq_ring != sq_ring) { ::munmap(cq_ring, cq_ring_size); } };
+
+                    const size_t sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+                    void *sqes = ::mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+                    if (sqes == MAP_FAILED) {
+                        return;
+                    }
+
+                    /* Set our members. */
+                    u8 *sq = static_cast<u8 *>(sq_ring);
+                    u8 *cq = static_cast<u8 *>(cq_ring);
+
+                    m_fd           = fd;
+                    m_sq_ring      = sq_ring;
+                    m_sq_ring_size = sq_ring_size;
+                    m_cq_ring      = cq_ring;
+                    m_cq_ring_size = cq_ring_size;
+                    m_sqes         = static_cast<struct io_uring_sqe *>(sqes);
+                    m_sqes_size    = sqes_size;
+                    m_sq_tail      = reinterpret_cast<u32 *>(sq + params.sq_off.tail);
+                    m_sq_mask      = reinterpret_cast<u32 *>(sq + params.sq_off.ring_mask);
+                    m_sq_array     = reinterpret_cast<u32 *>(sq + params.sq_off.array);
+                    m_cq_head      = reinterpret_cast<u32 *>(cq + params.cq_off.head);
+                    m_cq_tail      = reinterpret_cast<u32 *>(cq + params.cq_off.tail);
+                    m_cq_mask      = reinterpret_cast<u32 *>(cq + params.cq_off.ring_mask);
+                    m_cqes         = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+                    m_sq_entries   = params.sq_entries;
+                    m_available    = true;
+
+                    /* The ring lives for the rest of the process. */
+                    fd_guard.Cancel();
+                    sq_guard.Cancel();
+                    cq_guard.Cancel();
+                }
+        };
+
+        constinit IoUringReader g_io_uring_reader;
+        constinit bool g_is_io_uring_enabled = true;
+
+        bool CanReadBatchByIoUring(const fs::ReadRequest *requests, s32 count) {
+            /* Single requests gain nothing from the ring. */
+            if (count <= 1) {
+                return false;
+            }
+
+            for (s32 i = 0; i < count; ++i) {
+                if (requests[i].size > IoUringReader::RequestSizeMax) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+        #endif
+
+        Result ReadBatchImpl(int handle, const fs::ReadRequest *requests, s32 count) {
+            #if defined(AMS_FSSYSTEM_LOCAL_FILE_SYSTEM_USE_IO_URING)
+            /* Submit the whole batch through io_uring, if it's available and not busy. */
+            if (g_is_io_uring_enabled && CanReadBatchByIoUring(requests, count) && g_io_uring_reader.TryAcquire()) {
+                ON_SCOPE_EXIT { g_io_uring_reader.Release(); };
+                R_RETURN(g_io_uring_reader.ReadBatch(handle, requests, count));
+            }
+            #endif
+
+            R_RETURN(ReadBatchByPreadv(handle, requests, count));
+        }
+        #endif
+
         class LocalFile : public ::ams::fs::fsa::IFile, public ::ams::fs::impl::Newable {
             private:
                 const int m_handle;
@@ -578,6 +908,18 @@ namespace ams::fssystem {
                     R_SUCCEED();
                 }
 
+                #if defined(ATMOSPHERE_OS_LINUX)
+                virtual Result DoReadBatch(const fs::ReadRequest *requests, s32 count, const fs::ReadOption &option) override {
+                    AMS_UNUSED(option);
+
+                    /* Check that we can read. */
+                    R_UNLESS((m_open_mode & fs::OpenMode_Read) != 0, fs::ResultReadNotPermitted());
+
+                    /* Read. */
+                    R_RETURN(ReadBatchImpl(m_handle, requests, count));
+                }
+                #endif
+
                 virtual Result DoGetSize(s64 *out) override {
                     /* Get the file size. */
                     const auto size = RetryForEIntr([&] () ALWAYS_INLINE_LAMBDA -> s64 { return ::lseek(m_handle, 0, SEEK_END); });
@@ -1770,5 +2112,15 @@ namespace ams::fssystem {
         R_SUCCEED();
     }
 
+    #if defined(ATMOSPHERE_OS_LINUX)
+    void SetLocalFileIoUringEnabledForTest(bool enabled) {
+        #if defined(AMS_FSSYSTEM_LOCAL_FILE_SYSTEM_USE_IO_URING)
+        g_is_io_uring_enabled = enabled;
+        #else
+        AMS_UNUSED(enabled);
+        #endif
+    }
+    #endif
+
 }
 #endif
\ No newline at end of file
@@ -28,6 +28,7 @@ namespace ams::fssystem {
         constexpr inline s32 IndirectTableCacheCount     = 8;
         constexpr inline s32 IndirectDataCacheBlockSize  = 32_KB;
         constexpr inline s32 IndirectDataCacheCount      = 16;
+        constexpr inline s32 IndirectDataReadAheadWindow = 4;
         constexpr inline s32 SparseTableCacheBlockSize   = SparseStorage::NodeSize;
         constexpr inline s32 SparseTableCacheCount       = 4;
 
@@ -37,6 +38,8 @@ namespace ams::fssystem {
         constexpr inline s32 IntegrityDataCacheCountForMeta = 16;
         constexpr inline s32 IntegrityHashCacheCountForMeta = 2;
 
+        constexpr inline s32 IndirectTableEntrySetCacheCount = 2;
+
         //TODO: Better names for these?
         //constexpr inline s32 CompressedDataBlockSize            = 64_KB;
         //constexpr inline s32 CompressedContinuousReadingSizeMax = 640_KB;
@@ -46,6 +49,36 @@ namespace ams::fssystem {
         constexpr inline s32 AesCtrStorageCacheBlockSize = 0x200;
         constexpr inline s32 AesCtrStorageCacheCount     = 9;
 
+        /* NOTE: Atmosphère extension. */
+        constexpr inline s32    DecompressionWorkerCount     = 2;
+        constexpr inline size_t DecompressionWorkerStackSize = 16_KB;
+
+        /* NOTE: Atmosphère extension. */
+        /* Every driver in the process shares one decompression worker pool, which is started on first use and never stopped. */
+        alignas(os::ThreadStackAlignment) constinit u8 g_decompression_worker_stack[DecompressionWorkerStackSize * DecompressionWorkerCount];
+
+        constinit os::SdkMutex g_decompression_worker_pool_mutex;
+        constinit util::TypedStorage<DecompressionWorkerPool> g_decompression_worker_pool = {};
+        constinit bool g_decompression_worker_pool_initialized = false;
+
+        DecompressionWorkerPool *GetDecompressionWorkerPool() {
+            std::scoped_lock lk(g_decompression_worker_pool_mutex);
+
+            /* Start the pool, if we haven't already. */
+            if (!g_decompression_worker_pool_initialized) {
+                util::ConstructAt(g_decompression_worker_pool);
+                if (R_FAILED(util::GetReference(g_decompression_worker_pool).Initialize(g_decompression_worker_stack, sizeof(g_decompression_worker_stack), DecompressionWorkerCount, os::DefaultThreadPriority))) {
+                    /* This is best-effort; without a pool, blocks are just decompressed serially. */
+                    util::DestroyAt(g_decompression_worker_pool);
+                    return nullptr;
+                }
+
+                g_decompression_worker_pool_initialized = true;
+            }
+
+            return util::GetPointer(g_decompression_worker_pool);
+        }
+
         class SharedNcaBodyStorage : public ::ams::fs::IStorage, public ::ams::fs::impl::Newable {
             NON_COPYABLE(SharedNcaBodyStorage);
             NON_MOVEABLE(SharedNcaBodyStorage);
@@ -955,6 +988,11 @@ namespace ams::fssystem {
         /* Enable bulk read on the data storage. */
         indirect_data_storage->EnableBulkRead();
 
+        /* NOTE: Atmosphère extension. If a prefetcher is registered, enable read-ahead on the data storage, since patch data is mostly read sequentially. */
+        if (auto * const prefetcher = fssystem::GetRegisteredBufferedStoragePrefetcher(); prefetcher != nullptr) {
+            indirect_data_storage->EnableReadAhead(prefetcher, IndirectDataReadAheadWindow);
+        }
+
         /* Create the indirect storage. */
         auto indirect_storage = fssystem::AllocateShared<IndirectStorage>();
         R_UNLESS(indirect_storage != nullptr, fs::ResultAllocationMemoryFailedAllocateShared());
@@ -962,6 +1000,9 @@ namespace ams::fssystem {
         /* Initialize the indirect storage. */
         R_TRY(indirect_storage->Initialize(m_allocator, fs::SubStorage(meta_storage, 0, node_size), fs::SubStorage(meta_storage, node_size, entry_size), header.entry_count));
 
+        /* Build a lookup index for the indirect table. This is best-effort; without it, lookups just walk the tree. */
+        static_cast<void>(indirect_storage->InitializeLookupIndex(IndirectTableEntrySetCacheCount));
+
         /* Get the original data size. */
         s64 original_data_size;
         R_TRY(original_data_storage->GetSize(std::addressof(original_data_size)));
@@ -1210,10 +1251,10 @@ namespace ams::fssystem {
     }
 
     Result NcaFileSystemDriver::CreateCompressedStorage(std::shared_ptr<fs::IStorage> *out, std::shared_ptr<fssystem::CompressedStorage> *out_cmp, std::shared_ptr<fs::IStorage> *out_meta, std::shared_ptr<fs::IStorage> base_storage, const NcaCompressionInfo &compression_info) {
-        R_RETURN(this->CreateCompressedStorage(out, out_cmp, out_meta, std::move(base_storage), compression_info, m_reader->GetDecompressor(), m_allocator, m_buffer_manager));
+        R_RETURN(this->CreateCompressedStorage(out, out_cmp, out_meta, std::move(base_storage), compression_info, m_reader->GetDecompressor(), m_allocator, m_buffer_manager, GetDecompressionWorkerPool()));
     }
 
-    Result NcaFileSystemDriver::CreateCompressedStorage(std::shared_ptr<fs::IStorage> *out, std::shared_ptr<fssystem::CompressedStorage> *out_cmp, std::shared_ptr<fs::IStorage> *out_meta, std::shared_ptr<fs::IStorage> base_storage, const NcaCompressionInfo &compression_info, GetDecompressorFunction get_decompressor, MemoryResource *allocator, fs::IBufferManager *buffer_manager) {
+    Result NcaFileSystemDriver::CreateCompressedStorage(std::shared_ptr<fs::IStorage> *out, std::shared_ptr<fssystem::CompressedStorage> *out_cmp, std::shared_ptr<fs::IStorage> *out_meta, std::shared_ptr<fs::IStorage> base_storage, const NcaCompressionInfo &compression_info, GetDecompressorFunction get_decompressor, MemoryResource *allocator, fs::IBufferManager *buffer_manager, DecompressionWorkerPool *worker_pool) {
         /* Check pre-conditions. */
         AMS_ASSERT(out != nullptr);
         AMS_ASSERT(base_storage != nullptr);
@@ -1244,7 +1285,7 @@ namespace ams::fssystem {
         R_UNLESS(compressed_storage != nullptr, fs::ResultAllocationMemoryFailedAllocateShared());
 
         /* Initialize the compressed storage. */
-        R_TRY(compressed_storage->Initialize(allocator, buffer_manager, fs::SubStorage(base_storage, 0, table_offset), fs::SubStorage(base_storage, table_offset, node_size), fs::SubStorage(base_storage, table_offset + node_size, entry_size), header.entry_count, 64_KB, 640_KB, get_decompressor, 16_KB, 16_KB, 32));
+        R_TRY(compressed_storage->Initialize(allocator, buffer_manager, fs::SubStorage(base_storage, 0, table_offset), fs::SubStorage(base_storage, table_offset, node_size), fs::SubStorage(base_storage, table_offset + node_size, entry_size), header.entry_count, 64_KB, 640_KB, get_decompressor, 16_KB, 16_KB, 32, worker_pool));
 
         /* Potentially set the output compressed storage. */
         if (out_cmp) {
@@ -17,6 +17,22 @@
 
 namespace ams::fssystem {
 
+    namespace {
+
+        constexpr inline u32 IndexTableBucketCountMax = 0x10000;
+
+        constexpr u32 CalculateEntryNameHash(const char *name) {
+            /* FNV-1a. */
+            u32 hash = 0x811C9DC5;
+            while (*name != '\x00') {
+                hash ^= static_cast<u8>(*(name++));
+                hash *= 0x01000193;
+            }
+            return hash;
+        }
+
+    }
+
     template <typename Format>
     struct PartitionFileSystemMetaCore<Format>::PartitionFileSystemHeader {
         char signature[sizeof(Format::VersionSignature)];
@@ -47,7 +63,11 @@ namespace ams::fssystem {
         R_UNLESS(m_buffer != nullptr, fs::ResultAllocationMemoryFailedInPartitionFileSystemMetaA());
 
         /* Perform regular initialization. */
-        R_RETURN(this->Initialize(storage, m_buffer, m_meta_data_size));
+        R_TRY(this->Initialize(storage, m_buffer, m_meta_data_size));
+
+        /* Build the index table, if we can. */
+        this->BuildIndexTable();
+        R_SUCCEED();
     }
 
     template <typename Format>
@@ -55,6 +75,9 @@ namespace ams::fssystem {
         /* Validate size for header. */
         R_UNLESS(meta_size >= sizeof(PartitionFileSystemHeader), fs::ResultInvalidSize());
 
+        /* Any index table we have refers to the old meta data. */
+        this->DeallocateIndexTable();
+
         /* Read the header. */
         R_TRY(storage->Read(0, meta, sizeof(PartitionFileSystemHeader)));
 
@@ -80,6 +103,8 @@ namespace ams::fssystem {
 
     template <typename Format>
     void PartitionFileSystemMetaCore<Format>::DeallocateBuffer() {
+        this->DeallocateIndexTable();
+
         if (m_buffer != nullptr) {
             AMS_ABORT_UNLESS(m_allocator != nullptr);
             m_allocator->Deallocate(m_buffer, m_meta_data_size);
@@ -87,6 +112,71 @@ namespace ams::fssystem {
         }
     }
 
+    template <typename Format>
+    void PartitionFileSystemMetaCore<Format>::BuildIndexTable() {
+        /* Discard any existing index table. */
+        this->DeallocateIndexTable();
+
+        /* We can only build an index table if we have meta data and an allocator to hold the table. */
+        if (!m_initialized || m_allocator == nullptr || m_header->entry_count <= 0) {
+            return;
+        }
+
+        /* The index table requires every name to be valid and terminated within the name table. */
+        /* If any isn't, we fall back to linear search, which preserves its handling of malformed meta data. */
+        const s32 entry_count = m_header->entry_count;
+        for (s32 i = 0; i < entry_count; ++i) {
+            const auto name_offset = m_entries[i].name_offset;
+            if (name_offset >= m_header->name_table_size) {
+                return;
+            }
+
+            const size_t max_name_len = m_header->name_table_size - name_offset;
+            if (std::memchr(std::addressof(m_name_table[name_offset]), '\x00', max_name_len) == nullptr) {
+                return;
+            }
+        }
+
+        /* Determine the table layout: buckets, followed by a chain link for each entry. */
+        const u32 bucket_count = std::min<u32>(util::CeilingPowerOfTwo<u32>(entry_count), IndexTableBucketCountMax);
+        const size_t table_size = (bucket_count + entry_count) * sizeof(s32);
+
+        /* Allocate the table; if we can't, we'll just use linear search. */
+        s32 *table = static_cast<s32 *>(m_allocator->Allocate(table_size));
+        if (table == nullptr) {
+            return;
+        }
+
+        /* Clear the buckets. */
+        s32 * const buckets = table;
+        s32 * const links   = table + bucket_count;
+        std::fill(buckets, buckets + bucket_count, -1);
+
+        /* Insert entries in reverse order, so that each chain is ordered by ascending index. */
+        /* This ensures lookup finds the same entry as a linear search would, even if names are duplicated. */
+        for (s32 i = entry_count - 1; i >= 0; --i) {
+            const u32 bucket = CalculateEntryNameHash(std::addressof(m_name_table[m_entries[i].name_offset])) & (bucket_count - 1);
+            links[i]         = buckets[bucket];
+            buckets[bucket]  = i;
+        }
+
+        /* Set the table. */
+        m_index_table        = table;
+        m_index_table_size   = table_size;
+        m_index_bucket_count = bucket_count;
+    }
+
+    template <typename Format>
+    void PartitionFileSystemMetaCore<Format>::DeallocateIndexTable() {
+        if (m_index_table != nullptr) {
+            AMS_ABORT_UNLESS(m_allocator != nullptr);
+            m_allocator->Deallocate(m_index_table, m_index_table_size);
+            m_index_table        = nullptr;
+            m_index_table_size   = 0;
+            m_index_bucket_count = 0;
+        }
+    }
+
     template <typename Format>
     const typename Format::PartitionEntry *PartitionFileSystemMetaCore<Format>::GetEntry(s32 index) const {
         if (m_initialized && 0 <= index && index < static_cast<s32>(m_header->entry_count)) {
@@ -110,6 +200,33 @@ namespace ams::fssystem {
             return 0;
         }
 
+        /* Use the index table, if we have one. */
+        if (m_index_table != nullptr) {
+            return this->GetEntryIndexByIndexTable(name);
+        } else {
+            return this->GetEntryIndexByLinearSearch(name);
+        }
+    }
+
+    template <typename Format>
+    s32 PartitionFileSystemMetaCore<Format>::GetEntryIndexByIndexTable(const char *name) const {
+        const s32 * const buckets = m_index_table;
+        const s32 * const links   = m_index_table + m_index_bucket_count;
+
+        /* Walk the chain for the name's bucket. */
+        for (s32 i = buckets[CalculateEntryNameHash(name) & (m_index_bucket_count - 1)]; i >= 0; i = links[i]) {
+            /* NOTE: All names were verified to be terminated within the name table when the index table was built. */
+            if (std::strcmp(std::addressof(m_name_table[m_entries[i].name_offset]), name) == 0) {
+                return i;
+            }
+        }
+
+        /* Not found. */
+        return -1;
+    }
+
+    template <typename Format>
+    s32 PartitionFileSystemMetaCore<Format>::GetEntryIndexByLinearSearch(const char *name) const {
         for (s32 i = 0; i < static_cast<s32>(m_header->entry_count); i++) {
             const auto &entry = m_entries[i];
 
@@ -213,6 +330,9 @@ namespace ams::fssystem {
 
         /* We initialized. */
         m_initialized = true;
+
+        /* Build the index table, if we can. */
+        this->BuildIndexTable();
         R_SUCCEED();
     }
 
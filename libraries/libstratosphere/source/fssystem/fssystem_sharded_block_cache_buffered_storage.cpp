@@ -0,0 +1,969 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+
+namespace ams::fssystem {
+
+    namespace {
+
+        ALWAYS_INLINE u64 HashBlockOffset(s64 block_offset, size_t block_shift) {
+            /* Fibonacci hashing spreads neighbouring blocks across shards and index slots. */
+            return static_cast<u64>(block_offset >> block_shift) * UINT64_C(0x9E3779B97F4A7C15);
+        }
+
+    }
+
+    ShardedBlockCacheBufferedStorage::ShardedBlockCacheBufferedStorage() : m_data_storage(), m_buffer_manager(), m_data_size(), m_verification_block_size(), m_verification_block_shift(), m_buffer_level(-1), m_shard_count(), m_shard_entry_count(), m_index_table_size(), m_shards(), m_entries(), m_index_tables(), m_last_result_mutex(), m_last_result(ResultSuccess()), m_is_keep_burst_mode(), m_is_writable() {
+        /* ... */
+    }
+
+    ShardedBlockCacheBufferedStorage::~ShardedBlockCacheBufferedStorage() {
+        this->Finalize();
+    }
+
+    Result ShardedBlockCacheBufferedStorage::Initialize(fs::IBufferManager *bm, IStorage *data, s64 data_size, size_t verif_block_size, s32 max_cache_entries, s32 shard_count, s8 buffer_level, bool is_keep_burst_mode, bool is_writable) {
+        /* Validate preconditions. */
+        AMS_ASSERT(data != nullptr);
+        AMS_ASSERT(bm   != nullptr);
+        AMS_ASSERT(!this->IsInitialized());
+        AMS_ASSERT(max_cache_entries > 0);
+        AMS_ASSERT(0 < shard_count && shard_count <= ShardCountMax);
+        AMS_ASSERT(util::IsPowerOfTwo(shard_count));
+        AMS_ASSERT(util::IsPowerOfTwo(verif_block_size));
+
+        /* Determine our geometry. Index tables are kept at most half full, so that probe sequences stay short. */
+        const s32 shard_entry_count = static_cast<s32>(util::DivideUp(max_cache_entries, shard_count));
+        const s32 index_table_size  = static_cast<s32>(util::CeilingPowerOfTwo(static_cast<u32>(shard_entry_count * 2)));
+
+        /* Allocate the entries and index tables. */
+        auto entries = fs::impl::MakeUnique<CacheEntry[]>(static_cast<size_t>(shard_count * shard_entry_count));
+        R_UNLESS(entries != nullptr, fs::ResultAllocationMemoryFailedInBlockCacheBufferedStorageA());
+
+        auto index_tables = fs::impl::MakeUnique<CacheIndex[]>(static_cast<size_t>(shard_count * index_table_size));
+        R_UNLESS(index_tables != nullptr, fs::ResultAllocationMemoryFailedInBlockCacheBufferedStorageA());
+
+        std::memset(entries.get(), 0, sizeof(CacheEntry) * shard_count * shard_entry_count);
+        std::fill_n(index_tables.get(), shard_count * index_table_size, InvalidCacheIndex);
+
+        /* Setup our shards. */
+        for (s32 i = 0; i < shard_count; ++i) {
+            m_shards[i].entries     = entries.get() + shard_entry_count * i;
+            m_shards[i].index_table = index_tables.get() + index_table_size * i;
+            m_shards[i].access_tick         = 0;
+            m_shards[i].generation          = 0;
+            m_shards[i].direct_access_count = 0;
+        }
+
+        /* Set members. */
+        m_entries                  = std::move(entries);
+        m_index_tables             = std::move(index_tables);
+        m_data_storage             = data;
+        m_buffer_manager           = bm;
+        m_data_size                = data_size;
+        m_verification_block_size  = verif_block_size;
+        m_verification_block_shift = util::CountTrailingZeros(verif_block_size);
+        m_buffer_level             = buffer_level;
+        m_shard_count              = shard_count;
+        m_shard_entry_count        = shard_entry_count;
+        m_index_table_size         = index_table_size;
+        m_last_result              = ResultSuccess();
+        m_is_keep_burst_mode       = is_keep_burst_mode;
+        m_is_writable              = is_writable;
+
+        R_SUCCEED();
+    }
+
+    void ShardedBlockCacheBufferedStorage::Finalize() {
+        if (this->IsInitialized()) {
+            /* Invalidate all cache entries. */
+            static_cast<void>(this->InvalidateAllCacheEntries());
+
+            /* Clear our shards. */
+            for (s32 i = 0; i < m_shard_count; ++i) {
+                m_shards[i].entries     = nullptr;
+                m_shards[i].index_table = nullptr;
+            }
+
+            /* Clear members. */
+            m_entries.reset();
+            m_index_tables.reset();
+            m_data_storage             = nullptr;
+            m_buffer_manager           = nullptr;
+            m_data_size                = 0;
+            m_verification_block_size  = 0;
+            m_verification_block_shift = 0;
+            m_shard_count              = 0;
+            m_shard_entry_count        = 0;
+            m_index_table_size         = 0;
+        }
+    }
+
+    Result ShardedBlockCacheBufferedStorage::Read(s64 offset, void *buffer, size_t size) {
+        /* Validate pre-conditions. */
+        AMS_ASSERT(this->IsInitialized());
+
+        /* Ensure we aren't already in a failed state. */
+        R_TRY(this->GetLastResult());
+
+        /* Succeed if zero-size. */
+        R_SUCCEED_IF(size == 0);
+
+        /* Validate arguments. */
+        R_UNLESS(buffer != nullptr, fs::ResultNullptrArgument());
+
+        /* Determine the extents to read. */
+        R_UNLESS(offset < m_data_size, fs::ResultInvalidOffset());
+
+        if (static_cast<s64>(offset + size) > m_data_size) {
+            size = static_cast<size_t>(m_data_size - offset);
+        }
+
+        /* Read the data. */
+        const size_t block_alignment = m_verification_block_size;
+        char *dst = static_cast<char *>(buffer);
+        while (size > 0) {
+            const s64 block_offset = util::AlignDown(offset, block_alignment);
+
+            /* If conditions allow us to, read in burst mode. This doesn't use the cache. */
+            if (this->IsEnabledKeepBurstMode() && offset == block_offset && (block_alignment * 2 <= size)) {
+                const size_t aligned_size = util::AlignDown(size, block_alignment);
+
+                /* Flush the entries. */
+                R_TRY(this->UpdateLastResult(this->FlushRangeCacheEntries(offset, aligned_size, false)));
+
+                /* Read the data. */
+                R_TRY(this->UpdateLastResult(m_data_storage->Read(offset, dst, aligned_size)));
+
+                /* Advance. */
+                dst    += aligned_size;
+                offset += aligned_size;
+                size   -= aligned_size;
+            } else {
+                /* Read the part of the block we need through the cache. */
+                const size_t offset_in_block = static_cast<size_t>(offset - block_offset);
+                const size_t copy_size       = std::min(size, block_alignment - offset_in_block);
+                R_TRY(this->ReadBlock(block_offset, offset_in_block, dst, copy_size));
+
+                /* Advance. */
+                dst    += copy_size;
+                offset += copy_size;
+                size   -= copy_size;
+            }
+        }
+
+        R_SUCCEED();
+    }
+
+    Result ShardedBlockCacheBufferedStorage::Write(s64 offset, const void *buffer, size_t size) {
+        /* Validate pre-conditions. */
+        AMS_ASSERT(this->IsInitialized());
+
+        /* Ensure we aren't already in a failed state. */
+        R_TRY(this->GetLastResult());
+
+        /* Succeed if zero-size. */
+        R_SUCCEED_IF(size == 0);
+
+        /* Validate arguments. */
+        R_UNLESS(buffer != nullptr, fs::ResultNullptrArgument());
+
+        /* Determine the extents to write. */
+        R_UNLESS(offset < m_data_size, fs::ResultInvalidOffset());
+
+        if (static_cast<s64>(offset + size) > m_data_size) {
+            size = static_cast<size_t>(m_data_size - offset);
+        }
+
+        /* The actual extents may be zero-size, so succeed if that's the case. */
+        R_SUCCEED_IF(size == 0);
+
+        /* Write the data. */
+        const size_t block_alignment = m_verification_block_size;
+        const char *src = static_cast<const char *>(buffer);
+        while (size > 0) {
+            const s64 block_offset = util::AlignDown(offset, block_alignment);
+
+            /* If conditions allow us to, write in burst mode. This doesn't use the cache. */
+            if (this->IsEnabledKeepBurstMode() && offset == block_offset && (block_alignment * 2 <= size)) {
+                const size_t aligned_size = util::AlignDown(size, block_alignment);
+
+                /* Prevent any concurrent loads from caching data from before the write. */
+                this->BeginDirectAccess();
+                ON_SCOPE_EXIT { this->EndDirectAccess(); };
+
+                /* Flush and invalidate the entries. */
+                R_TRY(this->UpdateLastResult(this->FlushRangeCacheEntries(offset, aligned_size, true)));
+
+                /* Write the data. */
+                R_TRY(this->UpdateLastResult(m_data_storage->Write(offset, src, aligned_size)));
+
+                /* Advance. */
+                src    += aligned_size;
+                offset += aligned_size;
+                size   -= aligned_size;
+            } else {
+                /* Write the part of the block we were given into the cache. */
+                const size_t offset_in_block = static_cast<size_t>(offset - block_offset);
+                const size_t copy_size       = std::min(size, block_alignment - offset_in_block);
+                R_TRY(this->WriteBlock(block_offset, offset_in_block, src, copy_size));
+
+                /* Advance. */
+                src    += copy_size;
+                offset += copy_size;
+                size   -= copy_size;
+            }
+
+            /* Set blocking buffer manager allocations. */
+            buffers::EnableBlockingBufferManagerAllocation();
+        }
+
+        /* Ensure that didn't end up in a failure state. */
+        R_TRY(this->GetLastResult());
+
+        R_SUCCEED();
+    }
+
+    Result ShardedBlockCacheBufferedStorage::GetSize(s64 *out) {
+        /* Validate pre-conditions. */
+        AMS_ASSERT(out != nullptr);
+        AMS_ASSERT(m_data_storage != nullptr);
+
+        /* Set the size. */
+        *out = m_data_size;
+        R_SUCCEED();
+    }
+
+    Result ShardedBlockCacheBufferedStorage::Flush() {
+        /* Validate pre-conditions. */
+        AMS_ASSERT(this->IsInitialized());
+
+        /* Ensure we aren't already in a failed state. */
+        R_TRY(this->GetLastResult());
+
+        /* Flush all cache entries. */
+        R_TRY(this->UpdateLastResult(this->FlushAllCacheEntries()));
+
+        /* Flush the data storage. */
+        R_TRY(this->UpdateLastResult(m_data_storage->Flush()));
+
+        /* Set blocking buffer manager allocations. */
+        buffers::EnableBlockingBufferManagerAllocation();
+
+        R_SUCCEED();
+    }
+
+    Result ShardedBlockCacheBufferedStorage::OperateRange(void *dst, size_t dst_size, fs::OperationId op_id, s64 offset, s64 size, const void *src, size_t src_size) {
+        AMS_UNUSED(src, src_size);
+
+        /* Validate pre-conditions. */
+        AMS_ASSERT(m_data_storage != nullptr);
+
+        switch (op_id) {
+            case fs::OperationId::FillZero:
+                {
+                    R_RETURN(this->FillZeroImpl(offset, size));
+                }
+            case fs::OperationId::DestroySignature:
+                {
+                    R_RETURN(this->DestroySignatureImpl(offset, size));
+                }
+            case fs::OperationId::Invalidate:
+                {
+                    R_UNLESS(!m_is_writable, fs::ResultUnsupportedOperateRangeForWritableBlockCacheBufferedStorage());
+                    R_RETURN(this->InvalidateImpl());
+                }
+            case fs::OperationId::QueryRange:
+                {
+                    R_RETURN(this->QueryRangeImpl(dst, dst_size, offset, size));
+                }
+            default:
+                R_THROW(fs::ResultUnsupportedOperateRangeForBlockCacheBufferedStorage());
+        }
+    }
+
+    Result ShardedBlockCacheBufferedStorage::Commit() {
+        /* Validate pre-conditions. */
+        AMS_ASSERT(this->IsInitialized());
+
+        /* Ensure we aren't already in a failed state. */
+        R_TRY(this->GetLastResult());
+
+        /* Flush all cache entries. */
+        R_TRY(this->UpdateLastResult(this->FlushAllCacheEntries()));
+
+        R_SUCCEED();
+    }
+
+    Result ShardedBlockCacheBufferedStorage::OnRollback() {
+        /* Validate pre-conditions. */
+        AMS_ASSERT(this->IsInitialized());
+
+        /* Ensure we aren't already in a failed state. */
+        R_TRY(this->GetLastResult());
+
+        /* Release all valid entries back to the buffer manager, discarding any unwritten data. */
+        for (s32 i = 0; i < m_shard_count; ++i) {
+            auto &shard = m_shards[i];
+            std::scoped_lock lk(shard.mutex);
+
+            for (CacheIndex index = 0; index < m_shard_entry_count; ++index) {
+                if (shard.entries[index].is_valid) {
+                    this->InvalidateCacheEntry(shard, index);
+                }
+            }
+        }
+
+        R_SUCCEED();
+    }
+
+    Result ShardedBlockCacheBufferedStorage::FillZeroImpl(s64 offset, s64 size) {
+        /* Ensure we aren't already in a failed state. */
+        R_TRY(this->GetLastResult());
+
+        /* Get our storage size. */
+        s64 storage_size = 0;
+        R_TRY(this->UpdateLastResult(m_data_storage->GetSize(std::addressof(storage_size))));
+
+        /* Check the access range. */
+        R_UNLESS(0 <= offset && offset < storage_size, fs::ResultInvalidOffset());
+
+        /* Determine the extents to data signature for. */
+        auto start_offset = util::AlignDown(offset, m_verification_block_size);
+        auto end_offset   = util::AlignUp(std::min(offset + size, storage_size), m_verification_block_size);
+
+        /* Prevent any concurrent loads from caching data from before the clear. */
+        this->BeginDirectAccess();
+        ON_SCOPE_EXIT { this->EndDirectAccess(); };
+
+        /* Flush the entries. */
+        R_TRY(this->UpdateLastResult(this->FlushRangeCacheEntries(offset, size, true)));
+
+        /* Handle any data before or after the aligned range. */
+        if (start_offset < offset || offset + size < end_offset) {
+            /* Allocate a work buffer. */
+            std::unique_ptr<char[], fs::impl::Deleter> work = fs::impl::MakeUnique<char[]>(m_verification_block_size);
+            R_UNLESS(work != nullptr, fs::ResultAllocationMemoryFailedInBlockCacheBufferedStorageB());
+
+            /* Handle data before the aligned range. */
+            if (start_offset < offset) {
+                /* Read the block. */
+                R_TRY(this->UpdateLastResult(m_data_storage->Read(start_offset, work.get(), m_verification_block_size)));
+
+                /* Determine the partial extents to clear. */
+                const auto clear_offset = static_cast<size_t>(offset - start_offset);
+                const auto clear_size   = static_cast<size_t>(std::min(static_cast<s64>(m_verification_block_size - clear_offset), size));
+
+                /* Clear the partial block. */
+                std::memset(work.get() + clear_offset, 0, clear_size);
+
+                /* Write the partially cleared block. */
+                R_TRY(this->UpdateLastResult(m_data_storage->Write(start_offset, work.get(), m_verification_block_size)));
+
+                /* Update the start offset. */
+                start_offset += m_verification_block_size;
+
+                /* Set blocking buffer manager allocations. */
+                buffers::EnableBlockingBufferManagerAllocation();
+            }
+
+            /* Handle data after the aligned range. */
+            if (start_offset < offset + size && offset + size < end_offset) {
+                /* Read the block. */
+                const auto last_offset = end_offset - m_verification_block_size;
+                R_TRY(this->UpdateLastResult(m_data_storage->Read(last_offset, work.get(), m_verification_block_size)));
+
+                /* Clear the partial block. */
+                const auto clear_size = static_cast<size_t>((offset + size) - last_offset);
+                std::memset(work.get(), 0, clear_size);
+
+                /* Write the partially cleared block. */
+                R_TRY(this->UpdateLastResult(m_data_storage->Write(last_offset, work.get(), m_verification_block_size)));
+
+                /* Update the end offset. */
+                end_offset -= m_verification_block_size;
+
+                /* Set blocking buffer manager allocations. */
+                buffers::EnableBlockingBufferManagerAllocation();
+            }
+        }
+
+        /* We're done if there's no data to clear. */
+        R_SUCCEED_IF(start_offset == end_offset);
+
+        /* Clear the signature for the aligned range. */
+        R_TRY(this->UpdateLastResult(m_data_storage->OperateRange(fs::OperationId::FillZero, start_offset, end_offset - start_offset)));
+
+        /* Set blocking buffer manager allocations. */
+        buffers::EnableBlockingBufferManagerAllocation();
+
+        R_SUCCEED();
+    }
+
+    Result ShardedBlockCacheBufferedStorage::DestroySignatureImpl(s64 offset, s64 size) {
+        /* Ensure we aren't already in a failed state. */
+        R_TRY(this->GetLastResult());
+
+        /* Get our storage size. */
+        s64 storage_size = 0;
+        R_TRY(this->UpdateLastResult(m_data_storage->GetSize(std::addressof(storage_size))));
+
+        /* Check the access range. */
+        R_UNLESS(0 <= offset && offset < storage_size, fs::ResultInvalidOffset());
+
+        /* Determine the extents to clear signature for. */
+        const auto start_offset = util::AlignUp(offset, m_verification_block_size);
+        const auto end_offset   = util::AlignDown(std::min(offset + size, storage_size), m_verification_block_size);
+
+        /* Prevent any concurrent loads from caching data from before the clear. */
+        this->BeginDirectAccess();
+        ON_SCOPE_EXIT { this->EndDirectAccess(); };
+
+        /* Flush the entries. */
+        R_TRY(this->UpdateLastResult(this->FlushRangeCacheEntries(offset, size, true)));
+
+        /* Clear the signature for the aligned range. */
+        R_TRY(this->UpdateLastResult(m_data_storage->OperateRange(fs::OperationId::DestroySignature, start_offset, end_offset - start_offset)));
+
+        /* Set blocking buffer manager allocations. */
+        buffers::EnableBlockingBufferManagerAllocation();
+
+        R_SUCCEED();
+    }
+
+    Result ShardedBlockCacheBufferedStorage::InvalidateImpl() {
+        /* Prevent any concurrent loads from caching data from before the invalidation. */
+        this->BeginDirectAccess();
+        ON_SCOPE_EXIT { this->EndDirectAccess(); };
+
+        /* Invalidate cache entries. */
+        for (s32 i = 0; i < m_shard_count; ++i) {
+            auto &shard = m_shards[i];
+            std::scoped_lock lk(shard.mutex);
+
+            for (CacheIndex index = 0; index < m_shard_entry_count; ++index) {
+                if (shard.entries[index].is_valid) {
+                    this->InvalidateCacheEntry(shard, index);
+                }
+            }
+        }
+
+        /* Invalidate the aligned range. */
+        {
+            Result result = m_data_storage->OperateRange(fs::OperationId::Invalidate, 0, std::numeric_limits<s64>::max());
+            AMS_ASSERT(!fs::ResultBufferAllocationFailed::Includes(result));
+            R_TRY(result);
+        }
+
+        /* Clear our last result if we should. */
+        {
+            std::scoped_lock lk(m_last_result_mutex);
+            if (fs::ResultIntegrityVerificationStorageCorrupted::Includes(m_last_result)) {
+                m_last_result = ResultSuccess();
+            }
+        }
+
+        R_SUCCEED();
+    }
+
+    Result ShardedBlockCacheBufferedStorage::QueryRangeImpl(void *dst, size_t dst_size, s64 offset, s64 size) {
+        /* Get our storage size. */
+        s64 storage_size = 0;
+        R_TRY(this->GetSize(std::addressof(storage_size)));
+
+        /* Determine the extents we can actually query. */
+        const auto actual_size        = std::min(size, storage_size - offset);
+        const auto aligned_offset     = util::AlignDown(offset, m_verification_block_size);
+        const auto aligned_offset_end = util::AlignUp(offset + actual_size, m_verification_block_size);
+        const auto aligned_size       = aligned_offset_end - aligned_offset;
+
+        /* Query the aligned range. */
+        R_TRY(this->UpdateLastResult(m_data_storage->OperateRange(dst, dst_size, fs::OperationId::QueryRange, aligned_offset, aligned_size, nullptr, 0)));
+
+        R_SUCCEED();
+    }
+
+    Result ShardedBlockCacheBufferedStorage::ReadBlock(s64 block_offset, size_t offset_in_block, void *buffer, size_t size) {
+        AMS_ASSERT(util::IsAligned(block_offset, m_verification_block_size));
+        AMS_ASSERT(offset_in_block + size <= m_verification_block_size);
+
+        auto &shard = this->GetShard(block_offset);
+
+        /* If the block is cached, copy out of the cache while we hold the shard's lock. */
+        LoadTicket ticket;
+        {
+            std::scoped_lock lk(shard.mutex);
+
+            if (const auto index = this->FindCacheEntry(shard, block_offset); index != InvalidCacheIndex) {
+                MemoryRange range;
+                if (this->AcquireCacheEntryMemory(std::addressof(range), shard, index)) {
+                    std::memcpy(buffer, reinterpret_cast<const char *>(range.first) + offset_in_block, size);
+
+                    /* Give the buffer back to the buffer manager, if we're not holding it for write-back. */
+                    auto &entry = shard.entries[index];
+                    if (!entry.is_write_back) {
+                        entry.handle = m_buffer_manager->RegisterCache(range, fs::IBufferManager::BufferAttribute(m_buffer_level));
+                    }
+                    entry.last_access = ++shard.access_tick;
+
+                    R_SUCCEED();
+                }
+            }
+
+            ticket = this->BeginLoad(shard);
+        }
+
+        /* The block isn't cached, so read it without holding the lock. */
+        R_TRY(this->UpdateLastResult(this->PrepareAllocation()));
+
+        MemoryRange range;
+        R_TRY(this->UpdateLastResult(this->AllocateBuffer(std::addressof(range))));
+
+        if (const Result result = m_data_storage->Read(block_offset, reinterpret_cast<void *>(range.first), m_verification_block_size); R_FAILED(result)) {
+            m_buffer_manager->DeallocateBuffer(range);
+            R_RETURN(this->UpdateLastResult(result));
+        }
+
+        std::memcpy(buffer, reinterpret_cast<const char *>(range.first) + offset_in_block, size);
+
+        /* Store the block, unless someone else cached it or the data storage may have changed while we were reading. */
+        {
+            std::scoped_lock lk(shard.mutex);
+
+            if (this->FindCacheEntry(shard, block_offset) != InvalidCacheIndex || !this->IsLoadStorable(shard, ticket)) {
+                m_buffer_manager->DeallocateBuffer(range);
+            } else {
+                R_TRY(this->UpdateLastResult(this->StoreCacheEntry(shard, block_offset, range, false)));
+            }
+        }
+
+        R_SUCCEED();
+    }
+
+    Result ShardedBlockCacheBufferedStorage::WriteBlock(s64 block_offset, size_t offset_in_block, const void *buffer, size_t size) {
+        AMS_ASSERT(util::IsAligned(block_offset, m_verification_block_size));
+        AMS_ASSERT(offset_in_block + size <= m_verification_block_size);
+
+        auto &shard = this->GetShard(block_offset);
+
+        /* Writes the data into a cached entry, making it write-back. */
+        const auto WriteToCacheEntry = [&](CacheIndex index) ALWAYS_INLINE_LAMBDA -> bool {
+            MemoryRange range;
+            if (!this->AcquireCacheEntryMemory(std::addressof(range), shard, index)) {
+                return false;
+            }
+
+            /* Write-back entries hold their buffer until they're flushed. */
+            auto &entry = shard.entries[index];
+            if (!entry.is_write_back) {
+                entry.is_write_back  = true;
+                entry.handle         = 0;
+                entry.memory_address = range.first;
+                entry.memory_size    = range.second;
+            }
+
+            std::memcpy(reinterpret_cast<char *>(range.first) + offset_in_block, buffer, size);
+            entry.last_access = ++shard.access_tick;
+            return true;
+        };
+
+        const bool is_partial = offset_in_block != 0 || size != m_verification_block_size;
+
+        while (true) {
+            /* If the block is cached, write into the cache. */
+            LoadTicket ticket;
+            {
+                std::scoped_lock lk(shard.mutex);
+
+                if (const auto index = this->FindCacheEntry(shard, block_offset); index != InvalidCacheIndex && WriteToCacheEntry(index)) {
+                    R_TRY(this->UpdateLastResult(this->ControlDirtiness(shard)));
+                    R_SUCCEED();
+                }
+
+                ticket = this->BeginLoad(shard);
+            }
+
+            /* Allocate a buffer for the block. */
+            R_TRY(this->UpdateLastResult(this->PrepareAllocation()));
+
+            MemoryRange range;
+            R_TRY(this->UpdateLastResult(this->AllocateBuffer(std::addressof(range))));
+
+            /* If we're writing a partial block, read in the rest of it. */
+            if (is_partial) {
+                if (const Result result = m_data_storage->Read(block_offset, reinterpret_cast<void *>(range.first), m_verification_block_size); R_FAILED(result)) {
+                    m_buffer_manager->DeallocateBuffer(range);
+                    R_RETURN(this->UpdateLastResult(result));
+                }
+            }
+
+            /* Store the block. If someone else cached it in the meantime, write into theirs instead. */
+            {
+                std::scoped_lock lk(shard.mutex);
+
+                if (const auto index = this->FindCacheEntry(shard, block_offset); index != InvalidCacheIndex && WriteToCacheEntry(index)) {
+                    m_buffer_manager->DeallocateBuffer(range);
+                } else if (!is_partial || this->IsLoadStorable(shard, ticket)) {
+                    std::memcpy(reinterpret_cast<char *>(range.first) + offset_in_block, buffer, size);
+                    R_TRY(this->UpdateLastResult(this->StoreCacheEntry(shard, block_offset, range, true)));
+                } else {
+                    /* The rest of the block we read may be stale, so try again. */
+                    m_buffer_manager->DeallocateBuffer(range);
+                    continue;
+                }
+
+                R_TRY(this->UpdateLastResult(this->ControlDirtiness(shard)));
+            }
+
+            R_SUCCEED();
+        }
+    }
+
+    void ShardedBlockCacheBufferedStorage::BeginDirectAccess() {
+        for (s32 i = 0; i < m_shard_count; ++i) {
+            auto &shard = m_shards[i];
+            std::scoped_lock lk(shard.mutex);
+
+            ++shard.generation;
+            ++shard.direct_access_count;
+        }
+    }
+
+    void ShardedBlockCacheBufferedStorage::EndDirectAccess() {
+        for (s32 i = 0; i < m_shard_count; ++i) {
+            auto &shard = m_shards[i];
+            std::scoped_lock lk(shard.mutex);
+
+            AMS_ASSERT(shard.direct_access_count > 0);
+            --shard.direct_access_count;
+        }
+    }
+
+    ShardedBlockCacheBufferedStorage::LoadTicket ShardedBlockCacheBufferedStorage::BeginLoad(const Shard &shard) const {
+        AMS_ASSERT(shard.mutex.IsLockedByCurrentThread());
+
+        return LoadTicket{ shard.generation, shard.direct_access_count == 0 };
+    }
+
+    bool ShardedBlockCacheBufferedStorage::IsLoadStorable(const Shard &shard, const LoadTicket &ticket) const {
+        AMS_ASSERT(shard.mutex.IsLockedByCurrentThread());
+
+        return ticket.is_storable && ticket.generation == shard.generation;
+    }
+
+    ShardedBlockCacheBufferedStorage::Shard &ShardedBlockCacheBufferedStorage::GetShard(s64 block_offset) {
+        const auto hash = HashBlockOffset(block_offset, m_verification_block_shift);
+        return m_shards[static_cast<s32>(hash >> 56) & (m_shard_count - 1)];
+    }
+
+    s32 ShardedBlockCacheBufferedStorage::GetIndexSlot(s64 block_offset) const {
+        const auto hash = HashBlockOffset(block_offset, m_verification_block_shift);
+        return static_cast<s32>(hash >> 24) & (m_index_table_size - 1);
+    }
+
+    ShardedBlockCacheBufferedStorage::CacheIndex ShardedBlockCacheBufferedStorage::FindCacheEntry(Shard &shard, s64 block_offset) const {
+        AMS_ASSERT(shard.mutex.IsLockedByCurrentThread());
+
+        /* Probe linearly from the block's home slot until we find it or hit an empty slot. */
+        for (s32 slot = this->GetIndexSlot(block_offset); shard.index_table[slot] != InvalidCacheIndex; slot = (slot + 1) & (m_index_table_size - 1)) {
+            if (const auto index = shard.index_table[slot]; shard.entries[index].offset == block_offset) {
+                AMS_ASSERT(shard.entries[index].is_valid);
+                return index;
+            }
+        }
+
+        return InvalidCacheIndex;
+    }
+
+    void ShardedBlockCacheBufferedStorage::InsertIndex(Shard &shard, CacheIndex index) {
+        AMS_ASSERT(shard.mutex.IsLockedByCurrentThread());
+        AMS_ASSERT(shard.entries[index].is_valid);
+
+        s32 slot = this->GetIndexSlot(shard.entries[index].offset);
+        while (shard.index_table[slot] != InvalidCacheIndex) {
+            slot = (slot + 1) & (m_index_table_size - 1);
+        }
+
+        shard.index_table[slot] = index;
+    }
+
+    void ShardedBlockCacheBufferedStorage::EraseIndex(Shard &shard, CacheIndex index) {
+        AMS_ASSERT(shard.mutex.IsLockedByCurrentThread());
+
+        const s32 mask = m_index_table_size - 1;
+
+        /* Find the slot holding the entry. */
+        s32 slot = this->GetIndexSlot(shard.entries[index].offset);
+        while (shard.index_table[slot] != index) {
+            AMS_ASSERT(shard.index_table[slot] != InvalidCacheIndex);
+            slot = (slot + 1) & mask;
+        }
+
+        /* Remove it, shifting back any later entries in the probe sequence which can no longer be reached. */
+        shard.index_table[slot] = InvalidCacheIndex;
+        for (s32 next = (slot + 1) & mask; shard.index_table[next] != InvalidCacheIndex; next = (next + 1) & mask) {
+            const s32 home = this->GetIndexSlot(shard.entries[shard.index_table[next]].offset);
+            if (((next - home) & mask) >= ((next - slot) & mask)) {
+                shard.index_table[slot] = shard.index_table[next];
+                shard.index_table[next] = InvalidCacheIndex;
+                slot = next;
+            }
+        }
+    }
+
+    bool ShardedBlockCacheBufferedStorage::AcquireCacheEntryMemory(MemoryRange *out_range, Shard &shard, CacheIndex index) {
+        AMS_ASSERT(shard.mutex.IsLockedByCurrentThread());
+
+        auto &entry = shard.entries[index];
+        AMS_ASSERT(entry.is_valid);
+
+        /* Write-back entries own their buffer. */
+        if (entry.is_write_back) {
+            *out_range = fs::IBufferManager::MakeMemoryRange(entry.memory_address, entry.memory_size);
+            return true;
+        }
+
+        /* Otherwise, the buffer manager may have reclaimed the buffer since we registered it. */
+        *out_range   = m_buffer_manager->AcquireCache(entry.handle);
+        entry.handle = 0;
+        if (out_range->first == 0) {
+            this->EraseIndex(shard, index);
+            entry.is_valid = false;
+            return false;
+        }
+
+        return true;
+    }
+
+    void ShardedBlockCacheBufferedStorage::InvalidateCacheEntry(Shard &shard, CacheIndex index) {
+        AMS_ASSERT(shard.mutex.IsLockedByCurrentThread());
+
+        auto &entry = shard.entries[index];
+        AMS_ASSERT(entry.is_valid);
+
+        /* Release the entry's buffer. */
+        if (entry.is_write_back) {
+            AMS_ASSERT(entry.memory_address != 0 && entry.handle == 0);
+            m_buffer_manager->DeallocateBuffer(entry.memory_address, entry.memory_size);
+        } else {
+            if (const auto memory_range = m_buffer_manager->AcquireCache(entry.handle); memory_range.first) {
+                m_buffer_manager->DeallocateBuffer(memory_range);
+            }
+        }
+
+        /* Set entry as invalid. */
+        this->EraseIndex(shard, index);
+        entry.is_valid       = false;
+        entry.is_write_back  = false;
+        entry.handle         = 0;
+        entry.memory_address = 0;
+        entry.memory_size    = 0;
+    }
+
+    Result ShardedBlockCacheBufferedStorage::StoreCacheEntry(Shard &shard, s64 block_offset, const MemoryRange &range, bool is_write_back) {
+        AMS_ASSERT(shard.mutex.IsLockedByCurrentThread());
+        AMS_ASSERT(this->FindCacheEntry(shard, block_offset) == InvalidCacheIndex);
+
+        /* In the event that we fail, release our buffer. */
+        ON_RESULT_FAILURE { m_buffer_manager->DeallocateBuffer(range); };
+
+        /* Find an empty entry, or else the least recently used one. */
+        CacheIndex empty_index = InvalidCacheIndex, lru_index = InvalidCacheIndex;
+        for (CacheIndex index = 0; index < m_shard_entry_count; ++index) {
+            if (const auto &entry = shard.entries[index]; entry.is_valid) {
+                if (lru_index == InvalidCacheIndex || static_cast<u32>(shard.access_tick - shard.entries[lru_index].last_access) < static_cast<u32>(shard.access_tick - entry.last_access)) {
+                    lru_index = index;
+                }
+            } else {
+                empty_index = index;
+                break;
+            }
+        }
+
+        /* If all entries are valid, we need to evict one. */
+        if (empty_index == InvalidCacheIndex) {
+            empty_index = lru_index;
+            R_TRY(this->FlushCacheEntry(shard, empty_index, true));
+            AMS_ASSERT(!shard.entries[empty_index].is_valid);
+        }
+
+        /* Store the entry. */
+        auto &entry = shard.entries[empty_index];
+        entry.offset        = block_offset;
+        entry.is_valid      = true;
+        entry.is_write_back = is_write_back;
+        entry.last_access   = ++shard.access_tick;
+        if (is_write_back) {
+            entry.handle         = 0;
+            entry.memory_address = range.first;
+            entry.memory_size    = range.second;
+        } else {
+            entry.handle         = m_buffer_manager->RegisterCache(range, fs::IBufferManager::BufferAttribute(m_buffer_level));
+            entry.memory_address = 0;
+            entry.memory_size    = 0;
+        }
+
+        this->InsertIndex(shard, empty_index);
+        R_SUCCEED();
+    }
+
+    Result ShardedBlockCacheBufferedStorage::FlushCacheEntry(Shard &shard, CacheIndex index, bool invalidate) {
+        AMS_ASSERT(shard.mutex.IsLockedByCurrentThread());
+
+        auto &entry = shard.entries[index];
+        AMS_ASSERT(entry.is_valid);
+
+        /* If we're not write back (i.e. an invalidate is happening), just release the buffer. */
+        if (!entry.is_write_back) {
+            AMS_ASSERT(invalidate);
+
+            this->InvalidateCacheEntry(shard, index);
+            R_SUCCEED();
+        }
+
+        /* Create and check our memory range. */
+        const MemoryRange memory_range = fs::IBufferManager::MakeMemoryRange(entry.memory_address, entry.memory_size);
+        AMS_ASSERT(memory_range.first != 0);
+        AMS_ASSERT(memory_range.second >= m_verification_block_size);
+
+        /* Validate the entry's offset. */
+        AMS_ASSERT(entry.offset >= 0);
+        AMS_ASSERT(entry.offset < m_data_size);
+        AMS_ASSERT(util::IsAligned(entry.offset, m_verification_block_size));
+
+        /* Write back the data. */
+        Result result = this->GetLastResult();
+        if (R_SUCCEEDED(result)) {
+            result = m_data_storage->Write(entry.offset, reinterpret_cast<const void *>(memory_range.first), m_verification_block_size);
+
+            /* Any load which began before the write may have read the old data. */
+            ++shard.generation;
+
+            /* Check the result. */
+            AMS_ASSERT(!fs::ResultBufferAllocationFailed::Includes(result));
+        }
+
+        /* If we're invalidating, release the buffer. Otherwise, register the flushed data. */
+        if (invalidate) {
+            this->InvalidateCacheEntry(shard, index);
+        } else {
+            entry.is_write_back  = false;
+            entry.handle         = m_buffer_manager->RegisterCache(memory_range, fs::IBufferManager::BufferAttribute(m_buffer_level));
+            entry.memory_address = 0;
+            entry.memory_size    = 0;
+        }
+
+        R_RETURN(result);
+    }
+
+    Result ShardedBlockCacheBufferedStorage::AllocateBuffer(MemoryRange *out_range) {
+        const size_t block_alignment = m_verification_block_size;
+        R_RETURN(buffers::AllocateBufferUsingBufferManagerContext(out_range, m_buffer_manager, block_alignment, fs::IBufferManager::BufferAttribute(m_buffer_level), [=](const MemoryRange &buffer) {
+            return buffer.first != 0 && block_alignment <= buffer.second;
+        }, AMS_CURRENT_FUNCTION_NAME));
+    }
+
+    Result ShardedBlockCacheBufferedStorage::PrepareAllocation() {
+        /* Ensure that the allocatable size is above a threshold. */
+        const auto size_threshold = m_buffer_manager->GetTotalSize() / 8;
+        if (m_buffer_manager->GetTotalAllocatableSize() < size_threshold) {
+            R_TRY(this->FlushAllCacheEntries());
+        }
+
+        R_SUCCEED();
+    }
+
+    Result ShardedBlockCacheBufferedStorage::FlushRangeCacheEntries(s64 offset, s64 size, bool invalidate) {
+        /* Validate pre-conditions. */
+        AMS_ASSERT(this->IsInitialized());
+
+        /* Iterate over all entries that fall within the range, one shard at a time. */
+        Result result = ResultSuccess();
+        for (s32 i = 0; i < m_shard_count; ++i) {
+            auto &shard = m_shards[i];
+            std::scoped_lock lk(shard.mutex);
+
+            for (CacheIndex index = 0; index < m_shard_entry_count; ++index) {
+                const auto &entry = shard.entries[index];
+                if (entry.is_valid && (entry.is_write_back || invalidate) && (entry.offset < (offset + size)) && (offset < entry.offset + static_cast<s64>(m_verification_block_size))) {
+                    const auto cur_result = this->FlushCacheEntry(shard, index, invalidate);
+                    if (R_FAILED(cur_result) && R_SUCCEEDED(result)) {
+                        result = cur_result;
+                    }
+                }
+            }
+        }
+
+        R_RETURN(result);
+    }
+
+    Result ShardedBlockCacheBufferedStorage::FlushAllCacheEntries() {
+        R_TRY(this->FlushRangeCacheEntries(0, std::numeric_limits<s64>::max(), false));
+        R_SUCCEED();
+    }
+
+    Result ShardedBlockCacheBufferedStorage::InvalidateAllCacheEntries() {
+        R_TRY(this->FlushRangeCacheEntries(0, std::numeric_limits<s64>::max(), true));
+        R_SUCCEED();
+    }
+
+    Result ShardedBlockCacheBufferedStorage::ControlDirtiness(Shard &shard) {
+        AMS_ASSERT(shard.mutex.IsLockedByCurrentThread());
+
+        /* If we have enough allocatable space, we don't need to do anything. */
+        R_SUCCEED_IF(m_buffer_manager->GetTotalAllocatableSize() >= m_buffer_manager->GetTotalSize() / 4);
+
+        /* Flush the least recently used dirty entries in the shard (up to the threshold). */
+        constexpr auto Threshold = 2;
+        for (int n = 0; n < Threshold; ++n) {
+            auto flushed_index = InvalidCacheIndex;
+            for (CacheIndex index = 0; index < m_shard_entry_count; ++index) {
+                if (const auto &entry = shard.entries[index]; entry.is_valid && entry.is_write_back) {
+                    if (flushed_index == InvalidCacheIndex || static_cast<u32>(shard.access_tick - shard.entries[flushed_index].last_access) < static_cast<u32>(shard.access_tick - entry.last_access)) {
+                        flushed_index = index;
+                    }
+                }
+            }
+
+            /* If we can't flush anything, break. */
+            if (flushed_index == InvalidCacheIndex) {
+                break;
+            }
+
+            R_TRY(this->FlushCacheEntry(shard, flushed_index, false));
+        }
+
+        R_SUCCEED();
+    }
+
+    Result ShardedBlockCacheBufferedStorage::GetLastResult() {
+        std::scoped_lock lk(m_last_result_mutex);
+        R_RETURN(m_last_result);
+    }
+
+    Result ShardedBlockCacheBufferedStorage::UpdateLastResult(Result result) {
+        /* Update the last result. */
+        if (R_FAILED(result) && !fs::ResultBufferAllocationFailed::Includes(result)) {
+            std::scoped_lock lk(m_last_result_mutex);
+            if (R_SUCCEEDED(m_last_result)) {
+                m_last_result = result;
+            }
+        }
+
+        /* Try to succeed with the result. */
+        R_RETURN(result);
+    }
+
+}
@@ -36,10 +36,13 @@ namespace ams::fssystem {
 
             std::memset(buffer, 0, size);
         } else {
-            R_TRY((this->OperatePerEntry<false, true>(offset, size, [=](fs::IStorage *storage, s64 data_offset, s64 cur_offset, s64 cur_size) -> Result {
-                R_TRY(storage->Read(data_offset, reinterpret_cast<u8 *>(buffer) + (cur_offset - offset), static_cast<size_t>(cur_size)));
+            /* Gather the fragments, and read them in as few batches as possible. */
+            ReadRequestBatch batch;
+            R_TRY((this->OperatePerEntry<false, true>(offset, size, [&](fs::IStorage *storage, s64 data_offset, s64 cur_offset, s64 cur_size) -> Result {
+                R_TRY(batch.Add(storage, data_offset, reinterpret_cast<u8 *>(buffer) + (cur_offset - offset), static_cast<size_t>(cur_size)));
                 R_SUCCEED();
             })));
+            R_TRY(batch.Submit());
         }
 
         R_SUCCEED();
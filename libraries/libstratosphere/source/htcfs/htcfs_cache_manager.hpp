@@ -19,24 +19,138 @@
 namespace ams::htcfs {
 
     class CacheManager {
+        public:
+            static constexpr size_t BlockSize           = 4_KB;
+            static constexpr size_t BlockCountMax       = 32;
+            static constexpr size_t FileEntryCount      = 8;
+            static constexpr size_t ReadAheadBlockCount = 8;
+
+            static constexpr s64 UnknownFileSize = -1;
+        private:
+            struct FileEntry {
+                s64 file_size;
+                s64 next_offset;
+                u64 last_used;
+                s32 handle;
+                bool in_use;
+            };
+
+            struct BlockEntry {
+                s64 offset;
+                size_t data_size;
+                u64 last_used;
+                s32 handle;
+                bool in_use;
+            };
         private:
             os::SdkMutex m_mutex;
-            void *m_cache;
-            size_t m_cache_size;
-            s64 m_cached_file_size;
-            size_t m_cached_data_size;
-            s32 m_cached_handle;
-            bool m_has_cached_handle;
+            u8 *m_cache;
+            size_t m_block_count;
+            u64 m_use_counter;
+            FileEntry m_files[FileEntryCount];
+            BlockEntry m_blocks[BlockCountMax];
         public:
-            CacheManager(void *cache, size_t cache_size) : m_mutex(), m_cache(cache), m_cache_size(cache_size), m_cached_file_size(), m_cached_data_size(), m_cached_handle(), m_has_cached_handle() { /* ... */ }
+            CacheManager(void *cache, size_t cache_size) : m_mutex(), m_cache(static_cast<u8 *>(cache)), m_block_count(std::min(cache_size / BlockSize, BlockCountMax)), m_use_counter(), m_files(), m_blocks() {
+                AMS_ASSERT(m_block_count > 0);
+            }
+        private:
+            FileEntry *FindFile(s32 handle) {
+                for (auto &file : m_files) {
+                    if (file.in_use && file.handle == handle) {
+                        return std::addressof(file);
+                    }
+                }
+                return nullptr;
+            }
+
+            BlockEntry *FindBlock(s32 handle, s64 offset) {
+                for (size_t i = 0; i < m_block_count; ++i) {
+                    if (auto &block = m_blocks[i]; block.in_use && block.handle == handle && block.offset == offset) {
+                        return std::addressof(block);
+                    }
+                }
+                return nullptr;
+            }
+
+            u8 *GetBlockData(const BlockEntry *block) const {
+                return m_cache + (block - m_blocks) * BlockSize;
+            }
+
+            void InvalidateImpl(s32 handle) {
+                /* Release the file entry. */
+                if (auto *file = this->FindFile(handle); file != nullptr) {
+                    file->in_use = false;
+                }
+
+                /* Release all of the file's blocks. */
+                for (size_t i = 0; i < m_block_count; ++i) {
+                    if (m_blocks[i].in_use && m_blocks[i].handle == handle) {
+                        m_blocks[i].in_use = false;
+                    }
+                }
+            }
+
+            void RegisterImpl(s32 handle, s64 file_size) {
+                /* Drop anything we have for the handle. */
+                this->InvalidateImpl(handle);
+
+                /* Find a free file entry, evicting the least recently used one if we must. */
+                FileEntry *entry = nullptr;
+                for (auto &file : m_files) {
+                    if (!file.in_use) {
+                        entry = std::addressof(file);
+                        break;
+                    } else if (entry == nullptr || file.last_used < entry->last_used) {
+                        entry = std::addressof(file);
+                    }
+                }
+
+                if (entry->in_use) {
+                    this->InvalidateImpl(entry->handle);
+                }
+
+                /* Set the entry. */
+                *entry = { .file_size = file_size, .next_offset = 0, .last_used = ++m_use_counter, .handle = handle, .in_use = true };
+            }
+
+            void StoreImpl(s32 handle, s64 offset, const void *data, size_t data_size) {
+                AMS_ASSERT(util::IsAligned(offset, BlockSize));
+
+                const u8 *src = static_cast<const u8 *>(data);
+                while (data_size > 0) {
+                    const size_t cur_size = std::min(data_size, BlockSize);
+
+                    /* Find the block to store into, evicting the least recently used one if we must. */
+                    BlockEntry *block = this->FindBlock(handle, offset);
+                    if (block == nullptr) {
+                        for (size_t i = 0; i < m_block_count; ++i) {
+                            if (!m_blocks[i].in_use) {
+                                block = std::addressof(m_blocks[i]);
+                                break;
+                            } else if (block == nullptr || m_blocks[i].last_used < block->last_used) {
+                                block = std::addressof(m_blocks[i]);
+                            }
+                        }
+                    }
+
+                    /* Set the block. */
+                    std::memcpy(this->GetBlockData(block), src, cur_size);
+                    *block = { .offset = offset, .data_size = cur_size, .last_used = ++m_use_counter, .handle = handle, .in_use = true };
+
+                    /* Advance. */
+                    src       += cur_size;
+                    offset    += cur_size;
+                    data_size -= cur_size;
+                }
+            }
         public:
             bool GetFileSize(s64 *out, s32 handle) {
                 /* Lock ourselves. */
                 std::scoped_lock lk(m_mutex);
 
-                /* Get the cached size, if we match. */
-                if (m_has_cached_handle && m_cached_handle == handle) {
-                    *out = m_cached_file_size;
+                /* Get the cached size, if we know it. */
+                if (const auto *file = this->FindFile(handle); file != nullptr && file->file_size != UnknownFileSize) {
+                    *out = file->file_size;
                     return true;
                 } else {
                     return false;
@@ -47,38 +161,90 @@ namespace ams::htcfs {
                 /* Lock ourselves. */
                 std::scoped_lock lk(m_mutex);
 
-                /* Note that we have no handle. */
-                m_has_cached_handle = false;
+                /* Note that we have no handles. */
+                for (auto &file : m_files) {
+                    file.in_use = false;
+                }
+                for (auto &block : m_blocks) {
+                    block.in_use = false;
+                }
             }
 
             void Invalidate(s32 handle) {
                 /* Lock ourselves. */
                 std::scoped_lock lk(m_mutex);
 
-                if (m_has_cached_handle && m_cached_handle == handle) {
-                    /* Note that we have no handle. */
-                    m_has_cached_handle = false;
-                }
+                /* Note that we have no data for the handle. */
+                this->InvalidateImpl(handle);
+            }
+
+            void Register(s32 handle) {
+                /* Lock ourselves. */
+                std::scoped_lock lk(m_mutex);
+
+                /* Register the handle, without knowledge of its size. */
+                this->RegisterImpl(handle, UnknownFileSize);
             }
 
             void Record(s64 file_size, const void *data, s32 handle, size_t data_size) {
                 /* Lock ourselves. */
                 std::scoped_lock lk(m_mutex);
 
-                /* Set our cached file size. */
-                m_cached_file_size = file_size;
+                /* Register the handle. */
+                this->RegisterImpl(handle, file_size);
+
+                /* Store the file's leading data. */
+                this->StoreImpl(handle, 0, data, std::min(data_size, m_block_count * BlockSize));
+            }
+
+            void Store(s32 handle, s64 offset, const void *data, size_t data_size) {
+                /* Lock ourselves. */
+                std::scoped_lock lk(m_mutex);
+
+                /* Only store data for handles we're caching. */
+                if (this->FindFile(handle) != nullptr) {
+                    this->StoreImpl(handle, offset, data, data_size);
+                }
+            }
 
-                /* Set our cached data size. */
-                m_cached_data_size = std::min(m_cache_size, data_size);
+            bool GetReadAheadRange(s64 *out_offset, size_t *out_size, s32 handle, s64 offset, size_t size, size_t max_size) {
+                /* Lock ourselves. */
+                std::scoped_lock lk(m_mutex);
 
-                /* Copy the data. */
-                std::memcpy(m_cache, data, m_cached_data_size);
+                /* Check that we're caching the file. */
+                auto *file = this->FindFile(handle);
+                if (file == nullptr) {
+                    return false;
+                }
 
-                /* Set our cache handle. */
-                m_cached_handle = handle;
+                /* Don't read ahead at or past the end of the file. */
+                if (file->file_size != UnknownFileSize && offset >= file->file_size) {
+                    return false;
+                }
 
-                /* Note that we have cached data. */
-                m_has_cached_handle = true;
+                /* Determine the block-aligned range covering the request. */
+                const s64 start = util::AlignDown(offset, BlockSize);
+                s64 end         = util::AlignUp(offset + static_cast<s64>(size), BlockSize);
+
+                /* If the access is sequential, read ahead. We never fetch more than half of the cache at once, so that a fill can't evict itself. */
+                if (offset == file->next_offset) {
+                    end += ReadAheadBlockCount * BlockSize;
+                }
+                end = std::min<s64>(end, start + static_cast<s64>(util::AlignDown(std::min(max_size, (m_block_count * BlockSize) / 2), BlockSize)));
+
+                /* Clamp to the file size, when we know it. */
+                if (file->file_size != UnknownFileSize) {
+                    end = std::min(end, file->file_size);
+                }
+
+                /* Check that the range still covers the request. */
+                if (end < offset + static_cast<s64>(size) && (file->file_size == UnknownFileSize || end < file->file_size)) {
+                    return false;
+                }
+
+                *out_offset = start;
+                *out_size   = static_cast<size_t>(end - start);
+                return true;
             }
 
             bool ReadFile(size_t *out, void *dst, s32 handle, size_t offset, size_t size) {
@@ -86,25 +252,52 @@ namespace ams::htcfs {
                 std::scoped_lock lk(m_mutex);
 
                 /* Check that we have a cached file. */
-                if (!m_has_cached_handle) {
+                auto *file = this->FindFile(handle);
+                if (file == nullptr) {
                     return false;
                 }
 
-                /* Check the file is our cached one. */
-                if (handle != m_cached_handle) {
-                    return false;
+                /* Determine the range we can serve, clamping to the end of file when we know it. */
+                size_t end = offset + size;
+                if (file->file_size != UnknownFileSize && end > static_cast<size_t>(file->file_size)) {
+                    if (offset >= static_cast<size_t>(file->file_size)) {
+                        return false;
+                    }
+                    end = static_cast<size_t>(file->file_size);
                 }
 
-                /* Check that we can read data. */
-                if (offset + size > m_cached_data_size) {
-                    return false;
+                /* Check that every block in the range is cached. */
+                for (size_t cur = offset; cur < end; /* ... */) {
+                    const size_t block_offset = util::AlignDown(cur, BlockSize);
+                    const auto *block = this->FindBlock(handle, static_cast<s64>(block_offset));
+                    if (block == nullptr || block_offset + block->data_size < std::min(end, block_offset + BlockSize)) {
+                        return false;
+                    }
+
+                    cur = block_offset + BlockSize;
                 }
 
                 /* Copy the cached data. */
-                std::memcpy(dst, static_cast<const u8 *>(m_cache) + offset, size);
+                u8 *dst_u8 = static_cast<u8 *>(dst);
+                for (size_t cur = offset; cur < end; /* ... */) {
+                    const size_t block_offset = util::AlignDown(cur, BlockSize);
+                    auto *block = this->FindBlock(handle, static_cast<s64>(block_offset));
+
+                    const size_t block_end = std::min(end, block_offset + BlockSize);
+                    std::memcpy(dst_u8, this->GetBlockData(block) + (cur - block_offset), block_end - cur);
+
+                    block->last_used = ++m_use_counter;
+
+                    dst_u8 += block_end - cur;
+                    cur     = block_end;
+                }
+
+                /* Note the access. */
+                file->last_used   = ++m_use_counter;
+                file->next_offset = static_cast<s64>(end);
 
                 /* Set the output read size. */
-                *out = size;
+                *out = end - offset;
 
                 return true;
             }
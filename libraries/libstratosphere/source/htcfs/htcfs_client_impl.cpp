@@ -28,7 +28,9 @@ namespace ams::htcfs {
         alignas(os::ThreadStackAlignment) constinit u8 g_monitor_thread_stack[os::MemoryPageSize];
 
         constexpr size_t FileDataCacheSize = 32_KB;
-        constinit u8 g_cache[FileDataCacheSize];
+
+        constexpr size_t CacheSize = CacheManager::BlockCountMax * CacheManager::BlockSize;
+        constinit u8 g_cache[CacheSize];
 
         ALWAYS_INLINE Result ConvertNativeResult(s64 value) {
             return result::impl::MakeResult(value);
@@ -403,9 +405,6 @@ namespace ams::htcfs {
     }
 
     Result ClientImpl::OpenFile(s32 *out_handle, const char *path, fs::OpenMode mode, bool case_sensitive) {
-        /* Invalidate the cache manager. */
-        m_cache_manager.Invalidate();
-
         /* Lock ourselves. */
         std::scoped_lock lk(m_mutex);
 
@@ -446,9 +445,13 @@ namespace ams::htcfs {
         /* Set our output handle. */
         *out_handle = response.params[2];
 
-        /* If we have data to cache, cache it. */
+        /* If we have data to cache, cache it. Otherwise, cache reads for files we can't modify. */
         if (response.params[3]) {
             m_cache_manager.Record(response.params[4], m_packet_buffer, response.params[2], response.body_size);
+        } else if (mode == fs::OpenMode_Read) {
+            m_cache_manager.Register(response.params[2]);
+        } else {
+            m_cache_manager.Invalidate(response.params[2]);
         }
 
         R_SUCCEED();
@@ -1187,8 +1190,37 @@ namespace ams::htcfs {
                 *out = static_cast<s64>(read_size);
                 R_SUCCEED();
             }
+
+            /* If we're caching the file, read whole blocks (and ahead, for sequential access) into our packet buffer, and cache them. */
+            s64 fill_offset;
+            size_t fill_size;
+            if (m_cache_manager.GetReadAheadRange(std::addressof(fill_offset), std::addressof(fill_size), handle, offset, static_cast<size_t>(buffer_size), MaxPacketBodySize)) {
+                s64 filled;
+                if (R_SUCCEEDED(this->ReadFileImpl(std::addressof(filled), m_packet_buffer, handle, fill_offset, fill_size))) {
+                    m_cache_manager.Store(handle, fill_offset, m_packet_buffer, static_cast<size_t>(filled));
+
+                    /* Serve the read from the cache, or directly from the fill if it ended early. */
+                    size_t read_size;
+                    if (m_cache_manager.ReadFile(std::addressof(read_size), buffer, handle, static_cast<size_t>(offset), static_cast<size_t>(buffer_size))) {
+                        *out = static_cast<s64>(read_size);
+                    } else {
+                        const s64 available = std::max<s64>(fill_offset + filled - offset, 0);
+                        const s64 copy_size = std::min(available, buffer_size);
+                        std::memcpy(buffer, m_packet_buffer + (offset - fill_offset), copy_size);
+                        *out = copy_size;
+                    }
+
+                    R_SUCCEED();
+                }
+
+                /* If the fill failed, fall back to a read of exactly what was requested. */
+            }
         }
 
+        R_RETURN(this->ReadFileImpl(out, buffer, handle, offset, buffer_size));
+    }
+
+    Result ClientImpl::ReadFileImpl(s64 *out, void *buffer, s32 handle, s64 offset, s64 buffer_size) {
         /* Create space for request and response. */
         Header request, response;
 
@@ -1289,7 +1321,7 @@ namespace ams::htcfs {
 
     Result ClientImpl::WriteFile(const void *buffer, s32 handle, s64 offset, s64 buffer_size, fs::WriteOption option) {
         /* Invalidate the cache. */
-        m_cache_manager.Invalidate(handle);
+        m_cache_manager.Invalidate();
 
         /* Lock ourselves. */
         std::scoped_lock lk(m_mutex);
@@ -1323,7 +1355,7 @@ namespace ams::htcfs {
 
     Result ClientImpl::WriteFileLarge(const void *buffer, s32 handle, s64 offset, s64 buffer_size, fs::WriteOption option) {
         /* Invalidate the cache. */
-        m_cache_manager.Invalidate(handle);
+        m_cache_manager.Invalidate();
 
         /* Lock ourselves. */
         std::scoped_lock lk(m_mutex);
@@ -1421,7 +1453,7 @@ namespace ams::htcfs {
 
     Result ClientImpl::SetFileSize(s64 size, s32 handle) {
         /* Invalidate the cache. */
-        m_cache_manager.Invalidate(handle);
+        m_cache_manager.Invalidate();
 
         /* Lock ourselves. */
         std::scoped_lock lk(m_mutex);
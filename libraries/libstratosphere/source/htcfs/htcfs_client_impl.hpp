@@ -103,6 +103,8 @@ namespace ams::htcfs {
             Result CheckResponseHeader(const Header &response, PacketType packet_type);
             Result CheckResponseHeader(const Header &response, PacketType packet_type, s64 body_size);
 
+            Result ReadFileImpl(s64 *out, void *buffer, s32 handle, s64 offset, s64 buffer_size);
+
             Result GetMaxProtocolVersion(s16 *out);
             Result SetProtocolVersion(s16 version);
 
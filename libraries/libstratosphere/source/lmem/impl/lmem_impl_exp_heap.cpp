@@ -166,6 +166,194 @@ namespace ams::lmem::impl {
             return InitializeMemoryBlock(region, UsedBlockMagic);
         }
 
+        /* NOTE: Atmosphère extension. */
+        /* Heaps created with CreateOption_SegregatedFit keep their free blocks in two-level size-class lists (in the style of TLSF), */
+        /* rather than in a single address-ordered list. So that freed blocks can be coalesced without searching, such heaps are kept */
+        /* as a contiguous sequence of regions (alignment margins which can't become free blocks are given to the adjacent used block), */
+        /* each free block ends with a footer holding its region's size, and each region begins with a tag recording whether the */
+        /* region before it is free. The tag's magic is that of the block when the region begins with a block header, and zero when */
+        /* the region begins with a used block's alignment padding, so a region is free if and only if its tag has the free magic. */
+        struct ExpHeapRegionTag {
+            u16 magic;
+            u16 is_previous_free;
+        };
+        static_assert(offsetof(ExpHeapRegionTag, magic) == offsetof(ExpHeapMemoryBlockHead, magic));
+        static_assert(sizeof(ExpHeapRegionTag) <= offsetof(ExpHeapMemoryBlockHead, attributes));
+
+        using ExpHeapFreeBlockFooter = u32;
+        static_assert(sizeof(ExpHeapFreeBlockFooter) <= MinimumFreeBlockSize);
+
+        constexpr size_t SecondLevelIndexBits  = 3;
+        constexpr size_t SecondLevelIndexCount = 1 << SecondLevelIndexBits;
+        constexpr size_t SmallBlockSizeBits    = SecondLevelIndexBits + util::CountTrailingZeros(MinimumAlignment);
+        constexpr size_t SmallBlockSize        = 1 << SmallBlockSizeBits;
+        constexpr size_t FirstLevelIndexCount  = BITSIZEOF(ExpHeapFreeBlockFooter) - SmallBlockSizeBits + 1;
+        constexpr size_t IndexedRegionSizeMax  = std::numeric_limits<ExpHeapFreeBlockFooter>::max();
+
+        struct ExpHeapFreeBlockIndex {
+            u32 first_level_bitmap;
+            u8 second_level_bitmaps[FirstLevelIndexCount];
+            bool is_last_region_free;
+            ExpHeapMemoryBlockList free_lists[FirstLevelIndexCount][SecondLevelIndexCount];
+        };
+        static_assert(BITSIZEOF(u32) >= FirstLevelIndexCount);
+        static_assert(BITSIZEOF(u8) >= SecondLevelIndexCount);
+        static_assert(std::is_trivially_destructible<ExpHeapFreeBlockIndex>::value);
+
+        inline bool IsFreeBlockIndexEnabled(const HeapHead *heap) {
+            return (heap->option & CreateOption_SegregatedFit) != 0;
+        }
+
+        inline ExpHeapFreeBlockIndex *GetFreeBlockIndex(HeapHead *heap) {
+            /* The index is placed at the start of the heap's memory. */
+            return reinterpret_cast<ExpHeapFreeBlockIndex *>(util::AlignUp(reinterpret_cast<uintptr_t>(heap->heap_start), alignof(ExpHeapFreeBlockIndex)));
+        }
+
+        inline ExpHeapRegionTag *GetRegionTag(void *region_start) {
+            return reinterpret_cast<ExpHeapRegionTag *>(region_start);
+        }
+
+        inline bool IsFreeRegion(HeapHead *heap, void *region_start) {
+            return region_start != heap->heap_end && GetRegionTag(region_start)->magic == FreeBlockMagic;
+        }
+
+        inline bool IsPreviousRegionFree(HeapHead *heap, void *region_start) {
+            if (region_start == heap->heap_end) {
+                return GetFreeBlockIndex(heap)->is_last_region_free;
+            } else {
+                return GetRegionTag(region_start)->is_previous_free != 0;
+            }
+        }
+
+        inline void SetPreviousRegionFree(HeapHead *heap, void *region_start, bool is_free) {
+            if (region_start == heap->heap_end) {
+                GetFreeBlockIndex(heap)->is_last_region_free = is_free;
+            } else {
+                GetRegionTag(region_start)->is_previous_free = is_free;
+            }
+        }
+
+        inline ExpHeapFreeBlockFooter *GetFreeBlockFooter(ExpHeapMemoryBlockHead *block) {
+            return reinterpret_cast<ExpHeapFreeBlockFooter *>(reinterpret_cast<uintptr_t>(GetMemoryBlockEnd(block)) - sizeof(ExpHeapFreeBlockFooter));
+        }
+
+        inline ExpHeapMemoryBlockHead *GetPreviousFreeBlock(void *region_start) {
+            const ExpHeapFreeBlockFooter region_size = *reinterpret_cast<const ExpHeapFreeBlockFooter *>(reinterpret_cast<uintptr_t>(region_start) - sizeof(ExpHeapFreeBlockFooter));
+            return reinterpret_cast<ExpHeapMemoryBlockHead *>(reinterpret_cast<uintptr_t>(region_start) - region_size);
+        }
+
+        constexpr inline void GetFreeListIndex(size_t *out_fl, size_t *out_sl, size_t size) {
+            AMS_ASSERT(size <= IndexedRegionSizeMax);
+
+            if (size < SmallBlockSize) {
+                /* Small blocks are spread linearly over the first list row. */
+                *out_fl = 0;
+                *out_sl = size / (SmallBlockSize / SecondLevelIndexCount);
+            } else {
+                /* Larger blocks are classed by their most significant bit, then by the bits following it. */
+                const size_t msb = BITSIZEOF(size) - 1 - util::CountLeadingZeros(size);
+                *out_fl = msb - SmallBlockSizeBits + 1;
+                *out_sl = (size >> (msb - SecondLevelIndexBits)) & (SecondLevelIndexCount - 1);
+            }
+        }
+
+        constexpr inline size_t GetFreeListClassGranularity(size_t size) {
+            if (size < SmallBlockSize) {
+                return SmallBlockSize / SecondLevelIndexCount;
+            } else {
+                const size_t msb = BITSIZEOF(size) - 1 - util::CountLeadingZeros(size);
+                return static_cast<size_t>(1) << (msb - SecondLevelIndexBits);
+            }
+        }
+
+        bool FindNonEmptyFreeList(const ExpHeapFreeBlockIndex *index, size_t *fl, size_t *sl) {
+            /* Look for a non-empty list in the current row at or after the current class. */
+            u32 sl_bitmap = (*sl < SecondLevelIndexCount) ? (index->second_level_bitmaps[*fl] & (~0u << *sl)) : 0;
+            if (sl_bitmap == 0) {
+                /* Look for a later row with a non-empty list. */
+                const u32 fl_bitmap = (*fl + 1 < FirstLevelIndexCount) ? (index->first_level_bitmap & (~0u << (*fl + 1))) : 0;
+                if (fl_bitmap == 0) {
+                    return false;
+                }
+
+                *fl       = util::CountTrailingZeros(fl_bitmap);
+                sl_bitmap = index->second_level_bitmaps[*fl];
+            }
+
+            *sl = util::CountTrailingZeros(sl_bitmap);
+            return true;
+        }
+
+        void InsertIndexedFreeBlock(ExpHeapFreeBlockIndex *index, ExpHeapMemoryBlockHead *block) {
+            size_t fl, sl;
+            GetFreeListIndex(std::addressof(fl), std::addressof(sl), block->block_size);
+
+            index->free_lists[fl][sl].push_front(*block);
+            index->first_level_bitmap       |= (1u << fl);
+            index->second_level_bitmaps[fl] |= (1u << sl);
+        }
+
+        void RemoveIndexedFreeBlock(ExpHeapFreeBlockIndex *index, ExpHeapMemoryBlockHead *block) {
+            AMS_ASSERT(block->magic == FreeBlockMagic);
+
+            size_t fl, sl;
+            GetFreeListIndex(std::addressof(fl), std::addressof(sl), block->block_size);
+
+            auto &list = index->free_lists[fl][sl];
+            list.erase(list.iterator_to(*block));
+
+            if (list.empty()) {
+                index->second_level_bitmaps[fl] &= ~(1u << sl);
+                if (index->second_level_bitmaps[fl] == 0) {
+                    index->first_level_bitmap &= ~(1u << fl);
+                }
+            }
+        }
+
+        ExpHeapMemoryBlockHead *CreateIndexedFreeBlock(HeapHead *heap, const MemoryRegion &region) {
+            /* Initialize the block. */
+            ExpHeapMemoryBlockHead *block = InitializeFreeMemoryBlock(region);
+            *GetFreeBlockFooter(block) = static_cast<ExpHeapFreeBlockFooter>(GetPointerDifference(region.start, region.end));
+
+            /* Free blocks are never adjacent, so the region before a free block is never free. */
+            SetPreviousRegionFree(heap, region.start, false);
+            SetPreviousRegionFree(heap, region.end, true);
+
+            /* Index the block. */
+            InsertIndexedFreeBlock(GetFreeBlockIndex(heap), block);
+            return block;
+        }
+
+        void CoalesceIndexedFreeRegion(HeapHead *heap, MemoryRegion region, bool is_previous_free) {
+            ExpHeapFreeBlockIndex *index = GetFreeBlockIndex(heap);
+
+            /* Coalesce with the block before, if it's free. */
+            if (is_previous_free) {
+                ExpHeapMemoryBlockHead *prev_block = GetPreviousFreeBlock(region.start);
+                RemoveIndexedFreeBlock(index, prev_block);
+                region.start = prev_block;
+            }
+
+            /* Coalesce with the block after, if it's free. */
+            if (IsFreeRegion(heap, region.end)) {
+                ExpHeapMemoryBlockHead *next_block = static_cast<ExpHeapMemoryBlockHead *>(region.end);
+                RemoveIndexedFreeBlock(index, next_block);
+                region.end = GetMemoryBlockEnd(next_block);
+            }
+
+            /* Fill the memory with a pattern, for debug. */
+            FillFreedMemory(heap, region.start, GetPointerDifference(region.start, region.end));
+
+            /* Insert the new memory block. */
+            CreateIndexedFreeBlock(heap, region);
+        }
+
+        inline bool CanCreateFreeBlockFromMargin(const ExpHeapHead *head, const MemoryRegion &margin, bool is_alignment_margin) {
+            /* The margin must be large enough to hold a block, and we may only make a block from a small alignment margin if we're allowed to. */
+            const size_t margin_size = GetPointerDifference(margin.start, margin.end);
+            return margin_size >= sizeof(ExpHeapMemoryBlockHead) + MinimumFreeBlockSize && (head->use_alignment_margins || !is_alignment_margin || margin_size >= MaximumPaddingalignment);
+        }
+
         HeapHead *InitializeExpHeap(void *start, void *end, u32 option) {
             HeapHead *heap_head = reinterpret_cast<HeapHead *>(start);
             ExpHeapHead *exp_heap_head = GetExpHeapHead(heap_head);
@@ -182,6 +370,24 @@ namespace ams::lmem::impl {
             exp_heap_head->use_alignment_margins = false;
             SetAllocationModeImpl(exp_heap_head, DefaultAllocationMode);
 
+            /* If we should index free blocks, try to set up the index. */
+            if (IsFreeBlockIndexEnabled(heap_head)) {
+                ExpHeapFreeBlockIndex *index = GetFreeBlockIndex(heap_head);
+                const uintptr_t region_start = reinterpret_cast<uintptr_t>(index) + sizeof(*index);
+                const uintptr_t region_end   = reinterpret_cast<uintptr_t>(heap_head->heap_end);
+
+                if (region_start <= region_end && GetPointerDifference(region_start, region_end) >= sizeof(ExpHeapMemoryBlockHead) + MinimumFreeBlockSize && GetPointerDifference(region_start, region_end) <= IndexedRegionSizeMax) {
+                    std::construct_at(index);
+
+                    MemoryRegion region{ .start = reinterpret_cast<void *>(region_start), .end = heap_head->heap_end, };
+                    CreateIndexedFreeBlock(heap_head, region);
+                    return heap_head;
+                }
+
+                /* The heap can't hold an index, so fall back to an unindexed heap. */
+                heap_head->option &= ~CreateOption_SegregatedFit;
+            }
+
             /* Initialize memory block. */
             {
                 MemoryRegion region{ .start = heap_head->heap_start, .end = heap_head->heap_end, };
@@ -297,6 +503,160 @@ namespace ams::lmem::impl {
             return block;
         }
 
+        void *ConvertIndexedFreeBlockToUsedBlock(HeapHead *heap, ExpHeapMemoryBlockHead *block_head, void *block, size_t size, AllocationDirection direction) {
+            ExpHeapHead *head = GetExpHeapHead(heap);
+
+            /* Calculate freed memory regions. */
+            MemoryRegion free_region_front;
+            GetMemoryBlockRegion(std::addressof(free_region_front), block_head);
+            MemoryRegion free_region_back{ .start = reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(block) + size), .end = free_region_front.end, };
+
+            /* Adjust end of head region. */
+            free_region_front.end = reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(block) - sizeof(ExpHeapMemoryBlockHead));
+
+            /* Remove the old block. */
+            RemoveIndexedFreeBlock(GetFreeBlockIndex(heap), block_head);
+
+            /* Make new blocks from the margins if we can, and otherwise give them to the used block. */
+            const bool has_front_block = CanCreateFreeBlockFromMargin(head, free_region_front, direction == AllocationDirection_Front);
+            if (has_front_block) {
+                CreateIndexedFreeBlock(heap, free_region_front);
+            } else {
+                free_region_front.end = free_region_front.start;
+            }
+
+            const bool has_back_block = CanCreateFreeBlockFromMargin(head, free_region_back, direction == AllocationDirection_Back);
+            if (has_back_block) {
+                CreateIndexedFreeBlock(heap, free_region_back);
+            } else {
+                free_region_back.start = free_region_back.end;
+            }
+
+            /* Fill the memory with a pattern, for debug. */
+            FillAllocatedMemory(heap, free_region_front.end, GetPointerDifference(free_region_front.end, free_region_back.start));
+
+            {
+                /* Create the used block */
+                MemoryRegion used_region{ .start = reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(block) - sizeof(ExpHeapMemoryBlockHead)), .end = free_region_back.start };
+
+                ExpHeapMemoryBlockHead *used_block = InitializeUsedMemoryBlock(used_region);
+
+                /* Insert it into the used list. */
+                head->used_list.push_back(*used_block);
+                SetMemoryBlockAllocationDirection(used_block, direction);
+                SetMemoryBlockAlignmentPadding(used_block, static_cast<u16>(GetPointerDifference(free_region_front.end, used_block)));
+                SetMemoryBlockGroupId(used_block, head->group_id);
+
+                /* Tag the used region, clearing any stale magic from its padding. */
+                ExpHeapRegionTag *tag = GetRegionTag(free_region_front.end);
+                if (free_region_front.end != used_block) {
+                    tag->magic = 0;
+                }
+                tag->is_previous_free = has_front_block;
+
+                /* If we took the back margin, the region after us is no longer preceded by a free block. */
+                if (!has_back_block) {
+                    SetPreviousRegionFree(heap, free_region_back.end, false);
+                }
+            }
+
+            return block;
+        }
+
+        void *AllocateFromIndexedFreeBlocks(HeapHead *heap, size_t size, size_t alignment, AllocationDirection direction) {
+            /* NOTE: The index doesn't order blocks by address, so for indexed heaps first-fit takes the first block found which can */
+            /* hold the allocation (checking the classes guaranteed to fit first), and best-fit takes the smallest such block. */
+            ExpHeapFreeBlockIndex *index = GetFreeBlockIndex(heap);
+            const bool is_first_fit = GetAllocationModeImpl(GetExpHeapHead(heap)) == AllocationMode_FirstFit;
+
+            /* Nothing larger than the largest possible region can be allocated. */
+            if (size > IndexedRegionSizeMax) {
+                return nullptr;
+            }
+
+            /* Define a helper to get where in a block the allocation would be placed, carving from the front or the back as requested. */
+            auto get_allocation_start = [&](const ExpHeapMemoryBlockHead *block_head) -> uintptr_t {
+                const uintptr_t absolute_block_start = reinterpret_cast<uintptr_t>(GetMemoryBlockStart(block_head));
+                if (block_head->block_size < size) {
+                    return 0;
+                }
+
+                if (direction == AllocationDirection_Front) {
+                    const uintptr_t block_start = util::AlignUp(absolute_block_start, alignment);
+                    return (block_head->block_size >= size + (block_start - absolute_block_start)) ? block_start : 0;
+                } else {
+                    const uintptr_t block_start = util::AlignDown(absolute_block_start + block_head->block_size - size, alignment);
+                    return (block_start >= absolute_block_start) ? block_start : 0;
+                }
+            };
+
+            auto allocate = [&](ExpHeapMemoryBlockHead *block_head, uintptr_t block_start) -> void * {
+                return ConvertIndexedFreeBlockToUsedBlock(heap, block_head, reinterpret_cast<void *>(block_start), size, direction);
+            };
+
+            /* Every block in a class at or above the one rounded up from the worst-case size is guaranteed to fit, so first-fit tries those first. */
+            if (is_first_fit) {
+                const size_t worst_case_size = size + (alignment - MinimumAlignment);
+                const size_t rounded_size    = worst_case_size + GetFreeListClassGranularity(worst_case_size) - 1;
+                if (rounded_size <= IndexedRegionSizeMax) {
+                    size_t fl, sl;
+                    GetFreeListIndex(std::addressof(fl), std::addressof(sl), rounded_size);
+
+                    if (FindNonEmptyFreeList(index, std::addressof(fl), std::addressof(sl))) {
+                        ExpHeapMemoryBlockHead *block_head = std::addressof(index->free_lists[fl][sl].front());
+                        const uintptr_t block_start = get_allocation_start(block_head);
+                        AMS_ASSERT(block_start != 0);
+                        return allocate(block_head, block_start);
+                    }
+                }
+            }
+
+            /* Otherwise, search the classes which may hold a block that fits. */
+            /* Blocks in a later class are always larger than those in an earlier one, so the smallest fitting block is in the first class with any fitting block. */
+            size_t fl, sl;
+            GetFreeListIndex(std::addressof(fl), std::addressof(sl), size);
+            while (FindNonEmptyFreeList(index, std::addressof(fl), std::addressof(sl))) {
+                ExpHeapMemoryBlockHead *found_block_head = nullptr;
+                uintptr_t found_block_start = 0;
+
+                for (auto &it : index->free_lists[fl][sl]) {
+                    if (const uintptr_t block_start = get_allocation_start(std::addressof(it)); block_start != 0 && (found_block_head == nullptr || it.block_size < found_block_head->block_size)) {
+                        found_block_head  = std::addressof(it);
+                        found_block_start = block_start;
+
+                        if (is_first_fit || it.block_size == size) {
+                            break;
+                        }
+                    }
+                }
+
+                if (found_block_head != nullptr) {
+                    return allocate(found_block_head, found_block_start);
+                }
+
+                ++sl;
+            }
+
+            return nullptr;
+        }
+
+        template<typename F>
+        void ForEachFreeBlock(HeapHead *heap, F f) {
+            if (IsFreeBlockIndexEnabled(heap)) {
+                for (auto &row : GetFreeBlockIndex(heap)->free_lists) {
+                    for (auto &list : row) {
+                        for (auto &it : list) {
+                            f(it);
+                        }
+                    }
+                }
+            } else {
+                for (auto &it : GetExpHeapHead(heap)->free_list) {
+                    f(it);
+                }
+            }
+        }
+
         void *AllocateFromHead(HeapHead *heap, size_t size, s32 alignment) {
             ExpHeapHead *exp_heap_head = GetExpHeapHead(heap);
 
@@ -365,6 +725,65 @@ namespace ams::lmem::impl {
             return ConvertFreeBlockToUsedBlock(exp_heap_head, found_block_head, found_block, size, AllocationDirection_Back);
         }
 
+        size_t ResizeIndexedMemoryBlock(HeapHead *heap, ExpHeapMemoryBlockHead *block_head, void *mem_block, size_t size) {
+            ExpHeapFreeBlockIndex *index = GetFreeBlockIndex(heap);
+            const size_t original_block_size = block_head->block_size;
+
+            if (size > original_block_size) {
+                /* We want to try to make the block bigger, which we can only do if the block after this one is free. */
+                void * const cur_block_end = GetMemoryBlockEnd(block_head);
+                if (!IsFreeRegion(heap, cur_block_end)) {
+                    return 0;
+                }
+
+                /* If we can't get a big enough allocation using the next block, give up. */
+                ExpHeapMemoryBlockHead *next_block_head = static_cast<ExpHeapMemoryBlockHead *>(cur_block_end);
+                if (size > original_block_size + sizeof(ExpHeapMemoryBlockHead) + next_block_head->block_size) {
+                    return 0;
+                }
+
+                /* Get block region, and remove the next block from the index. */
+                MemoryRegion new_free_region;
+                GetMemoryBlockRegion(std::addressof(new_free_region), next_block_head);
+                RemoveIndexedFreeBlock(index, next_block_head);
+
+                /* Figure out the new block extents, taking the whole region if what remains can't hold a block. */
+                void *old_start = new_free_region.start;
+                new_free_region.start = reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(mem_block) + size);
+
+                const bool has_free_block = GetPointerDifference(new_free_region.start, new_free_region.end) >= sizeof(ExpHeapMemoryBlockHead) + MinimumFreeBlockSize;
+                if (!has_free_block) {
+                    new_free_region.start = new_free_region.end;
+                }
+
+                /* Adjust block sizes. */
+                block_head->block_size = GetPointerDifference(mem_block, new_free_region.start);
+                if (has_free_block) {
+                    CreateIndexedFreeBlock(heap, new_free_region);
+                } else {
+                    SetPreviousRegionFree(heap, new_free_region.end, false);
+                }
+
+                /* Fill the memory with a pattern, for debug. */
+                FillAllocatedMemory(heap, old_start, GetPointerDifference(old_start, new_free_region.start));
+            } else {
+                /* We're shrinking the block, so determine the region to free (including the next block, if it's free). */
+                MemoryRegion new_free_region{ .start = reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(mem_block) + size), .end = GetMemoryBlockEnd(block_head) };
+                void * const next_block_end = IsFreeRegion(heap, new_free_region.end) ? GetMemoryBlockEnd(static_cast<ExpHeapMemoryBlockHead *>(new_free_region.end)) : new_free_region.end;
+
+                /* If the freed region can't hold a block, we can't shrink. */
+                if (GetPointerDifference(new_free_region.start, next_block_end) < sizeof(ExpHeapMemoryBlockHead) + MinimumFreeBlockSize) {
+                    return original_block_size;
+                }
+
+                /* Free the new memory. */
+                block_head->block_size = size;
+                CoalesceIndexedFreeRegion(heap, new_free_region, false);
+            }
+
+            return block_head->block_size;
+        }
+
     }
 
     HeapHandle CreateExpHeap(void *address, size_t size, u32 option) {
@@ -390,6 +809,25 @@ namespace ams::lmem::impl {
         HeapHead *heap_head = handle;
         ExpHeapHead *exp_heap_head = GetExpHeapHead(heap_head);
 
+        /* If we're indexing free blocks, we can find the last block directly. */
+        if (IsFreeBlockIndexEnabled(heap_head)) {
+            ExpHeapFreeBlockIndex *index = GetFreeBlockIndex(heap_head);
+            if (!index->is_last_region_free) {
+                return MakeMemoryRange(handle->heap_end, 0);
+            }
+
+            /* Remove the memory block. */
+            ExpHeapMemoryBlockHead *block = GetPreviousFreeBlock(heap_head->heap_end);
+            RemoveIndexedFreeBlock(index, block);
+
+            /* The region before the removed block can't have been free. */
+            index->is_last_region_free = false;
+
+            const size_t freed_size = block->block_size + sizeof(ExpHeapMemoryBlockHead);
+            heap_head->heap_end = reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(heap_head->heap_end) - freed_size);
+            return MakeMemoryRange(heap_head->heap_end, freed_size);
+        }
+
         /* If there's no free blocks, we can't do anything. */
         if (exp_heap_head->free_list.empty()) {
             return MakeMemoryRange(handle->heap_end, 0);
@@ -437,7 +875,9 @@ namespace ams::lmem::impl {
 
         /* Allocate a memory block. */
         void *allocated_memory = nullptr;
-        if (alignment >= 0) {
+        if (IsFreeBlockIndexEnabled(handle)) {
+            allocated_memory = AllocateFromIndexedFreeBlocks(handle, size, std::abs(alignment), alignment >= 0 ? AllocationDirection_Front : AllocationDirection_Back);
+        } else if (alignment >= 0) {
             allocated_memory = AllocateFromHead(handle, size, alignment);
         } else {
             allocated_memory = AllocateFromTail(handle, size, -alignment);
@@ -463,6 +903,12 @@ namespace ams::lmem::impl {
         GetMemoryBlockRegion(std::addressof(region), block);
         exp_heap_head->used_list.erase(exp_heap_head->used_list.iterator_to(*block));
 
+        /* If we're indexing free blocks, coalescing is done via the region tags. */
+        if (IsFreeBlockIndexEnabled(heap_head)) {
+            CoalesceIndexedFreeRegion(heap_head, region, IsPreviousRegionFree(heap_head, region.start));
+            return;
+        }
+
         /* Coalesce with adjacent blocks. */
         const bool coalesced = CoalesceFreedRegion(exp_heap_head, std::addressof(region));
         AMS_ASSERT(coalesced);
@@ -484,6 +930,11 @@ namespace ams::lmem::impl {
             return size;
         }
 
+        /* If we're indexing free blocks, resize via the region tags. */
+        if (IsFreeBlockIndexEnabled(handle)) {
+            return ResizeIndexedMemoryBlock(handle, block_head, mem_block, size);
+        }
+
         /* We're resizing one way or the other. */
         if (size > original_block_size) {
             /* We want to try to make the block bigger. */
@@ -552,9 +1003,9 @@ namespace ams::lmem::impl {
         AMS_ASSERT(IsValidHeapHandle(handle));
 
         size_t total_size = 0;
-        for (const auto &it : GetExpHeapHead(handle)->free_list) {
+        ForEachFreeBlock(handle, [&](const ExpHeapMemoryBlockHead &it) {
             total_size += it.block_size;
-        }
+        });
         return total_size;
     }
 
@@ -566,7 +1017,7 @@ namespace ams::lmem::impl {
 
         size_t max_size   = std::numeric_limits<size_t>::min();
         size_t min_offset = std::numeric_limits<size_t>::max();
-        for (const auto &it : GetExpHeapHead(handle)->free_list) {
+        ForEachFreeBlock(handle, [&](const ExpHeapMemoryBlockHead &it) {
             const uintptr_t absolute_block_start = reinterpret_cast<uintptr_t>(GetMemoryBlockStart(std::addressof(it)));
             const uintptr_t block_start          = util::AlignUp(absolute_block_start, alignment);
             const uintptr_t block_end            = reinterpret_cast<uintptr_t>(GetMemoryBlockEnd(std::addressof(it)));
@@ -580,7 +1031,7 @@ namespace ams::lmem::impl {
                     min_offset = offset;
                 }
             }
-        }
+        });
 
         return max_size;
     }
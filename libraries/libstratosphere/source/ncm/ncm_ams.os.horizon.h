@@ -0,0 +1,33 @@
+/**
+ * @file ncm_ams.h
+ * @brief Content Manager (ncm) IPC wrapper for Atmosphere extensions.
+ * @copyright libnx Authors
+ */
+#pragma once
+
+#if defined(ATMOSPHERE_OS_HORIZON)
+
+#include <switch.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    u64 hit_count;
+    u64 miss_count;
+    u64 eviction_count;
+} NcmFileCacheState;
+
+typedef struct {
+    NcmFileCacheState content_file_cache_state;
+    NcmFileCacheState placeholder_file_cache_state;
+} NcmFileCacheReport;
+
+Result ncmAtmosphereGetFileCacheReport(NcmFileCacheReport *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
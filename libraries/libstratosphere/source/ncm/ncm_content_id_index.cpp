@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+#include "ncm_content_id_index.hpp"
+
+namespace ams::ncm {
+
+    namespace {
+
+        ALWAYS_INLINE size_t HashContentId(const ContentId &content_id) {
+            /* Content ids are random, so we can just mix the low bytes. */
+            u64 value;
+            std::memcpy(std::addressof(value), content_id.uuid.data, sizeof(value));
+            return static_cast<size_t>((value * UINT64_C(0x9E3779B97F4A7C15)) >> 32);
+        }
+
+        constexpr ALWAYS_INLINE bool IsAcceptableLoad(size_t count, size_t slot_count) {
+            /* Keep the table at most three quarters full. */
+            return count * 4 <= slot_count * 3;
+        }
+
+    }
+
+    bool ContentIdIndex::Build(const ContentMetaKeyValueStore &kvs) {
+        /* Clear any existing index. */
+        this->Invalidate();
+
+        /* Determine the number of contents we need to index. */
+        size_t content_count = 0;
+        for (const auto &entry : kvs) {
+            ContentMetaReader reader(entry.GetValuePointer(), entry.GetValueSize());
+            content_count += reader.GetContentCount();
+        }
+
+        /* Allocate our slots. */
+        if (!this->Reserve(content_count)) {
+            return false;
+        }
+
+        /* Add every content. */
+        for (const auto &entry : kvs) {
+            ContentMetaReader reader(entry.GetValuePointer(), entry.GetValueSize());
+            for (size_t i = 0; i < reader.GetContentCount(); ++i) {
+                this->Acquire(reader.GetContentInfo(i)->GetId());
+            }
+        }
+
+        m_valid = true;
+        return true;
+    }
+
+    void ContentIdIndex::Invalidate() {
+        m_slots.reset();
+        m_states.reset();
+        m_slot_count    = 0;
+        m_used_count    = 0;
+        m_removed_count = 0;
+        m_valid         = false;
+    }
+
+    void ContentIdIndex::Add(const void *meta, size_t meta_size) {
+        AMS_ASSERT(m_valid);
+
+        /* Ensure we have space for the new contents; if we can't, discard the index so that it's rebuilt on next use. */
+        ContentMetaReader reader(meta, meta_size);
+        if (!this->Reserve(m_used_count + reader.GetContentCount())) {
+            this->Invalidate();
+            return;
+        }
+
+        /* Add the contents. */
+        for (size_t i = 0; i < reader.GetContentCount(); ++i) {
+            this->Acquire(reader.GetContentInfo(i)->GetId());
+        }
+    }
+
+    void ContentIdIndex::Remove(const void *meta, size_t meta_size) {
+        AMS_ASSERT(m_valid);
+
+        /* Release a reference for each content the meta references. */
+        ContentMetaReader reader(meta, meta_size);
+        for (size_t i = 0; i < reader.GetContentCount(); ++i) {
+            if (const size_t index = this->FindSlot(reader.GetContentInfo(i)->GetId()); index < m_slot_count) {
+                if ((--m_slots[index].reference_count) == 0) {
+                    m_states[index] = SlotState_Removed;
+                    --m_used_count;
+                    ++m_removed_count;
+                }
+            }
+        }
+    }
+
+    bool ContentIdIndex::Contains(const ContentId &content_id) const {
+        AMS_ASSERT(m_valid);
+        return this->FindSlot(content_id) < m_slot_count;
+    }
+
+    bool ContentIdIndex::Reserve(size_t count) {
+        /* If we can hold the count without exceeding our load (counting removed slots, which lengthen probes just as used ones do), we're done. */
+        if (m_slot_count != 0 && IsAcceptableLoad(count + m_removed_count, m_slot_count)) {
+            return true;
+        }
+
+        /* Allocate new slots. */
+        const size_t new_slot_count = util::CeilingPowerOfTwo(std::max(util::DivideUp(count * 4, 3), SlotCountMin));
+
+        std::unique_ptr<Slot[]> new_slots(new (std::nothrow) Slot[new_slot_count]);
+        std::unique_ptr<u8[]> new_states(new (std::nothrow) u8[new_slot_count]);
+        if (new_slots == nullptr || new_states == nullptr) {
+            return false;
+        }
+        std::memset(new_states.get(), SlotState_Empty, new_slot_count);
+
+        /* Swap in the new slots, and re-insert our old entries. */
+        auto old_slots       = std::move(m_slots);
+        auto old_states      = std::move(m_states);
+        const auto old_count = m_slot_count;
+
+        m_slots         = std::move(new_slots);
+        m_states        = std::move(new_states);
+        m_slot_count    = new_slot_count;
+        m_used_count    = 0;
+        m_removed_count = 0;
+
+        for (size_t i = 0; i < old_count; ++i) {
+            if (old_states[i] == SlotState_Used) {
+                this->Insert(old_slots[i].content_id, old_slots[i].reference_count);
+            }
+        }
+
+        return true;
+    }
+
+    void ContentIdIndex::Insert(const ContentId &content_id, u32 reference_count) {
+        AMS_ASSERT(IsAcceptableLoad(m_used_count + m_removed_count + 1, m_slot_count));
+
+        /* Find the first slot along the probe sequence that isn't in use. */
+        const size_t mask = m_slot_count - 1;
+        size_t index = HashContentId(content_id) & mask;
+        while (m_states[index] == SlotState_Used) {
+            index = (index + 1) & mask;
+        }
+
+        /* If we're reusing a removed slot, account for it. */
+        if (m_states[index] == SlotState_Removed) {
+            --m_removed_count;
+        }
+
+        m_slots[index]  = { content_id, reference_count };
+        m_states[index] = SlotState_Used;
+        ++m_used_count;
+    }
+
+    void ContentIdIndex::Acquire(const ContentId &content_id) {
+        /* If the content is already present, just take a reference to it. */
+        if (const size_t index = this->FindSlot(content_id); index < m_slot_count) {
+            ++m_slots[index].reference_count;
+        } else {
+            this->Insert(content_id, 1);
+        }
+    }
+
+    size_t ContentIdIndex::FindSlot(const ContentId &content_id) const {
+        /* Nothing is found in an empty table. */
+        if (m_slot_count == 0) {
+            return m_slot_count;
+        }
+
+        /* Walk the probe sequence until we reach an empty slot. */
+        const size_t mask = m_slot_count - 1;
+        for (size_t index = HashContentId(content_id) & mask; m_states[index] != SlotState_Empty; index = (index + 1) & mask) {
+            if (m_states[index] == SlotState_Used && m_slots[index].content_id == content_id) {
+                return index;
+            }
+        }
+
+        return m_slot_count;
+    }
+
+}
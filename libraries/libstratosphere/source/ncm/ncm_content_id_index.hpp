@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+
+namespace ams::ncm {
+
+    /* NOTE: Atmosphère extension. */
+    /* Reference-counted set of every content id referenced by the content metas in a key value store. */
+    class ContentIdIndex {
+        NON_COPYABLE(ContentIdIndex);
+        NON_MOVEABLE(ContentIdIndex);
+        private:
+            using ContentMetaKeyValueStore = ams::kvdb::MemoryKeyValueStore<ContentMetaKey>;
+
+            enum SlotState : u8 {
+                SlotState_Empty   = 0,
+                SlotState_Used    = 1,
+                SlotState_Removed = 2,
+            };
+
+            struct Slot {
+                ContentId content_id;
+                u32 reference_count;
+            };
+
+            static constexpr size_t SlotCountMin = 0x40;
+        private:
+            std::unique_ptr<Slot[]> m_slots;
+            std::unique_ptr<u8[]> m_states;
+            size_t m_slot_count;
+            size_t m_used_count;
+            size_t m_removed_count;
+            bool m_valid;
+        public:
+            ContentIdIndex() : m_slots(), m_states(), m_slot_count(0), m_used_count(0), m_removed_count(0), m_valid(false) { /* ... */ }
+
+            bool IsValid() const { return m_valid; }
+
+            bool Build(const ContentMetaKeyValueStore &kvs);
+            void Invalidate();
+
+            void Add(const void *meta, size_t meta_size);
+            void Remove(const void *meta, size_t meta_size);
+
+            bool Contains(const ContentId &content_id) const;
+        private:
+            bool Reserve(size_t count);
+            void Insert(const ContentId &content_id, u32 reference_count);
+            void Acquire(const ContentId &content_id);
+            size_t FindSlot(const ContentId &content_id) const;
+    };
+
+}
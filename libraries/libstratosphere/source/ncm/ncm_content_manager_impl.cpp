@@ -344,6 +344,9 @@ namespace ams::ncm {
                     break;
             }
 
+            /* NOTE: Atmosphère extension. Size the content storage's file handle caches. */
+            content_storage.GetImpl().SetFileCacheEntryCount(root.content_file_cache_count, root.placeholder_file_cache_count);
+
             root.content_storage = std::move(content_storage);
         } else {
             switch (root.storage_id) {
@@ -678,6 +681,10 @@ namespace ams::ncm {
         out->config             = config;
         out->content_storage    = nullptr;
 
+        /* NOTE: Atmosphère extension. */
+        out->content_file_cache_count     = m_manager_config.content_file_cache_count;
+        out->placeholder_file_cache_count = m_manager_config.placeholder_file_cache_count;
+
         /* Create a new mount name and copy it to out. */
         std::strcpy(out->mount_name, impl::CreateUniqueMountName().str);
         util::SNPrintf(out->path, sizeof(out->path), "%s:/", out->mount_name);
@@ -910,6 +917,8 @@ namespace ams::ncm {
         R_SUCCEED_IF(m_initialized);
 
         /* Set our configs. */
+        m_manager_config = manager_config;
+
         for (size_t i = 0; i < num_integrated_configs; ++i) {
             m_integrated_configs[i] = integrated_configs[i];
         }
@@ -1208,4 +1217,9 @@ namespace ams::ncm {
         R_SUCCEED();
     }
 
+    Result ContentManagerImpl::AtmosphereGetFileCacheReport(sf::Out<FileCacheReport> out) {
+        GetFileCacheReport(out.GetPointer());
+        R_SUCCEED();
+    }
+
 }
@@ -51,7 +51,26 @@ namespace ams::ncm {
 
     Result ContentMetaDatabaseImpl::Set(const ContentMetaKey &key, const sf::InBuffer &value) {
         R_TRY(this->EnsureEnabled());
-        R_RETURN(m_kvs->Set(key, value.GetPointer(), value.GetSize()));
+
+        /* If we have a content id index, remove any contents referenced by the value we're replacing. */
+        if (m_content_id_index.IsValid()) {
+            const void *meta;
+            size_t meta_size;
+            if (R_SUCCEEDED(this->GetContentMetaPointer(std::addressof(meta), std::addressof(meta_size), key))) {
+                m_content_id_index.Remove(meta, meta_size);
+            }
+        }
+
+        /* Set the value, discarding the index if we fail (it will be rebuilt on next use). */
+        ON_RESULT_FAILURE { m_content_id_index.Invalidate(); };
+        R_TRY(m_kvs->Set(key, value.GetPointer(), value.GetSize()));
+
+        /* Add the new value's contents to the index. */
+        if (m_content_id_index.IsValid()) {
+            m_content_id_index.Add(value.GetPointer(), value.GetSize());
+        }
+
+        R_SUCCEED();
     }
 
     Result ContentMetaDatabaseImpl::Get(sf::Out<u64> out_size, const ContentMetaKey &key, const sf::OutBuffer &out_value) {
@@ -70,6 +89,17 @@ namespace ams::ncm {
     Result ContentMetaDatabaseImpl::Remove(const ContentMetaKey &key) {
         R_TRY(this->EnsureEnabled());
 
+        /* If we have a content id index, remove the contents referenced by the value we're removing. */
+        if (m_content_id_index.IsValid()) {
+            const void *meta;
+            size_t meta_size;
+            if (R_SUCCEEDED(this->GetContentMetaPointer(std::addressof(meta), std::addressof(meta_size), key))) {
+                m_content_id_index.Remove(meta, meta_size);
+            }
+        }
+
+        /* Remove the value, discarding the index if we fail (it will be rebuilt on next use). */
+        ON_RESULT_FAILURE { m_content_id_index.Invalidate(); };
         R_TRY_CATCH(m_kvs->Remove(key)) {
             R_CONVERT(kvdb::ResultKeyNotFound, ncm::ResultContentMetaNotFound())
         } R_END_TRY_CATCH;
@@ -313,6 +343,18 @@ namespace ams::ncm {
         R_TRY(this->EnsureEnabled());
         R_UNLESS(out_orphaned.GetSize() >= content_ids.GetSize(), ncm::ResultBufferInsufficient());
 
+        /* If we can, use our content id index to look up the content ids directly. */
+        if (this->EnsureContentIdIndex()) {
+            for (size_t i = 0; i < content_ids.GetSize(); i++) {
+                out_orphaned[i] = !m_content_id_index.Contains(content_ids[i]);
+            }
+            for (size_t i = content_ids.GetSize(); i < out_orphaned.GetSize(); i++) {
+                out_orphaned[i] = true;
+            }
+
+            R_SUCCEED();
+        }
+
         /* Default to orphaned for all content ids. */
         for (size_t i = 0; i < out_orphaned.GetSize(); i++) {
             out_orphaned[i] = true;
@@ -359,6 +401,12 @@ namespace ams::ncm {
         size_t meta_size;
         R_TRY(this->GetContentMetaPointer(&meta, &meta_size, key));
 
+        /* If no content meta references the content, we can skip searching the content infos. */
+        if (this->EnsureContentIdIndex() && !m_content_id_index.Contains(content_id)) {
+            out.SetValue(false);
+            R_SUCCEED();
+        }
+
         /* Create a reader. */
         ContentMetaReader reader(meta, meta_size);
 
@@ -16,15 +16,24 @@
 #pragma once
 #include <stratosphere.hpp>
 #include "ncm_content_meta_database_impl_base.hpp"
+#include "ncm_content_id_index.hpp"
 
 namespace ams::ncm {
 
     class ContentMetaDatabaseImpl : public ContentMetaDatabaseImplBase {
+        private:
+            /* NOTE: Atmosphère extension. */
+            ContentIdIndex m_content_id_index;
         public:
             ContentMetaDatabaseImpl(ContentMetaKeyValueStore *kvs, const char *mount_name) : ContentMetaDatabaseImplBase(kvs, mount_name) { /* ... */ }
             ContentMetaDatabaseImpl(ContentMetaKeyValueStore *kvs) : ContentMetaDatabaseImplBase(kvs) { /* ... */ }
         private:
             /* Helpers. */
+            bool EnsureContentIdIndex() {
+                /* The index is built lazily from the loaded key value store, and maintained incrementally thereafter. */
+                return m_content_id_index.IsValid() || m_content_id_index.Build(*m_kvs);
+            }
+
             Result GetContentInfoImpl(ContentInfo *out, const ContentMetaKey &key, ContentType type, util::optional<u8> id_offset) const;
 
             Result GetContentIdImpl(ContentId *out, const ContentMetaKey &key, ContentType type, util::optional<u8> id_offset) const {
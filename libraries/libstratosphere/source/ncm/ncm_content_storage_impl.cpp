@@ -349,30 +349,75 @@ namespace ams::ncm {
     }
 
     void ContentStorageImpl::InvalidateFileCache() {
-        if (m_cached_content_id != InvalidContentId) {
-            fs::CloseFile(m_cached_file_handle);
-            m_cached_content_id = InvalidContentId;
-        }
+        m_content_file_cache.InvalidateAll();
         m_content_iterator = util::nullopt;
     }
 
-    Result ContentStorageImpl::OpenContentIdFile(ContentId content_id) {
-        /* If the file is the currently cached one, we've nothing to do. */
-        R_SUCCEED_IF(m_cached_content_id == content_id);
+    void ContentStorageImpl::InvalidateFileCache(ContentId content_id) {
+        m_content_file_cache.Invalidate(content_id);
+        m_content_iterator = util::nullopt;
+    }
 
-        /* Close any cached file. */
-        this->InvalidateFileCache();
+    Result ContentStorageImpl::OpenContentIdFile(fs::FileHandle *out, u64 *out_generation, ContentId content_id) {
+        /* If the file is cached, we've nothing to do. */
+        R_SUCCEED_IF(m_content_file_cache.Acquire(out, out_generation, content_id));
 
         /* Create the content path. */
         PathString path;
         MakeContentPath(std::addressof(path), content_id, m_make_content_path_func, m_root_path);
 
-        /* Open the content file and store to the cache. */
-        R_TRY_CATCH(fs::OpenFile(std::addressof(m_cached_file_handle), path, fs::OpenMode_Read)) {
+        /* Open the content file. */
+        R_TRY_CATCH(fs::OpenFile(out, path, fs::OpenMode_Read)) {
             R_CONVERT(ams::fs::ResultPathNotFound, ncm::ResultContentNotFound())
         } R_END_TRY_CATCH;
 
-        m_cached_content_id = content_id;
+        R_SUCCEED();
+    }
+
+    Result ContentStorageImpl::EnsureRegisteredContentIdList() {
+        /* If we already have a list (or can't have one), there's nothing to do. */
+        R_SUCCEED_IF(m_registered_content_id_list.IsValid() || m_registered_content_id_list_unavailable);
+
+        /* Obtain the content base directory path. */
+        PathString path;
+        MakeBaseContentDirectoryPath(std::addressof(path), m_root_path);
+
+        /* Traverse the content base directory, adding every content we find to the list. */
+        bool allocation_failed = false;
+        m_registered_content_id_list.BeginBuild();
+        ON_RESULT_FAILURE { m_registered_content_id_list.Invalidate(); };
+
+        R_TRY(TraverseDirectory(path, GetHierarchicalContentDirectoryDepth(m_make_content_path_func), [&](bool *should_continue, bool *should_retry_dir_read, const char *current_path, const fs::DirectoryEntry &entry) -> Result {
+            AMS_UNUSED(current_path);
+
+            *should_continue = true;
+            *should_retry_dir_read = false;
+
+            /* We are only looking for files. */
+            if (entry.type == fs::DirectoryEntryType_File) {
+                if (auto content_id = GetContentIdFromString(entry.name, std::strlen(entry.name)); content_id.has_value()) {
+                    /* If we can't grow the list, stop traversing. */
+                    if (!m_registered_content_id_list.Insert(*content_id)) {
+                        allocation_failed = true;
+                        *should_continue = false;
+                    }
+                } else {
+                    /* Track files which aren't content, so that we can count them as GetContentCount always has. */
+                    m_registered_content_id_list.AddOtherFile();
+                }
+            }
+
+            R_SUCCEED();
+        }));
+
+        /* If we couldn't allocate the list, don't try again; we'll just traverse the directory when we need to. */
+        if (allocation_failed) {
+            m_registered_content_id_list.Invalidate();
+            m_registered_content_id_list_unavailable = true;
+        } else {
+            m_registered_content_id_list.EndBuild();
+        }
+
         R_SUCCEED();
     }
 
@@ -429,7 +474,7 @@ namespace ams::ncm {
     }
 
     Result ContentStorageImpl::Register(PlaceHolderId placeholder_id, ContentId content_id) {
-        this->InvalidateFileCache();
+        this->InvalidateFileCache(content_id);
         R_TRY(this->EnsureEnabled());
 
         /* Create the placeholder path. */
@@ -446,13 +491,25 @@ namespace ams::ncm {
             R_CONVERT(fs::ResultPathAlreadyExists, ncm::ResultContentAlreadyExists())
         } R_END_TRY_CATCH;
 
+        /* Add the content to our registered content id list, discarding the list if we can't (it will be rebuilt on next use). */
+        if (m_registered_content_id_list.IsValid() && !m_registered_content_id_list.Insert(content_id)) {
+            m_registered_content_id_list.Invalidate();
+        }
+
         R_SUCCEED();
     }
 
     Result ContentStorageImpl::Delete(ContentId content_id) {
         R_TRY(this->EnsureEnabled());
-        this->InvalidateFileCache();
-        R_RETURN(DeleteContentFile(content_id, m_make_content_path_func, m_root_path));
+        this->InvalidateFileCache(content_id);
+        R_TRY(DeleteContentFile(content_id, m_make_content_path_func, m_root_path));
+
+        /* Remove the content from our registered content id list. */
+        if (m_registered_content_id_list.IsValid()) {
+            m_registered_content_id_list.Remove(content_id);
+        }
+
+        R_SUCCEED();
     }
 
     Result ContentStorageImpl::Has(sf::Out<bool> out, ContentId content_id) {
@@ -552,6 +609,13 @@ namespace ams::ncm {
     Result ContentStorageImpl::GetContentCount(sf::Out<s32> out_count) {
         R_TRY(this->EnsureEnabled());
 
+        /* If we have a registered content id list, use it. */
+        R_TRY(this->EnsureRegisteredContentIdList());
+        if (m_registered_content_id_list.IsValid()) {
+            out_count.SetValue(static_cast<s32>(m_registered_content_id_list.GetFileCount()));
+            R_SUCCEED();
+        }
+
         /* Obtain the content base directory path. */
         PathString path;
         MakeBaseContentDirectoryPath(std::addressof(path), m_root_path);
@@ -582,6 +646,15 @@ namespace ams::ncm {
         R_UNLESS(offset >= 0, ncm::ResultInvalidOffset());
         R_TRY(this->EnsureEnabled());
 
+        /* If we have a registered content id list, list directly from it. */
+        /* NOTE: This lists ids in ascending byte order rather than in directory traversal order. */
+        /* Official ncm never specified an order; paging by offset only relies on it being stable between calls. */
+        R_TRY(this->EnsureRegisteredContentIdList());
+        if (m_registered_content_id_list.IsValid()) {
+            *out_count = static_cast<s32>(m_registered_content_id_list.List(out.GetPointer(), out.GetSize(), offset));
+            R_SUCCEED();
+        }
+
         if (!m_content_iterator.has_value() || !m_last_content_offset.has_value() || m_last_content_offset != offset) {
             /* Create and initialize the content cache. */
             m_content_iterator.emplace();
@@ -658,6 +731,7 @@ namespace ams::ncm {
         m_disabled = true;
         this->InvalidateFileCache();
         m_placeholder_accessor.InvalidateAll();
+        m_registered_content_id_list.Invalidate();
         R_SUCCEED();
     }
 
@@ -665,7 +739,7 @@ namespace ams::ncm {
         R_TRY(this->EnsureEnabled());
 
         /* Close any cached file. */
-        this->InvalidateFileCache();
+        this->InvalidateFileCache(old_content_id);
 
         /* Ensure the future content directory exists. */
         R_TRY(EnsureContentDirectory(new_content_id, m_make_content_path_func, m_root_path));
@@ -687,6 +761,11 @@ namespace ams::ncm {
             R_CONVERT(fs::ResultPathAlreadyExists, ncm::ResultContentAlreadyExists())
         } R_END_TRY_CATCH;
 
+        /* The old content is no longer registered. */
+        if (m_registered_content_id_list.IsValid()) {
+            m_registered_content_id_list.Remove(old_content_id);
+        }
+
         R_SUCCEED();
     }
 
@@ -700,15 +779,14 @@ namespace ams::ncm {
         R_UNLESS(offset >= 0, ncm::ResultInvalidOffset());
         R_TRY(this->EnsureEnabled());
 
-        /* Create the content path. */
-        PathString content_path;
-        MakeContentPath(std::addressof(content_path), content_id, m_make_content_path_func, m_root_path);
-
-        /* Open the content file. */
-        R_TRY(this->OpenContentIdFile(content_id));
+        /* Open the content file, returning it to the cache when we're done. */
+        fs::FileHandle file;
+        u64 generation;
+        R_TRY(this->OpenContentIdFile(std::addressof(file), std::addressof(generation), content_id));
+        ON_SCOPE_EXIT { m_content_file_cache.Release(content_id, file, generation); };
 
         /* Read from the requested offset up to the requested size. */
-        R_RETURN(fs::ReadFile(m_cached_file_handle, offset, buf.GetPointer(), buf.GetSize()));
+        R_RETURN(fs::ReadFile(file, offset, buf.GetPointer(), buf.GetSize()));
     }
 
     Result ContentStorageImpl::GetRightsIdFromPlaceHolderIdDeprecated(sf::Out<ams::fs::RightsId> out_rights_id, PlaceHolderId placeholder_id) {
@@ -782,7 +860,7 @@ namespace ams::ncm {
         AMS_ABORT_UNLESS(spl::IsDevelopment());
 
         /* Close any cached file. */
-        this->InvalidateFileCache();
+        this->InvalidateFileCache(content_id);
 
         /* Make the content path. */
         PathString path;
@@ -862,6 +940,8 @@ namespace ams::ncm {
         };
 
         /* Fix content. */
+        /* NOTE: Repairing attributes may turn directories into content files, so our registered content id list must be rebuilt. */
+        m_registered_content_id_list.Invalidate();
         {
             path_checker = IsContentPath;
             PathString path;
@@ -18,6 +18,7 @@
 
 #include "ncm_content_storage_impl_base.hpp"
 #include "ncm_placeholder_accessor.hpp"
+#include "ncm_registered_content_id_list.hpp"
 
 namespace ams::ncm {
 
@@ -49,26 +50,40 @@ namespace ams::ncm {
                     Result LoadEntries();
             };
             static_assert(std::is_constructible<ContentIterator>::value);
+
+            static constexpr size_t MaxContentFileCacheEntries     = 0x10;
+            static constexpr size_t DefaultContentFileCacheEntries = 0x4;
+
+            using ContentFileCache = FileHandleCache<ContentId, MaxContentFileCacheEntries>;
         protected:
             PlaceHolderAccessor m_placeholder_accessor;
-            ContentId m_cached_content_id;
-            fs::FileHandle m_cached_file_handle;
+            ContentFileCache m_content_file_cache;
             RightsIdCache *m_rights_id_cache;
             util::optional<ContentIterator> m_content_iterator;
             util::optional<s32> m_last_content_offset;
+            RegisteredContentIdList m_registered_content_id_list;
+            bool m_registered_content_id_list_unavailable;
         public:
             static Result InitializeBase(const char *root_path);
             static Result CleanupBase(const char *root_path);
             static Result VerifyBase(const char *root_path);
         public:
-            ContentStorageImpl() : m_placeholder_accessor(), m_cached_content_id(InvalidContentId), m_cached_file_handle(), m_rights_id_cache(nullptr), m_content_iterator(util::nullopt), m_last_content_offset(util::nullopt) { /* ... */ }
+            ContentStorageImpl() : m_placeholder_accessor(), m_content_file_cache(fs::CloseFile, std::addressof(GetContentFileCacheStatistics()), DefaultContentFileCacheEntries), m_rights_id_cache(nullptr), m_content_iterator(util::nullopt), m_last_content_offset(util::nullopt), m_registered_content_id_list(), m_registered_content_id_list_unavailable(false) { /* ... */ }
             ~ContentStorageImpl();
 
             Result Initialize(const char *root_path, MakeContentPathFunction content_path_func, MakePlaceHolderPathFunction placeholder_path_func, bool delay_flush, RightsIdCache *rights_id_cache);
+
+            /* NOTE: Atmosphère extension. Zero selects the default number of handles for a cache. */
+            void SetFileCacheEntryCount(size_t content_count, size_t placeholder_count) {
+                m_content_file_cache.SetEntryCount(content_count != 0 ? std::min(content_count, MaxContentFileCacheEntries) : DefaultContentFileCacheEntries);
+                m_placeholder_accessor.SetCacheEntryCount(placeholder_count);
+            }
         private:
             /* Helpers. */
-            Result OpenContentIdFile(ContentId content_id);
+            Result OpenContentIdFile(fs::FileHandle *out, u64 *out_generation, ContentId content_id);
             void InvalidateFileCache();
+            void InvalidateFileCache(ContentId content_id);
+            Result EnsureRegisteredContentIdList();
         public:
             /* Actual commands. */
             virtual Result GeneratePlaceHolderId(sf::Out<PlaceHolderId> out) override;
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+
+namespace ams::ncm {
+
+    /* NOTE: Atmosphère extension. */
+    /* LRU cache of open file handles, keyed by content or placeholder id. */
+    /* Handles are checked out of the cache while in use, so that files for different ids may be accessed concurrently. */
+    /* Acquire hands out the current invalidation generation; a handle released under an older one is closed rather than cached. */
+    /* Up to EntryCountMax handles are held; the number actually used may be configured at runtime. */
+    template<typename IdType, size_t EntryCountMax>
+    class FileHandleCache {
+        NON_COPYABLE(FileHandleCache);
+        NON_MOVEABLE(FileHandleCache);
+        static_assert(EntryCountMax > 0);
+        public:
+            using CloseFunction = void (*)(fs::FileHandle);
+        private:
+            struct Entry {
+                IdType id;
+                fs::FileHandle handle;
+                u64 last_used;
+                bool is_valid;
+            };
+        private:
+            Entry m_entries[EntryCountMax];
+            size_t m_entry_count;
+            u64 m_counter;
+            u64 m_generation;
+            os::SdkMutex m_mutex;
+            CloseFunction m_close_function;
+            FileCacheStatistics *m_statistics;
+        public:
+            FileHandleCache(CloseFunction close_function, FileCacheStatistics *statistics, size_t entry_count) : m_entries(), m_entry_count(entry_count), m_counter(0), m_generation(0), m_mutex(), m_close_function(close_function), m_statistics(statistics) {
+                AMS_ASSERT(0 < entry_count && entry_count <= EntryCountMax);
+
+                for (auto &entry : m_entries) {
+                    entry.is_valid = false;
+                }
+            }
+
+            ~FileHandleCache() { this->InvalidateAll(); }
+
+            size_t GetEntryCount() const { return m_entry_count; }
+
+            void SetEntryCount(size_t entry_count) {
+                AMS_ABORT_UNLESS(0 < entry_count && entry_count <= EntryCountMax);
+
+                /* Close any cached handles, so that no valid entry lies beyond the new count. */
+                this->InvalidateAll();
+
+                std::scoped_lock lk(m_mutex);
+                m_entry_count = entry_count;
+            }
+
+            bool Acquire(fs::FileHandle *out, u64 *out_generation, const IdType &id) {
+                std::scoped_lock lk(m_mutex);
+
+                /* Note the generation, so that Release can tell whether the id was invalidated while the handle was out. */
+                *out_generation = m_generation;
+
+                /* Try to find the id in the cache; if we do, check the handle out. */
+                if (Entry *entry = this->Find(id); entry != nullptr) {
+                    entry->is_valid = false;
+                    *out = entry->handle;
+
+                    m_statistics->Hit();
+                    return true;
+                }
+
+                m_statistics->Miss();
+                return false;
+            }
+
+            void Release(const IdType &id, fs::FileHandle handle, u64 generation) {
+                util::optional<fs::FileHandle> close_handle = util::nullopt;
+                ON_SCOPE_EXIT { if (close_handle.has_value()) { m_close_function(*close_handle); } };
+
+                std::scoped_lock lk(m_mutex);
+
+                /* If the cache was invalidated while the handle was checked out, the handle may refer to a stale file. */
+                /* Likewise, if the id was cached while the handle was checked out, we have no need of this handle. */
+                if (generation != m_generation || this->Find(id) != nullptr) {
+                    close_handle = handle;
+                    return;
+                }
+
+                /* Find a free entry, or else the least recently used one. */
+                Entry *target = std::addressof(m_entries[0]);
+                for (size_t i = 0; i < m_entry_count; ++i) {
+                    auto &entry = m_entries[i];
+                    if (!entry.is_valid) {
+                        target = std::addressof(entry);
+                        break;
+                    }
+                    if (entry.last_used < target->last_used) {
+                        target = std::addressof(entry);
+                    }
+                }
+
+                /* Evict the entry, if it's in use. */
+                if (target->is_valid) {
+                    close_handle = target->handle;
+                    m_statistics->Evict();
+                }
+
+                /* Store the handle. */
+                target->id        = id;
+                target->handle    = handle;
+                target->last_used = m_counter++;
+                target->is_valid  = true;
+            }
+
+            void Invalidate(const IdType &id) {
+                util::optional<fs::FileHandle> close_handle = util::nullopt;
+                ON_SCOPE_EXIT { if (close_handle.has_value()) { m_close_function(*close_handle); } };
+
+                std::scoped_lock lk(m_mutex);
+
+                /* Advance the generation, in case a handle for the id is checked out. */
+                ++m_generation;
+
+                if (Entry *entry = this->Find(id); entry != nullptr) {
+                    entry->is_valid = false;
+                    close_handle    = entry->handle;
+                }
+            }
+
+            void InvalidateAll() {
+                fs::FileHandle close_handles[EntryCountMax];
+                size_t num_close_handles = 0;
+                ON_SCOPE_EXIT {
+                    for (size_t i = 0; i < num_close_handles; ++i) {
+                        m_close_function(close_handles[i]);
+                    }
+                };
+
+                std::scoped_lock lk(m_mutex);
+
+                ++m_generation;
+
+                for (auto &entry : m_entries) {
+                    if (entry.is_valid) {
+                        entry.is_valid = false;
+                        close_handles[num_close_handles++] = entry.handle;
+                    }
+                }
+            }
+        private:
+            Entry *Find(const IdType &id) {
+                for (size_t i = 0; i < m_entry_count; ++i) {
+                    auto &entry = m_entries[i];
+                    if (entry.is_valid && entry.id == id) {
+                        return std::addressof(entry);
+                    }
+                }
+                return nullptr;
+            }
+    };
+
+}
@@ -49,4 +49,28 @@ namespace ams::ncm {
         return s_heap_state;
     }
 
+    void FileCacheStatistics::GetFileCacheState(FileCacheState *out) const {
+        out->hit_count      = m_hit_count.load(std::memory_order_relaxed);
+        out->miss_count     = m_miss_count.load(std::memory_order_relaxed);
+        out->eviction_count = m_eviction_count.load(std::memory_order_relaxed);
+    }
+
+    FileCacheStatistics &GetContentFileCacheStatistics() {
+        AMS_FUNCTION_LOCAL_STATIC_CONSTINIT(FileCacheStatistics, s_content_file_cache_statistics);
+
+        return s_content_file_cache_statistics;
+    }
+
+    FileCacheStatistics &GetPlaceHolderFileCacheStatistics() {
+        AMS_FUNCTION_LOCAL_STATIC_CONSTINIT(FileCacheStatistics, s_placeholder_file_cache_statistics);
+
+        return s_placeholder_file_cache_statistics;
+    }
+
+    void GetFileCacheReport(FileCacheReport *out) {
+        *out = {};
+        GetContentFileCacheStatistics().GetFileCacheState(std::addressof(out->content_file_cache_state));
+        GetPlaceHolderFileCacheStatistics().GetFileCacheState(std::addressof(out->placeholder_file_cache_state));
+    }
+
 }
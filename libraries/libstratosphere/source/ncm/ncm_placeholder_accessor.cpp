@@ -75,9 +75,9 @@ namespace ams::ncm {
         R_SUCCEED();
     }
 
-    Result PlaceHolderAccessor::Open(fs::FileHandle *out_handle, PlaceHolderId placeholder_id) {
+    Result PlaceHolderAccessor::Open(fs::FileHandle *out_handle, u64 *out_generation, PlaceHolderId placeholder_id) {
         /* Try to load from the cache. */
-        R_SUCCEED_IF(this->LoadFromCache(out_handle, placeholder_id));
+        R_SUCCEED_IF(m_cache.Acquire(out_handle, out_generation, placeholder_id));
 
         /* Make the path of the placeholder. */
         PathString placeholder_path;
@@ -87,79 +87,14 @@ namespace ams::ncm {
         R_RETURN(fs::OpenFile(out_handle, placeholder_path, fs::OpenMode_Write));
     }
 
-    bool PlaceHolderAccessor::LoadFromCache(fs::FileHandle *out_handle, PlaceHolderId placeholder_id) {
-        std::scoped_lock lk(m_cache_mutex);
-
-        /* Attempt to find an entry in the cache. */
-        CacheEntry *entry = this->FindInCache(placeholder_id);
-        if (!entry) {
-            return false;
-        }
-
-        /* No cached entry found. */
-        entry->id = InvalidPlaceHolderId;
-        *out_handle = entry->handle;
-        return true;
-    }
-
-    void PlaceHolderAccessor::StoreToCache(PlaceHolderId placeholder_id, fs::FileHandle handle) {
-        std::scoped_lock lk(m_cache_mutex);
-
-        /* Store placeholder id and file handle to a free entry. */
-        CacheEntry *entry = this->GetFreeEntry();
-        entry->id      = placeholder_id;
-        entry->handle  = handle;
-        entry->counter = m_cur_counter++;
-    }
-
-    void PlaceHolderAccessor::Invalidate(CacheEntry *entry) {
+    void PlaceHolderAccessor::FlushAndCloseFile(fs::FileHandle handle) {
         /* Flush and close the cached entry's file. */
-        if (entry != nullptr) {
-            fs::FlushFile(entry->handle);
-            fs::CloseFile(entry->handle);
-            entry->id = InvalidPlaceHolderId;
-        }
-    }
-
-    PlaceHolderAccessor::CacheEntry *PlaceHolderAccessor::FindInCache(PlaceHolderId placeholder_id) {
-        /* Ensure placeholder id is valid. */
-        if (placeholder_id == InvalidPlaceHolderId) {
-            return nullptr;
-        }
-
-        /* Attempt to find a cache entry with the same placeholder id. */
-        for (size_t i = 0; i < MaxCacheEntries; i++) {
-            if (placeholder_id == m_caches[i].id) {
-                return std::addressof(m_caches[i]);
-            }
-        }
-        return nullptr;
-    }
-
-    PlaceHolderAccessor::CacheEntry *PlaceHolderAccessor::GetFreeEntry() {
-        /* Try to find an already free entry. */
-        for (size_t i = 0; i < MaxCacheEntries; i++) {
-            if (m_caches[i].id == InvalidPlaceHolderId) {
-                return std::addressof(m_caches[i]);
-            }
-        }
-
-        /* Get the oldest entry. */
-        CacheEntry *entry = std::addressof(m_caches[0]);
-        for (size_t i = 1; i < MaxCacheEntries; i++) {
-            if (entry->counter < m_caches[i].counter) {
-                entry = std::addressof(m_caches[i]);
-            }
-        }
-        this->Invalidate(entry);
-        return entry;
+        fs::FlushFile(handle);
+        fs::CloseFile(handle);
     }
 
     void PlaceHolderAccessor::GetPath(PathString *placeholder_path, PlaceHolderId placeholder_id) {
-        {
-            std::scoped_lock lock(m_cache_mutex);
-            this->Invalidate(this->FindInCache(placeholder_id));
-        }
+        m_cache.Invalidate(placeholder_id);
         this->MakePath(placeholder_path, placeholder_id);
     }
 
@@ -195,12 +130,13 @@ namespace ams::ncm {
     Result PlaceHolderAccessor::WritePlaceHolderFile(PlaceHolderId placeholder_id, s64 offset, const void *buffer, size_t size) {
         /* Open the placeholder file. */
         fs::FileHandle file;
-        R_TRY_CATCH(this->Open(std::addressof(file), placeholder_id)) {
+        u64 generation;
+        R_TRY_CATCH(this->Open(std::addressof(file), std::addressof(generation), placeholder_id)) {
             R_CONVERT(fs::ResultPathNotFound, ncm::ResultPlaceHolderNotFound())
         } R_END_TRY_CATCH;
 
         /* Store opened files to the cache regardless of write failures. */
-        ON_SCOPE_EXIT { this->StoreToCache(placeholder_id, file); };
+        ON_SCOPE_EXIT { m_cache.Release(placeholder_id, file, generation); };
 
         /* Write data to the placeholder file. */
         R_RETURN(fs::WriteFile(file, offset, buffer, size, m_delay_flush ? fs::WriteOption::Flush : fs::WriteOption::None));
@@ -209,7 +145,8 @@ namespace ams::ncm {
     Result PlaceHolderAccessor::SetPlaceHolderFileSize(PlaceHolderId placeholder_id, s64 size) {
         /* Open the placeholder file. */
         fs::FileHandle file;
-        R_TRY_CATCH(this->Open(std::addressof(file), placeholder_id)) {
+        u64 generation;
+        R_TRY_CATCH(this->Open(std::addressof(file), std::addressof(generation), placeholder_id)) {
             R_CONVERT(fs::ResultPathNotFound, ncm::ResultPlaceHolderNotFound())
         } R_END_TRY_CATCH;
 
@@ -223,11 +160,12 @@ namespace ams::ncm {
     Result PlaceHolderAccessor::TryGetPlaceHolderFileSize(bool *found_in_cache, s64 *out_size, PlaceHolderId placeholder_id) {
         /* Attempt to find the placeholder in the cache. */
         fs::FileHandle handle;
-        auto found = this->LoadFromCache(std::addressof(handle), placeholder_id);
+        u64 generation;
+        auto found = m_cache.Acquire(std::addressof(handle), std::addressof(generation), placeholder_id);
 
         if (found) {
             /* Renew the entry in the cache. */
-            this->StoreToCache(placeholder_id, handle);
+            ON_SCOPE_EXIT { m_cache.Release(placeholder_id, handle, generation); };
             R_TRY(fs::GetFileSize(out_size, handle));
             *found_in_cache = true;
         } else {
@@ -239,11 +177,7 @@ namespace ams::ncm {
 
     void PlaceHolderAccessor::InvalidateAll() {
         /* Invalidate all cache entries. */
-        for (auto &entry : m_caches) {
-            if (entry.id != InvalidPlaceHolderId) {
-                this->Invalidate(std::addressof(entry));
-            }
-        }
+        m_cache.InvalidateAll();
     }
 
 }
@@ -15,38 +15,27 @@
  */
 #pragma once
 #include <stratosphere.hpp>
+#include "ncm_file_handle_cache.hpp"
 
 namespace ams::ncm {
 
     class PlaceHolderAccessor {
         private:
-            struct CacheEntry {
-                PlaceHolderId id;
-                fs::FileHandle handle;
-                u64 counter;
-            };
+            static constexpr size_t MaxCacheEntries     = 0x10;
+            static constexpr size_t DefaultCacheEntries = 0x4;
 
-            static constexpr size_t MaxCacheEntries = 0x2;
+            using PlaceHolderFileCache = FileHandleCache<PlaceHolderId, MaxCacheEntries>;
         private:
-            std::array<CacheEntry, MaxCacheEntries> m_caches;
+            PlaceHolderFileCache m_cache;
             PathString *m_root_path;
-            u64 m_cur_counter;
-            os::SdkMutex m_cache_mutex;
             MakePlaceHolderPathFunction m_make_placeholder_path_func;
             bool m_delay_flush;
         private:
-            Result Open(fs::FileHandle *out_handle, PlaceHolderId placeholder_id);
-            bool LoadFromCache(fs::FileHandle *out_handle, PlaceHolderId placeholder_id);
-            void StoreToCache(PlaceHolderId placeholder_id, fs::FileHandle handle);
-            void Invalidate(CacheEntry *entry);
-            CacheEntry *FindInCache(PlaceHolderId placeholder_id);
-            CacheEntry *GetFreeEntry();;
+            Result Open(fs::FileHandle *out_handle, u64 *out_generation, PlaceHolderId placeholder_id);
+
+            static void FlushAndCloseFile(fs::FileHandle handle);
         public:
-            PlaceHolderAccessor() : m_root_path(nullptr), m_cur_counter(0), m_cache_mutex(), m_make_placeholder_path_func(nullptr), m_delay_flush(false) {
-                for (size_t i = 0; i < MaxCacheEntries; i++) {
-                    m_caches[i].id = InvalidPlaceHolderId;
-                }
-            }
+            PlaceHolderAccessor() : m_cache(FlushAndCloseFile, std::addressof(GetPlaceHolderFileCacheStatistics()), DefaultCacheEntries), m_root_path(nullptr), m_make_placeholder_path_func(nullptr), m_delay_flush(false) { /* ... */ }
 
             ~PlaceHolderAccessor() { this->InvalidateAll(); }
 
@@ -71,6 +60,11 @@ namespace ams::ncm {
 
             void InvalidateAll();
 
+            /* NOTE: Atmosphère extension. Zero selects the default. */
+            void SetCacheEntryCount(size_t count) {
+                m_cache.SetEntryCount(count != 0 ? std::min(count, MaxCacheEntries) : DefaultCacheEntries);
+            }
+
             Result EnsurePlaceHolderDirectory(PlaceHolderId placeholder_id);
             size_t GetHierarchicalDirectoryDepth() const { return GetHierarchicalPlaceHolderDirectoryDepth(m_make_placeholder_path_func); }
     };
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+#include "ncm_registered_content_id_list.hpp"
+
+namespace ams::ncm {
+
+    namespace {
+
+        ALWAYS_INLINE bool IsLess(const ContentId &lhs, const ContentId &rhs) {
+            return std::memcmp(lhs.uuid.data, rhs.uuid.data, sizeof(lhs.uuid.data)) < 0;
+        }
+
+    }
+
+    void RegisteredContentIdList::BeginBuild() {
+        /* Discard any existing contents, but keep our storage for reuse. */
+        m_count            = 0;
+        m_other_file_count = 0;
+        m_valid            = false;
+    }
+
+    void RegisteredContentIdList::Invalidate() {
+        m_ids.reset();
+        m_count            = 0;
+        m_capacity         = 0;
+        m_other_file_count = 0;
+        m_valid            = false;
+    }
+
+    bool RegisteredContentIdList::Insert(const ContentId &content_id) {
+        /* Find where the id belongs; if it's already present, we're done. */
+        const ContentId *pos = this->LowerBound(content_id);
+        const size_t index = pos - m_ids.get();
+        if (index < m_count && m_ids[index] == content_id) {
+            return true;
+        }
+
+        /* Ensure we have space for the id. */
+        if (!this->Reserve(m_count + 1)) {
+            return false;
+        }
+
+        /* Insert the id. */
+        std::memmove(m_ids.get() + index + 1, m_ids.get() + index, sizeof(ContentId) * (m_count - index));
+        m_ids[index] = content_id;
+        ++m_count;
+
+        return true;
+    }
+
+    void RegisteredContentIdList::Remove(const ContentId &content_id) {
+        /* Find the id; if it isn't present, there's nothing to remove. */
+        const ContentId *pos = this->LowerBound(content_id);
+        const size_t index = pos - m_ids.get();
+        if (index >= m_count || m_ids[index] != content_id) {
+            return;
+        }
+
+        /* Remove the id. */
+        std::memmove(m_ids.get() + index, m_ids.get() + index + 1, sizeof(ContentId) * (m_count - (index + 1)));
+        --m_count;
+    }
+
+    size_t RegisteredContentIdList::List(ContentId *out, size_t max_count, size_t offset) const {
+        AMS_ASSERT(m_valid);
+
+        /* If the offset is past our end, there's nothing to list. */
+        if (offset >= m_count) {
+            return 0;
+        }
+
+        /* Copy out as many ids as we can. */
+        const size_t count = std::min(max_count, m_count - offset);
+        std::memcpy(out, m_ids.get() + offset, sizeof(ContentId) * count);
+        return count;
+    }
+
+    const ContentId *RegisteredContentIdList::LowerBound(const ContentId &content_id) const {
+        return std::lower_bound(m_ids.get(), m_ids.get() + m_count, content_id, IsLess);
+    }
+
+    bool RegisteredContentIdList::Reserve(size_t count) {
+        /* If we already have enough space, we're done. */
+        if (count <= m_capacity) {
+            return true;
+        }
+
+        /* Allocate a larger buffer. */
+        const size_t new_capacity = std::max(count, std::max(m_capacity * 2, CapacityMin));
+        std::unique_ptr<ContentId[]> new_ids(new (std::nothrow) ContentId[new_capacity]);
+        if (new_ids == nullptr) {
+            return false;
+        }
+
+        /* Copy our ids to the new buffer. */
+        if (m_count > 0) {
+            std::memcpy(new_ids.get(), m_ids.get(), sizeof(ContentId) * m_count);
+        }
+
+        m_ids      = std::move(new_ids);
+        m_capacity = new_capacity;
+        return true;
+    }
+
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+
+namespace ams::ncm {
+
+    /* NOTE: Atmosphère extension. */
+    /* Sorted in-memory list of the content ids registered in a content storage, to avoid traversing its directory hierarchy. */
+    /* Ids are unique and kept in ascending byte order, which is the order List() pages them in. */
+    class RegisteredContentIdList {
+        NON_COPYABLE(RegisteredContentIdList);
+        NON_MOVEABLE(RegisteredContentIdList);
+        private:
+            static constexpr size_t CapacityMin = 0x40;
+        private:
+            std::unique_ptr<ContentId[]> m_ids;
+            size_t m_count;
+            size_t m_capacity;
+            size_t m_other_file_count;
+            bool m_valid;
+        public:
+            RegisteredContentIdList() : m_ids(), m_count(0), m_capacity(0), m_other_file_count(0), m_valid(false) { /* ... */ }
+
+            bool IsValid() const { return m_valid; }
+
+            void BeginBuild();
+            void EndBuild() { m_valid = true; }
+            void Invalidate();
+
+            bool Insert(const ContentId &content_id);
+            void Remove(const ContentId &content_id);
+            void AddOtherFile() { ++m_other_file_count; }
+
+            size_t GetCount() const { AMS_ASSERT(m_valid); return m_count; }
+            size_t GetFileCount() const { AMS_ASSERT(m_valid); return m_count + m_other_file_count; }
+            size_t List(ContentId *out, size_t max_count, size_t offset) const;
+        private:
+            const ContentId *LowerBound(const ContentId &content_id) const;
+            bool Reserve(size_t count);
+    };
+
+}
@@ -17,6 +17,7 @@
 #include <stratosphere.hpp>
 #include "ncm_remote_content_storage_impl.hpp"
 #include "ncm_remote_content_meta_database_impl.hpp"
+#include "ncm_ams.os.horizon.h"
 
 namespace ams::ncm {
 
@@ -103,6 +104,11 @@ namespace ams::ncm {
             Result ActivateFsContentStorage(fs::ContentStorageId fs_content_storage_id) {
                 R_RETURN(::ncmActivateFsContentStorage(static_cast<::FsContentStorageId>(util::ToUnderlying(fs_content_storage_id))));
             }
+
+            Result AtmosphereGetFileCacheReport(sf::Out<FileCacheReport> out) {
+                static_assert(sizeof(FileCacheReport) == sizeof(::NcmFileCacheReport));
+                R_RETURN(::ncmAtmosphereGetFileCacheReport(reinterpret_cast<::NcmFileCacheReport *>(out.GetPointer())));
+            }
     };
     static_assert(ncm::IsIContentManager<RemoteContentManagerImpl>);
     #endif
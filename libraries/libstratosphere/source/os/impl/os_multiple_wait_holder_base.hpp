@@ -40,6 +40,12 @@ namespace ams::os::impl {
             /* Gets whether waitable has a native handle, writes to output if it does. */
             virtual bool GetNativeHandle(os::NativeHandle *) const = 0;
 
+            /* NOTE: Atmosphère extension. */
+            /* Gets whether the native handle is an ipc session, which host ReplyAndReceive must receive from. */
+            virtual bool IsSessionNativeHandle() const {
+                return false;
+            }
+
             /* Gets the amount of time remaining until this wakes up. */
             virtual TimeSpan GetAbsoluteTimeToWakeup() const {
                 return TimeSpan::FromNanoSeconds(std::numeric_limits<s64>::max());
@@ -21,8 +21,9 @@ namespace ams::os::impl {
     class MultiWaitHolderOfNativeHandle : public MultiWaitHolderOfNativeWaitObject {
         private:
             NativeHandle m_handle;
+            bool m_is_session;
         public:
-            explicit MultiWaitHolderOfNativeHandle(NativeHandle h) : m_handle(h) { /* ... */ }
+            explicit MultiWaitHolderOfNativeHandle(NativeHandle h, bool is_session = false) : m_handle(h), m_is_session(is_session) { /* ... */ }
 
             /* IsSignaled, GetHandle both implemented. */
             virtual TriBool IsSignaled() const override {
@@ -33,6 +34,10 @@ namespace ams::os::impl {
                 *out = m_handle;
                 return true;
             }
+
+            virtual bool IsSessionNativeHandle() const override {
+                return m_is_session;
+            }
     };
 
 }
@@ -20,6 +20,15 @@
 
 namespace ams::os::impl {
 
+    namespace {
+
+        template<typename TargetImpl>
+        ALWAYS_INLINE s32 GetLinkedNativeHandleArray(TargetImpl &target_impl, NativeHandle **out_handles, MultiWaitHolderBase ***out_objects) {
+            return target_impl.GetLinkedNativeHandleArray(out_handles, out_objects);
+        }
+
+    }
+
     template<bool AllowReply>
     Result MultiWaitImpl::WaitAnyImpl(MultiWaitHolderBase **out, bool infinite, TimeSpan timeout, NativeHandle reply_target) {
         /* Prepare for processing. */
@@ -72,10 +81,20 @@ namespace ams::os::impl {
     template<bool AllowReply>
     Result MultiWaitImpl::InternalWaitAnyImpl(MultiWaitHolderBase **out, bool infinite, TimeSpan timeout, NativeHandle reply_target) {
         /* Build the objects array. */
-        NativeHandle object_handles[MaximumHandleCount];
-        MultiWaitHolderBase *objects[MaximumHandleCount];
-
-        const s32 count = this->ConstructObjectsArray(object_handles, objects, MaximumHandleCount);
+        std::array<NativeHandle, ObjectsArrayStorageCount> object_handles_storage;
+        std::array<MultiWaitHolderBase *, ObjectsArrayStorageCount> objects_storage;
+
+        NativeHandle *object_handles;
+        MultiWaitHolderBase **objects;
+        s32 count;
+        if constexpr (MultiWaitTargetImpl::HasLinkedNativeHandleArray) {
+            /* The target keeps its linked handles in list order, so we can use its array directly. */
+            count = GetLinkedNativeHandleArray(m_target_impl, std::addressof(object_handles), std::addressof(objects));
+        } else {
+            object_handles = object_handles_storage.data();
+            objects        = objects_storage.data();
+            count          = this->ConstructObjectsArray(object_handles, objects, MaximumHandleCount);
+        }
 
         /* Determine the appropriate end time for our wait. */
         const TimeSpan end_time = infinite ? TimeSpan::FromNanoSeconds(std::numeric_limits<s64>::max()) : os::impl::GetCurrentTick().ToTimeSpan() + timeout;
@@ -37,6 +37,9 @@ namespace ams::os::impl {
             static constexpr s32 WaitCancelled = -2;
             static constexpr s32 WaitTimedOut  = -1;
             using MultiWaitList = util::IntrusiveListMemberTraitsByNonConstexprOffsetOf<&MultiWaitHolderBase::m_multi_wait_node>::ListType;
+        private:
+            /* NOTE: Atmosphère extension; targets which keep their own array of linked handles don't need one built on the stack for every wait. */
+            static constexpr size_t ObjectsArrayStorageCount = MultiWaitTargetImpl::HasLinkedNativeHandleArray ? 0 : MaximumHandleCount;
         private:
             MultiWaitList m_multi_wait_list;
             MultiWaitHolderBase *m_signaled_holder;
@@ -58,6 +61,18 @@ namespace ams::os::impl {
             MultiWaitHolderBase *RecalcMultiWaitTimeout(TimeSpan *out_min_timeout, TimeSpan end_time);
 
             MultiWaitHolderBase *WaitAnyImpl(bool infinite, TimeSpan timeout);
+
+            void LinkToTarget(MultiWaitHolderBase &holder_base) {
+                if (NativeHandle handle; holder_base.GetNativeHandle(std::addressof(handle))) {
+                    m_target_impl.LinkNativeHandle(std::addressof(holder_base), handle);
+                }
+            }
+
+            void UnlinkFromTarget(MultiWaitHolderBase &holder_base) {
+                if (NativeHandle handle; holder_base.GetNativeHandle(std::addressof(handle))) {
+                    m_target_impl.UnlinkNativeHandle(std::addressof(holder_base), handle);
+                }
+            }
         public:
             /* Wait. */
             MultiWaitHolderBase *WaitAny() {
@@ -85,14 +100,17 @@ namespace ams::os::impl {
 
             void PushBackToList(MultiWaitHolderBase &holder_base) {
                 m_multi_wait_list.push_back(holder_base);
+                this->LinkToTarget(holder_base);
             }
 
             void EraseFromList(MultiWaitHolderBase &holder_base) {
+                this->UnlinkFromTarget(holder_base);
                 m_multi_wait_list.erase(m_multi_wait_list.iterator_to(holder_base));
             }
 
             void EraseAllFromList() {
                 while (!m_multi_wait_list.empty()) {
+                    this->UnlinkFromTarget(m_multi_wait_list.front());
                     m_multi_wait_list.front().SetMultiWait(nullptr);
                     m_multi_wait_list.pop_front();
                 }
@@ -101,7 +119,9 @@ namespace ams::os::impl {
             void MoveAllFromOther(MultiWaitImpl &other) {
                 /* Set ourselves as multi wait for all of the other's holders. */
                 for (auto &w : other.m_multi_wait_list) {
+                    other.UnlinkFromTarget(w);
                     w.SetMultiWait(this);
+                    this->LinkToTarget(w);
                 }
 
                 m_multi_wait_list.splice(m_multi_wait_list.end(), other.m_multi_wait_list);
@@ -22,6 +22,7 @@ namespace ams::os::impl {
     class MultiWaitHorizonImpl {
         public:
             static constexpr size_t MaximumHandleCount = static_cast<size_t>(ams::svc::ArgumentHandleCountMax);
+            static constexpr bool HasLinkedNativeHandleArray = false;
         private:
             NativeHandle m_handle;
         private:
@@ -32,6 +33,14 @@ namespace ams::os::impl {
 
             void CancelWait();
 
+            void LinkNativeHandle(MultiWaitHolderBase *holder, NativeHandle handle) {
+                AMS_UNUSED(holder, handle);
+            }
+
+            void UnlinkNativeHandle(MultiWaitHolderBase *holder, NativeHandle handle) {
+                AMS_UNUSED(holder, handle);
+            }
+
             Result WaitAny(s32 *out_index, NativeHandle arr[], s32 array_size, s32 num) {
                 R_RETURN(this->WaitSynchronizationN(out_index, num, arr, array_size, svc::WaitInfinite));
             }
@@ -17,19 +17,114 @@
 #include "os_multiple_wait_holder_base.hpp"
 #include "os_multiple_wait_impl.hpp"
 #include "os_timeout_helper.hpp"
+#include "os_native_handle_impl.os.linux.hpp"
 #include "os_inter_process_event_impl.os.linux.hpp"
 
 #include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
 
 namespace ams::os::impl {
 
+    namespace {
+
+        /* Each registration carries the handle alongside its slot, so that an event for a slot which has since been reused can be recognized. */
+        constexpr u32 CancelEventSlot = std::numeric_limits<u32>::max();
+
+        constexpr u64 EncodeEpollData(NativeHandle handle, u32 slot) {
+            return (static_cast<u64>(static_cast<u32>(handle)) << 32) | slot;
+        }
+
+        constexpr NativeHandle DecodeEpollHandle(u64 data) {
+            return static_cast<NativeHandle>(static_cast<u32>(data >> 32));
+        }
+
+        constexpr u32 DecodeEpollSlot(u64 data) {
+            return static_cast<u32>(data);
+        }
+
+        void ModifyInEpoll(NativeHandle epoll_handle, NativeHandle handle, u32 slot) {
+            /* NOTE: As with removal, the descriptor may already have been closed. */
+            struct epoll_event ev = { .events = EPOLLIN, .data = { .u64 = EncodeEpollData(handle, slot) } };
+            const auto ret = ::epoll_ctl(epoll_handle, EPOLL_CTL_MOD, handle, std::addressof(ev));
+            AMS_ABORT_UNLESS(ret == 0 || errno == ENOENT || errno == EBADF);
+        }
+
+        void AddToEpoll(NativeHandle epoll_handle, NativeHandle handle, u32 slot) {
+            struct epoll_event ev = { .events = EPOLLIN, .data = { .u64 = EncodeEpollData(handle, slot) } };
+            if (::epoll_ctl(epoll_handle, EPOLL_CTL_ADD, handle, std::addressof(ev)) != 0) {
+                /* A stale registration may remain for a descriptor that was closed while its file lived on elsewhere; take it over. */
+                AMS_ABORT_UNLESS(errno == EEXIST);
+                ModifyInEpoll(epoll_handle, handle, slot);
+            }
+        }
+
+        void RemoveFromEpoll(NativeHandle epoll_handle, NativeHandle handle) {
+            /* NOTE: The kernel drops closed descriptors from the interest list on its own, so a missing entry is fine. */
+            const auto ret = ::epoll_ctl(epoll_handle, EPOLL_CTL_DEL, handle, nullptr);
+            AMS_ABORT_UNLESS(ret == 0 || errno == ENOENT || errno == EBADF);
+        }
+
+        s32 FindLowestSignaledIndex(const NativeHandle arr[], s32 num) {
+            /* Check the handles with a non-blocking poll, a chunk at a time, so that we can stop at the first chunk holding a signaled handle. */
+            constexpr s32 ChunkCount = 64;
+
+            struct pollfd pfds[ChunkCount];
+            for (s32 start = 0; start < num; start += ChunkCount) {
+                const s32 count = std::min(num - start, ChunkCount);
+                for (s32 i = 0; i < count; ++i) {
+                    pfds[i] = { .fd = arr[start + i], .events = POLLIN, .revents = 0 };
+                }
+
+                s32 ret;
+                do {
+                    ret = ::poll(pfds, count, 0);
+                } while (ret < 0 && errno == EINTR);
+                AMS_ABORT_UNLESS(ret >= 0);
+
+                if (ret > 0) {
+                    for (s32 i = 0; i < count; ++i) {
+                        if (pfds[i].revents & (POLLIN | POLLERR | POLLHUP)) {
+                            return start + i;
+                        }
+                    }
+                }
+            }
+
+            return -1;
+        }
+
+    }
+
     MultiWaitLinuxImpl::MultiWaitLinuxImpl() {
         R_ABORT_UNLESS(InterProcessEventLinuxImpl::CreateSingle(std::addressof(m_cancel_event)));
+
+        /* Create our epoll instance; linked handles are registered to it once, rather than on every wait. */
+        m_epoll_handle = ::epoll_create1(EPOLL_CLOEXEC);
+        AMS_ABORT_UNLESS(m_epoll_handle != InvalidNativeHandle);
+
+        AddToEpoll(m_epoll_handle, m_cancel_event, CancelEventSlot);
+
+        /* Create our linked handle table. */
+        m_linked_table = static_cast<LinkedHandleTable *>(ams::Malloc(sizeof(LinkedHandleTable)));
+        AMS_ABORT_UNLESS(m_linked_table != nullptr);
+
+        m_linked_table->count          = 0;
+        m_linked_table->num_free_slots = MaximumHandleCount;
+        for (size_t i = 0; i < MaximumHandleCount; ++i) {
+            /* Hand out lower slots first. */
+            m_linked_table->free_slots[i]    = static_cast<u16>(MaximumHandleCount - 1 - i);
+            m_linked_table->index_of_slot[i] = InvalidLinkedIndex;
+        }
     }
 
     MultiWaitLinuxImpl::~MultiWaitLinuxImpl() {
+        ams::Free(m_linked_table);
+        NativeHandleLinuxImpl::Close(m_epoll_handle);
         InterProcessEventLinuxImpl::Close(m_cancel_event);
 
+        m_linked_table = nullptr;
+        m_epoll_handle = InvalidNativeHandle;
         m_cancel_event = InvalidNativeHandle;
     }
 
@@ -37,30 +132,126 @@ namespace ams::os::impl {
         InterProcessEventLinuxImpl::Signal(m_cancel_event);
     }
 
+    s32 MultiWaitLinuxImpl::FindLinkedIndex(NativeHandle handle, s32 ignored_index) const {
+        /* NOTE: This is only needed when the same handle is linked more than once, or when an event arrives for a stale registration. */
+        for (auto i = 0; i < m_linked_table->count; ++i) {
+            if (i != ignored_index && m_linked_table->handles[i] == handle) {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    void MultiWaitLinuxImpl::LinkNativeHandle(MultiWaitHolderBase *holder, NativeHandle handle) {
+        auto &table = *m_linked_table;
+        AMS_ABORT_UNLESS(table.num_free_slots > 0);
+
+        /* Take a slot, and append the handle. */
+        const u16 slot  = table.free_slots[--table.num_free_slots];
+        const s32 index = table.count++;
+
+        table.handles[index]       = handle;
+        table.holders[index]       = holder;
+        table.slot_of_index[index] = slot;
+        table.index_of_slot[slot]  = static_cast<u16>(index);
+
+        /* Register the handle with epoll, unless it's already registered for an earlier (and so preferred) index. */
+        if (this->FindLinkedIndex(handle, index) < 0) {
+            AddToEpoll(m_epoll_handle, handle, slot);
+        }
+    }
+
+    void MultiWaitLinuxImpl::UnlinkNativeHandle(MultiWaitHolderBase *holder, NativeHandle handle) {
+        auto &table = *m_linked_table;
+
+        /* Find the holder's index. */
+        s32 index = -1;
+        for (auto i = 0; i < table.count; ++i) {
+            if (table.holders[i] == holder) {
+                index = i;
+                break;
+            }
+        }
+        AMS_ABORT_UNLESS(index >= 0);
+        AMS_ASSERT(table.handles[index] == handle);
+
+        /* Remove the handle, preserving the order of the others. */
+        const u16 slot = table.slot_of_index[index];
+        for (auto i = index + 1; i < table.count; ++i) {
+            table.handles[i - 1]       = table.handles[i];
+            table.holders[i - 1]       = table.holders[i];
+            table.slot_of_index[i - 1] = table.slot_of_index[i];
+            table.index_of_slot[table.slot_of_index[i - 1]] = static_cast<u16>(i - 1);
+        }
+        --table.count;
+
+        table.index_of_slot[slot] = InvalidLinkedIndex;
+        table.free_slots[table.num_free_slots++] = slot;
+
+        /* If the handle is still linked elsewhere, point its registration there; otherwise, unregister it. */
+        if (const s32 other = this->FindLinkedIndex(handle, -1); other >= 0) {
+            ModifyInEpoll(m_epoll_handle, handle, table.slot_of_index[other]);
+        } else {
+            RemoveFromEpoll(m_epoll_handle, handle);
+        }
+    }
+
+    Result MultiWaitLinuxImpl::WaitForCancelImpl(s32 *out_index, s64 ns) {
+        /* With no handles to wait on, only a cancellation can end the wait early; leave the epoll instance (and whatever is ready on it) alone. */
+        constexpr s64 NanoSecondsPerSecond = TimeSpan::FromSeconds(1).GetNanoSeconds();
+        struct timespec ts = { .tv_sec = (std::max<s64>(ns, 0) / NanoSecondsPerSecond), .tv_nsec = std::max<s64>(ns, 0) % NanoSecondsPerSecond };
+
+        struct pollfd pfd = { .fd = m_cancel_event, .events = POLLIN, .revents = 0 };
+        const auto ret = ::ppoll(std::addressof(pfd), 1, ns >= 0 ? std::addressof(ts) : nullptr, nullptr);
+        if (ret < 0) {
+            /* Treat EINTR like a cancellation event; this will lead to a re-poll if nothing is signaled. */
+            AMS_ABORT_UNLESS(errno == EINTR);
+
+            *out_index = MultiWaitImpl::WaitCancelled;
+        } else if (ret == 0) {
+            *out_index = MultiWaitImpl::WaitTimedOut;
+        } else {
+            *out_index = MultiWaitImpl::WaitCancelled;
+
+            /* Reset our cancel event. */
+            InterProcessEventLinuxImpl::Clear(m_cancel_event);
+        }
+
+        R_SUCCEED();
+    }
+
     Result MultiWaitLinuxImpl::PollNativeHandlesImpl(s32 *out_index, s32 num, NativeHandle arr[], s32 array_size, s64 ns) {
-        /* Check that we can add our cancel handle to the wait. */
         AMS_ABORT_UNLESS(array_size <= static_cast<s32>(MaximumHandleCount));
         AMS_UNUSED(array_size);
 
-        /* Create poll fds. */
-        struct pollfd pfds[MaximumHandleCount + 1];
-        for (auto i = 0; i < num; ++i) {
-            pfds[i].fd      = arr[i];
-            pfds[i].events  = POLLIN;
-            pfds[i].revents = 0;
+        /* If there's nothing to wait on, don't consume (or discard) events for handles which aren't part of this wait. */
+        if (num == 0) {
+            R_RETURN(this->WaitForCancelImpl(out_index, ns));
         }
 
-        pfds[num].fd      = m_cancel_event;
-        pfds[num].events  = POLLIN;
-        pfds[num].revents = 0;
+        /* NOTE: Every handle in arr was registered to our epoll instance when its holder was linked. */
+        const TimeoutHelper timeout_helper(TimeSpan::FromNanoSeconds(std::max<s64>(ns, 0)));
 
-        /* Determine timeout. */
-        constexpr s64 NanoSecondsPerSecond = TimeSpan::FromSeconds(1).GetNanoSeconds();
-        struct timespec ts = { .tv_sec = (ns / NanoSecondsPerSecond), .tv_nsec = ns % NanoSecondsPerSecond };
-
-        /* Wait. */
+        struct epoll_event events[EventBatchCount];
         while (true) {
-            const auto ret = ::ppoll(pfds, num + 1, ns >= 0 ? std::addressof(ts) : nullptr, nullptr);
+            /* Wait for a batch of events. */
+            s32 ret;
+            if (ns > 0) {
+                /* epoll_wait only has millisecond resolution, so perform timed waits by polling the epoll descriptor itself. */
+                constexpr s64 NanoSecondsPerSecond = TimeSpan::FromSeconds(1).GetNanoSeconds();
+                const s64 left = std::max<s64>(timeout_helper.GetTimeLeftOnTarget().GetNanoSeconds(), 0);
+                struct timespec ts = { .tv_sec = (left / NanoSecondsPerSecond), .tv_nsec = left % NanoSecondsPerSecond };
+
+                struct pollfd pfd = { .fd = m_epoll_handle, .events = POLLIN, .revents = 0 };
+                ret = ::ppoll(std::addressof(pfd), 1, std::addressof(ts), nullptr);
+                if (ret > 0) {
+                    ret = ::epoll_wait(m_epoll_handle, events, EventBatchCount, 0);
+                }
+            } else {
+                ret = ::epoll_wait(m_epoll_handle, events, EventBatchCount, ns < 0 ? -1 : 0);
+            }
+
             if (ret < 0) {
                 /* Treat EINTR like a cancellation event; this will lead to a re-poll if nothing is signaled. */
                 AMS_ABORT_UNLESS(errno == EINTR);
@@ -71,31 +262,107 @@ namespace ams::os::impl {
 
             /* Determine what event was polled. */
             if (ret == 0) {
+                /* Our epoll descriptor may have been readied by an event that was consumed before we collected it. */
+                if (ns > 0 && !timeout_helper.TimedOut()) {
+                    continue;
+                }
+
                 *out_index = MultiWaitImpl::WaitTimedOut;
                 R_SUCCEED();
-            } else if (pfds[num].revents != 0) {
+            }
+
+            /* Process the batch: cancellation takes priority, and otherwise we prefer the lowest signaled index. */
+            bool cancelled = false;
+            s32 index = -1;
+            for (auto i = 0; i < ret; ++i) {
+                const NativeHandle handle = DecodeEpollHandle(events[i].data.u64);
+                const u32 slot            = DecodeEpollSlot(events[i].data.u64);
+                if (slot == CancelEventSlot) {
+                    cancelled = true;
+                    continue;
+                }
+
+                /* Each registration names its slot, which maps straight to the handle's index. */
+                AMS_ASSERT(slot < MaximumHandleCount);
+                if (const s32 cur = m_linked_table->index_of_slot[slot]; cur != InvalidLinkedIndex && cur < num && arr[cur] == handle) {
+                    if (index < 0 || cur < index) {
+                        index = cur;
+                    }
+                } else if (this->FindLinkedIndex(handle, -1) < 0) {
+                    /* The registration outlived its link (the descriptor was closed and its number reused before unlinking); drop it. */
+                    RemoveFromEpoll(m_epoll_handle, handle);
+                }
+            }
+
+            if (cancelled) {
                 *out_index = MultiWaitImpl::WaitCancelled;
 
                 /* Reset our cancel event. */
                 InterProcessEventLinuxImpl::Clear(m_cancel_event);
 
                 R_SUCCEED();
-            } else {
-                for (auto i = 0; i < num; ++i) {
-                    if (pfds[i].revents != 0) {
-                        *out_index = i;
-                        R_SUCCEED();
+            } else if (index >= 0) {
+                /* A full batch may have left lower signaled handles behind in the ready list, so check those directly. */
+                if (ret == EventBatchCount && index > 0) {
+                    if (const s32 lower = FindLowestSignaledIndex(arr, index); lower >= 0) {
+                        index = lower;
                     }
                 }
 
-                AMS_ABORT("This should be impossible?");
+                *out_index = index;
+                R_SUCCEED();
+            }
+
+            /* If we only saw stale descriptors, and we weren't asked to block, we've timed out. */
+            if (ns == 0 || (ns > 0 && timeout_helper.TimedOut())) {
+                *out_index = MultiWaitImpl::WaitTimedOut;
+                R_SUCCEED();
             }
         }
     }
 
     Result MultiWaitLinuxImpl::ReplyAndReceiveImpl(s32 *out_index, s32 num, NativeHandle arr[], s32 array_size, s64 ns, NativeHandle reply_target) {
-        AMS_UNUSED(out_index, num, arr, array_size, ns, reply_target);
-        R_ABORT_UNLESS(os::ResultNotImplemented());
+        /* If we have a reply target, send it the reply held in our message buffer. */
+        if (reply_target != InvalidNativeHandle) {
+            ssize_t res;
+            do {
+                res = ::send(reply_target, sf::hipc::GetMessageBufferOnTls(), sf::hipc::TlsMessageBufferSize, MSG_NOSIGNAL);
+            } while (res < 0 && errno == EINTR);
+
+            if (res < 0) {
+                AMS_ABORT_UNLESS(errno == EPIPE || errno == ECONNRESET);
+
+                *out_index = MultiWaitImpl::WaitInvalid;
+                R_THROW(os::ResultSessionClosedForReply());
+            }
+            AMS_ABORT_UNLESS(res == static_cast<ssize_t>(sf::hipc::TlsMessageBufferSize));
+
+            /* If we were only asked to reply, there is nothing to wait on. */
+            if (num == 0) {
+                *out_index = MultiWaitImpl::WaitTimedOut;
+                R_SUCCEED();
+            }
+        }
+
+        /* Wait for one of our handles to be signaled. */
+        R_TRY(this->PollNativeHandlesImpl(out_index, num, arr, array_size, ns != std::numeric_limits<s64>::max() ? ns : -1));
+
+        /* If a session was signaled, receive its request into our message buffer, as the kernel would. */
+        /* NOTE: We are always waiting on our linked handles, so the holder tells us whether the handle was attached as a session. */
+        AMS_ASSERT(num == 0 || arr == m_linked_table->handles);
+        if (const s32 index = *out_index; 0 <= index && index < num && m_linked_table->holders[index]->IsSessionNativeHandle()) {
+            ssize_t res;
+            do {
+                res = ::recv(arr[index], sf::hipc::GetMessageBufferOnTls(), sf::hipc::TlsMessageBufferSize, 0);
+            } while (res < 0 && errno == EINTR);
+
+            if (res == 0 || (res < 0 && errno == ECONNRESET)) {
+                R_THROW(os::ResultSessionClosedForReceive());
+            }
+            AMS_ABORT_UNLESS(res > 0);
+        }
+
+        R_SUCCEED();
     }
 
 }
@@ -19,13 +19,36 @@
 
 namespace ams::os::impl {
 
+    class MultiWaitHolderBase;
+
     class MultiWaitLinuxImpl {
         public:
-            /* TODO: This can potentially be higher. */
-            static constexpr size_t MaximumHandleCount = 64;
+            /* NOTE: Atmosphère extension; handles are registered with epoll rather than passed to poll for each wait, so we can support many more. */
+            static constexpr size_t MaximumHandleCount = 1024;
+            static constexpr bool HasLinkedNativeHandleArray = true;
+            static constexpr s32 EventBatchCount = 16;
+        private:
+            static constexpr u16 InvalidLinkedIndex = std::numeric_limits<u16>::max();
+            static_assert(MaximumHandleCount < InvalidLinkedIndex);
+
+            /* Linked handles are kept in link order (matching the multi wait's list), and each has a stable slot which we register with epoll. */
+            struct LinkedHandleTable {
+                NativeHandle handles[MaximumHandleCount];
+                MultiWaitHolderBase *holders[MaximumHandleCount];
+                u16 slot_of_index[MaximumHandleCount];
+                u16 index_of_slot[MaximumHandleCount];
+                u16 free_slots[MaximumHandleCount];
+                s32 count;
+                s32 num_free_slots;
+            };
         private:
             NativeHandle m_cancel_event;
+            NativeHandle m_epoll_handle;
+            LinkedHandleTable *m_linked_table;
         private:
+            s32 FindLinkedIndex(NativeHandle handle, s32 ignored_index) const;
+
+            Result WaitForCancelImpl(s32 *out_index, s64 ns);
             Result PollNativeHandlesImpl(s32 *out_index, s32 num, NativeHandle arr[], s32 array_size, s64 ns);
             Result ReplyAndReceiveImpl(s32 *out_index, s32 num, NativeHandle arr[], s32 array_size, s64 ns, NativeHandle reply_target);
         public:
@@ -34,6 +57,15 @@ namespace ams::os::impl {
 
             void CancelWait();
 
+            void LinkNativeHandle(MultiWaitHolderBase *holder, NativeHandle handle);
+            void UnlinkNativeHandle(MultiWaitHolderBase *holder, NativeHandle handle);
+
+            s32 GetLinkedNativeHandleArray(NativeHandle **out_handles, MultiWaitHolderBase ***out_holders) {
+                *out_handles = m_linked_table->handles;
+                *out_holders = m_linked_table->holders;
+                return m_linked_table->count;
+            }
+
             Result WaitAny(s32 *out_index, NativeHandle arr[], s32 array_size, s32 num) {
                 R_RETURN(this->PollNativeHandlesImpl(out_index, num, arr, array_size, static_cast<s64>(-1)));
             }
@@ -23,6 +23,7 @@ namespace ams::os::impl {
         public:
             /* TODO: This can potentially be higher. */
             static constexpr size_t MaximumHandleCount = 64;
+            static constexpr bool HasLinkedNativeHandleArray = false;
         private:
             NativeHandle m_cancel_read_handle;
             NativeHandle m_cancel_write_handle;
@@ -35,6 +36,14 @@ namespace ams::os::impl {
 
             void CancelWait();
 
+            void LinkNativeHandle(MultiWaitHolderBase *holder, NativeHandle handle) {
+                AMS_UNUSED(holder, handle);
+            }
+
+            void UnlinkNativeHandle(MultiWaitHolderBase *holder, NativeHandle handle) {
+                AMS_UNUSED(holder, handle);
+            }
+
             Result WaitAny(s32 *out_index, NativeHandle arr[], s32 array_size, s32 num) {
                 R_RETURN(this->PollNativeHandlesImpl(out_index, num, arr, array_size, static_cast<s64>(-1)));
             }
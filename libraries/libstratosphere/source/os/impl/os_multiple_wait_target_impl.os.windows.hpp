@@ -22,6 +22,7 @@ namespace ams::os::impl {
     class MultiWaitWindowsImpl {
         public:
             static constexpr size_t MaximumHandleCount = static_cast<size_t>(MAXIMUM_WAIT_OBJECTS);
+            static constexpr bool HasLinkedNativeHandleArray = false;
         private:
             os::NativeHandle m_cancel_event;
         private:
@@ -43,6 +44,14 @@ namespace ams::os::impl {
                 ::SetEvent(m_cancel_event);
             }
 
+            void LinkNativeHandle(MultiWaitHolderBase *holder, NativeHandle handle) {
+                AMS_UNUSED(holder, handle);
+            }
+
+            void UnlinkNativeHandle(MultiWaitHolderBase *holder, NativeHandle handle) {
+                AMS_UNUSED(holder, handle);
+            }
+
             Result WaitAny(s32 *out_index, NativeHandle arr[], s32 array_size, s32 num) {
                 R_RETURN(this->WaitForMultipleObjectsImpl(out_index, num, arr, array_size, INFINITE));
             }
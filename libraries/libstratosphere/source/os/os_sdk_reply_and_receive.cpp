@@ -44,4 +44,12 @@ namespace ams::os {
         R_RETURN(impl.ReplyAndReceive(std::addressof(holder_base), reply_target));
     }
 
+    void SdkInitializeMultiWaitHolderForSession(MultiWaitHolderType *holder, NativeHandle session_handle) {
+        AMS_ASSERT(session_handle != os::InvalidNativeHandle);
+
+        util::ConstructAt(GetReference(holder->impl_storage).holder_of_native_handle_storage, session_handle, true);
+
+        holder->user_data = 0;
+    }
+
 }
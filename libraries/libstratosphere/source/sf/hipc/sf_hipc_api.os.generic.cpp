@@ -15,8 +15,361 @@
  */
 #include <stratosphere.hpp>
 
+#if defined(ATMOSPHERE_OS_LINUX)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace ams::sf::hipc {
 
+    namespace {
+
+        /* NOTE: Atmosphère extension. */
+        /* Host threads have no kernel-provided message buffer, so we provide one with the same size and alignment. */
+        alignas(0x10) constinit thread_local u8 g_tls_message_buffer[TlsMessageBufferSize] = {};
+
+        #if defined(ATMOSPHERE_OS_LINUX)
+        /* NOTE: On linux, a session is a pair of connected SOCK_SEQPACKET sockets. */
+        /* Each request/reply is a single packet holding the message buffer, so message boundaries are preserved */
+        /* and readiness can be waited upon by polling the session's descriptor directly. */
+        /* Sessions only ever connect threads of a single process, so buffer descriptors are passed through as-is; */
+        /* the rest of what the kernel does to a message in transit (copying statics into the receiver's receive list, */
+        /* duplicating copy handles and filling in the sender's process id) is done here. */
+        constexpr inline size_t ReceiveListEntryCountMax = 13;
+
+        struct ReceiveList {
+            u32 num_entries; /* HIPC_AUTO_RECV_STATIC for a single entry that statics are packed into. */
+            HipcRecvListEntry entries[ReceiveListEntryCountMax];
+        };
+
+        /* A receiver that can't accept a message answers with this in place of a reply, which full message buffers can't be confused with. */
+        struct ErrorPacket {
+            u32 result;
+        };
+
+        ALWAYS_INLINE uintptr_t GetMessageEnd(const void *message_buf, size_t message_size) {
+            return reinterpret_cast<uintptr_t>(message_buf) + message_size;
+        }
+
+        void SaveReceiveList(ReceiveList *out, void *message_buf, size_t message_buf_size) {
+            const auto request = hipcParseRequest(message_buf);
+
+            /* A receive list which doesn't fit in the message buffer is treated as empty; any statics sent to it will break it. */
+            const size_t num_entries = request.meta.num_recv_statics == HIPC_AUTO_RECV_STATIC ? 1 : request.meta.num_recv_statics;
+            static_assert(util::size(ReceiveList{}.entries) >= 0xF - 2);
+            if (num_entries == 0 || reinterpret_cast<uintptr_t>(request.data.recv_list + num_entries) > GetMessageEnd(message_buf, message_buf_size)) {
+                out->num_entries = 0;
+                return;
+            }
+
+            out->num_entries = request.meta.num_recv_statics;
+            std::memcpy(out->entries, request.data.recv_list, num_entries * sizeof(HipcRecvListEntry));
+        }
+
+        Result CopyStatics(void *message_buf, size_t message_size, const ReceiveList &recv_list) {
+            const auto request = hipcParseRequest(message_buf);
+            R_UNLESS(reinterpret_cast<uintptr_t>(request.data.send_statics + request.meta.num_send_statics) <= GetMessageEnd(message_buf, message_size), svc::ResultInvalidCombination());
+
+            size_t auto_offset = 0;
+            for (size_t i = 0; i < request.meta.num_send_statics; ++i) {
+                HipcStaticDescriptor * const desc = request.data.send_statics + i;
+                const size_t size = hipcGetStaticSize(desc);
+                if (size == 0) {
+                    continue;
+                }
+
+                /* Select where in the receive list the static goes. */
+                const HipcRecvListEntry *entry;
+                size_t offset;
+                if (recv_list.num_entries == HIPC_AUTO_RECV_STATIC) {
+                    entry       = recv_list.entries;
+                    offset      = util::AlignUp(auto_offset, 0x10);
+                    auto_offset = offset + size;
+                } else {
+                    R_UNLESS(desc->index < recv_list.num_entries, svc::ResultReceiveListBroken());
+                    entry  = recv_list.entries + desc->index;
+                    offset = 0;
+                }
+                R_UNLESS(offset + size <= entry->size, svc::ResultReceiveListBroken());
+
+                /* Copy the static, and point its descriptor at the copy. */
+                void * const dst = reinterpret_cast<void *>((static_cast<uintptr_t>(entry->address_low) | (static_cast<uintptr_t>(entry->address_high) << 32)) + offset);
+                std::memcpy(dst, hipcGetStaticAddress(desc), size);
+                *desc = hipcMakeSendStatic(dst, size, desc->index);
+            }
+
+            R_SUCCEED();
+        }
+
+        void CloseCopyHandles(void *message_buf, size_t count) {
+            const auto request = hipcParseRequest(message_buf);
+            for (size_t i = 0; i < count; ++i) {
+                os::CloseNativeHandle(request.data.copy_handles[i]);
+            }
+        }
+
+        Result DuplicateCopyHandles(void *message_buf, size_t message_size) {
+            const auto request = hipcParseRequest(message_buf);
+            R_UNLESS(reinterpret_cast<uintptr_t>(request.data.copy_handles + request.meta.num_copy_handles) <= GetMessageEnd(message_buf, message_size), svc::ResultInvalidCombination());
+
+            for (size_t i = 0; i < request.meta.num_copy_handles; ++i) {
+                const int handle = ::fcntl(request.data.copy_handles[i], F_DUPFD_CLOEXEC, 0);
+                if (handle < 0) {
+                    CloseCopyHandles(message_buf, i);
+                    R_UNLESS(errno != EBADF, svc::ResultInvalidHandle());
+                    R_THROW(svc::ResultOutOfHandles());
+                }
+
+                request.data.copy_handles[i] = handle;
+            }
+
+            R_SUCCEED();
+        }
+
+        void SetProcessId(void *message_buf) {
+            HipcHeader hdr = {};
+            std::memcpy(std::addressof(hdr), message_buf, sizeof(hdr));
+            if (!hdr.has_special_header) {
+                return;
+            }
+
+            HipcSpecialHeader sphdr = {};
+            std::memcpy(std::addressof(sphdr), static_cast<u8 *>(message_buf) + sizeof(hdr), sizeof(sphdr));
+            if (sphdr.send_pid) {
+                const u64 process_id = static_cast<u64>(::getpid());
+                std::memcpy(static_cast<u8 *>(message_buf) + sizeof(hdr) + sizeof(sphdr), std::addressof(process_id), sizeof(process_id));
+            }
+        }
+
+        bool SendPacket(os::NativeHandle session_handle, const void *packet, size_t packet_size) {
+            /* NOTE: We never send empty packets, as those would be indistinguishable from the session closing. */
+            AMS_ASSERT(packet_size > 0);
+
+            ssize_t res;
+            do {
+                res = ::send(session_handle, packet, packet_size, MSG_NOSIGNAL);
+            } while (res < 0 && errno == EINTR);
+
+            if (res < 0) {
+                AMS_ABORT_UNLESS(errno == EPIPE || errno == ECONNRESET);
+                return false;
+            }
+            AMS_ABORT_UNLESS(res == static_cast<ssize_t>(packet_size));
+
+            return true;
+        }
+
+        size_t ReceivePacket(os::NativeHandle session_handle, void *packet, size_t packet_size) {
+            AMS_ASSERT(packet_size > 0);
+
+            ssize_t res;
+            do {
+                res = ::recv(session_handle, packet, packet_size, 0);
+            } while (res < 0 && errno == EINTR);
+
+            /* A zero-length read or a reset connection means our peer has closed the session. */
+            if (res == 0 || (res < 0 && errno == ECONNRESET)) {
+                return 0;
+            }
+            AMS_ABORT_UNLESS(res > 0);
+
+            return static_cast<size_t>(res);
+        }
+
+        Result ReceiveImpl(bool *out_closed, os::NativeHandle session_handle, void *message_buf, size_t message_buf_size) {
+            /* Save the receive list set up in our message buffer, before the request overwrites it. */
+            ReceiveList recv_list;
+            SaveReceiveList(std::addressof(recv_list), message_buf, message_buf_size);
+
+            const size_t message_size = ReceivePacket(session_handle, message_buf, message_buf_size);
+            if (message_size == 0) {
+                *out_closed = true;
+                R_SUCCEED();
+            }
+
+            /* If the request's statics don't fit our receive list, the request fails for its sender. */
+            if (const Result result = CopyStatics(message_buf, message_size, recv_list); R_FAILED(result)) {
+                const ErrorPacket packet = { .result = result.GetValue() };
+                SendPacket(session_handle, std::addressof(packet), sizeof(packet));
+                R_THROW(result);
+            }
+
+            *out_closed = false;
+            R_SUCCEED();
+        }
+
+        Result ReplyImpl(os::NativeHandle session_handle, void *message_buf, size_t message_buf_size) {
+            R_TRY(DuplicateCopyHandles(message_buf, message_buf_size));
+
+            /* Replying to a closed session is not an error, as on the real kernel. */
+            if (!SendPacket(session_handle, message_buf, message_buf_size)) {
+                CloseCopyHandles(message_buf, hipcParseRequest(message_buf).meta.num_copy_handles);
+            }
+
+            R_SUCCEED();
+        }
+
+        Result ConvertSocketCreationError() {
+            AMS_ABORT_UNLESS(errno == EMFILE || errno == ENFILE || errno == ENOMEM || errno == ENOBUFS);
+            R_THROW(sf::hipc::ResultOutOfSessions());
+        }
+        #endif
+
+    }
+
+    void *GetMessageBufferOnTls() {
+        return g_tls_message_buffer;
+    }
+
+    #if defined(ATMOSPHERE_OS_LINUX)
+
+    void AttachMultiWaitHolderForAccept(os::MultiWaitHolderType *holder, os::NativeHandle port) {
+        return os::InitializeMultiWaitHolder(holder, port);
+    }
+
+    void AttachMultiWaitHolderForReply(os::MultiWaitHolderType *holder, os::NativeHandle request) {
+        return os::SdkInitializeMultiWaitHolderForSession(holder, request);
+    }
+
+    Result Receive(ReceiveResult *out_recv_result, os::NativeHandle session_handle, const cmif::PointerAndSize &message_buffer) {
+        bool closed;
+        R_TRY_CATCH(ReceiveImpl(std::addressof(closed), session_handle, message_buffer.GetPointer(), message_buffer.GetSize())) {
+            R_CATCH(svc::ResultReceiveListBroken, svc::ResultInvalidCombination) {
+                *out_recv_result = ReceiveResult::NeedsRetry;
+                R_SUCCEED();
+            }
+        } R_END_TRY_CATCH;
+
+        *out_recv_result = closed ? ReceiveResult::Closed : ReceiveResult::Success;
+        R_SUCCEED();
+    }
+
+    Result Receive(bool *out_closed, os::NativeHandle session_handle, const cmif::PointerAndSize &message_buffer) {
+        R_RETURN(ReceiveImpl(out_closed, session_handle, message_buffer.GetPointer(), message_buffer.GetSize()));
+    }
+
+    Result Reply(os::NativeHandle session_handle, const cmif::PointerAndSize &message_buffer) {
+        R_RETURN(ReplyImpl(session_handle, message_buffer.GetPointer(), message_buffer.GetSize()));
+    }
+
+    Result CreateSession(os::NativeHandle *out_server_handle, os::NativeHandle *out_client_handle) {
+        int fds[2];
+        int res;
+        do {
+            res = ::socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds);
+        } while (res < 0 && errno == EINTR);
+
+        R_UNLESS(res == 0, ConvertSocketCreationError());
+
+        *out_server_handle = fds[0];
+        *out_client_handle = fds[1];
+        R_SUCCEED();
+    }
+
+    /* NOTE: On linux, a server port is a listening SOCK_SEQPACKET socket bound to an autogenerated abstract address. */
+    /* The client port shares the listening socket, and is only used to look up the address to connect to; */
+    /* as such, the port keeps accepting connections until both of its handles have been closed. */
+    Result CreatePort(os::NativeHandle *out_server_handle, os::NativeHandle *out_client_handle, s32 max_sessions) {
+        AMS_ASSERT(max_sessions > 0);
+
+        const int server_handle = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        R_UNLESS(server_handle >= 0, ConvertSocketCreationError());
+        auto server_guard = SCOPE_GUARD { os::CloseNativeHandle(server_handle); };
+
+        /* Binding with only an address family makes the kernel choose a unique abstract address for us. */
+        struct sockaddr_un addr = { .sun_family = AF_UNIX };
+        AMS_ABORT_UNLESS(::bind(server_handle, reinterpret_cast<struct sockaddr *>(std::addressof(addr)), sizeof(addr.sun_family)) == 0);
+
+        /* NOTE: The backlog bounds the number of pending connections, not the number of open sessions. */
+        AMS_ABORT_UNLESS(::listen(server_handle, max_sessions) == 0);
+
+        const int client_handle = ::fcntl(server_handle, F_DUPFD_CLOEXEC, 0);
+        R_UNLESS(client_handle >= 0, ConvertSocketCreationError());
+
+        server_guard.Cancel();
+
+        *out_server_handle = server_handle;
+        *out_client_handle = client_handle;
+        R_SUCCEED();
+    }
+
+    Result ConnectToPort(os::NativeHandle *out_session_handle, os::NativeHandle client_port_handle) {
+        /* Get the address the port is listening on. */
+        struct sockaddr_un addr = {};
+        socklen_t addr_len = sizeof(addr);
+        AMS_ABORT_UNLESS(::getsockname(client_port_handle, reinterpret_cast<struct sockaddr *>(std::addressof(addr)), std::addressof(addr_len)) == 0);
+
+        /* Create our session. */
+        const int session_handle = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        R_UNLESS(session_handle >= 0, ConvertSocketCreationError());
+        auto session_guard = SCOPE_GUARD { os::CloseNativeHandle(session_handle); };
+
+        /* Connect it to the port. */
+        int res;
+        do {
+            res = ::connect(session_handle, reinterpret_cast<struct sockaddr *>(std::addressof(addr)), addr_len);
+        } while (res < 0 && errno == EINTR);
+
+        if (res < 0) {
+            AMS_ABORT_UNLESS(errno == ECONNREFUSED);
+            R_THROW(svc::ResultPortClosed());
+        }
+
+        session_guard.Cancel();
+
+        *out_session_handle = session_handle;
+        R_SUCCEED();
+    }
+
+    Result AcceptSession(os::NativeHandle *out_session_handle, os::NativeHandle server_port_handle) {
+        int session_handle;
+        do {
+            session_handle = ::accept4(server_port_handle, nullptr, nullptr, SOCK_CLOEXEC);
+        } while (session_handle < 0 && errno == EINTR);
+
+        R_UNLESS(session_handle >= 0, ConvertSocketCreationError());
+
+        *out_session_handle = session_handle;
+        R_SUCCEED();
+    }
+
+    Result SendSyncRequest(os::NativeHandle session_handle, const cmif::PointerAndSize &message_buffer) {
+        void * const message_buf     = message_buffer.GetPointer();
+        const size_t message_buf_size = message_buffer.GetSize();
+
+        /* Save our receive list, which the reply will overwrite. */
+        ReceiveList recv_list;
+        SaveReceiveList(std::addressof(recv_list), message_buf, message_buf_size);
+
+        /* Prepare the request as the kernel would. */
+        SetProcessId(message_buf);
+        R_TRY(DuplicateCopyHandles(message_buf, message_buf_size));
+
+        /* Send the request; once sent, the duplicated handles belong to the server. */
+        if (!SendPacket(session_handle, message_buf, message_buf_size)) {
+            CloseCopyHandles(message_buf, hipcParseRequest(message_buf).meta.num_copy_handles);
+            R_THROW(svc::ResultSessionClosed());
+        }
+
+        /* Receive the reply in place. */
+        const size_t message_size = ReceivePacket(session_handle, message_buf, message_buf_size);
+        R_UNLESS(message_size > 0, svc::ResultSessionClosed());
+
+        /* If the server couldn't accept our request, it told us why instead of replying. */
+        if (message_size == sizeof(ErrorPacket)) {
+            ErrorPacket packet;
+            std::memcpy(std::addressof(packet), message_buf, sizeof(packet));
+            R_THROW(Result(packet.result));
+        }
+
+        /* Copy the reply's statics into our receive list. */
+        R_RETURN(CopyStatics(message_buf, message_size, recv_list));
+    }
+
+    #else
+
     void AttachMultiWaitHolderForAccept(os::MultiWaitHolderType *, os::NativeHandle) {
         AMS_ABORT("TODO: Generic ams::sf::hipc::AttachMultiWaitHolderForAccept");
     }
@@ -41,4 +394,6 @@ namespace ams::sf::hipc {
         AMS_ABORT("TODO: Generic ams::sf::hipc::CreateSession");
     }
 
+    #endif
+
 }
@@ -119,6 +119,8 @@ namespace ams::sf::hipc {
         os::NativeHandle session_handle;
         #if defined(ATMOSPHERE_OS_HORIZON)
         R_TRY(svc::AcceptSession(std::addressof(session_handle), port_handle));
+        #elif defined(ATMOSPHERE_OS_LINUX)
+        R_TRY(hipc::AcceptSession(std::addressof(session_handle), port_handle));
         #else
         AMS_UNUSED(port_handle);
         AMS_ABORT("TODO");
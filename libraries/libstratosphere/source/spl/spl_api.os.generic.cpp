@@ -132,4 +132,9 @@ namespace ams::spl {
         R_RETURN(impl::PrepareCommonEsTitleKey(out, *static_cast<const KeySource *>(key_source), generation));
     }
 
+    bool IsDevelopment() {
+        /* NOTE: There is no secure monitor to report a hardware state on generic hosts, so we never claim development hardware. */
+        return false;
+    }
+
 }
@@ -57,4 +57,20 @@ namespace ams::util {
         return ZSTD_decompress(dst, dst_size, src, src_size);
     }
 
-}
\ No newline at end of file
+    bool DecompressZstd(void *dst, size_t dst_size, size_t expected_dec_size, const void *src, size_t src_size) {
+        /* Make sure we fit in the destination buffer. */
+        if (expected_dec_size > dst_size) {
+            return false;
+        }
+
+        /* Decompress, without trusting the frame to be well-formed. */
+        const size_t dec_size = ZSTD_decompress(dst, dst_size, src, src_size);
+        if (ZSTD_isError(dec_size)) {
+            return false;
+        }
+
+        /* Make sure we match the expected size. */
+        return dec_size == expected_dec_size;
+    }
+
+}
@@ -86,6 +86,14 @@ namespace ams::crypto {
         return GenerateSha256(dst, dst_size, src, src_size);
     }
 
+    /* Hashes block_count consecutive blocks of block_size bytes from src, each optionally preceded by prefix, */
+    /* writing block_count consecutive hashes to dst. */
+    void GenerateSha256Multiple(void *dst, size_t dst_size, const void *prefix, size_t prefix_size, const void *src, size_t block_size, size_t block_count);
+
+    ALWAYS_INLINE void GenerateSha256Multiple(void *dst, size_t dst_size, const void *src, size_t block_size, size_t block_count) {
+        return GenerateSha256Multiple(dst, dst_size, nullptr, 0, src, block_size, block_count);
+    }
+
     template<typename T, typename = typename std::enable_if<std::same_as<T, u8> || std::same_as<T, s8> || std::same_as<T, char> || std::same_as<T, unsigned char>>::type>
     constexpr ALWAYS_INLINE void GenerateSha256(u8 *dst, size_t dst_size, const T *src, size_t src_size) {
         if (std::is_constant_evaluated()) {
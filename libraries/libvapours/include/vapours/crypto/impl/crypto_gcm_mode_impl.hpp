@@ -99,8 +99,19 @@ namespace ams::crypto::impl {
                 static_cast<const BlockCipher *>(ctx)->EncryptBlock(dst_block, BlockSize, src_block, BlockSize);
             }
 
+            #if defined(ATMOSPHERE_ARCH_X64)
+            size_t UpdateMessage(void *dst, const void *src, size_t src_size, bool encrypt);
+            #endif
+
             void InitializeHashKey();
             void ComputeMac(bool encrypt);
     };
 
+    #if defined(ATMOSPHERE_ARCH_X64)
+    /* NOTE: Atmosphère extension. */
+    /* Disables the pclmul path for GCM, so that tests can check it against the generic path. */
+    /* NOTE: The hash key layout depends on the path, so this must not change while a GcmModeImpl is initialized. */
+    void SetAcceleratedGcmEnabledForTest(bool enabled);
+    #endif
+
 }
@@ -74,4 +74,12 @@ namespace ams::crypto::impl {
 
     static_assert(HashFunction<Sha256Impl>);
 
+    void GenerateSha256MultiBuffer(void *dst, size_t dst_size, const void *prefix, size_t prefix_size, const void *src, size_t block_size, size_t block_count);
+
+    #if defined(ATMOSPHERE_ARCH_X64)
+    /* NOTE: Atmosphère extension. */
+    /* Restricts the instruction set extensions used for SHA-256, so that tests can reach the scalar and avx2 paths on sha-ni hosts. */
+    void SetSha256ExtensionsEnabledForTest(bool sha_ni, bool avx2);
+    #endif
+
 }
@@ -25,4 +25,11 @@ namespace ams::crypto {
         gen.GetHash(dst, dst_size);
     }
 
+    void GenerateSha256Multiple(void *dst, size_t dst_size, const void *prefix, size_t prefix_size, const void *src, size_t block_size, size_t block_count) {
+        AMS_ASSERT(dst_size >= Sha256Generator::HashSize * block_count);
+        AMS_ASSERT(prefix != nullptr || prefix_size == 0);
+
+        return impl::GenerateSha256MultiBuffer(dst, dst_size, prefix, prefix_size, src, block_size, block_count);
+    }
+
 }
@@ -0,0 +1,645 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <vapours.hpp>
+#include "crypto_aes_impl.arch.x64.hpp"
+
+namespace ams::crypto::impl {
+
+    namespace {
+
+        constexpr size_t GcmBlockSize = 16;
+
+        /* Index into the hash key table at which the powers of H used by the pclmul path are stored. */
+        /* NOTE: m_h_mult_blocks[0] always holds H in its natural byte order, for use by the generic path. */
+        constexpr size_t PclmulHashKeyIndex   = 1;
+        constexpr size_t PclmulHashKeyPowers  = 4;
+
+        bool GetPclmulAvailabilityImpl() {
+            /* Call cpu id. */
+            int a = 0, b = 0, c = 0, d = 0;
+            __asm__ __volatile__("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "0"(1) : "memory");
+
+            /* Check for PCLMULQDQ and SSSE3. */
+            return (c & (1 << 1)) && (c & (1 << 9));
+        }
+
+        const bool g_is_pclmul_available = GetPclmulAvailabilityImpl();
+
+        constinit bool g_is_accelerated_gcm_enabled = true;
+
+        ALWAYS_INLINE bool IsAcceleratedGcmAvailable() {
+            return IsAesNiAvailable() && g_is_pclmul_available && g_is_accelerated_gcm_enabled;
+        }
+
+        constexpr u64 GetMultiplyFactor(u8 value) {
+            constexpr size_t Shift = BITSIZEOF(u8) - 1;
+            constexpr u8     Mask  = (1u << Shift);
+            return (value & Mask) >> Shift;
+        }
+
+        constexpr void GaloisShiftLeft(u64 *block) {
+            /* Shift the block left by one. */
+            block[1] <<= 1;
+            block[1] |= (block[0] & (static_cast<u64>(1) << (BITSIZEOF(u64) - 1))) >> (BITSIZEOF(u64) - 1);
+            block[0] <<= 1;
+        }
+
+        constexpr u8 GaloisShiftRight(u64 *block) {
+            /* Determine the mask to return. */
+            constexpr u8 GaloisFieldMask = 0xE1;
+            const u8 mask = (block[0] & 1) * GaloisFieldMask;
+
+            /* Shift the block right by one. */
+            block[0] >>= 1;
+            block[0] |= (block[1] & 1) << (BITSIZEOF(u64) - 1);
+            block[1] >>= 1;
+
+            /* Return the mask. */
+            return mask;
+        }
+
+        /* Multiply two 128-bit numbers X, Y in the GF(128) Galois Field. */
+        void GaloisFieldMult(void *dst, const void *x, const void *y) {
+            /* Our block size is 16 bytes (for a 128-bit integer). */
+            constexpr size_t BlockSize = 16;
+            constexpr size_t FieldSize = 128;
+
+            /* Declare work blocks for us to store temporary values. */
+            u8 x_block[BlockSize];
+            u8 y_block[BlockSize];
+            u8 out[BlockSize];
+
+            /* Declare 64-bit pointers for our convenience. */
+            u64 *x_64   = static_cast<u64 *>(static_cast<void *>(x_block));
+            u64 *y_64   = static_cast<u64 *>(static_cast<void *>(y_block));
+            u64 *out_64 = static_cast<u64 *>(static_cast<void *>(out));
+
+            /* Initialize our work blocks. */
+            for (size_t i = 0; i < BlockSize; ++i) {
+                x_block[i] = static_cast<const u8 *>(x)[BlockSize - 1 - i];
+                y_block[i] = static_cast<const u8 *>(y)[BlockSize - 1 - i];
+                out[i]     = 0;
+            }
+
+            /* Perform multiplication on each bit in y. */
+            for (size_t i = 0; i < FieldSize; ++i) {
+                /* Get the multiply factor for this bit. */
+                const auto y_mult = GetMultiplyFactor(y_block[BlockSize - 1]);
+
+                /* Multiply x by the factor. */
+                out_64[0] ^= x_64[0] * y_mult;
+                out_64[1] ^= x_64[1] * y_mult;
+
+                /* Shift left y by one. */
+                GaloisShiftLeft(y_64);
+
+                /* Shift right x by one, and mask appropriately. */
+                const u8 x_mask = GaloisShiftRight(x_64);
+                x_block[BlockSize - 1] ^= x_mask;
+            }
+
+            /* Copy out our result. */
+            for (size_t i = 0; i < BlockSize; ++i) {
+                static_cast<u8 *>(dst)[i] = out[BlockSize - 1 - i];
+            }
+        }
+
+        /* PCLMUL helpers. These operate on byte-reversed blocks, per the Intel carry-less multiplication white paper. */
+        ALWAYS_INLINE __m128i ByteReverse(__m128i block) {
+            return _mm_shuffle_epi8(block, _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+        }
+
+        ALWAYS_INLINE void CarrylessMultiply(__m128i *out_lo, __m128i *out_hi, __m128i a, __m128i b) {
+            /* Compute the 256-bit carry-less product of a and b. */
+            const __m128i lo  = _mm_clmulepi64_si128(a, b, 0x00);
+            const __m128i hi  = _mm_clmulepi64_si128(a, b, 0x11);
+            const __m128i mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+
+            *out_lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+            *out_hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+        }
+
+        ALWAYS_INLINE __m128i Reduce(__m128i lo, __m128i hi) {
+            /* Shift the 256-bit product left by one, to account for the bit-reflected representation. */
+            {
+                const __m128i lo_carry = _mm_srli_epi32(lo, 31);
+                const __m128i hi_carry = _mm_srli_epi32(hi, 31);
+
+                lo = _mm_or_si128(_mm_slli_epi32(lo, 1), _mm_slli_si128(lo_carry, 4));
+                hi = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(hi, 1), _mm_slli_si128(hi_carry, 4)), _mm_srli_si128(lo_carry, 12));
+            }
+
+            /* Reduce modulo x^128 + x^7 + x^2 + x + 1. */
+            const __m128i a = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30)), _mm_slli_epi32(lo, 25));
+            lo = _mm_xor_si128(lo, _mm_slli_si128(a, 12));
+
+            const __m128i b = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2)), _mm_srli_epi32(lo, 7));
+            return _mm_xor_si128(hi, _mm_xor_si128(lo, _mm_xor_si128(b, _mm_srli_si128(a, 4))));
+        }
+
+        ALWAYS_INLINE __m128i GaloisFieldMultPclmul(__m128i a, __m128i b) {
+            __m128i lo, hi;
+            CarrylessMultiply(std::addressof(lo), std::addressof(hi), a, b);
+            return Reduce(lo, hi);
+        }
+
+        ALWAYS_INLINE __m128i IncrementCounter(__m128i counter) {
+            /* Increment the low 32 bits of the big-endian counter block. */
+            const __m128i Swap32 = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 15, 14, 13, 12);
+            return _mm_shuffle_epi8(_mm_add_epi32(_mm_shuffle_epi8(counter, Swap32), _mm_setr_epi32(0, 0, 0, 1)), Swap32);
+        }
+
+        template<size_t RoundKeyCount>
+        ALWAYS_INLINE __m128i EncryptBlockAesNi(__m128i block, const __m128i (&round_keys)[RoundKeyCount]) {
+            block = _mm_xor_si128(block, round_keys[0]);
+            for (size_t i = 1; i < RoundKeyCount - 1; ++i) {
+                block = _mm_aesenc_si128(block, round_keys[i]);
+            }
+            return _mm_aesenclast_si128(block, round_keys[RoundKeyCount - 1]);
+        }
+
+        template<typename BlockCipher>
+        void EncryptBlocksPclmul(u8 *dst, const u8 *src, size_t num_blocks, bool encrypt, u8 *counter_u8, u8 *ghash_u8, const void *hash_keys, const BlockCipher *cipher) {
+            constexpr size_t RoundKeyCount = BlockCipher::RoundKeySize / GcmBlockSize;
+
+            /* Load all keys into sse2 registers. */
+            const u8 *raw_round_keys = cipher->GetRoundKey();
+            __m128i round_keys[RoundKeyCount];
+            for (size_t i = 0; i < RoundKeyCount; ++i) {
+                round_keys[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(raw_round_keys + GcmBlockSize * i));
+            }
+
+            /* Load the hash key powers (H^1...H^4), which are stored byte-reversed. */
+            const __m128i *h = static_cast<const __m128i *>(hash_keys);
+            const __m128i h1 = _mm_loadu_si128(h + 0);
+            const __m128i h2 = _mm_loadu_si128(h + 1);
+            const __m128i h3 = _mm_loadu_si128(h + 2);
+            const __m128i h4 = _mm_loadu_si128(h + 3);
+
+            /* Load the counter and ghash state. */
+            __m128i counter = _mm_loadu_si128(reinterpret_cast<const __m128i *>(counter_u8));
+            __m128i ghash   = ByteReverse(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ghash_u8)));
+
+            /* Process four blocks at a time, aggregating the ghash reduction. */
+            while (num_blocks >= 4) {
+                /* Generate the counter blocks. */
+                const __m128i c0 = IncrementCounter(counter);
+                const __m128i c1 = IncrementCounter(c0);
+                const __m128i c2 = IncrementCounter(c1);
+                const __m128i c3 = IncrementCounter(c2);
+                counter = c3;
+
+                /* Encrypt the counter blocks. */
+                __m128i b0 = _mm_xor_si128(c0, round_keys[0]);
+                __m128i b1 = _mm_xor_si128(c1, round_keys[0]);
+                __m128i b2 = _mm_xor_si128(c2, round_keys[0]);
+                __m128i b3 = _mm_xor_si128(c3, round_keys[0]);
+                for (size_t i = 1; i < RoundKeyCount - 1; ++i) {
+                    b0 = _mm_aesenc_si128(b0, round_keys[i]);
+                    b1 = _mm_aesenc_si128(b1, round_keys[i]);
+                    b2 = _mm_aesenc_si128(b2, round_keys[i]);
+                    b3 = _mm_aesenc_si128(b3, round_keys[i]);
+                }
+                b0 = _mm_aesenclast_si128(b0, round_keys[RoundKeyCount - 1]);
+                b1 = _mm_aesenclast_si128(b1, round_keys[RoundKeyCount - 1]);
+                b2 = _mm_aesenclast_si128(b2, round_keys[RoundKeyCount - 1]);
+                b3 = _mm_aesenclast_si128(b3, round_keys[RoundKeyCount - 1]);
+
+                /* Load the input. */
+                const __m128i in0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + GcmBlockSize * 0));
+                const __m128i in1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + GcmBlockSize * 1));
+                const __m128i in2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + GcmBlockSize * 2));
+                const __m128i in3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + GcmBlockSize * 3));
+
+                /* Xor with the keystream, and write the output. */
+                const __m128i out0 = _mm_xor_si128(in0, b0);
+                const __m128i out1 = _mm_xor_si128(in1, b1);
+                const __m128i out2 = _mm_xor_si128(in2, b2);
+                const __m128i out3 = _mm_xor_si128(in3, b3);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + GcmBlockSize * 0), out0);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + GcmBlockSize * 1), out1);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + GcmBlockSize * 2), out2);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + GcmBlockSize * 3), out3);
+
+                /* Hash the ciphertext: X' = (X ^ C0) * H^4 ^ C1 * H^3 ^ C2 * H^2 ^ C3 * H. */
+                const __m128i x0 = _mm_xor_si128(ghash, ByteReverse(encrypt ? out0 : in0));
+                const __m128i x1 = ByteReverse(encrypt ? out1 : in1);
+                const __m128i x2 = ByteReverse(encrypt ? out2 : in2);
+                const __m128i x3 = ByteReverse(encrypt ? out3 : in3);
+
+                __m128i lo, hi, tmp_lo, tmp_hi;
+                CarrylessMultiply(std::addressof(lo), std::addressof(hi), x0, h4);
+                CarrylessMultiply(std::addressof(tmp_lo), std::addressof(tmp_hi), x1, h3);
+                lo = _mm_xor_si128(lo, tmp_lo);
+                hi = _mm_xor_si128(hi, tmp_hi);
+                CarrylessMultiply(std::addressof(tmp_lo), std::addressof(tmp_hi), x2, h2);
+                lo = _mm_xor_si128(lo, tmp_lo);
+                hi = _mm_xor_si128(hi, tmp_hi);
+                CarrylessMultiply(std::addressof(tmp_lo), std::addressof(tmp_hi), x3, h1);
+                lo = _mm_xor_si128(lo, tmp_lo);
+                hi = _mm_xor_si128(hi, tmp_hi);
+                ghash = Reduce(lo, hi);
+
+                src        += GcmBlockSize * 4;
+                dst        += GcmBlockSize * 4;
+                num_blocks -= 4;
+            }
+
+            /* Process remaining blocks one at a time. */
+            while (num_blocks > 0) {
+                counter = IncrementCounter(counter);
+
+                const __m128i in  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+                const __m128i out = _mm_xor_si128(in, EncryptBlockAesNi(counter, round_keys));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), out);
+
+                ghash = GaloisFieldMultPclmul(_mm_xor_si128(ghash, ByteReverse(encrypt ? out : in)), h1);
+
+                src += GcmBlockSize;
+                dst += GcmBlockSize;
+                --num_blocks;
+            }
+
+            /* Store the updated counter and ghash state. */
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(counter_u8), counter);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(ghash_u8), ByteReverse(ghash));
+        }
+
+        void HashBlocksPclmul(u8 *ghash_u8, const u8 *src, size_t num_blocks, const void *hash_keys) {
+            /* Load the hash key powers (H^1...H^4), which are stored byte-reversed. */
+            const __m128i *h = static_cast<const __m128i *>(hash_keys);
+            const __m128i h1 = _mm_loadu_si128(h + 0);
+            const __m128i h2 = _mm_loadu_si128(h + 1);
+            const __m128i h3 = _mm_loadu_si128(h + 2);
+            const __m128i h4 = _mm_loadu_si128(h + 3);
+
+            /* Load the ghash state. */
+            __m128i ghash = ByteReverse(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ghash_u8)));
+
+            /* Process four blocks at a time, aggregating the reduction. */
+            while (num_blocks >= 4) {
+                const __m128i x0 = _mm_xor_si128(ghash, ByteReverse(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + GcmBlockSize * 0))));
+                const __m128i x1 = ByteReverse(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + GcmBlockSize * 1)));
+                const __m128i x2 = ByteReverse(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + GcmBlockSize * 2)));
+                const __m128i x3 = ByteReverse(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + GcmBlockSize * 3)));
+
+                __m128i lo, hi, tmp_lo, tmp_hi;
+                CarrylessMultiply(std::addressof(lo), std::addressof(hi), x0, h4);
+                CarrylessMultiply(std::addressof(tmp_lo), std::addressof(tmp_hi), x1, h3);
+                lo = _mm_xor_si128(lo, tmp_lo);
+                hi = _mm_xor_si128(hi, tmp_hi);
+                CarrylessMultiply(std::addressof(tmp_lo), std::addressof(tmp_hi), x2, h2);
+                lo = _mm_xor_si128(lo, tmp_lo);
+                hi = _mm_xor_si128(hi, tmp_hi);
+                CarrylessMultiply(std::addressof(tmp_lo), std::addressof(tmp_hi), x3, h1);
+                lo = _mm_xor_si128(lo, tmp_lo);
+                hi = _mm_xor_si128(hi, tmp_hi);
+                ghash = Reduce(lo, hi);
+
+                src        += GcmBlockSize * 4;
+                num_blocks -= 4;
+            }
+
+            /* Process remaining blocks one at a time. */
+            while (num_blocks > 0) {
+                ghash = GaloisFieldMultPclmul(_mm_xor_si128(ghash, ByteReverse(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src)))), h1);
+
+                src += GcmBlockSize;
+                --num_blocks;
+            }
+
+            /* Store the updated ghash state. */
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(ghash_u8), ByteReverse(ghash));
+        }
+
+    }
+
+    template<class BlockCipher>
+    void GcmModeImpl<BlockCipher>::Initialize(const BlockCipher *block_cipher) {
+        /* Set member variables. */
+        m_block_cipher = block_cipher;
+        m_cipher_func  = std::addressof(GcmModeImpl<BlockCipher>::ProcessBlock);
+
+        /* Pre-calculate values to speed up galois field multiplications later. */
+        this->InitializeHashKey();
+
+        /* Note that we're initialized. */
+        m_state = State_Initialized;
+    }
+
+    template<class BlockCipher>
+    void GcmModeImpl<BlockCipher>::Reset(const void *iv, size_t iv_size) {
+        /* Validate pre-conditions. */
+        AMS_ASSERT(m_state >= State_Initialized);
+
+        /* Reset blocks. */
+        m_block_x.block_128.Clear();
+        m_block_tmp.block_128.Clear();
+
+        /* Clear sizes. */
+        m_aad_size      = 0;
+        m_msg_size      = 0;
+        m_aad_remaining = 0;
+        m_msg_remaining = 0;
+
+        /* Update our state. */
+        m_state = State_ProcessingAad;
+
+        /* Set our iv. */
+        if (iv_size == 12) {
+            /* If our iv is the correct size, simply copy in the iv, and set the magic bit. */
+            std::memcpy(std::addressof(m_block_ek0), iv, iv_size);
+            util::StoreBigEndian(m_block_ek0.block_32 + 3, static_cast<u32>(1));
+        } else {
+            /* Clear our ek0 block. */
+            m_block_ek0.block_128.Clear();
+
+            /* Update using the iv as aad. */
+            this->UpdateAad(iv, iv_size);
+
+            /* Treat the iv as fake msg for the mac that will become our iv. */
+            m_msg_size = m_aad_size;
+            m_aad_size = 0;
+
+            /* Compute a non-final mac. */
+            this->ComputeMac(false);
+
+            /* Set our ek0 block to our calculated mac block. */
+            m_block_ek0 = m_block_x;
+
+            /* Clear our calculated mac block. */
+            m_block_x.block_128.Clear();
+
+            /* Reset our state. */
+            m_msg_size      = 0;
+            m_aad_size      = 0;
+            m_msg_remaining = 0;
+            m_aad_remaining = 0;
+        }
+
+        /* Set the working block to the iv. */
+        m_block_ek = m_block_ek0;
+    }
+
+    template<class BlockCipher>
+    void GcmModeImpl<BlockCipher>::UpdateAad(const void *aad, size_t aad_size) {
+        /* Validate pre-conditions. */
+        AMS_ASSERT(m_state    == State_ProcessingAad);
+        AMS_ASSERT(m_msg_size == 0);
+
+        /* Update our aad size. */
+        m_aad_size += aad_size;
+
+        /* Define a working tracker variable. */
+        const u8 *cur_aad = static_cast<const u8 *>(aad);
+
+        /* Process any leftover aad data from a previous invocation. */
+        while (m_aad_remaining > 0 && aad_size > 0) {
+            /* Copy in a byte of the aad to our partial block. */
+            m_block_x.block_8[m_aad_remaining] ^= *(cur_aad++);
+
+            /* Note that we consumed a byte. */
+            --aad_size;
+
+            /* Increment our partial block size. */
+            m_aad_remaining = (m_aad_remaining + 1) % BlockSize;
+
+            /* If we have a complete block, process it. */
+            if (m_aad_remaining == 0) {
+                GaloisFieldMult(std::addressof(m_block_x), std::addressof(m_block_x), std::addressof(m_h_mult_blocks[0]));
+            }
+        }
+
+        /* Process as many blocks as we can. */
+        if (const size_t num_blocks = aad_size / BlockSize; num_blocks > 0) {
+            if (IsAcceleratedGcmAvailable()) {
+                HashBlocksPclmul(m_block_x.block_8, cur_aad, num_blocks, std::addressof(m_h_mult_blocks[PclmulHashKeyIndex]));
+            } else {
+                for (size_t i = 0; i < num_blocks; ++i) {
+                    /* Xor the current aad into our work block. */
+                    for (size_t j = 0; j < BlockSize; ++j) {
+                        m_block_x.block_8[j] ^= cur_aad[BlockSize * i + j];
+                    }
+
+                    /* Multiply the blocks in our galois field. */
+                    GaloisFieldMult(std::addressof(m_block_x), std::addressof(m_block_x), std::addressof(m_h_mult_blocks[0]));
+                }
+            }
+
+            cur_aad  += num_blocks * BlockSize;
+            aad_size -= num_blocks * BlockSize;
+        }
+
+        /* Update our state with whatever aad is left over. */
+        if (aad_size > 0) {
+            /* Note how much left over data we have. */
+            m_aad_remaining = static_cast<u32>(aad_size);
+
+            /* Xor the data in. */
+            for (size_t i = 0; i < aad_size; ++i) {
+                m_block_x.block_8[i] ^= *(cur_aad++);
+            }
+        }
+    }
+
+    template<class BlockCipher>
+    size_t GcmModeImpl<BlockCipher>::UpdateEncrypt(void *dst, size_t dst_size, const void *src, size_t src_size) {
+        /* Validate pre-conditions. */
+        AMS_ASSERT(m_state == State_ProcessingAad || m_state == State_Encrypting);
+        AMS_ASSERT(dst_size >= src_size);
+        AMS_UNUSED(dst_size);
+
+        return this->UpdateMessage(dst, src, src_size, true);
+    }
+
+    template<class BlockCipher>
+    size_t GcmModeImpl<BlockCipher>::UpdateDecrypt(void *dst, size_t dst_size, const void *src, size_t src_size) {
+        /* Validate pre-conditions. */
+        AMS_ASSERT(m_state == State_ProcessingAad || m_state == State_Decrypting);
+        AMS_ASSERT(dst_size >= src_size);
+        AMS_UNUSED(dst_size);
+
+        return this->UpdateMessage(dst, src, src_size, false);
+    }
+
+    template<class BlockCipher>
+    size_t GcmModeImpl<BlockCipher>::UpdateMessage(void *dst, const void *src, size_t src_size, bool encrypt) {
+        /* If we're transitioning from aad, finish any partial aad block. */
+        if (m_state == State_ProcessingAad) {
+            if (m_aad_remaining > 0) {
+                GaloisFieldMult(std::addressof(m_block_x), std::addressof(m_block_x), std::addressof(m_h_mult_blocks[0]));
+                m_aad_remaining = 0;
+            }
+
+            m_state = encrypt ? State_Encrypting : State_Decrypting;
+        }
+
+        /* Update our message size. */
+        m_msg_size += src_size;
+
+        /* Define working tracker variables. */
+        const u8 *cur_src = static_cast<const u8 *>(src);
+              u8 *cur_dst = static_cast<u8 *>(dst);
+        size_t remaining  = src_size;
+
+        /* Process any leftover keystream from a previous invocation. */
+        while (m_msg_remaining > 0 && remaining > 0) {
+            const u8 in  = *(cur_src++);
+            const u8 out = in ^ m_block_tmp.block_8[m_msg_remaining];
+            *(cur_dst++) = out;
+            --remaining;
+
+            /* Hash the ciphertext byte. */
+            m_block_x.block_8[m_msg_remaining] ^= encrypt ? out : in;
+
+            /* If we have a complete block, process it. */
+            m_msg_remaining = (m_msg_remaining + 1) % BlockSize;
+            if (m_msg_remaining == 0) {
+                GaloisFieldMult(std::addressof(m_block_x), std::addressof(m_block_x), std::addressof(m_h_mult_blocks[0]));
+            }
+        }
+
+        /* Process as many blocks as we can. */
+        if (const size_t num_blocks = remaining / BlockSize; num_blocks > 0) {
+            if (IsAcceleratedGcmAvailable()) {
+                EncryptBlocksPclmul(cur_dst, cur_src, num_blocks, encrypt, m_block_ek.block_8, m_block_x.block_8, std::addressof(m_h_mult_blocks[PclmulHashKeyIndex]), m_block_cipher);
+            } else {
+                for (size_t i = 0; i < num_blocks; ++i) {
+                    /* Increment the counter, and generate the keystream. */
+                    util::StoreBigEndian(m_block_ek.block_32 + 3, util::LoadBigEndian(m_block_ek.block_32 + 3) + 1);
+                    m_cipher_func(std::addressof(m_block_tmp), std::addressof(m_block_ek), m_block_cipher);
+
+                    /* Crypt the block, and hash the ciphertext. */
+                    for (size_t j = 0; j < BlockSize; ++j) {
+                        const u8 in  = cur_src[BlockSize * i + j];
+                        const u8 out = in ^ m_block_tmp.block_8[j];
+                        cur_dst[BlockSize * i + j] = out;
+                        m_block_x.block_8[j] ^= encrypt ? out : in;
+                    }
+
+                    GaloisFieldMult(std::addressof(m_block_x), std::addressof(m_block_x), std::addressof(m_h_mult_blocks[0]));
+                }
+            }
+
+            cur_src   += num_blocks * BlockSize;
+            cur_dst   += num_blocks * BlockSize;
+            remaining -= num_blocks * BlockSize;
+        }
+
+        /* Process any leftover data as a partial block. */
+        if (remaining > 0) {
+            /* Increment the counter, and generate the keystream. */
+            util::StoreBigEndian(m_block_ek.block_32 + 3, util::LoadBigEndian(m_block_ek.block_32 + 3) + 1);
+            m_cipher_func(std::addressof(m_block_tmp), std::addressof(m_block_ek), m_block_cipher);
+
+            /* Crypt the data, and hash the ciphertext. */
+            for (size_t i = 0; i < remaining; ++i) {
+                const u8 in  = cur_src[i];
+                const u8 out = in ^ m_block_tmp.block_8[i];
+                cur_dst[i] = out;
+                m_block_x.block_8[i] ^= encrypt ? out : in;
+            }
+
+            /* Note how much of the keystream block we've used. */
+            m_msg_remaining = static_cast<u32>(remaining);
+        }
+
+        return src_size;
+    }
+
+    template<class BlockCipher>
+    void GcmModeImpl<BlockCipher>::GetMac(void *dst, size_t dst_size) {
+        /* Validate pre-conditions. */
+        AMS_ASSERT(State_ProcessingAad <= m_state && m_state <= State_Done);
+        AMS_ASSERT(dst != nullptr);
+        AMS_ASSERT(dst_size >= MacSize);
+        AMS_UNUSED(dst_size);
+
+        /* If we haven't already done so, compute the final mac. */
+        if (m_state != State_Done) {
+            this->ComputeMac(true);
+            m_state = State_Done;
+        }
+
+        static_assert(sizeof(m_block_x) == MacSize);
+        std::memcpy(dst, std::addressof(m_block_x), MacSize);
+    }
+
+    template<class BlockCipher>
+    void GcmModeImpl<BlockCipher>::InitializeHashKey() {
+        /* We want to encrypt an empty block to use for intermediate calculations. */
+        constexpr const Block EmptyBlock = {};
+
+        this->ProcessBlock(std::addressof(m_h_mult_blocks[0]), std::addressof(EmptyBlock), m_block_cipher);
+
+        /* If we can use pclmul, pre-calculate the powers of H used for aggregated reduction. */
+        static_assert(PclmulHashKeyIndex + PclmulHashKeyPowers <= sizeof(m_h_mult_blocks) / sizeof(m_h_mult_blocks[0]));
+        if (IsAcceleratedGcmAvailable()) {
+            const __m128i h = ByteReverse(_mm_loadu_si128(reinterpret_cast<const __m128i *>(std::addressof(m_h_mult_blocks[0]))));
+
+            __m128i cur = h;
+            for (size_t i = 0; i < PclmulHashKeyPowers; ++i) {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(std::addressof(m_h_mult_blocks[PclmulHashKeyIndex + i])), cur);
+                cur = GaloisFieldMultPclmul(cur, h);
+            }
+        }
+    }
+
+    template<class BlockCipher>
+    void GcmModeImpl<BlockCipher>::ComputeMac(bool encrypt) {
+        /* If we have leftover data, process it. */
+        if (m_aad_remaining > 0 || m_msg_remaining > 0) {
+            GaloisFieldMult(std::addressof(m_block_x), std::addressof(m_block_x), std::addressof(m_h_mult_blocks[0]));
+        }
+
+        /* Setup the last block. */
+        Block last_block = Block{ .block_128 = { m_msg_size, m_aad_size } };
+
+        /* Multiply the last block by 8 to account for bit vs byte sizes. */
+        static_assert(AMS_OFFSETOF(Block128, hi) == 0);
+        GaloisShiftLeft(std::addressof(last_block.block_128.hi));
+        GaloisShiftLeft(std::addressof(last_block.block_128.hi));
+        GaloisShiftLeft(std::addressof(last_block.block_128.hi));
+
+        /* Xor the data in. */
+        for (size_t i = 0; i < BlockSize; ++i) {
+            m_block_x.block_8[BlockSize - 1 - i] ^= last_block.block_8[i];
+        }
+
+        /* Perform the final multiplication. */
+        GaloisFieldMult(std::addressof(m_block_x), std::addressof(m_block_x), std::addressof(m_h_mult_blocks[0]));
+
+        /* If we need to do an encryption, do so. */
+        if (encrypt) {
+            /* Encrypt the iv. */
+            u8 enc_result[BlockSize];
+            this->ProcessBlock(enc_result, std::addressof(m_block_ek0), m_block_cipher);
+
+            /* Xor the iv in. */
+            for (size_t i = 0; i < BlockSize; ++i) {
+                m_block_x.block_8[i] ^= enc_result[i];
+            }
+        }
+    }
+
+    /* Explicitly instantiate the valid template classes. */
+    template class GcmModeImpl<AesEncryptor128>;
+
+    void SetAcceleratedGcmEnabledForTest(bool enabled) {
+        g_is_accelerated_gcm_enabled = enabled;
+    }
+
+}
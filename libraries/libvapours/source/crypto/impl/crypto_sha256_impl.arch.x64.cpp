@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <vapours.hpp>
+#include "crypto_sha256_impl.arch.x64.hpp"
+
+namespace ams::crypto::impl {
+
+    namespace {
+
+        alignas(Sha256Impl::BlockSize) constexpr const u32 RoundConstants[0x40] = {
+            0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5,
+            0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+            0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+            0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+            0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC,
+            0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+            0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7,
+            0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+            0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+            0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+            0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3,
+            0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+            0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5,
+            0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+            0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+            0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+        };
+
+        constexpr ALWAYS_INLINE u32 Choose(u32 x, u32 y, u32 z) {
+            return (x & y) ^ ((~x) & z);
+        }
+
+        constexpr ALWAYS_INLINE u32 Majority(u32 x, u32 y, u32 z) {
+            return (x & y) ^ (x & z) ^ (y & z);
+        }
+
+        constexpr ALWAYS_INLINE u32 LargeSigma0(u32 x) {
+            return util::RotateRight<u32>(x, 2) ^ util::RotateRight<u32>(x, 13) ^ util::RotateRight<u32>(x, 22);
+        }
+
+        constexpr ALWAYS_INLINE u32 LargeSigma1(u32 x) {
+            return util::RotateRight<u32>(x, 6) ^ util::RotateRight<u32>(x, 11) ^ util::RotateRight<u32>(x, 25);
+        }
+
+        constexpr ALWAYS_INLINE u32 SmallSigma0(u32 x) {
+            return util::RotateRight<u32>(x, 7) ^ util::RotateRight<u32>(x, 18) ^ (x >> 3);
+        }
+
+        constexpr ALWAYS_INLINE u32 SmallSigma1(u32 x) {
+            return util::RotateRight<u32>(x, 17) ^ util::RotateRight<u32>(x, 19) ^ (x >> 10);
+        }
+
+        bool GetShaNiAvailabilityImpl() {
+            /* Call cpu id. */
+            int a = 0, b = 0, c = 0, d = 0;
+            __asm__ __volatile__("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "0"(1) : "memory");
+
+            /* Check for SSSE3 and SSE4.1. */
+            if (!((c & (1 << 9)) && (c & (1 << 19)))) {
+                return false;
+            }
+
+            /* Call cpu id for extended features. */
+            __asm__ __volatile__("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "0"(7), "2"(0) : "memory");
+
+            /* Check for SHA. */
+            return (b & (1 << 29));
+        }
+
+        bool GetAvx2AvailabilityImpl() {
+            /* Call cpu id. */
+            int a = 0, b = 0, c = 0, d = 0;
+            __asm__ __volatile__("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "0"(1) : "memory");
+
+            /* Check for OSXSAVE and AVX. */
+            if (!((c & (1 << 27)) && (c & (1 << 28)))) {
+                return false;
+            }
+
+            /* Check that the OS saves ymm state. */
+            u32 xcr0_lo = 0, xcr0_hi = 0;
+            __asm__ __volatile__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+            if ((xcr0_lo & 0x6) != 0x6) {
+                return false;
+            }
+
+            /* Call cpu id for extended features. */
+            __asm__ __volatile__("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "0"(7), "2"(0) : "memory");
+
+            /* Check for AVX2. */
+            return (b & (1 << 5));
+        }
+
+        void ProcessBlockGeneric(u32 *intermediate_hash, const void *data) {
+            /* Load work variables. */
+            u32 a = intermediate_hash[0];
+            u32 b = intermediate_hash[1];
+            u32 c = intermediate_hash[2];
+            u32 d = intermediate_hash[3];
+            u32 e = intermediate_hash[4];
+            u32 f = intermediate_hash[5];
+            u32 g = intermediate_hash[6];
+            u32 h = intermediate_hash[7];
+            u32 tmp[2];
+            size_t i;
+
+            /* Copy the input. */
+            constexpr size_t BlockSize = Sha256Impl::BlockSize;
+            u32 w[64];
+            static_assert(util::IsLittleEndian());
+            static_assert(BlockSize % sizeof(u32) == 0);
+            {
+                const u32 *src_32 = static_cast<const u32 *>(data);
+                for (size_t i = 0; i < BlockSize / sizeof(u32); ++i) {
+                    w[i] = util::LoadBigEndian<u32>(src_32 + i);
+                }
+            }
+
+            /* Initialize the rest of w. */
+            for (i = BlockSize / sizeof(u32); i < util::size(w); ++i) {
+                const u32 *prev = w + (i - BlockSize / sizeof(u32));
+                w[i] = prev[0] + SmallSigma0(prev[1]) + prev[9] + SmallSigma1(prev[14]);
+            }
+
+            /* Perform rounds. */
+            for (i = 0; i < 64; ++i) {
+                tmp[0] = h + LargeSigma1(e) + Choose(e, f, g) + RoundConstants[i] + w[i];
+                tmp[1] = LargeSigma0(a) + Majority(a, b, c);
+
+                h = g;
+                g = f;
+                f = e;
+                e = d + tmp[0];
+                d = c;
+                c = b;
+                b = a;
+                a = tmp[0] + tmp[1];
+            }
+
+            /* Update intermediate hash. */
+            intermediate_hash[0] += a;
+            intermediate_hash[1] += b;
+            intermediate_hash[2] += c;
+            intermediate_hash[3] += d;
+            intermediate_hash[4] += e;
+            intermediate_hash[5] += f;
+            intermediate_hash[6] += g;
+            intermediate_hash[7] += h;
+        }
+
+        __attribute__((target("sha,ssse3,sse4.1")))
+        void ProcessBlocksShaNi(u32 *intermediate_hash, const u8 *data, size_t block_count) {
+            /* Declare mask used to convert big endian message words. */
+            const __m128i ByteSwapMask = _mm_set_epi64x(0x0C0D0E0F08090A0Bull, 0x0405060700010203ull);
+
+            /* Load the intermediate hash, and rearrange it into the ABEF/CDGH order used by the sha instructions. */
+            __m128i state0 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(intermediate_hash + 0)), 0xB1); /* CDAB */
+            __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(intermediate_hash + 4)), 0x1B); /* EFGH */
+            {
+                const __m128i cdab = state0;
+                state0 = _mm_alignr_epi8(cdab, state1, 8);    /* ABEF */
+                state1 = _mm_blend_epi16(state1, cdab, 0xF0); /* CDGH */
+            }
+
+            while (block_count-- > 0) {
+                /* Save the current state. */
+                const __m128i abef = state0;
+                const __m128i cdgh = state1;
+
+                /* Load the message. */
+                __m128i msg[4] = {
+                    _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x00)), ByteSwapMask),
+                    _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x10)), ByteSwapMask),
+                    _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x20)), ByteSwapMask),
+                    _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x30)), ByteSwapMask),
+                };
+
+                /* Perform rounds, four at a time. */
+                for (size_t i = 0; i < util::size(RoundConstants) / 4; ++i) {
+                    /* Extend the message schedule, once we've consumed the input words. */
+                    if (i >= 4) {
+                        __m128i tmp = _mm_sha256msg1_epu32(msg[(i - 4) % 4], msg[(i - 3) % 4]);
+                        tmp = _mm_add_epi32(tmp, _mm_alignr_epi8(msg[(i - 1) % 4], msg[(i - 2) % 4], 4));
+                        msg[i % 4] = _mm_sha256msg2_epu32(tmp, msg[(i - 1) % 4]);
+                    }
+
+                    const __m128i wk = _mm_add_epi32(msg[i % 4], _mm_load_si128(reinterpret_cast<const __m128i *>(RoundConstants + 4 * i)));
+                    state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+                    state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(wk, 0x0E));
+                }
+
+                /* Update the state. */
+                state0 = _mm_add_epi32(state0, abef);
+                state1 = _mm_add_epi32(state1, cdgh);
+
+                data += Sha256Impl::BlockSize;
+            }
+
+            /* Rearrange the state back into ABCD/EFGH order, and store it. */
+            {
+                const __m128i feba = _mm_shuffle_epi32(state0, 0x1B);
+                const __m128i dchg = _mm_shuffle_epi32(state1, 0xB1);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(intermediate_hash + 0), _mm_blend_epi16(feba, dchg, 0xF0)); /* DCBA */
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(intermediate_hash + 4), _mm_alignr_epi8(dchg, feba, 8));    /* HGFE */
+            }
+        }
+
+    }
+
+    const bool g_is_sha_ni_available = GetShaNiAvailabilityImpl();
+    const bool g_is_avx2_available   = GetAvx2AvailabilityImpl();
+
+    constinit bool g_is_sha_ni_enabled = true;
+    constinit bool g_is_avx2_enabled   = true;
+
+    void SetSha256ExtensionsEnabledForTest(bool sha_ni, bool avx2) {
+        g_is_sha_ni_enabled = sha_ni;
+        g_is_avx2_enabled   = avx2;
+    }
+
+    void Sha256Impl::Initialize() {
+        /* Reset buffered bytes/bits. */
+        m_buffered_bytes = 0;
+        m_bits_consumed  = 0;
+
+        /* Set intermediate hash. */
+        m_intermediate_hash[0] = 0x6A09E667;
+        m_intermediate_hash[1] = 0xBB67AE85;
+        m_intermediate_hash[2] = 0x3C6EF372;
+        m_intermediate_hash[3] = 0xA54FF53A;
+        m_intermediate_hash[4] = 0x510E527F;
+        m_intermediate_hash[5] = 0x9B05688C;
+        m_intermediate_hash[6] = 0x1F83D9AB;
+        m_intermediate_hash[7] = 0x5BE0CD19;
+
+        /* Set state. */
+        m_state = State_Initialized;
+    }
+
+    void Sha256Impl::Update(const void *data, size_t size) {
+        /* Verify we're in a state to update. */
+        AMS_ASSERT(m_state == State_Initialized);
+
+        /* Advance our input bit count. */
+        m_bits_consumed += BITSIZEOF(u8) * (((m_buffered_bytes + size) / BlockSize) * BlockSize);
+
+        /* Process anything we have buffered. */
+        const u8 *data8 = static_cast<const u8 *>(data);
+        size_t remaining = size;
+
+        if (m_buffered_bytes > 0) {
+            const size_t copy_size = std::min(BlockSize - m_buffered_bytes, remaining);
+            std::memcpy(m_buffer + m_buffered_bytes, data8, copy_size);
+
+            data8            += copy_size;
+            remaining        -= copy_size;
+            m_buffered_bytes += copy_size;
+
+            /* Process a block, if we filled one. */
+            if (m_buffered_bytes == BlockSize) {
+                this->ProcessBlock(m_buffer);
+                m_buffered_bytes = 0;
+            }
+        }
+
+        /* Process blocks, if we have any. */
+        if (remaining >= BlockSize) {
+            const size_t blocks = remaining / BlockSize;
+
+            this->ProcessBlocks(data8, blocks);
+            data8     += BlockSize * blocks;
+            remaining -= BlockSize * blocks;
+        }
+
+        /* Copy any leftover data to our buffer. */
+        if (remaining > 0) {
+            m_buffered_bytes = remaining;
+            std::memcpy(m_buffer, data8, remaining);
+        }
+    }
+
+    void Sha256Impl::GetHash(void *dst, size_t size) {
+        /* Verify we're in a state to get hash. */
+        AMS_ASSERT(m_state == State_Initialized || m_state == State_Done);
+        AMS_ASSERT(size >= HashSize);
+        AMS_UNUSED(size);
+
+        /* If we need to, process the last block. */
+        if (m_state == State_Initialized) {
+            this->ProcessLastBlock();
+            m_state = State_Done;
+        }
+
+        /* Copy the output hash. */
+        if constexpr (util::IsLittleEndian()) {
+            static_assert(HashSize % sizeof(u32) == 0);
+
+            u32 *dst_32 = static_cast<u32 *>(dst);
+            for (size_t i = 0; i < HashSize / sizeof(u32); ++i) {
+                dst_32[i] = util::LoadBigEndian<u32>(m_intermediate_hash + i);
+            }
+        } else {
+            std::memcpy(dst, m_intermediate_hash, HashSize);
+        }
+    }
+
+    void Sha256Impl::InitializeWithContext(const Sha256Context *context) {
+        /* Copy state in from the context. */
+        std::memcpy(m_intermediate_hash, context->intermediate_hash, sizeof(m_intermediate_hash));
+        m_bits_consumed = context->bits_consumed;
+
+        /* Reset other fields. */
+        m_buffered_bytes = 0;
+        m_state = State_Initialized;
+    }
+
+    size_t Sha256Impl::GetContext(Sha256Context *context) const {
+        /* Check our state. */
+        AMS_ASSERT(m_state == State_Initialized);
+
+        /* Copy out the context. */
+        std::memcpy(context->intermediate_hash, m_intermediate_hash, sizeof(context->intermediate_hash));
+        context->bits_consumed = m_bits_consumed;
+
+        return m_buffered_bytes;
+    }
+
+    ALWAYS_INLINE void Sha256Impl::ProcessBlock(const void *data) {
+        return this->ProcessBlocks(static_cast<const u8 *>(data), 1);
+    }
+
+    void Sha256Impl::ProcessBlocks(const u8 *data, size_t block_count) {
+        /* If we have sha-ni, use an optimized impl. */
+        if (IsShaNiAvailable()) {
+            ProcessBlocksShaNi(m_intermediate_hash, data, block_count);
+        } else {
+            /* Fall back to the default implementation. */
+            while (block_count--) {
+                ProcessBlockGeneric(m_intermediate_hash, data);
+                data += BlockSize;
+            }
+        }
+    }
+
+    void Sha256Impl::ProcessLastBlock() {
+        /* Setup the final block. */
+        constexpr const auto BlockSizeWithoutSizeField = BlockSize - sizeof(u64);
+
+        /* Increment our bits consumed. */
+        m_bits_consumed += BITSIZEOF(u8) * m_buffered_bytes;
+
+        /* Add 0x80 terminator. */
+        m_buffer[m_buffered_bytes++] = 0x80;
+
+        /* If we can process the size field directly, do so, otherwise set up to process it. */
+        if (m_buffered_bytes <= BlockSizeWithoutSizeField) {
+            /* Clear up to size field. */
+            std::memset(m_buffer + m_buffered_bytes, 0, BlockSizeWithoutSizeField - m_buffered_bytes);
+        } else {
+            /* Consume full block */
+            std::memset(m_buffer + m_buffered_bytes, 0, BlockSize - m_buffered_bytes);
+            this->ProcessBlock(m_buffer);
+
+            /* Clear up to size field. */
+            std::memset(m_buffer, 0, BlockSizeWithoutSizeField);
+        }
+
+        /* Store the size field. */
+        util::StoreBigEndian<u64>(reinterpret_cast<u64 *>(m_buffer + BlockSizeWithoutSizeField), m_bits_consumed);
+
+        /* Process the final block. */
+        this->ProcessBlock(m_buffer);
+    }
+
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <vapours.hpp>
+#include <x86intrin.h>
+
+namespace ams::crypto::impl {
+
+    extern const bool g_is_sha_ni_available;
+    extern const bool g_is_avx2_available;
+
+    extern constinit bool g_is_sha_ni_enabled;
+    extern constinit bool g_is_avx2_enabled;
+
+    ALWAYS_INLINE bool IsShaNiAvailable() {
+        return g_is_sha_ni_available && g_is_sha_ni_enabled;
+    }
+
+    ALWAYS_INLINE bool IsAvx2Available() {
+        return g_is_avx2_available && g_is_avx2_enabled;
+    }
+
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <vapours.hpp>
+
+namespace ams::crypto::impl {
+
+    void GenerateSha256MultiBuffer(void *dst, size_t dst_size, const void *prefix, size_t prefix_size, const void *src, size_t block_size, size_t block_count) {
+        AMS_UNUSED(dst_size);
+
+        u8 *dst8 = static_cast<u8 *>(dst);
+        const u8 *src8 = static_cast<const u8 *>(src);
+
+        /* Hash each block in turn. */
+        for (size_t i = 0; i < block_count; ++i) {
+            Sha256Impl sha;
+            sha.Initialize();
+            if (prefix_size > 0) {
+                sha.Update(prefix, prefix_size);
+            }
+            sha.Update(src8, block_size);
+            sha.GetHash(dst8, Sha256Impl::HashSize);
+
+            src8 += block_size;
+            dst8 += Sha256Impl::HashSize;
+        }
+    }
+
+}
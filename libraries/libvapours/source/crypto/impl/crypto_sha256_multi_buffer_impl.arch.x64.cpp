@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <vapours.hpp>
+#include "crypto_sha256_impl.arch.x64.hpp"
+
+namespace ams::crypto::impl {
+
+    namespace {
+
+        constexpr size_t LaneCount = 8;
+
+        constexpr const u32 RoundConstants[0x40] = {
+            0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5,
+            0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+            0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+            0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+            0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC,
+            0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+            0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7,
+            0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+            0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+            0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+            0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3,
+            0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+            0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5,
+            0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+            0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+            0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+        };
+
+        constexpr const u32 InitialHash[Sha256Impl::HashSize / sizeof(u32)] = {
+            0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+        };
+
+        void CopyPaddedMessageBlock(u8 *dst, size_t block_index, const u8 *prefix, size_t prefix_size, const u8 *src, size_t src_size) {
+            /* Determine the layout of the message. */
+            const size_t message_size = prefix_size + src_size;
+            const size_t padded_size  = util::AlignUp(message_size + 1 + sizeof(u64), Sha256Impl::BlockSize);
+
+            /* Copy each byte range of the block from the appropriate part of the padded message. */
+            size_t cur = block_index * Sha256Impl::BlockSize;
+            const size_t end = cur + Sha256Impl::BlockSize;
+            while (cur < end) {
+                if (cur < prefix_size) {
+                    const size_t copy_size = std::min(end, prefix_size) - cur;
+                    std::memcpy(dst, prefix + cur, copy_size);
+                    dst += copy_size;
+                    cur += copy_size;
+                } else if (cur < message_size) {
+                    const size_t copy_size = std::min(end, message_size) - cur;
+                    std::memcpy(dst, src + (cur - prefix_size), copy_size);
+                    dst += copy_size;
+                    cur += copy_size;
+                } else if (cur < padded_size - sizeof(u64)) {
+                    *(dst++) = (cur == message_size) ? 0x80 : 0x00;
+                    ++cur;
+                } else {
+                    util::StoreBigEndian<u64>(reinterpret_cast<u64 *>(dst), static_cast<u64>(message_size) * BITSIZEOF(u8));
+                    dst += sizeof(u64);
+                    cur += sizeof(u64);
+                }
+            }
+        }
+
+        #define AMS_CRYPTO_SHA256_AVX2_TARGET __attribute__((target("avx2")))
+
+        AMS_CRYPTO_SHA256_AVX2_TARGET ALWAYS_INLINE __m256i RotateRight(__m256i x, int n) {
+            return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+        }
+
+        AMS_CRYPTO_SHA256_AVX2_TARGET ALWAYS_INLINE __m256i LargeSigma0(__m256i x) {
+            return _mm256_xor_si256(_mm256_xor_si256(RotateRight(x, 2), RotateRight(x, 13)), RotateRight(x, 22));
+        }
+
+        AMS_CRYPTO_SHA256_AVX2_TARGET ALWAYS_INLINE __m256i LargeSigma1(__m256i x) {
+            return _mm256_xor_si256(_mm256_xor_si256(RotateRight(x, 6), RotateRight(x, 11)), RotateRight(x, 25));
+        }
+
+        AMS_CRYPTO_SHA256_AVX2_TARGET ALWAYS_INLINE __m256i SmallSigma0(__m256i x) {
+            return _mm256_xor_si256(_mm256_xor_si256(RotateRight(x, 7), RotateRight(x, 18)), _mm256_srli_epi32(x, 3));
+        }
+
+        AMS_CRYPTO_SHA256_AVX2_TARGET ALWAYS_INLINE __m256i SmallSigma1(__m256i x) {
+            return _mm256_xor_si256(_mm256_xor_si256(RotateRight(x, 17), RotateRight(x, 19)), _mm256_srli_epi32(x, 10));
+        }
+
+        AMS_CRYPTO_SHA256_AVX2_TARGET ALWAYS_INLINE __m256i Choose(__m256i x, __m256i y, __m256i z) {
+            return _mm256_xor_si256(_mm256_and_si256(x, y), _mm256_andnot_si256(x, z));
+        }
+
+        AMS_CRYPTO_SHA256_AVX2_TARGET ALWAYS_INLINE __m256i Majority(__m256i x, __m256i y, __m256i z) {
+            return _mm256_xor_si256(_mm256_and_si256(x, _mm256_xor_si256(y, z)), _mm256_and_si256(y, z));
+        }
+
+        AMS_CRYPTO_SHA256_AVX2_TARGET void GenerateHashesAvx2(u8 *dst, const u8 *prefix, size_t prefix_size, const u8 *src, size_t block_size) {
+            /* Declare mask used to convert big endian message words. */
+            const __m256i ByteSwapMask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+            /* Declare index used to gather the same word from each lane's block. */
+            constexpr int LaneStride = Sha256Impl::BlockSize / sizeof(u32);
+            const __m256i GatherIndex = _mm256_setr_epi32(LaneStride * 0, LaneStride * 1, LaneStride * 2, LaneStride * 3, LaneStride * 4, LaneStride * 5, LaneStride * 6, LaneStride * 7);
+
+            /* Set up the interleaved state for each lane. */
+            __m256i state[util::size(InitialHash)];
+            for (size_t i = 0; i < util::size(state); ++i) {
+                state[i] = _mm256_set1_epi32(InitialHash[i]);
+            }
+
+            /* Process each message block. */
+            const size_t num_message_blocks = util::AlignUp(prefix_size + block_size + 1 + sizeof(u64), Sha256Impl::BlockSize) / Sha256Impl::BlockSize;
+            for (size_t block = 0; block < num_message_blocks; ++block) {
+                /* Gather the current block for every lane. */
+                alignas(0x20) u8 lane_blocks[LaneCount][Sha256Impl::BlockSize];
+                for (size_t lane = 0; lane < LaneCount; ++lane) {
+                    CopyPaddedMessageBlock(lane_blocks[lane], block, prefix, prefix_size, src + lane * block_size, block_size);
+                }
+
+                /* Load the message words, transposed so that each vector holds one word from every lane. */
+                __m256i w[16];
+                for (size_t i = 0; i < util::size(w); ++i) {
+                    w[i] = _mm256_shuffle_epi8(_mm256_i32gather_epi32(reinterpret_cast<const int *>(lane_blocks[0]) + i, GatherIndex, sizeof(u32)), ByteSwapMask);
+                }
+
+                /* Load work variables. */
+                __m256i a = state[0];
+                __m256i b = state[1];
+                __m256i c = state[2];
+                __m256i d = state[3];
+                __m256i e = state[4];
+                __m256i f = state[5];
+                __m256i g = state[6];
+                __m256i h = state[7];
+
+                /* Perform rounds, extending the message schedule in place. */
+                for (size_t i = 0; i < util::size(RoundConstants); ++i) {
+                    if (i >= util::size(w)) {
+                        w[i % 16] = _mm256_add_epi32(_mm256_add_epi32(w[i % 16], SmallSigma0(w[(i + 1) % 16])), _mm256_add_epi32(w[(i + 9) % 16], SmallSigma1(w[(i + 14) % 16])));
+                    }
+
+                    const __m256i tmp0 = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(h, LargeSigma1(e)), _mm256_add_epi32(Choose(e, f, g), _mm256_set1_epi32(RoundConstants[i]))), w[i % 16]);
+                    const __m256i tmp1 = _mm256_add_epi32(LargeSigma0(a), Majority(a, b, c));
+
+                    h = g;
+                    g = f;
+                    f = e;
+                    e = _mm256_add_epi32(d, tmp0);
+                    d = c;
+                    c = b;
+                    b = a;
+                    a = _mm256_add_epi32(tmp0, tmp1);
+                }
+
+                /* Update intermediate hash. */
+                state[0] = _mm256_add_epi32(state[0], a);
+                state[1] = _mm256_add_epi32(state[1], b);
+                state[2] = _mm256_add_epi32(state[2], c);
+                state[3] = _mm256_add_epi32(state[3], d);
+                state[4] = _mm256_add_epi32(state[4], e);
+                state[5] = _mm256_add_epi32(state[5], f);
+                state[6] = _mm256_add_epi32(state[6], g);
+                state[7] = _mm256_add_epi32(state[7], h);
+            }
+
+            /* Write out each lane's hash. */
+            alignas(0x20) u32 words[util::size(state)][LaneCount];
+            for (size_t i = 0; i < util::size(state); ++i) {
+                _mm256_store_si256(reinterpret_cast<__m256i *>(words[i]), state[i]);
+            }
+
+            for (size_t lane = 0; lane < LaneCount; ++lane) {
+                u32 *dst_32 = reinterpret_cast<u32 *>(dst + lane * Sha256Impl::HashSize);
+                for (size_t i = 0; i < util::size(state); ++i) {
+                    util::StoreBigEndian<u32>(dst_32 + i, words[i][lane]);
+                }
+            }
+        }
+
+        #undef AMS_CRYPTO_SHA256_AVX2_TARGET
+
+        void GenerateHashesGeneric(u8 *dst, const u8 *prefix, size_t prefix_size, const u8 *src, size_t block_size, size_t block_count) {
+            /* Hash each block in turn. */
+            for (size_t i = 0; i < block_count; ++i) {
+                Sha256Impl sha;
+                sha.Initialize();
+                if (prefix_size > 0) {
+                    sha.Update(prefix, prefix_size);
+                }
+                sha.Update(src, block_size);
+                sha.GetHash(dst, Sha256Impl::HashSize);
+
+                src += block_size;
+                dst += Sha256Impl::HashSize;
+            }
+        }
+
+    }
+
+    void GenerateSha256MultiBuffer(void *dst, size_t dst_size, const void *prefix, size_t prefix_size, const void *src, size_t block_size, size_t block_count) {
+        AMS_UNUSED(dst_size);
+
+        u8 *dst8 = static_cast<u8 *>(dst);
+        const u8 *src8 = static_cast<const u8 *>(src);
+        const u8 *prefix8 = static_cast<const u8 *>(prefix);
+
+        /* When sha-ni is available, hashing each block serially is faster than interleaving lanes with avx2. */
+        if (IsAvx2Available() && !IsShaNiAvailable()) {
+            while (block_count >= LaneCount) {
+                GenerateHashesAvx2(dst8, prefix8, prefix_size, src8, block_size);
+
+                src8        += block_size * LaneCount;
+                dst8        += Sha256Impl::HashSize * LaneCount;
+                block_count -= LaneCount;
+            }
+        }
+
+        /* Hash any remaining blocks. */
+        GenerateHashesGeneric(dst8, prefix8, prefix_size, src8, block_size, block_count);
+    }
+
+}
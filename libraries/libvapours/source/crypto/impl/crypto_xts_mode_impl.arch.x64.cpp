@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <vapours.hpp>
+#include "crypto_update_impl.hpp"
+#include "crypto_aes_impl.arch.x64.hpp"
+
+namespace ams::crypto::impl {
+
+    namespace {
+
+        constexpr size_t XtsBlockSize = XtsModeImpl::BlockSize;
+
+        ALWAYS_INLINE __m128i MultiplyTweak(const __m128i tweak) {
+            /* The tweak is a little-endian 128-bit value; multiply by x in GF(2^128). */
+            /* Each qword is shifted left by one, the carry out of the low qword moves into the high qword, */
+            /* and the carry out of the high qword is reduced into the low qword via the 0x87 polynomial. */
+            const __m128i Polynomial = _mm_set_epi32(0, 1, 0, 0x87);
+
+            const __m128i carry = _mm_and_si128(_mm_shuffle_epi32(_mm_srai_epi32(tweak, 31), _MM_SHUFFLE(0, 1, 0, 3)), Polynomial);
+            return _mm_xor_si128(_mm_add_epi64(tweak, tweak), carry);
+        }
+
+        template<bool IsEncrypt>
+        ALWAYS_INLINE void AesRound(__m128i &b0, __m128i &b1, __m128i &b2, __m128i &b3, __m128i &b4, __m128i &b5, __m128i &b6, __m128i &b7, const __m128i key) {
+            if constexpr (IsEncrypt) {
+                b0 = _mm_aesenc_si128(b0, key);
+                b1 = _mm_aesenc_si128(b1, key);
+                b2 = _mm_aesenc_si128(b2, key);
+                b3 = _mm_aesenc_si128(b3, key);
+                b4 = _mm_aesenc_si128(b4, key);
+                b5 = _mm_aesenc_si128(b5, key);
+                b6 = _mm_aesenc_si128(b6, key);
+                b7 = _mm_aesenc_si128(b7, key);
+            } else {
+                b0 = _mm_aesdec_si128(b0, key);
+                b1 = _mm_aesdec_si128(b1, key);
+                b2 = _mm_aesdec_si128(b2, key);
+                b3 = _mm_aesdec_si128(b3, key);
+                b4 = _mm_aesdec_si128(b4, key);
+                b5 = _mm_aesdec_si128(b5, key);
+                b6 = _mm_aesdec_si128(b6, key);
+                b7 = _mm_aesdec_si128(b7, key);
+            }
+        }
+
+        template<bool IsEncrypt>
+        ALWAYS_INLINE void AesLastRound(__m128i &b0, __m128i &b1, __m128i &b2, __m128i &b3, __m128i &b4, __m128i &b5, __m128i &b6, __m128i &b7, const __m128i key) {
+            if constexpr (IsEncrypt) {
+                b0 = _mm_aesenclast_si128(b0, key);
+                b1 = _mm_aesenclast_si128(b1, key);
+                b2 = _mm_aesenclast_si128(b2, key);
+                b3 = _mm_aesenclast_si128(b3, key);
+                b4 = _mm_aesenclast_si128(b4, key);
+                b5 = _mm_aesenclast_si128(b5, key);
+                b6 = _mm_aesenclast_si128(b6, key);
+                b7 = _mm_aesenclast_si128(b7, key);
+            } else {
+                b0 = _mm_aesdeclast_si128(b0, key);
+                b1 = _mm_aesdeclast_si128(b1, key);
+                b2 = _mm_aesdeclast_si128(b2, key);
+                b3 = _mm_aesdeclast_si128(b3, key);
+                b4 = _mm_aesdeclast_si128(b4, key);
+                b5 = _mm_aesdeclast_si128(b5, key);
+                b6 = _mm_aesdeclast_si128(b6, key);
+                b7 = _mm_aesdeclast_si128(b7, key);
+            }
+        }
+
+        template<bool IsEncrypt, size_t RoundKeyCount>
+        ALWAYS_INLINE __m128i AesBlock(__m128i block, const __m128i (&round_keys)[RoundKeyCount]) {
+            block = _mm_xor_si128(block, round_keys[0]);
+            for (size_t i = 1; i < RoundKeyCount - 1; ++i) {
+                if constexpr (IsEncrypt) {
+                    block = _mm_aesenc_si128(block, round_keys[i]);
+                } else {
+                    block = _mm_aesdec_si128(block, round_keys[i]);
+                }
+            }
+            if constexpr (IsEncrypt) {
+                return _mm_aesenclast_si128(block, round_keys[RoundKeyCount - 1]);
+            } else {
+                return _mm_aesdeclast_si128(block, round_keys[RoundKeyCount - 1]);
+            }
+        }
+
+        template<typename BlockCipher, bool IsEncrypt>
+        void ProcessBlocksAesNi(u8 *dst, const u8 *src, size_t num_blocks, u8 *tweak_u8, const BlockCipher *cipher) {
+            constexpr size_t RoundKeyCount = BlockCipher::RoundKeySize / XtsBlockSize;
+            static_assert(RoundKeyCount == 11 || RoundKeyCount == 13 || RoundKeyCount == 15);
+
+            /* Load all keys into sse2 registers, in the order in which they will be used. */
+            /* NOTE: Decryption keys have already had inverse mix columns applied by the key schedule. */
+            const u8 *raw_round_keys = cipher->GetRoundKey();
+            __m128i round_keys[RoundKeyCount];
+            for (size_t i = 0; i < RoundKeyCount; ++i) {
+                const size_t key_index = IsEncrypt ? i : (RoundKeyCount - 1 - i);
+                round_keys[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(raw_round_keys + XtsBlockSize * key_index));
+            }
+
+            /* Load the tweak. */
+            __m128i tweak = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tweak_u8));
+
+            /* Process eight blocks at a time, while we can. */
+            constexpr const auto UnrolledBlockCount = 8;
+            while (num_blocks >= UnrolledBlockCount) {
+                /* Generate the tweaks for each block. */
+                const __m128i t0 = tweak;
+                const __m128i t1 = MultiplyTweak(t0);
+                const __m128i t2 = MultiplyTweak(t1);
+                const __m128i t3 = MultiplyTweak(t2);
+                const __m128i t4 = MultiplyTweak(t3);
+                const __m128i t5 = MultiplyTweak(t4);
+                const __m128i t6 = MultiplyTweak(t5);
+                const __m128i t7 = MultiplyTweak(t6);
+                tweak = MultiplyTweak(t7);
+
+                /* Read blocks in, xor with tweaks and the first round key. */
+                __m128i key = round_keys[0];
+                __m128i b0 = _mm_xor_si128(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + XtsBlockSize * 0)), t0), key);
+                __m128i b1 = _mm_xor_si128(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + XtsBlockSize * 1)), t1), key);
+                __m128i b2 = _mm_xor_si128(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + XtsBlockSize * 2)), t2), key);
+                __m128i b3 = _mm_xor_si128(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + XtsBlockSize * 3)), t3), key);
+                __m128i b4 = _mm_xor_si128(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + XtsBlockSize * 4)), t4), key);
+                __m128i b5 = _mm_xor_si128(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + XtsBlockSize * 5)), t5), key);
+                __m128i b6 = _mm_xor_si128(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + XtsBlockSize * 6)), t6), key);
+                __m128i b7 = _mm_xor_si128(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + XtsBlockSize * 7)), t7), key);
+
+                /* Do all middle rounds. */
+                for (size_t i = 1; i < RoundKeyCount - 1; ++i) {
+                    AesRound<IsEncrypt>(b0, b1, b2, b3, b4, b5, b6, b7, round_keys[i]);
+                }
+
+                /* Do the final round. */
+                AesLastRound<IsEncrypt>(b0, b1, b2, b3, b4, b5, b6, b7, round_keys[RoundKeyCount - 1]);
+
+                /* Xor with tweaks and write the blocks. */
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + XtsBlockSize * 0), _mm_xor_si128(b0, t0));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + XtsBlockSize * 1), _mm_xor_si128(b1, t1));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + XtsBlockSize * 2), _mm_xor_si128(b2, t2));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + XtsBlockSize * 3), _mm_xor_si128(b3, t3));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + XtsBlockSize * 4), _mm_xor_si128(b4, t4));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + XtsBlockSize * 5), _mm_xor_si128(b5, t5));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + XtsBlockSize * 6), _mm_xor_si128(b6, t6));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + XtsBlockSize * 7), _mm_xor_si128(b7, t7));
+
+                src        += XtsBlockSize * UnrolledBlockCount;
+                dst        += XtsBlockSize * UnrolledBlockCount;
+                num_blocks -= UnrolledBlockCount;
+            }
+
+            /* Process blocks one at a time. */
+            while (num_blocks > 0) {
+                const __m128i block = AesBlock<IsEncrypt>(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src)), tweak), round_keys);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_xor_si128(block, tweak));
+
+                tweak = MultiplyTweak(tweak);
+
+                src += XtsBlockSize;
+                dst += XtsBlockSize;
+                --num_blocks;
+            }
+
+            /* Store the updated tweak. */
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(tweak_u8), tweak);
+        }
+
+    }
+
+    size_t XtsModeImpl::UpdateGeneric(void *dst, size_t dst_size, const void *src, size_t src_size) {
+        AMS_ASSERT(m_state == State_Initialized || m_state == State_Processing);
+
+        return UpdateImpl<void>(this, dst, dst_size, src, src_size);
+    }
+
+    size_t XtsModeImpl::ProcessBlocksGeneric(u8 *dst, const u8 *src, size_t num_blocks) {
+        size_t processed = BlockSize * (num_blocks - 1);
+
+        if (m_state == State_Processing) {
+            this->ProcessBlock(dst, m_last_block);
+            dst       += BlockSize;
+            processed += BlockSize;
+        }
+
+        while ((--num_blocks) > 0) {
+            this->ProcessBlock(dst, src);
+            dst += BlockSize;
+            src += BlockSize;
+        }
+
+        std::memcpy(m_last_block, src, BlockSize);
+
+        m_state = State_Processing;
+
+        return processed;
+    }
+
+    #define AMS_CRYPTO_DEFINE_XTS_X64_PROCESS_BLOCKS(_BLOCK_CIPHER_, _IS_ENCRYPT_)                                                                  \
+    template<>                                                                                                                                      \
+    size_t XtsModeImpl::ProcessBlocks<_BLOCK_CIPHER_>(u8 *dst, const u8 *src, size_t num_blocks) {                                                  \
+        /* If we don't have aes-ni, fall back to the default implementation. */                                                                     \
+        if (!IsAesNiAvailable()) {                                                                                                                  \
+            return this->ProcessBlocksGeneric(dst, src, num_blocks);                                                                                \
+        }                                                                                                                                           \
+                                                                                                                                                    \
+        /* Handle last buffered block. */                                                                                                           \
+        size_t processed = (num_blocks - 1) * BlockSize;                                                                                            \
+                                                                                                                                                    \
+        if (m_state == State_Processing) {                                                                                                          \
+            this->ProcessBlock(dst, m_last_block);                                                                                                  \
+            dst       += BlockSize;                                                                                                                 \
+            processed += BlockSize;                                                                                                                 \
+        }                                                                                                                                           \
+                                                                                                                                                    \
+        /* Process all but the final block, which is retained for ciphertext stealing. */                                                          \
+        ProcessBlocksAesNi<_BLOCK_CIPHER_, _IS_ENCRYPT_>(dst, src, num_blocks - 1, m_tweak, static_cast<const _BLOCK_CIPHER_ *>(m_cipher_ctx));     \
+        src += (num_blocks - 1) * BlockSize;                                                                                                        \
+                                                                                                                                                    \
+        std::memcpy(m_last_block, src, BlockSize);                                                                                                  \
+        m_state = State_Processing;                                                                                                                 \
+                                                                                                                                                    \
+        return processed;                                                                                                                           \
+    }
+
+    AMS_CRYPTO_DEFINE_XTS_X64_PROCESS_BLOCKS(AesEncryptor128, true)
+    AMS_CRYPTO_DEFINE_XTS_X64_PROCESS_BLOCKS(AesEncryptor192, true)
+    AMS_CRYPTO_DEFINE_XTS_X64_PROCESS_BLOCKS(AesEncryptor256, true)
+
+    AMS_CRYPTO_DEFINE_XTS_X64_PROCESS_BLOCKS(AesDecryptor128, false)
+    AMS_CRYPTO_DEFINE_XTS_X64_PROCESS_BLOCKS(AesDecryptor192, false)
+    AMS_CRYPTO_DEFINE_XTS_X64_PROCESS_BLOCKS(AesDecryptor256, false)
+
+    #undef AMS_CRYPTO_DEFINE_XTS_X64_PROCESS_BLOCKS
+
+    template<> size_t XtsModeImpl::Update<AesEncryptor128>(void *dst, size_t dst_size, const void *src, size_t src_size) { return UpdateImpl<AesEncryptor128>(this, dst, dst_size, src, src_size); }
+    template<> size_t XtsModeImpl::Update<AesEncryptor192>(void *dst, size_t dst_size, const void *src, size_t src_size) { return UpdateImpl<AesEncryptor192>(this, dst, dst_size, src, src_size); }
+    template<> size_t XtsModeImpl::Update<AesEncryptor256>(void *dst, size_t dst_size, const void *src, size_t src_size) { return UpdateImpl<AesEncryptor256>(this, dst, dst_size, src, src_size); }
+
+    template<> size_t XtsModeImpl::Update<AesDecryptor128>(void *dst, size_t dst_size, const void *src, size_t src_size) { return UpdateImpl<AesDecryptor128>(this, dst, dst_size, src, src_size); }
+    template<> size_t XtsModeImpl::Update<AesDecryptor192>(void *dst, size_t dst_size, const void *src, size_t src_size) { return UpdateImpl<AesDecryptor192>(this, dst, dst_size, src, src_size); }
+    template<> size_t XtsModeImpl::Update<AesDecryptor256>(void *dst, size_t dst_size, const void *src, size_t src_size) { return UpdateImpl<AesDecryptor256>(this, dst, dst_size, src, src_size); }
+
+}
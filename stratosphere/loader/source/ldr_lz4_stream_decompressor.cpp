@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+#include "ldr_lz4_stream_decompressor.hpp"
+
+namespace ams::ldr {
+
+    namespace {
+
+        enum class ReadState {
+            Success,
+            NeedMoreData,
+        };
+
+        ALWAYS_INLINE ReadState ReadExtendedSize(size_t *out, const u8 *src, size_t *cur, size_t available_size) {
+            u8 value;
+            do {
+                if (*cur >= available_size) {
+                    return ReadState::NeedMoreData;
+                }
+
+                value = src[(*cur)++];
+                *out += value;
+            } while (value == 0xFF);
+
+            return ReadState::Success;
+        }
+
+    }
+
+    bool Lz4StreamDecompressor::OverlapsUnconsumedSource(size_t write_size, size_t src_offset) const {
+        const uintptr_t write_start = reinterpret_cast<uintptr_t>(m_dst + m_dst_offset);
+        const uintptr_t write_end   = write_start + write_size;
+        const uintptr_t src_start   = reinterpret_cast<uintptr_t>(m_src + src_offset);
+        const uintptr_t src_end     = reinterpret_cast<uintptr_t>(m_src + m_src_size);
+
+        return write_start < src_end && src_start < write_end;
+    }
+
+    Result Lz4StreamDecompressor::Decompress(size_t available_size) {
+        AMS_ASSERT(m_src_offset <= available_size && available_size <= m_src_size);
+
+        /* Sequences which extend past the available data are left for a later call; once all data is available, they're invalid. */
+        const bool is_final = available_size == m_src_size;
+
+        while (m_src_offset < available_size) {
+            /* Parse the sequence, without consuming anything until we know it's complete. */
+            size_t cur = m_src_offset;
+            const u8 token = m_src[cur++];
+
+            /* Determine the literal size. */
+            size_t literal_size = token >> 4;
+            if (literal_size == 0xF && ReadExtendedSize(std::addressof(literal_size), m_src, std::addressof(cur), available_size) != ReadState::Success) {
+                R_UNLESS(!is_final, ldr::ResultInvalidNso());
+                break;
+            }
+
+            R_UNLESS(literal_size <= m_src_size - cur,          ldr::ResultInvalidNso());
+            R_UNLESS(literal_size <= m_dst_size - m_dst_offset, ldr::ResultInvalidNso());
+            if (literal_size > available_size - cur) {
+                break;
+            }
+
+            const size_t literal_offset = cur;
+            cur += literal_size;
+
+            /* The last sequence is only literals. */
+            if (cur == m_src_size) {
+                std::memmove(m_dst + m_dst_offset, m_src + literal_offset, literal_size);
+                m_dst_offset += literal_size;
+                m_src_offset  = cur;
+                break;
+            }
+
+            /* Read the match offset. */
+            if (available_size - cur < sizeof(u16)) {
+                R_UNLESS(!is_final, ldr::ResultInvalidNso());
+                break;
+            }
+            const size_t match_offset = static_cast<size_t>(m_src[cur]) | (static_cast<size_t>(m_src[cur + 1]) << 8);
+            cur += sizeof(u16);
+
+            /* Determine the match size. */
+            size_t match_size = token & 0xF;
+            if (match_size == 0xF && ReadExtendedSize(std::addressof(match_size), m_src, std::addressof(cur), available_size) != ReadState::Success) {
+                R_UNLESS(!is_final, ldr::ResultInvalidNso());
+                break;
+            }
+            match_size += MinimumMatchSize;
+
+            /* Validate the sequence. */
+            R_UNLESS(match_offset != 0,                                         ldr::ResultInvalidNso());
+            R_UNLESS(match_offset <= m_dst_offset + literal_size,               ldr::ResultInvalidNso());
+            R_UNLESS(match_size <= m_dst_size - m_dst_offset - literal_size,    ldr::ResultInvalidNso());
+            R_UNLESS(!this->OverlapsUnconsumedSource(literal_size + match_size, cur), ldr::ResultInvalidNso());
+
+            /* Copy the literals. */
+            std::memmove(m_dst + m_dst_offset, m_src + literal_offset, literal_size);
+            m_dst_offset += literal_size;
+
+            /* Copy the match. */
+            u8 *dst = m_dst + m_dst_offset;
+            const u8 *match = dst - match_offset;
+            if (match_offset >= match_size) {
+                std::memcpy(dst, match, match_size);
+            } else {
+                for (size_t i = 0; i < match_size; ++i) {
+                    dst[i] = match[i];
+                }
+            }
+            m_dst_offset += match_size;
+
+            /* Consume the sequence. */
+            m_src_offset = cur;
+        }
+
+        R_SUCCEED();
+    }
+
+}
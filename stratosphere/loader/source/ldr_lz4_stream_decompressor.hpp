@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+
+namespace ams::ldr {
+
+    /* Decompresses a raw lz4 block whose compressed data becomes available incrementally. */
+    /* Decompression may be performed in place, with the compressed data at the end of the destination. */
+    class Lz4StreamDecompressor {
+        NON_COPYABLE(Lz4StreamDecompressor);
+        NON_MOVEABLE(Lz4StreamDecompressor);
+        private:
+            static constexpr size_t MinimumMatchSize = 4;
+        private:
+            u8 *m_dst;
+            size_t m_dst_size;
+            size_t m_dst_offset;
+            const u8 *m_src;
+            size_t m_src_size;
+            size_t m_src_offset;
+        public:
+            Lz4StreamDecompressor(void *dst, size_t dst_size, const void *src, size_t src_size) : m_dst(static_cast<u8 *>(dst)), m_dst_size(dst_size), m_dst_offset(0), m_src(static_cast<const u8 *>(src)), m_src_size(src_size), m_src_offset(0) {
+                /* ... */
+            }
+
+            Result Decompress(size_t available_size);
+
+            size_t GetDecompressedSize() const { return m_dst_offset; }
+            bool IsCompleted() const { return m_src_offset == m_src_size; }
+        private:
+            bool OverlapsUnconsumedSource(size_t write_size, size_t src_offset) const;
+    };
+
+}
@@ -18,6 +18,7 @@
 #include "ldr_content_management.hpp"
 #include "ldr_development_manager.hpp"
 #include "ldr_launch_record.hpp"
+#include "ldr_lz4_stream_decompressor.hpp"
 #include "ldr_meta.hpp"
 #include "ldr_patcher.hpp"
 #include "ldr_process_creation.hpp"
@@ -123,6 +124,9 @@ namespace ams::ldr {
         /* Global Zstd decompression context. */
         alignas(8) u8 g_zstd_dctx_workspace[util::DecompressZstdWithBicWorkBufferSizeDefault];
 
+        /* Segments are read in chunks, so that each chunk can be decompressed and hashed while still in cache. */
+        constexpr size_t SegmentReadChunkSize = 128_KB;
+
         Result ValidateProgramVersion(ncm::ProgramId program_id, u32 version) {
             /* No version verification is done before 8.1.0. */
             R_SUCCEED_IF(hos::GetVersion() < hos::Version_8_1_0);
@@ -636,7 +640,16 @@ namespace ams::ldr {
             R_SUCCEED();
         }
 
-        Result LoadAutoLoadModuleSegment(fs::FileHandle file, size_t file_offset, size_t compressed_size, size_t segment_size, bool is_compressed, bool is_zbic, uintptr_t map_base, uintptr_t map_end) {
+        Result LoadAutoLoadModuleSegment(fs::FileHandle file, const NsoHeader *nso_header, NsoHeader::Segment segment, uintptr_t map_address, uintptr_t map_end) {
+            /* Determine the segment's extents and compression. */
+            const size_t file_offset     = nso_header->segments[segment].file_offset;
+            const size_t segment_size    = nso_header->segments[segment].size;
+            const size_t compressed_size = nso_header->compressed_sizes[segment];
+            const bool is_compressed     = (nso_header->flags & (NsoHeader::Flag_CompressedText << segment)) != 0;
+            const bool is_zbic           = (nso_header->flags & NsoHeader::Flag_UseZbicCompression) != 0;
+            const bool check_hash        = (nso_header->flags & (NsoHeader::Flag_CheckHashText << segment)) != 0;
+            const uintptr_t map_base     = map_address + nso_header->segments[segment].dst_offset;
+
             /* Select read size based on compression. */
             size_t file_size = is_compressed ? compressed_size : segment_size;
 
@@ -648,44 +661,73 @@ namespace ams::ldr {
             R_UNLESS(file_size    <= std::numeric_limits<s32>::max(), ldr::ResultInvalidNso());
             R_UNLESS(segment_size <= std::numeric_limits<s32>::max(), ldr::ResultInvalidNso());
 
+            /* Hash the segment as it's produced, while the data is still in cache. */
+            crypto::Sha256Generator sha256;
+            uintptr_t hashed_end = map_base;
+            if (check_hash) {
+                sha256.Initialize();
+            }
+
+            const auto UpdateHash = [&](uintptr_t produced_end) ALWAYS_INLINE_LAMBDA {
+                if (check_hash) {
+                    sha256.Update(reinterpret_cast<const void *>(hashed_end), produced_end - hashed_end);
+                }
+                hashed_end = produced_end;
+            };
+
             /* Load data from file. */
             uintptr_t load_address = is_compressed ? map_end - compressed_size : map_base;
-            size_t read_size;
-            R_TRY(fs::ReadFile(std::addressof(read_size), file, file_offset, reinterpret_cast<void *>(load_address), file_size));
-            R_UNLESS_LOG(read_size == file_size, ldr::ResultInvalidNso(), "[ldr] Couldn't read segment from file!\n");
+            if (is_compressed && is_zbic) {
+                /* NOTE: zbic segments are decompressed in one shot, as their in-place margin can only be validated over the whole input. */
+                size_t read_size;
+                R_TRY(fs::ReadFile(std::addressof(read_size), file, file_offset, reinterpret_cast<void *>(load_address), file_size));
+                R_UNLESS_LOG(read_size == file_size, ldr::ResultInvalidNso(), "[ldr] Couldn't read segment from file!\n");
 
-            /* Uncompress if necessary. */
-            R_SUCCEED_IF(!is_compressed);
+                auto compressed_data_buf = reinterpret_cast<const void *>(load_address);
 
-            auto compressed_data_buf = reinterpret_cast<const void *>(load_address);
-
-            if (is_zbic) {
                 bool decompressed = util::DecompressZstdWithBic(reinterpret_cast<void *>(g_zstd_dctx_workspace), sizeof(g_zstd_dctx_workspace), reinterpret_cast<void *>(map_base), static_cast<size_t>(map_end - map_base), segment_size, compressed_data_buf, file_size);
                 R_UNLESS_LOG(decompressed, ldr::ResultInvalidNso(), "[ldr] Failed to decompress segment with zbic!\n");
+
+                UpdateHash(map_base + segment_size);
             } else {
-                bool decompressed = (util::DecompressLZ4(reinterpret_cast<void *>(map_base), segment_size, compressed_data_buf, file_size) == static_cast<int>(segment_size));
-                R_UNLESS_LOG(decompressed, ldr::ResultInvalidNso(), "[ldr] Failed to decompress segment with lz4!\n");
-            }
+                /* Read the segment a chunk at a time, decompressing and hashing each chunk as it arrives. */
+                Lz4StreamDecompressor decompressor(reinterpret_cast<void *>(map_base), segment_size, reinterpret_cast<const void *>(load_address), file_size);
 
-            R_SUCCEED();
-        }
+                for (size_t offset = 0; offset < file_size; /* ... */) {
+                    const size_t cur_size = std::min(file_size - offset, SegmentReadChunkSize);
 
-        Result CheckSegmentHash(const NsoHeader *nso_header, uintptr_t map_address, NsoHeader::Segment segment) {
-            if ((nso_header->flags & (NsoHeader::Flag_CheckHashText << segment)) == 0) {
-                R_SUCCEED();
+                    size_t read_size;
+                    R_TRY(fs::ReadFile(std::addressof(read_size), file, file_offset + offset, reinterpret_cast<void *>(load_address + offset), cur_size));
+                    R_UNLESS_LOG(read_size == cur_size, ldr::ResultInvalidNso(), "[ldr] Couldn't read segment from file!\n");
+
+                    offset += cur_size;
+
+                    if (is_compressed) {
+                        const Result decompress_result = decompressor.Decompress(offset);
+                        R_UNLESS_LOG(R_SUCCEEDED(decompress_result), decompress_result, "[ldr] Failed to decompress segment with lz4!\n");
+
+                        UpdateHash(map_base + decompressor.GetDecompressedSize());
+                    } else {
+                        UpdateHash(map_base + offset);
+                    }
+                }
+
+                if (is_compressed) {
+                    R_UNLESS_LOG(decompressor.IsCompleted() && decompressor.GetDecompressedSize() == segment_size, ldr::ResultInvalidNso(), "[ldr] Failed to decompress segment with lz4!\n");
+                }
+            }
+
+            /* Check the segment hash. */
+            if (check_hash) {
+                u8 hash[crypto::Sha256Generator::HashSize];
+                sha256.GetHash(hash, sizeof(hash));
+                R_UNLESS_LOG(std::memcmp(hash, nso_header->segment_hashes[segment], sizeof(hash)) == 0, ldr::ResultInvalidNso(), "[ldr] Invalid segment hash!\n");
             }
 
-            u8 hash[crypto::Sha256Generator::HashSize];
-            crypto::GenerateSha256(hash, sizeof(hash),
-                reinterpret_cast<void *>(map_address + nso_header->segments[segment].dst_offset),
-                nso_header->segments[segment].size);
-            R_UNLESS_LOG(std::memcmp(hash, nso_header->segment_hashes[segment], sizeof(hash)) == 0, ldr::ResultInvalidNso(), "[ldr] Invalid segment hash!\n");
             R_SUCCEED();
         }
 
         Result LoadAutoLoadModule(os::NativeHandle process_handle, fs::FileHandle file, const NsoHeader *nso_header, uintptr_t nso_address, size_t nso_size, size_t map_size) {
-            const bool is_zbic = (nso_header->flags & NsoHeader::Flag_UseZbicCompression) != 0;
-
             /* Map and read data from file. */
             {
                 /* Map the process memory. */
@@ -696,13 +738,10 @@ namespace ams::ldr {
                 const uintptr_t map_address = reinterpret_cast<uintptr_t>(mapped_memory);
                 const uintptr_t map_end     = map_address + map_size;
 
-                /* Load NSO segments. */
-                R_TRY(LoadAutoLoadModuleSegment(file, nso_header->segments[NsoHeader::Segment_Text].file_offset, nso_header->text_compressed_size, nso_header->text_size,
-                                                      (nso_header->flags & NsoHeader::Flag_CompressedText) != 0, is_zbic, map_address + nso_header->text_dst_offset, map_end));
-                R_TRY(LoadAutoLoadModuleSegment(file, nso_header->segments[NsoHeader::Segment_Ro].file_offset, nso_header->ro_compressed_size, nso_header->ro_size,
-                                                      (nso_header->flags & NsoHeader::Flag_CompressedRo) != 0, is_zbic, map_address + nso_header->ro_dst_offset, map_end));
-                R_TRY(LoadAutoLoadModuleSegment(file, nso_header->segments[NsoHeader::Segment_Rw].file_offset, nso_header->rw_compressed_size, nso_header->rw_size,
-                                                      (nso_header->flags & NsoHeader::Flag_CompressedRw) != 0, is_zbic, map_address + nso_header->rw_dst_offset, map_end));
+                /* Load NSO segments, checking their hashes as they're loaded. */
+                R_TRY(LoadAutoLoadModuleSegment(file, nso_header, NsoHeader::Segment_Text, map_address, map_end));
+                R_TRY(LoadAutoLoadModuleSegment(file, nso_header, NsoHeader::Segment_Ro,   map_address, map_end));
+                R_TRY(LoadAutoLoadModuleSegment(file, nso_header, NsoHeader::Segment_Rw,   map_address, map_end));
 
                 /* Clear unused space to zero. */
                 const size_t text_end = static_cast<size_t>(nso_header->text_dst_offset) + static_cast<size_t>(nso_header->text_size);
@@ -712,11 +751,6 @@ namespace ams::ldr {
                 std::memset(reinterpret_cast<void *>(map_address + ro_end),   0, nso_header->rw_dst_offset - ro_end);
                 std::memset(reinterpret_cast<void *>(map_address + rw_end),   0, nso_size - rw_end);
 
-                /* Check segment hashes. */
-                R_TRY(CheckSegmentHash(nso_header, map_address, NsoHeader::Segment_Text));
-                R_TRY(CheckSegmentHash(nso_header, map_address, NsoHeader::Segment_Ro));
-                R_TRY(CheckSegmentHash(nso_header, map_address, NsoHeader::Segment_Rw));
-
                 /* Apply embedded patches. */
                 ApplyEmbeddedPatchesToModule(nso_header->module_id, map_address, nso_size);
 
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <stratosphere.hpp>
+
+namespace ams::ro::impl {
+
+    struct Sha256Hash {
+        u8 hash[crypto::Sha256Generator::HashSize];
+
+        bool operator==(const Sha256Hash &o) const {
+            return std::memcmp(this, std::addressof(o), sizeof(*this)) == 0;
+        }
+        bool operator!=(const Sha256Hash &o) const {
+            return std::memcmp(this, std::addressof(o), sizeof(*this)) != 0;
+        }
+        bool operator<(const Sha256Hash &o) const {
+            return std::memcmp(this, std::addressof(o), sizeof(*this)) < 0;
+        }
+        bool operator>(const Sha256Hash &o) const {
+            return std::memcmp(this, std::addressof(o), sizeof(*this)) > 0;
+        }
+    };
+    static_assert(sizeof(Sha256Hash) == sizeof(Sha256Hash::hash));
+
+    /* NOTE: Atmosphère extension. */
+    /* Private copies of NRR hash tables, stored back to back, so that NRO lookups need not re-validate the mapped tables. */
+    template<size_t HashCountMax>
+    class NroHashIndex {
+        private:
+            Sha256Hash m_hashes[HashCountMax]{};
+            size_t m_num_hashes{};
+        public:
+            constexpr NroHashIndex() = default;
+
+            void Clear() {
+                m_num_hashes = 0;
+            }
+
+            size_t GetCount() const {
+                return m_num_hashes;
+            }
+
+            Sha256Hash *Stage(const void *hashes, size_t num_hashes) {
+                /* Copy a hash table into the free space past the end of the index; it is not indexed until committed. */
+                if (num_hashes == 0 || num_hashes > HashCountMax - m_num_hashes) {
+                    return nullptr;
+                }
+
+                Sha256Hash *staged = m_hashes + m_num_hashes;
+                std::memcpy(staged, hashes, num_hashes * sizeof(Sha256Hash));
+
+                /* Lookups binary search the table, so it must be sorted. */
+                if (!std::is_sorted(staged, staged + num_hashes)) {
+                    return nullptr;
+                }
+
+                return staged;
+            }
+
+            size_t Commit(size_t num_hashes) {
+                AMS_ASSERT(num_hashes <= HashCountMax - m_num_hashes);
+
+                const size_t offset = m_num_hashes;
+                m_num_hashes += num_hashes;
+                return offset;
+            }
+
+            void Remove(size_t offset, size_t num_hashes) {
+                AMS_ASSERT(offset + num_hashes <= m_num_hashes);
+
+                /* Compact the index over the removed hashes; the caller fixes up the offsets of any tables after them. */
+                std::memmove(m_hashes + offset, m_hashes + offset + num_hashes, (m_num_hashes - (offset + num_hashes)) * sizeof(Sha256Hash));
+                m_num_hashes -= num_hashes;
+            }
+
+            bool Contains(size_t offset, size_t num_hashes, const Sha256Hash &hash) const {
+                AMS_ASSERT(offset + num_hashes <= m_num_hashes);
+
+                const Sha256Hash *start = m_hashes + offset;
+                const Sha256Hash *end   = start + num_hashes;
+
+                const Sha256Hash *lower_bound = std::lower_bound(start, end, hash);
+                return lower_bound != end && *lower_bound == hash;
+            }
+    };
+
+}
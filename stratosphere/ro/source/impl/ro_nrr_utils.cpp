@@ -245,8 +245,9 @@ namespace ams::ro::impl {
         sha256.Update(signed_area, pre_hash_table_size);
 
         /* Hash the hash table, checking if the desired hash exists inside it. */
+        /* NOTE: Atmosphère extension; when no desired hash is specified, only the table itself is validated. */
         size_t remaining_size = signed_area_size - pre_hash_table_size;
-        bool found_hash = false;
+        bool found_hash = (desired_hash == nullptr);
         for (size_t i = 0; i < num_hashes; i++) {
             /* Get the current hash. */
             u8 cur_hash[crypto::Sha256Generator::HashSize];
@@ -256,7 +257,9 @@ namespace ams::ro::impl {
             sha256.Update(cur_hash, sizeof(cur_hash));
 
             /* Check if the current hash is our target. */
-            found_hash |= std::memcmp(cur_hash, desired_hash, sizeof(cur_hash)) == 0;
+            if (desired_hash != nullptr) {
+                found_hash |= std::memcmp(cur_hash, desired_hash, sizeof(cur_hash)) == 0;
+            }
 
             /* Advance our pointers. */
             hash_table     += sizeof(cur_hash);
@@ -284,4 +287,8 @@ namespace ams::ro::impl {
         return is_valid;
     }
 
+    bool ValidateNrrHashTable(const void *signed_area, size_t signed_area_size, size_t hashes_offset, size_t num_hashes, const void *nrr_hash, const u8 *hash_table) {
+        return ValidateNrrHashTableEntry(signed_area, signed_area_size, hashes_offset, num_hashes, nrr_hash, hash_table, nullptr);
+    }
+
 }
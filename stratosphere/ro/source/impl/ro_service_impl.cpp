@@ -19,6 +19,7 @@
 #include "ro_patcher.hpp"
 #include "ro_random.hpp"
 #include "ro_service_impl.hpp"
+#include "ro_nro_hash_index.hpp"
 
 namespace ams::ro::impl {
 
@@ -29,25 +30,10 @@ namespace ams::ro::impl {
         constexpr size_t MaxNrrInfos = 0x40;
         constexpr size_t MaxNroInfos = 0x40;
 
-        /* Types. */
-        struct Sha256Hash {
-            u8 hash[crypto::Sha256Generator::HashSize];
-
-            bool operator==(const Sha256Hash &o) const {
-                return std::memcmp(this, std::addressof(o), sizeof(*this)) == 0;
-            }
-            bool operator!=(const Sha256Hash &o) const {
-                return std::memcmp(this, std::addressof(o), sizeof(*this)) != 0;
-            }
-            bool operator<(const Sha256Hash &o) const {
-                return std::memcmp(this, std::addressof(o), sizeof(*this)) < 0;
-            }
-            bool operator>(const Sha256Hash &o) const {
-                return std::memcmp(this, std::addressof(o), sizeof(*this)) > 0;
-            }
-        };
-        static_assert(sizeof(Sha256Hash) == sizeof(Sha256Hash::hash));
+        /* NOTE: Atmosphère extension. */
+        constexpr size_t MaxIndexedNroHashes = 0x400;
 
+        /* Types. */
         struct NroInfo {
             u64 base_address;
             u64 nro_heap_address;
@@ -71,6 +57,10 @@ namespace ams::ro::impl {
             u32 cached_num_hashes;
             u8  cached_signed_area[sizeof(NrrHeader) - NrrHeader::GetSignedAreaOffset()];
             Sha256Hash signed_area_hash;
+
+            /* NOTE: Atmosphère extension. */
+            bool is_hash_indexed;
+            u32 indexed_hashes_offset;
         };
 
         struct ProcessContext {
@@ -79,6 +69,7 @@ namespace ams::ro::impl {
                 bool m_nrr_in_use[MaxNrrInfos]{};
                 NroInfo m_nro_infos[MaxNroInfos]{};
                 NrrInfo m_nrr_infos[MaxNrrInfos]{};
+                NroHashIndex<MaxIndexedNroHashes> m_nro_hash_index{};
                 os::NativeHandle m_process_handle = os::InvalidNativeHandle;
                 os::ProcessId m_process_id = os::InvalidProcessId;
                 bool m_in_use{};
@@ -92,6 +83,7 @@ namespace ams::ro::impl {
                     std::memset(m_nrr_in_use, 0, sizeof(m_nrr_in_use));
                     std::memset(m_nro_infos, 0, sizeof(m_nro_infos));
                     std::memset(m_nrr_infos, 0, sizeof(m_nrr_infos));
+                    m_nro_hash_index.Clear();
 
                     m_process_handle = process_handle;
                     m_process_id     = process_id;
@@ -114,6 +106,7 @@ namespace ams::ro::impl {
                     std::memset(m_nrr_in_use, 0, sizeof(m_nrr_in_use));
                     std::memset(m_nro_infos, 0, sizeof(m_nro_infos));
                     std::memset(m_nrr_infos, 0, sizeof(m_nrr_infos));
+                    m_nro_hash_index.Clear();
 
                     m_process_handle = os::InvalidNativeHandle;
                     m_process_id     = os::InvalidProcessId;
@@ -213,6 +206,15 @@ namespace ams::ro::impl {
                             continue;
                         }
 
+                        /* If we've indexed the NRR's hashes, we can search our validated copy directly. */
+                        if (m_nrr_infos[i].is_hash_indexed) {
+                            if (m_nro_hash_index.Contains(m_nrr_infos[i].indexed_hashes_offset, m_nrr_infos[i].cached_num_hashes, hash)) {
+                                R_SUCCEED();
+                            }
+
+                            continue;
+                        }
+
                         /* Get the mapped header, ensure that it has hashes. */
                         const NrrHeader *mapped_nrr_header = m_nrr_infos[i].mapped_header;
                         const size_t mapped_num_hashes = mapped_nrr_header->GetNumHashes();
@@ -310,6 +312,52 @@ namespace ams::ro::impl {
                     R_SUCCEED();
                 }
 
+                void AddNrrToHashIndex(NrrInfo *info) {
+                    /* NOTE: Atmosphère extension. */
+                    /* Rather than re-validating the mapped hash table on every NRO load, we validate a private copy of it once. */
+                    /* NRRs which don't fit (or whose tables aren't sorted) fall back to validating the mapped table. */
+                    info->is_hash_indexed       = false;
+                    info->indexed_hashes_offset = 0;
+
+                    /* Copy the hash table. */
+                    const size_t num_hashes = info->cached_num_hashes;
+                    const Sha256Hash *indexed_hashes = m_nro_hash_index.Stage(reinterpret_cast<const void *>(info->mapped_header->GetHashes()), num_hashes);
+                    if (indexed_hashes == nullptr) {
+                        return;
+                    }
+
+                    /* Validate the copy. */
+                    if (!ValidateNrrHashTable(info->cached_signed_area, info->cached_signed_area_size, info->cached_hashes_offset, num_hashes, std::addressof(info->signed_area_hash), reinterpret_cast<const u8 *>(indexed_hashes))) {
+                        return;
+                    }
+
+                    /* Commit the copy to the index. */
+                    info->is_hash_indexed       = true;
+                    info->indexed_hashes_offset = m_nro_hash_index.Commit(num_hashes);
+                }
+
+                void RemoveNrrFromHashIndex(NrrInfo *info) {
+                    /* NOTE: Atmosphère extension. */
+                    if (!info->is_hash_indexed) {
+                        return;
+                    }
+
+                    /* Compact the index over the removed hashes. */
+                    const size_t offset     = info->indexed_hashes_offset;
+                    const size_t num_hashes = info->cached_num_hashes;
+                    m_nro_hash_index.Remove(offset, num_hashes);
+
+                    /* Fix up the offsets of any NRRs whose hashes were moved. */
+                    for (size_t i = 0; i < MaxNrrInfos; i++) {
+                        if (m_nrr_in_use[i] && m_nrr_infos[i].is_hash_indexed && m_nrr_infos[i].indexed_hashes_offset > offset) {
+                            m_nrr_infos[i].indexed_hashes_offset -= num_hashes;
+                        }
+                    }
+
+                    info->is_hash_indexed       = false;
+                    info->indexed_hashes_offset = 0;
+                }
+
                 void SetNrrInfoInUse(const NrrInfo *info, bool in_use) {
                     AMS_ASSERT(std::addressof(m_nrr_infos[0]) <= info && info <= std::addressof(m_nrr_infos[MaxNrrInfos - 1]));
                     const size_t index = info - std::addressof(m_nrr_infos[0]);
@@ -506,6 +554,9 @@ namespace ams::ro::impl {
         std::memcpy(nrr_info->cached_signed_area, header->GetSignedArea(), std::min(sizeof(nrr_info->cached_signed_area), header->GetHashesOffset() - header->GetSignedAreaOffset()));
         std::memcpy(std::addressof(nrr_info->signed_area_hash), std::addressof(signed_area_hash), sizeof(signed_area_hash));
 
+        /* Index the NRR's hashes. */
+        context->AddNrrToHashIndex(nrr_info);
+
         R_SUCCEED();
     }
 
@@ -525,6 +576,7 @@ namespace ams::ro::impl {
         const NrrInfo nrr_backup = *nrr_info;
         {
             /* Nintendo does this unconditionally, whether or not the actual unmap succeeds. */
+            context->RemoveNrrFromHashIndex(nrr_info);
             context->SetNrrInfoInUse(nrr_info, false);
             std::memset(nrr_info, 0, sizeof(*nrr_info));
         }
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <stratosphere.hpp>
+
+namespace ams::sm::impl {
+
+    /* NOTE: Atmosphère extension. */
+    /* Open-addressed index from a 64-bit key to a position in one of our info lists, so that lookups need not scan the list. */
+    template<typename InfoType, size_t InfoCount, u64 (*GetKey)(const InfoType &)>
+    class InfoIndex {
+        private:
+            static constexpr size_t SlotCount = util::CeilingPowerOfTwo(InfoCount * 2);
+            static constexpr size_t SlotMask  = SlotCount - 1;
+            static constexpr int    HashShift = BITSIZEOF(u64) - util::CountTrailingZeros(SlotCount);
+
+            static constexpr u16 InvalidPosition = std::numeric_limits<u16>::max();
+            static_assert(InfoCount < InvalidPosition);
+        private:
+            std::array<u16, SlotCount> m_slots;
+        private:
+            static constexpr ALWAYS_INLINE size_t GetHomeSlot(u64 key) {
+                /* Fibonacci hashing. */
+                return static_cast<size_t>((key * UINT64_C(0x9E3779B97F4A7C15)) >> HashShift);
+            }
+        public:
+            constexpr InfoIndex() : m_slots() {
+                m_slots.fill(InvalidPosition);
+            }
+
+            InfoType *Find(std::array<InfoType, InfoCount> &list, u64 key) const {
+                /* Walk the probe sequence until we find the key, or reach an empty slot. */
+                for (size_t slot = GetHomeSlot(key); m_slots[slot] != InvalidPosition; slot = (slot + 1) & SlotMask) {
+                    if (InfoType *info = std::addressof(list[m_slots[slot]]); GetKey(*info) == key) {
+                        return info;
+                    }
+                }
+
+                return nullptr;
+            }
+
+            void Insert(const std::array<InfoType, InfoCount> &list, const InfoType *info) {
+                const size_t position = info - list.data();
+                AMS_ASSERT(position < InfoCount);
+
+                /* Find the first empty slot along the probe sequence. */
+                size_t slot = GetHomeSlot(GetKey(*info));
+                while (m_slots[slot] != InvalidPosition) {
+                    slot = (slot + 1) & SlotMask;
+                }
+
+                m_slots[slot] = static_cast<u16>(position);
+            }
+
+            void Remove(const std::array<InfoType, InfoCount> &list, const InfoType *info) {
+                const size_t position = info - list.data();
+                AMS_ASSERT(position < InfoCount);
+
+                /* Find the slot referring to the info. */
+                size_t slot = GetHomeSlot(GetKey(*info));
+                while (m_slots[slot] != position) {
+                    AMS_ASSERT(m_slots[slot] != InvalidPosition);
+                    slot = (slot + 1) & SlotMask;
+                }
+
+                /* Remove the slot, shifting back any later entries in the run that may no longer be reachable. */
+                for (size_t next = (slot + 1) & SlotMask; m_slots[next] != InvalidPosition; next = (next + 1) & SlotMask) {
+                    /* An entry can fill the hole only if its home slot is not cyclically within (slot, next]. */
+                    const size_t home = GetHomeSlot(GetKey(list[m_slots[next]]));
+                    if (((next - home) & SlotMask) >= ((next - slot) & SlotMask)) {
+                        m_slots[slot] = m_slots[next];
+                        slot = next;
+                    }
+                }
+
+                m_slots[slot] = InvalidPosition;
+            }
+    };
+
+}
@@ -15,6 +15,7 @@
  */
 #include <stratosphere.hpp>
 #include "sm_service_manager.hpp"
+#include "sm_info_index.hpp"
 #include "../sm_wait_list.hpp"
 
 namespace ams::hos {
@@ -134,6 +135,17 @@ namespace ams::sm::impl {
                 }
         };
 
+        constexpr u64 GetProcessInfoKey(const ProcessInfo &process_info) {
+            return process_info.process_id.value;
+        }
+
+        constexpr u64 GetServiceInfoKey(const ServiceInfo &service_info) {
+            return std::bit_cast<u64>(service_info.name);
+        }
+
+        using ProcessInfoIndex = InfoIndex<ProcessInfo, ProcessCountMax, GetProcessInfoKey>;
+        using ServiceInfoIndex = InfoIndex<ServiceInfo, ServiceCountMax, GetServiceInfoKey>;
+
         class InitialProcessIdLimits {
             private:
                 os::ProcessId m_min;
@@ -184,6 +196,10 @@ namespace ams::sm::impl {
             return list;
         }();
 
+        /* NOTE: Atmosphère extension; these index every valid entry in the above lists. */
+        constinit ProcessInfoIndex g_process_index;
+        constinit ServiceInfoIndex g_service_index;
+
         constinit std::array<ServiceName, MitmCountMax> g_future_mitm_list = [] {
             std::array<ServiceName, MitmCountMax> list = {};
 
@@ -291,8 +307,13 @@ namespace ams::sm::impl {
 
         ProcessInfo *GetProcessInfo(os::ProcessId process_id) {
             /* Find a process info with a matching id. */
+            return g_process_index.Find(g_process_list, process_id.value);
+        }
+
+        ProcessInfo *GetFreeProcessInfo() {
+            /* Find a process info without a process. */
             for (auto &process_info : g_process_list) {
-                if (process_info.process_id == process_id) {
+                if (process_info.process_id == os::InvalidProcessId) {
                     return std::addressof(process_info);
                 }
             }
@@ -300,18 +321,19 @@ namespace ams::sm::impl {
             return nullptr;
         }
 
-        ProcessInfo *GetFreeProcessInfo() {
-            return GetProcessInfo(os::InvalidProcessId);
-        }
-
         bool HasProcessInfo(os::ProcessId process_id) {
             return GetProcessInfo(process_id) != nullptr;
         }
 
         ServiceInfo *GetServiceInfo(ServiceName service_name) {
             /* Find a service with a matching name. */
+            return g_service_index.Find(g_service_list, std::bit_cast<u64>(service_name));
+        }
+
+        ServiceInfo *GetFreeServiceInfo() {
+            /* Find a service info without a name. */
             for (auto &service_info : g_service_list) {
-                if (service_info.name == service_name) {
+                if (service_info.name == InvalidServiceName) {
                     return std::addressof(service_info);
                 }
             }
@@ -319,10 +341,6 @@ namespace ams::sm::impl {
             return nullptr;
         }
 
-        ServiceInfo *GetFreeServiceInfo() {
-            return GetServiceInfo(InvalidServiceName);
-        }
-
         bool HasServiceInfo(ServiceName service) {
             return GetServiceInfo(service) != nullptr;
         }
@@ -498,6 +516,9 @@ namespace ams::sm::impl {
             free_service->max_sessions     = max_sessions;
             free_service->is_light         = is_light;
 
+            /* Index the service. */
+            g_service_index.Insert(g_service_list, free_service);
+
             /* This might undefer some requests. */
             TriggerResume(service);
 
@@ -512,6 +533,7 @@ namespace ams::sm::impl {
             os::CloseNativeHandle(service_info->port_h);
 
             /* Reset the info's state. */
+            g_service_index.Remove(g_service_list, service_info);
             *service_info = InvalidServiceInfo;
 
             /* Reset the mitm info, if necessary. */
@@ -567,6 +589,9 @@ namespace ams::sm::impl {
         proc->access_control_size = aci_sac_size;
         std::memcpy(proc->access_control, aci_sac, proc->access_control_size);
 
+        /* Index the process. */
+        g_process_index.Insert(g_process_list, proc);
+
         R_SUCCEED();
     }
 
@@ -579,6 +604,7 @@ namespace ams::sm::impl {
         R_UNLESS(proc != nullptr, sm::ResultInvalidClient());
 
         /* Free the process. */
+        g_process_index.Remove(g_process_list, proc);
         *proc = InvalidProcessInfo;
 
         R_SUCCEED();
@@ -0,0 +1,642 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+
+namespace ams {
+
+    namespace {
+
+        /* ==================================================================================================================== */
+        /* AES-XTS (IEEE Std 1619-2007 test vectors)                                                                            */
+        /* ==================================================================================================================== */
+
+        constexpr const u8 XtsVector2Key[] = {
+            0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22,
+        };
+        constexpr const u8 XtsVector2Tweak[] = {
+            0x33, 0x33, 0x33, 0x33, 0x33, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        };
+        constexpr const u8 XtsVector2Plain[] = {
+            0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44,
+            0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44,
+        };
+        constexpr const u8 XtsVector2Cipher[] = {
+            0xC4, 0x54, 0x18, 0x5E, 0x6A, 0x16, 0x93, 0x6E, 0x39, 0x33, 0x40, 0x38, 0xAC, 0xEF, 0x83, 0x8B,
+            0xFB, 0x18, 0x6F, 0xFF, 0x74, 0x80, 0xAD, 0xC4, 0x28, 0x93, 0x82, 0xEC, 0xD6, 0xD3, 0x94, 0xF0,
+        };
+
+        constexpr const u8 XtsVector3Key[] = {
+            0xFF, 0xFE, 0xFD, 0xFC, 0xFB, 0xFA, 0xF9, 0xF8, 0xF7, 0xF6, 0xF5, 0xF4, 0xF3, 0xF2, 0xF1, 0xF0,
+            0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22,
+        };
+        constexpr const u8 XtsVector3Cipher[] = {
+            0xAF, 0x85, 0x33, 0x6B, 0x59, 0x7A, 0xFC, 0x1A, 0x90, 0x0B, 0x2E, 0xB2, 0x1E, 0xC9, 0x49, 0xD2,
+            0x92, 0xDF, 0x4C, 0x04, 0x7E, 0x0B, 0x21, 0x53, 0x21, 0x86, 0xA5, 0x97, 0x1A, 0x22, 0x7A, 0x89,
+        };
+
+        constexpr const u8 XtsVector4Key[] = {
+            0x27, 0x18, 0x28, 0x18, 0x28, 0x45, 0x90, 0x45, 0x23, 0x53, 0x60, 0x28, 0x74, 0x71, 0x35, 0x26,
+            0x31, 0x41, 0x59, 0x26, 0x53, 0x58, 0x97, 0x93, 0x23, 0x84, 0x62, 0x64, 0x33, 0x83, 0x27, 0x95,
+        };
+        constexpr const u8 XtsVector4Cipher[] = {
+            0x27, 0xA7, 0x47, 0x9B, 0xEF, 0xA1, 0xD4, 0x76, 0x48, 0x9F, 0x30, 0x8C, 0xD4, 0xCF, 0xA6, 0xE2,
+            0xA9, 0x6E, 0x4B, 0xBE, 0x32, 0x08, 0xFF, 0x25, 0x28, 0x7D, 0xD3, 0x81, 0x96, 0x16, 0xE8, 0x9C,
+            0xC7, 0x8C, 0xF7, 0xF5, 0xE5, 0x43, 0x44, 0x5F, 0x83, 0x33, 0xD8, 0xFA, 0x7F, 0x56, 0x00, 0x00,
+            0x05, 0x27, 0x9F, 0xA5, 0xD8, 0xB5, 0xE4, 0xAD, 0x40, 0xE7, 0x36, 0xDD, 0xB4, 0xD3, 0x54, 0x12,
+            0x32, 0x80, 0x63, 0xFD, 0x2A, 0xAB, 0x53, 0xE5, 0xEA, 0x1E, 0x0A, 0x9F, 0x33, 0x25, 0x00, 0xA5,
+            0xDF, 0x94, 0x87, 0xD0, 0x7A, 0x5C, 0x92, 0xCC, 0x51, 0x2C, 0x88, 0x66, 0xC7, 0xE8, 0x60, 0xCE,
+            0x93, 0xFD, 0xF1, 0x66, 0xA2, 0x49, 0x12, 0xB4, 0x22, 0x97, 0x61, 0x46, 0xAE, 0x20, 0xCE, 0x84,
+            0x6B, 0xB7, 0xDC, 0x9B, 0xA9, 0x4A, 0x76, 0x7A, 0xAE, 0xF2, 0x0C, 0x0D, 0x61, 0xAD, 0x02, 0x65,
+            0x5E, 0xA9, 0x2D, 0xC4, 0xC4, 0xE4, 0x1A, 0x89, 0x52, 0xC6, 0x51, 0xD3, 0x31, 0x74, 0xBE, 0x51,
+            0xA1, 0x0C, 0x42, 0x11, 0x10, 0xE6, 0xD8, 0x15, 0x88, 0xED, 0xE8, 0x21, 0x03, 0xA2, 0x52, 0xD8,
+            0xA7, 0x50, 0xE8, 0x76, 0x8D, 0xEF, 0xFF, 0xED, 0x91, 0x22, 0x81, 0x0A, 0xAE, 0xB9, 0x9F, 0x91,
+            0x72, 0xAF, 0x82, 0xB6, 0x04, 0xDC, 0x4B, 0x8E, 0x51, 0xBC, 0xB0, 0x82, 0x35, 0xA6, 0xF4, 0x34,
+            0x13, 0x32, 0xE4, 0xCA, 0x60, 0x48, 0x2A, 0x4B, 0xA1, 0xA0, 0x3B, 0x3E, 0x65, 0x00, 0x8F, 0xC5,
+            0xDA, 0x76, 0xB7, 0x0B, 0xF1, 0x69, 0x0D, 0xB4, 0xEA, 0xE2, 0x9C, 0x5F, 0x1B, 0xAD, 0xD0, 0x3C,
+            0x5C, 0xCF, 0x2A, 0x55, 0xD7, 0x05, 0xDD, 0xCD, 0x86, 0xD4, 0x49, 0x51, 0x1C, 0xEB, 0x7E, 0xC3,
+            0x0B, 0xF1, 0x2B, 0x1F, 0xA3, 0x5B, 0x91, 0x3F, 0x9F, 0x74, 0x7A, 0x8A, 0xFD, 0x1B, 0x13, 0x0E,
+            0x94, 0xBF, 0xF9, 0x4E, 0xFF, 0xD0, 0x1A, 0x91, 0x73, 0x5C, 0xA1, 0x72, 0x6A, 0xCD, 0x0B, 0x19,
+            0x7C, 0x4E, 0x5B, 0x03, 0x39, 0x36, 0x97, 0xE1, 0x26, 0x82, 0x6F, 0xB6, 0xBB, 0xDE, 0x8E, 0xCC,
+            0x1E, 0x08, 0x29, 0x85, 0x16, 0xE2, 0xC9, 0xED, 0x03, 0xFF, 0x3C, 0x1B, 0x78, 0x60, 0xF6, 0xDE,
+            0x76, 0xD4, 0xCE, 0xCD, 0x94, 0xC8, 0x11, 0x98, 0x55, 0xEF, 0x52, 0x97, 0xCA, 0x67, 0xE9, 0xF3,
+            0xE7, 0xFF, 0x72, 0xB1, 0xE9, 0x97, 0x85, 0xCA, 0x0A, 0x7E, 0x77, 0x20, 0xC5, 0xB3, 0x6D, 0xC6,
+            0xD7, 0x2C, 0xAC, 0x95, 0x74, 0xC8, 0xCB, 0xBC, 0x2F, 0x80, 0x1E, 0x23, 0xE5, 0x6F, 0xD3, 0x44,
+            0xB0, 0x7F, 0x22, 0x15, 0x4B, 0xEB, 0xA0, 0xF0, 0x8C, 0xE8, 0x89, 0x1E, 0x64, 0x3E, 0xD9, 0x95,
+            0xC9, 0x4D, 0x9A, 0x69, 0xC9, 0xF1, 0xB5, 0xF4, 0x99, 0x02, 0x7A, 0x78, 0x57, 0x2A, 0xEE, 0xBD,
+            0x74, 0xD2, 0x0C, 0xC3, 0x98, 0x81, 0xC2, 0x13, 0xEE, 0x77, 0x0B, 0x10, 0x10, 0xE4, 0xBE, 0xA7,
+            0x18, 0x84, 0x69, 0x77, 0xAE, 0x11, 0x9F, 0x7A, 0x02, 0x3A, 0xB5, 0x8C, 0xCA, 0x0A, 0xD7, 0x52,
+            0xAF, 0xE6, 0x56, 0xBB, 0x3C, 0x17, 0x25, 0x6A, 0x9F, 0x6E, 0x9B, 0xF1, 0x9F, 0xDD, 0x5A, 0x38,
+            0xFC, 0x82, 0xBB, 0xE8, 0x72, 0xC5, 0x53, 0x9E, 0xDB, 0x60, 0x9E, 0xF4, 0xF7, 0x9C, 0x20, 0x3E,
+            0xBB, 0x14, 0x0F, 0x2E, 0x58, 0x3C, 0xB2, 0xAD, 0x15, 0xB4, 0xAA, 0x5B, 0x65, 0x50, 0x16, 0xA8,
+            0x44, 0x92, 0x77, 0xDB, 0xD4, 0x77, 0xEF, 0x2C, 0x8D, 0x6C, 0x01, 0x7D, 0xB7, 0x38, 0xB1, 0x8D,
+            0xEB, 0x4A, 0x42, 0x7D, 0x19, 0x23, 0xCE, 0x3F, 0xF2, 0x62, 0x73, 0x57, 0x79, 0xA4, 0x18, 0xF2,
+            0x0A, 0x28, 0x2D, 0xF9, 0x20, 0x14, 0x7B, 0xEA, 0xBE, 0x42, 0x1E, 0xE5, 0x31, 0x9D, 0x05, 0x68,
+        };
+
+        constexpr const u8 XtsVector10Key[] = {
+            0x27, 0x18, 0x28, 0x18, 0x28, 0x45, 0x90, 0x45, 0x23, 0x53, 0x60, 0x28, 0x74, 0x71, 0x35, 0x26,
+            0x62, 0x49, 0x77, 0x57, 0x24, 0x70, 0x93, 0x69, 0x99, 0x59, 0x57, 0x49, 0x66, 0x96, 0x76, 0x27,
+            0x31, 0x41, 0x59, 0x26, 0x53, 0x58, 0x97, 0x93, 0x23, 0x84, 0x62, 0x64, 0x33, 0x83, 0x27, 0x95,
+            0x02, 0x88, 0x41, 0x97, 0x16, 0x93, 0x99, 0x37, 0x51, 0x05, 0x82, 0x09, 0x74, 0x94, 0x45, 0x92,
+        };
+        constexpr const u8 XtsVector10Tweak[] = {
+            0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        };
+        constexpr const u8 XtsVector10Cipher[] = {
+            0x1C, 0x3B, 0x3A, 0x10, 0x2F, 0x77, 0x03, 0x86, 0xE4, 0x83, 0x6C, 0x99, 0xE3, 0x70, 0xCF, 0x9B,
+            0xEA, 0x00, 0x80, 0x3F, 0x5E, 0x48, 0x23, 0x57, 0xA4, 0xAE, 0x12, 0xD4, 0x14, 0xA3, 0xE6, 0x3B,
+            0x5D, 0x31, 0xE2, 0x76, 0xF8, 0xFE, 0x4A, 0x8D, 0x66, 0xB3, 0x17, 0xF9, 0xAC, 0x68, 0x3F, 0x44,
+            0x68, 0x0A, 0x86, 0xAC, 0x35, 0xAD, 0xFC, 0x33, 0x45, 0xBE, 0xFE, 0xCB, 0x4B, 0xB1, 0x88, 0xFD,
+            0x57, 0x76, 0x92, 0x6C, 0x49, 0xA3, 0x09, 0x5E, 0xB1, 0x08, 0xFD, 0x10, 0x98, 0xBA, 0xEC, 0x70,
+            0xAA, 0xA6, 0x69, 0x99, 0xA7, 0x2A, 0x82, 0xF2, 0x7D, 0x84, 0x8B, 0x21, 0xD4, 0xA7, 0x41, 0xB0,
+            0xC5, 0xCD, 0x4D, 0x5F, 0xFF, 0x9D, 0xAC, 0x89, 0xAE, 0xBA, 0x12, 0x29, 0x61, 0xD0, 0x3A, 0x75,
+            0x71, 0x23, 0xE9, 0x87, 0x0F, 0x8A, 0xCF, 0x10, 0x00, 0x02, 0x08, 0x87, 0x89, 0x14, 0x29, 0xCA,
+            0x2A, 0x3E, 0x7A, 0x7D, 0x7D, 0xF7, 0xB1, 0x03, 0x55, 0x16, 0x5C, 0x8B, 0x9A, 0x6D, 0x0A, 0x7D,
+            0xE8, 0xB0, 0x62, 0xC4, 0x50, 0x0D, 0xC4, 0xCD, 0x12, 0x0C, 0x0F, 0x74, 0x18, 0xDA, 0xE3, 0xD0,
+            0xB5, 0x78, 0x1C, 0x34, 0x80, 0x3F, 0xA7, 0x54, 0x21, 0xC7, 0x90, 0xDF, 0xE1, 0xDE, 0x18, 0x34,
+            0xF2, 0x80, 0xD7, 0x66, 0x7B, 0x32, 0x7F, 0x6C, 0x8C, 0xD7, 0x55, 0x7E, 0x12, 0xAC, 0x3A, 0x0F,
+            0x93, 0xEC, 0x05, 0xC5, 0x2E, 0x04, 0x93, 0xEF, 0x31, 0xA1, 0x2D, 0x3D, 0x92, 0x60, 0xF7, 0x9A,
+            0x28, 0x9D, 0x6A, 0x37, 0x9B, 0xC7, 0x0C, 0x50, 0x84, 0x14, 0x73, 0xD1, 0xA8, 0xCC, 0x81, 0xEC,
+            0x58, 0x3E, 0x96, 0x45, 0xE0, 0x7B, 0x8D, 0x96, 0x70, 0x65, 0x5B, 0xA5, 0xBB, 0xCF, 0xEC, 0xC6,
+            0xDC, 0x39, 0x66, 0x38, 0x0A, 0xD8, 0xFE, 0xCB, 0x17, 0xB6, 0xBA, 0x02, 0x46, 0x9A, 0x02, 0x0A,
+            0x84, 0xE1, 0x8E, 0x8F, 0x84, 0x25, 0x20, 0x70, 0xC1, 0x3E, 0x9F, 0x1F, 0x28, 0x9B, 0xE5, 0x4F,
+            0xBC, 0x48, 0x14, 0x57, 0x77, 0x8F, 0x61, 0x60, 0x15, 0xE1, 0x32, 0x7A, 0x02, 0xB1, 0x40, 0xF1,
+            0x50, 0x5E, 0xB3, 0x09, 0x32, 0x6D, 0x68, 0x37, 0x8F, 0x83, 0x74, 0x59, 0x5C, 0x84, 0x9D, 0x84,
+            0xF4, 0xC3, 0x33, 0xEC, 0x44, 0x23, 0x88, 0x51, 0x43, 0xCB, 0x47, 0xBD, 0x71, 0xC5, 0xED, 0xAE,
+            0x9B, 0xE6, 0x9A, 0x2F, 0xFE, 0xCE, 0xB1, 0xBE, 0xC9, 0xDE, 0x24, 0x4F, 0xBE, 0x15, 0x99, 0x2B,
+            0x11, 0xB7, 0x7C, 0x04, 0x0F, 0x12, 0xBD, 0x8F, 0x6A, 0x97, 0x5A, 0x44, 0xA0, 0xF9, 0x0C, 0x29,
+            0xA9, 0xAB, 0xC3, 0xD4, 0xD8, 0x93, 0x92, 0x72, 0x84, 0xC5, 0x87, 0x54, 0xCC, 0xE2, 0x94, 0x52,
+            0x9F, 0x86, 0x14, 0xDC, 0xD2, 0xAB, 0xA9, 0x91, 0x92, 0x5F, 0xED, 0xC4, 0xAE, 0x74, 0xFF, 0xAC,
+            0x6E, 0x33, 0x3B, 0x93, 0xEB, 0x4A, 0xFF, 0x04, 0x79, 0xDA, 0x9A, 0x41, 0x0E, 0x44, 0x50, 0xE0,
+            0xDD, 0x7A, 0xE4, 0xC6, 0xE2, 0x91, 0x09, 0x00, 0x57, 0x5D, 0xA4, 0x01, 0xFC, 0x07, 0x05, 0x9F,
+            0x64, 0x5E, 0x8B, 0x7E, 0x9B, 0xFD, 0xEF, 0x33, 0x94, 0x30, 0x54, 0xFF, 0x84, 0x01, 0x14, 0x93,
+            0xC2, 0x7B, 0x34, 0x29, 0xEA, 0xED, 0xB4, 0xED, 0x53, 0x76, 0x44, 0x1A, 0x77, 0xED, 0x43, 0x85,
+            0x1A, 0xD7, 0x7F, 0x16, 0xF5, 0x41, 0xDF, 0xD2, 0x69, 0xD5, 0x0D, 0x6A, 0x5F, 0x14, 0xFB, 0x0A,
+            0xAB, 0x1C, 0xBB, 0x4C, 0x15, 0x50, 0xBE, 0x97, 0xF7, 0xAB, 0x40, 0x66, 0x19, 0x3C, 0x4C, 0xAA,
+            0x77, 0x3D, 0xAD, 0x38, 0x01, 0x4B, 0xD2, 0x09, 0x2F, 0xA7, 0x55, 0xC8, 0x24, 0xBB, 0x5E, 0x54,
+            0xC4, 0xF3, 0x6F, 0xFD, 0xA9, 0xFC, 0xEA, 0x70, 0xB9, 0xC6, 0xE6, 0x93, 0xE1, 0x48, 0xC1, 0x51,
+        };
+
+        constexpr const u8 XtsVector15Key[] = {
+            0xFF, 0xFE, 0xFD, 0xFC, 0xFB, 0xFA, 0xF9, 0xF8, 0xF7, 0xF6, 0xF5, 0xF4, 0xF3, 0xF2, 0xF1, 0xF0,
+            0xBF, 0xBE, 0xBD, 0xBC, 0xBB, 0xBA, 0xB9, 0xB8, 0xB7, 0xB6, 0xB5, 0xB4, 0xB3, 0xB2, 0xB1, 0xB0,
+        };
+        constexpr const u8 XtsVector15Tweak[] = {
+            0x9A, 0x78, 0x56, 0x34, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        };
+        constexpr const u8 XtsVector15Cipher[] = {
+            0x6C, 0x16, 0x25, 0xDB, 0x46, 0x71, 0x52, 0x2D, 0x3D, 0x75, 0x99, 0x60, 0x1D, 0xE7, 0xCA, 0x09,
+            0xED,
+        };
+
+        /* ==================================================================================================================== */
+        /* AES-GCM (McGrew/Viega GCM specification test cases, as used by NIST CAVP)                                            */
+        /* ==================================================================================================================== */
+
+        constexpr const u8 GcmTestCase1Tag[] = {
+            0x58, 0xE2, 0xFC, 0xCE, 0xFA, 0x7E, 0x30, 0x61, 0x36, 0x7F, 0x1D, 0x57, 0xA4, 0xE7, 0x45, 0x5A,
+        };
+
+        constexpr const u8 GcmTestCase2Cipher[] = {
+            0x03, 0x88, 0xDA, 0xCE, 0x60, 0xB6, 0xA3, 0x92, 0xF3, 0x28, 0xC2, 0xB9, 0x71, 0xB2, 0xFE, 0x78,
+        };
+        constexpr const u8 GcmTestCase2Tag[] = {
+            0xAB, 0x6E, 0x47, 0xD4, 0x2C, 0xEC, 0x13, 0xBD, 0xF5, 0x3A, 0x67, 0xB2, 0x12, 0x57, 0xBD, 0xDF,
+        };
+
+        constexpr const u8 GcmTestCase3Key[] = {
+            0xFE, 0xFF, 0xE9, 0x92, 0x86, 0x65, 0x73, 0x1C, 0x6D, 0x6A, 0x8F, 0x94, 0x67, 0x30, 0x83, 0x08,
+        };
+        constexpr const u8 GcmTestCase3Iv[] = {
+            0xCA, 0xFE, 0xBA, 0xBE, 0xFA, 0xCE, 0xDB, 0xAD, 0xDE, 0xCA, 0xF8, 0x88,
+        };
+        constexpr const u8 GcmTestCase3Plain[] = {
+            0xD9, 0x31, 0x32, 0x25, 0xF8, 0x84, 0x06, 0xE5, 0xA5, 0x59, 0x09, 0xC5, 0xAF, 0xF5, 0x26, 0x9A,
+            0x86, 0xA7, 0xA9, 0x53, 0x15, 0x34, 0xF7, 0xDA, 0x2E, 0x4C, 0x30, 0x3D, 0x8A, 0x31, 0x8A, 0x72,
+            0x1C, 0x3C, 0x0C, 0x95, 0x95, 0x68, 0x09, 0x53, 0x2F, 0xCF, 0x0E, 0x24, 0x49, 0xA6, 0xB5, 0x25,
+            0xB1, 0x6A, 0xED, 0xF5, 0xAA, 0x0D, 0xE6, 0x57, 0xBA, 0x63, 0x7B, 0x39, 0x1A, 0xAF, 0xD2, 0x55,
+        };
+        constexpr const u8 GcmTestCase3Cipher[] = {
+            0x42, 0x83, 0x1E, 0xC2, 0x21, 0x77, 0x74, 0x24, 0x4B, 0x72, 0x21, 0xB7, 0x84, 0xD0, 0xD4, 0x9C,
+            0xE3, 0xAA, 0x21, 0x2F, 0x2C, 0x02, 0xA4, 0xE0, 0x35, 0xC1, 0x7E, 0x23, 0x29, 0xAC, 0xA1, 0x2E,
+            0x21, 0xD5, 0x14, 0xB2, 0x54, 0x66, 0x93, 0x1C, 0x7D, 0x8F, 0x6A, 0x5A, 0xAC, 0x84, 0xAA, 0x05,
+            0x1B, 0xA3, 0x0B, 0x39, 0x6A, 0x0A, 0xAC, 0x97, 0x3D, 0x58, 0xE0, 0x91, 0x47, 0x3F, 0x59, 0x85,
+        };
+        constexpr const u8 GcmTestCase3Tag[] = {
+            0x4D, 0x5C, 0x2A, 0xF3, 0x27, 0xCD, 0x64, 0xA6, 0x2C, 0xF3, 0x5A, 0xBD, 0x2B, 0xA6, 0xFA, 0xB4,
+        };
+
+        constexpr const u8 GcmTestCase4Aad[] = {
+            0xFE, 0xED, 0xFA, 0xCE, 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED, 0xFA, 0xCE, 0xDE, 0xAD, 0xBE, 0xEF,
+            0xAB, 0xAD, 0xDA, 0xD2,
+        };
+        constexpr const u8 GcmTestCase4Tag[] = {
+            0x5B, 0xC9, 0x4F, 0xBC, 0x32, 0x21, 0xA5, 0xDB, 0x94, 0xFA, 0xE9, 0x5A, 0xE7, 0x12, 0x1A, 0x47,
+        };
+
+        constexpr const u8 GcmTestCase5Iv[] = {
+            0xCA, 0xFE, 0xBA, 0xBE, 0xFA, 0xCE, 0xDB, 0xAD,
+        };
+        constexpr const u8 GcmTestCase5Cipher[] = {
+            0x61, 0x35, 0x3B, 0x4C, 0x28, 0x06, 0x93, 0x4A, 0x77, 0x7F, 0xF5, 0x1F, 0xA2, 0x2A, 0x47, 0x55,
+            0x69, 0x9B, 0x2A, 0x71, 0x4F, 0xCD, 0xC6, 0xF8, 0x37, 0x66, 0xE5, 0xF9, 0x7B, 0x6C, 0x74, 0x23,
+            0x73, 0x80, 0x69, 0x00, 0xE4, 0x9F, 0x24, 0xB2, 0x2B, 0x09, 0x75, 0x44, 0xD4, 0x89, 0x6B, 0x42,
+            0x49, 0x89, 0xB5, 0xE1, 0xEB, 0xAC, 0x0F, 0x07, 0xC2, 0x3F, 0x45, 0x98,
+        };
+        constexpr const u8 GcmTestCase5Tag[] = {
+            0x36, 0x12, 0xD2, 0xE7, 0x9E, 0x3B, 0x07, 0x85, 0x56, 0x1B, 0xE1, 0x4A, 0xAC, 0xA2, 0xFC, 0xCB,
+        };
+
+        constexpr const u8 GcmTestCase6Iv[] = {
+            0x93, 0x13, 0x22, 0x5D, 0xF8, 0x84, 0x06, 0xE5, 0x55, 0x90, 0x9C, 0x5A, 0xFF, 0x52, 0x69, 0xAA,
+            0x6A, 0x7A, 0x95, 0x38, 0x53, 0x4F, 0x7D, 0xA1, 0xE4, 0xC3, 0x03, 0xD2, 0xA3, 0x18, 0xA7, 0x28,
+            0xC3, 0xC0, 0xC9, 0x51, 0x56, 0x80, 0x95, 0x39, 0xFC, 0xF0, 0xE2, 0x42, 0x9A, 0x6B, 0x52, 0x54,
+            0x16, 0xAE, 0xDB, 0xF5, 0xA0, 0xDE, 0x6A, 0x57, 0xA6, 0x37, 0xB3, 0x9B,
+        };
+        constexpr const u8 GcmTestCase6Cipher[] = {
+            0x8C, 0xE2, 0x49, 0x98, 0x62, 0x56, 0x15, 0xB6, 0x03, 0xA0, 0x33, 0xAC, 0xA1, 0x3F, 0xB8, 0x94,
+            0xBE, 0x91, 0x12, 0xA5, 0xC3, 0xA2, 0x11, 0xA8, 0xBA, 0x26, 0x2A, 0x3C, 0xCA, 0x7E, 0x2C, 0xA7,
+            0x01, 0xE4, 0xA9, 0xA4, 0xFB, 0xA4, 0x3C, 0x90, 0xCC, 0xDC, 0xB2, 0x81, 0xD4, 0x8C, 0x7C, 0x6F,
+            0xD6, 0x28, 0x75, 0xD2, 0xAC, 0xA4, 0x17, 0x03, 0x4C, 0x34, 0xAE, 0xE5,
+        };
+        constexpr const u8 GcmTestCase6Tag[] = {
+            0x61, 0x9C, 0xC5, 0xAE, 0xFF, 0xFE, 0x0B, 0xFA, 0x46, 0x2A, 0xF4, 0x3C, 0x16, 0x99, 0xD0, 0x50,
+        };
+
+        constexpr const u8 GcmLongMessageTag[] = {
+            0x3B, 0xCF, 0xC4, 0xF9, 0x76, 0xA9, 0xA0, 0x67, 0xF0, 0x52, 0x8A, 0x1D, 0x36, 0xF5, 0x5B, 0x6F,
+        };
+
+        /* ==================================================================================================================== */
+        /* SHA-256 (FIPS 180-2 test vectors)                                                                                    */
+        /* ==================================================================================================================== */
+
+        constexpr const char Sha256Vector448Message[] = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+        constexpr const char Sha256Vector896Message[] = "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu";
+
+        constexpr const u8 Sha256VectorEmptyHash[] = {
+            0xE3, 0xB0, 0xC4, 0x42, 0x98, 0xFC, 0x1C, 0x14, 0x9A, 0xFB, 0xF4, 0xC8, 0x99, 0x6F, 0xB9, 0x24,
+            0x27, 0xAE, 0x41, 0xE4, 0x64, 0x9B, 0x93, 0x4C, 0xA4, 0x95, 0x99, 0x1B, 0x78, 0x52, 0xB8, 0x55,
+        };
+        constexpr const u8 Sha256VectorAbcHash[] = {
+            0xBA, 0x78, 0x16, 0xBF, 0x8F, 0x01, 0xCF, 0xEA, 0x41, 0x41, 0x40, 0xDE, 0x5D, 0xAE, 0x22, 0x23,
+            0xB0, 0x03, 0x61, 0xA3, 0x96, 0x17, 0x7A, 0x9C, 0xB4, 0x10, 0xFF, 0x61, 0xF2, 0x00, 0x15, 0xAD,
+        };
+        constexpr const u8 Sha256Vector448Hash[] = {
+            0x24, 0x8D, 0x6A, 0x61, 0xD2, 0x06, 0x38, 0xB8, 0xE5, 0xC0, 0x26, 0x93, 0x0C, 0x3E, 0x60, 0x39,
+            0xA3, 0x3C, 0xE4, 0x59, 0x64, 0xFF, 0x21, 0x67, 0xF6, 0xEC, 0xED, 0xD4, 0x19, 0xDB, 0x06, 0xC1,
+        };
+        constexpr const u8 Sha256Vector896Hash[] = {
+            0xCF, 0x5B, 0x16, 0xA7, 0x78, 0xAF, 0x83, 0x80, 0x03, 0x6C, 0xE5, 0x9E, 0x7B, 0x04, 0x92, 0x37,
+            0x0B, 0x24, 0x9B, 0x11, 0xE8, 0xF0, 0x7A, 0x51, 0xAF, 0xAC, 0x45, 0x03, 0x7A, 0xFE, 0xE9, 0xD1,
+        };
+        constexpr const u8 Sha256VectorMillionAHash[] = {
+            0xCD, 0xC7, 0x6E, 0x5C, 0x99, 0x14, 0xFB, 0x92, 0x81, 0xA1, 0xC7, 0xE2, 0x84, 0xD7, 0x3E, 0x67,
+            0xF1, 0x80, 0x9A, 0x48, 0xA4, 0x97, 0x20, 0x0E, 0x04, 0x6D, 0x39, 0xCC, 0xC7, 0x11, 0x2C, 0xD0,
+        };
+
+        constexpr size_t Sha256VectorMillionASize = 1'000'000;
+
+        /* One full set of eight avx2 lanes, plus a tail which is hashed serially. */
+        constexpr size_t Sha256TestLaneCount   = 11;
+        constexpr size_t Sha256TestMaxLaneSize = 0x1000;
+
+        constexpr size_t TestChunkSizes[] = { 1, 15, 16, 17, 48, 0x200 };
+
+        alignas(os::MemoryPageSize) constinit u8 g_plain_buffer[4_MB];
+        alignas(os::MemoryPageSize) constinit u8 g_cipher_buffer[4_MB];
+        alignas(os::MemoryPageSize) constinit u8 g_work_buffer[4_MB];
+
+        void GenerateSequentialBytes(u8 *dst, size_t size) {
+            for (size_t i = 0; i < size; ++i) {
+                dst[i] = static_cast<u8>(i);
+            }
+        }
+
+        template<typename Cryptor>
+        void ProcessXts(void *dst, const u8 *key, const void *tweak, const void *src, size_t size, size_t chunk_size) {
+            Cryptor xts;
+            xts.Initialize(key, key + Cryptor::KeySize, Cryptor::KeySize, tweak, Cryptor::IvSize);
+
+            u8 * const dst_end = static_cast<u8 *>(dst) + size;
+            u8 *cur_dst        = static_cast<u8 *>(dst);
+            const u8 *cur_src  = static_cast<const u8 *>(src);
+            size_t remaining   = size;
+            while (remaining > 0) {
+                const size_t cur_size = std::min(remaining, chunk_size);
+                cur_dst   += xts.Update(cur_dst, dst_end - cur_dst, cur_src, cur_size);
+                cur_src   += cur_size;
+                remaining -= cur_size;
+            }
+
+            cur_dst += xts.Finalize(cur_dst, dst_end - cur_dst);
+            AMS_ABORT_UNLESS(cur_dst == dst_end);
+        }
+
+        template<typename Encryptor, typename Decryptor>
+        void TestXtsVector(const char *name, const u8 *key, const u8 *tweak, const u8 *plain, const u8 *cipher, size_t size) {
+            /* Check the vector both in one go and split at awkward boundaries, so that buffering and stealing are exercised. */
+            for (size_t i = 0; i <= util::size(TestChunkSizes); ++i) {
+                const size_t chunk_size = i < util::size(TestChunkSizes) ? TestChunkSizes[i] : size;
+
+                ProcessXts<Encryptor>(g_work_buffer, key, tweak, plain, size, chunk_size);
+                AMS_ABORT_UNLESS(std::memcmp(g_work_buffer, cipher, size) == 0);
+
+                ProcessXts<Decryptor>(g_work_buffer, key, tweak, cipher, size, chunk_size);
+                AMS_ABORT_UNLESS(std::memcmp(g_work_buffer, plain, size) == 0);
+            }
+
+            printf("%s: OK\n", name);
+        }
+
+        void DoXtsTests() {
+            TestXtsVector<crypto::Aes128XtsEncryptor, crypto::Aes128XtsDecryptor>("XTS-AES-128 vector 2", XtsVector2Key, XtsVector2Tweak, XtsVector2Plain, XtsVector2Cipher, sizeof(XtsVector2Cipher));
+            TestXtsVector<crypto::Aes128XtsEncryptor, crypto::Aes128XtsDecryptor>("XTS-AES-128 vector 3", XtsVector3Key, XtsVector2Tweak, XtsVector2Plain, XtsVector3Cipher, sizeof(XtsVector3Cipher));
+
+            /* Vectors 4, 10 and 15 use sequential bytes as plaintext. */
+            GenerateSequentialBytes(g_plain_buffer, sizeof(XtsVector4Cipher));
+
+            constexpr const u8 ZeroTweak[crypto::Aes128XtsEncryptor::IvSize] = {};
+            TestXtsVector<crypto::Aes128XtsEncryptor, crypto::Aes128XtsDecryptor>("XTS-AES-128 vector 4", XtsVector4Key, ZeroTweak, g_plain_buffer, XtsVector4Cipher, sizeof(XtsVector4Cipher));
+            TestXtsVector<crypto::Aes256XtsEncryptor, crypto::Aes256XtsDecryptor>("XTS-AES-256 vector 10", XtsVector10Key, XtsVector10Tweak, g_plain_buffer, XtsVector10Cipher, sizeof(XtsVector10Cipher));
+            TestXtsVector<crypto::Aes128XtsEncryptor, crypto::Aes128XtsDecryptor>("XTS-AES-128 vector 15", XtsVector15Key, XtsVector15Tweak, g_plain_buffer, XtsVector15Cipher, sizeof(XtsVector15Cipher));
+        }
+
+        template<typename F>
+        void ProcessInChunks(const void *src, size_t size, size_t chunk_size, F f) {
+            const u8 *cur_src = static_cast<const u8 *>(src);
+            size_t remaining  = size;
+            while (remaining > 0) {
+                const size_t cur_size = std::min(remaining, chunk_size);
+                f(cur_src, cur_size);
+                cur_src   += cur_size;
+                remaining -= cur_size;
+            }
+        }
+
+        void ProcessGcm(void *dst, u8 *out_mac, bool encrypt, const u8 *key, const u8 *iv, size_t iv_size, const u8 *aad, size_t aad_size, const void *src, size_t size, size_t chunk_size) {
+            crypto::AesEncryptor128 aes;
+            aes.Initialize(key, crypto::AesEncryptor128::KeySize);
+
+            crypto::impl::GcmModeImpl<crypto::AesEncryptor128> gcm;
+            gcm.Initialize(std::addressof(aes));
+            gcm.Reset(iv, iv_size);
+
+            ProcessInChunks(aad, aad_size, chunk_size, [&](const u8 *cur_aad, size_t cur_size) {
+                gcm.UpdateAad(cur_aad, cur_size);
+            });
+
+            u8 * const dst_end = static_cast<u8 *>(dst) + size;
+            u8 *cur_dst        = static_cast<u8 *>(dst);
+            ProcessInChunks(src, size, chunk_size, [&](const u8 *cur_src, size_t cur_size) {
+                if (encrypt) {
+                    cur_dst += gcm.UpdateEncrypt(cur_dst, dst_end - cur_dst, cur_src, cur_size);
+                } else {
+                    cur_dst += gcm.UpdateDecrypt(cur_dst, dst_end - cur_dst, cur_src, cur_size);
+                }
+            });
+            AMS_ABORT_UNLESS(cur_dst == dst_end);
+
+            gcm.GetMac(out_mac, crypto::Aes128GcmEncryptor::MacSize);
+        }
+
+        void TestGcmVector(const char *name, const char *config, const u8 *key, const u8 *iv, size_t iv_size, const u8 *aad, size_t aad_size, const u8 *plain, const u8 *cipher, size_t size, const u8 *tag) {
+            for (size_t i = 0; i <= util::size(TestChunkSizes); ++i) {
+                const size_t chunk_size = i < util::size(TestChunkSizes) ? TestChunkSizes[i] : std::max<size_t>(std::max(size, aad_size), 1);
+
+                /* Encrypt, checking the ciphertext if we have it. */
+                u8 mac[crypto::Aes128GcmEncryptor::MacSize];
+                ProcessGcm(g_cipher_buffer, mac, true, key, iv, iv_size, aad, aad_size, plain, size, chunk_size);
+                AMS_ABORT_UNLESS(cipher == nullptr || std::memcmp(g_cipher_buffer, cipher, size) == 0);
+                AMS_ABORT_UNLESS(std::memcmp(mac, tag, sizeof(mac)) == 0);
+
+                /* Decrypt what we produced. */
+                ProcessGcm(g_work_buffer, mac, false, key, iv, iv_size, aad, aad_size, g_cipher_buffer, size, chunk_size);
+                AMS_ABORT_UNLESS(size == 0 || std::memcmp(g_work_buffer, plain, size) == 0);
+                AMS_ABORT_UNLESS(std::memcmp(mac, tag, sizeof(mac)) == 0);
+            }
+
+            printf("%s (%s): OK\n", name, config);
+        }
+
+        void DoGcmTests(const char *config) {
+            constexpr const u8 ZeroKey[crypto::Aes128GcmEncryptor::KeySize] = {};
+            constexpr const u8 ZeroIv[12] = {};
+            constexpr const u8 ZeroPlain[sizeof(GcmTestCase2Cipher)] = {};
+
+            TestGcmVector("AES-128-GCM test case 1", config, ZeroKey, ZeroIv, sizeof(ZeroIv), nullptr, 0, nullptr, nullptr, 0, GcmTestCase1Tag);
+            TestGcmVector("AES-128-GCM test case 2", config, ZeroKey, ZeroIv, sizeof(ZeroIv), nullptr, 0, ZeroPlain, GcmTestCase2Cipher, sizeof(GcmTestCase2Cipher), GcmTestCase2Tag);
+            TestGcmVector("AES-128-GCM test case 3", config, GcmTestCase3Key, GcmTestCase3Iv, sizeof(GcmTestCase3Iv), nullptr, 0, GcmTestCase3Plain, GcmTestCase3Cipher, sizeof(GcmTestCase3Cipher), GcmTestCase3Tag);
+
+            /* Test case 4 is test case 3 truncated to 60 bytes, with additional data. */
+            TestGcmVector("AES-128-GCM test case 4", config, GcmTestCase3Key, GcmTestCase3Iv, sizeof(GcmTestCase3Iv), GcmTestCase4Aad, sizeof(GcmTestCase4Aad), GcmTestCase3Plain, GcmTestCase3Cipher, 60, GcmTestCase4Tag);
+
+            /* Test cases 5 and 6 are test case 4 with ivs which aren't 96 bits, which must themselves be hashed. */
+            TestGcmVector("AES-128-GCM test case 5", config, GcmTestCase3Key, GcmTestCase5Iv, sizeof(GcmTestCase5Iv), GcmTestCase4Aad, sizeof(GcmTestCase4Aad), GcmTestCase3Plain, GcmTestCase5Cipher, sizeof(GcmTestCase5Cipher), GcmTestCase5Tag);
+            TestGcmVector("AES-128-GCM test case 6", config, GcmTestCase3Key, GcmTestCase6Iv, sizeof(GcmTestCase6Iv), GcmTestCase4Aad, sizeof(GcmTestCase4Aad), GcmTestCase3Plain, GcmTestCase6Cipher, sizeof(GcmTestCase6Cipher), GcmTestCase6Tag);
+
+            /* Check a long, unaligned message, so that the multi-block path and its tail are both used. */
+            constexpr size_t LongMessageSize = 4099;
+            for (size_t i = 0; i < LongMessageSize; ++i) {
+                g_plain_buffer[i] = static_cast<u8>(i * 7 + 3);
+            }
+            TestGcmVector("AES-128-GCM long message", config, GcmTestCase3Key, GcmTestCase3Iv, sizeof(GcmTestCase3Iv), GcmTestCase4Aad, sizeof(GcmTestCase4Aad), g_plain_buffer, nullptr, LongMessageSize, GcmLongMessageTag);
+        }
+
+        void DoGcmTests() {
+            #if defined(ATMOSPHERE_ARCH_X64)
+            {
+                /* Run the vectors through the pclmul path, then through the generic path. */
+                /* NOTE: If the host lacks pclmul, both configurations use the generic path. */
+                DoGcmTests("pclmul");
+
+                crypto::impl::SetAcceleratedGcmEnabledForTest(false);
+                DoGcmTests("generic");
+
+                crypto::impl::SetAcceleratedGcmEnabledForTest(true);
+            }
+
+            /* Check that both paths agree on sizes around the block boundaries, for both the additional data and the message. */
+            {
+                constexpr size_t AadSizes[]     = { 0, 1, 15, 16, 17, 20, 33, 69 };
+                constexpr size_t MessageSizes[] = { 0, 1, 15, 16, 17, 31, 60, 63, 64, 65, 127, 255, 257, 1000 };
+                constexpr size_t AadOffset      = 1_MB;
+
+                for (size_t i = 0; i < AadOffset + 0x100; ++i) {
+                    g_plain_buffer[i] = static_cast<u8>(i * 13 + (i >> 8));
+                }
+
+                for (const size_t aad_size : AadSizes) {
+                    for (const size_t size : MessageSizes) {
+                        for (const size_t chunk_size : { static_cast<size_t>(17), std::max<size_t>(std::max(size, aad_size), 1) }) {
+                            u8 accelerated_mac[crypto::Aes128GcmEncryptor::MacSize];
+                            u8 generic_mac[crypto::Aes128GcmEncryptor::MacSize];
+
+                            ProcessGcm(g_cipher_buffer, accelerated_mac, true, GcmTestCase3Key, GcmTestCase3Iv, sizeof(GcmTestCase3Iv), g_plain_buffer + AadOffset, aad_size, g_plain_buffer, size, chunk_size);
+
+                            crypto::impl::SetAcceleratedGcmEnabledForTest(false);
+                            ProcessGcm(g_work_buffer, generic_mac, true, GcmTestCase3Key, GcmTestCase3Iv, sizeof(GcmTestCase3Iv), g_plain_buffer + AadOffset, aad_size, g_plain_buffer, size, chunk_size);
+                            crypto::impl::SetAcceleratedGcmEnabledForTest(true);
+
+                            AMS_ABORT_UNLESS(std::memcmp(g_cipher_buffer, g_work_buffer, size) == 0);
+                            AMS_ABORT_UNLESS(std::memcmp(accelerated_mac, generic_mac, sizeof(generic_mac)) == 0);
+                        }
+                    }
+                }
+
+                printf("AES-128-GCM pclmul/generic agreement: OK\n");
+            }
+            #else
+            {
+                DoGcmTests("default");
+            }
+            #endif
+        }
+
+        void GenerateSha256InChunks(u8 *dst, const void *prefix, size_t prefix_size, const void *src, size_t size, size_t chunk_size) {
+            crypto::Sha256Generator sha;
+            sha.Initialize();
+            sha.Update(prefix, prefix_size);
+            ProcessInChunks(src, size, chunk_size, [&](const u8 *cur_src, size_t cur_size) {
+                sha.Update(cur_src, cur_size);
+            });
+            sha.GetHash(dst, crypto::Sha256Generator::HashSize);
+        }
+
+        void TestSha256Vector(const char *name, const char *config, const void *message, size_t size, const u8 *hash) {
+            constexpr size_t HashSize = crypto::Sha256Generator::HashSize;
+            const u8 *message8 = static_cast<const u8 *>(message);
+
+            /* Check a single buffer, both in one go and in chunks. */
+            u8 out[HashSize];
+            crypto::GenerateSha256(out, sizeof(out), message, size);
+            AMS_ABORT_UNLESS(std::memcmp(out, hash, HashSize) == 0);
+            for (const size_t chunk_size : TestChunkSizes) {
+                GenerateSha256InChunks(out, nullptr, 0, message, size, chunk_size);
+                AMS_ABORT_UNLESS(std::memcmp(out, hash, HashSize) == 0);
+            }
+
+            /* Check multiple buffers, hashing the tail of the message in every lane behind the rest of it as the prefix. */
+            /* Odd lanes get a tail with one byte changed, so that a result written to the wrong lane is caught. */
+            for (const size_t tail_size : { size, size / 2, std::min<size_t>(size, 0x41) }) {
+                if (tail_size > Sha256TestMaxLaneSize) {
+                    continue;
+                }
+
+                const size_t prefix_size = size - tail_size;
+                for (size_t lane = 0; lane < Sha256TestLaneCount; ++lane) {
+                    u8 *lane_data = g_work_buffer + lane * tail_size;
+                    std::memcpy(lane_data, message8 + prefix_size, tail_size);
+                    if ((lane % 2) != 0 && tail_size > 0) {
+                        lane_data[lane % tail_size] ^= 0x5A;
+                    }
+                }
+
+                crypto::GenerateSha256Multiple(g_cipher_buffer, HashSize * Sha256TestLaneCount, message, prefix_size, g_work_buffer, tail_size, Sha256TestLaneCount);
+
+                for (size_t lane = 0; lane < Sha256TestLaneCount; ++lane) {
+                    const u8 *lane_hash = g_cipher_buffer + lane * HashSize;
+                    if ((lane % 2) == 0 || tail_size == 0) {
+                        AMS_ABORT_UNLESS(std::memcmp(lane_hash, hash, HashSize) == 0);
+                    } else {
+                        GenerateSha256InChunks(out, message, prefix_size, g_work_buffer + lane * tail_size, tail_size, tail_size);
+                        AMS_ABORT_UNLESS(std::memcmp(lane_hash, out, HashSize) == 0);
+                        AMS_ABORT_UNLESS(std::memcmp(lane_hash, hash, HashSize) != 0);
+                    }
+                }
+            }
+
+            printf("SHA-256 %s (%s): OK\n", name, config);
+        }
+
+        void DoSha256Tests(const char *config) {
+            std::memset(g_plain_buffer, 'a', Sha256VectorMillionASize);
+
+            TestSha256Vector("empty message",   config, "",                     0,                                  Sha256VectorEmptyHash);
+            TestSha256Vector("\"abc\"",         config, "abc",                  3,                                  Sha256VectorAbcHash);
+            TestSha256Vector("448-bit message", config, Sha256Vector448Message, std::strlen(Sha256Vector448Message), Sha256Vector448Hash);
+            TestSha256Vector("896-bit message", config, Sha256Vector896Message, std::strlen(Sha256Vector896Message), Sha256Vector896Hash);
+            TestSha256Vector("1M x \"a\"",      config, g_plain_buffer,         Sha256VectorMillionASize,           Sha256VectorMillionAHash);
+        }
+
+        void DoSha256Tests() {
+            #if defined(ATMOSPHERE_ARCH_X64)
+            {
+                /* Run the vectors through sha-ni, then through the avx2 lanes and the scalar fallback. */
+                /* NOTE: Extensions the host lacks stay disabled, in which case the configurations overlap. */
+                DoSha256Tests("sha-ni");
+
+                crypto::impl::SetSha256ExtensionsEnabledForTest(false, true);
+                DoSha256Tests("avx2");
+
+                crypto::impl::SetSha256ExtensionsEnabledForTest(false, false);
+                DoSha256Tests("generic");
+
+                crypto::impl::SetSha256ExtensionsEnabledForTest(true, true);
+            }
+            #else
+            {
+                DoSha256Tests("default");
+            }
+            #endif
+        }
+
+        /* ==================================================================================================================== */
+        /* Benchmarks                                                                                                           */
+        /* ==================================================================================================================== */
+
+        constexpr size_t BenchmarkBufferSize = sizeof(g_plain_buffer);
+        constexpr int    BenchmarkIterations = 16;
+
+        void PrintThroughput(const char *name, TimeSpan elapsed) {
+            const s64 total_size = static_cast<s64>(BenchmarkBufferSize) * BenchmarkIterations;
+            const s64 us         = std::max<s64>(elapsed.GetMicroSeconds(), 1);
+            printf("%-40s %6" PRId64 " MB/s\n", name, total_size * 1'000'000 / us / static_cast<s64>(1_MB));
+        }
+
+        template<typename BlockCipher, typename TweakCipher, bool Decrypt, bool Accelerated>
+        void BenchmarkXts(const char *name) {
+            /* Set up the ciphers. */
+            constexpr u8 Key[BlockCipher::KeySize * 2] = {};
+            BlockCipher cipher;
+            TweakCipher tweak_cipher;
+            cipher.Initialize(Key, BlockCipher::KeySize);
+            tweak_cipher.Initialize(Key + BlockCipher::KeySize, BlockCipher::KeySize);
+
+            /* Process the buffer as NCA-sized sectors, each with its own tweak, as AesXtsStorage does. */
+            constexpr size_t SectorSize = 0x200;
+            u8 tweak[crypto::impl::XtsModeImpl::IvSize] = {};
+
+            const auto start = os::GetSystemTick();
+            for (int i = 0; i < BenchmarkIterations; ++i) {
+                for (size_t offset = 0; offset < BenchmarkBufferSize; offset += SectorSize) {
+                    util::StoreBigEndian(reinterpret_cast<u64 *>(tweak + sizeof(u64)), static_cast<u64>(offset / SectorSize));
+
+                    crypto::impl::XtsModeImpl xts;
+                    if constexpr (Decrypt) {
+                        xts.InitializeDecryption(std::addressof(cipher), std::addressof(tweak_cipher), tweak, sizeof(tweak));
+                    } else {
+                        xts.InitializeEncryption(std::addressof(cipher), std::addressof(tweak_cipher), tweak, sizeof(tweak));
+                    }
+
+                    size_t processed;
+                    if constexpr (Accelerated) {
+                        processed = xts.Update<BlockCipher>(g_cipher_buffer + offset, SectorSize, g_plain_buffer + offset, SectorSize);
+                    } else {
+                        processed = xts.UpdateGeneric(g_cipher_buffer + offset, SectorSize, g_plain_buffer + offset, SectorSize);
+                    }
+
+                    if constexpr (Decrypt) {
+                        processed += xts.FinalizeDecryption(g_cipher_buffer + offset + processed, SectorSize - processed);
+                    } else {
+                        processed += xts.FinalizeEncryption(g_cipher_buffer + offset + processed, SectorSize - processed);
+                    }
+                    AMS_ABORT_UNLESS(processed == SectorSize);
+                }
+            }
+            const auto elapsed = (os::GetSystemTick() - start).ToTimeSpan();
+
+            PrintThroughput(name, elapsed);
+        }
+
+        void DoXtsBenchmarks() {
+            BenchmarkXts<crypto::AesEncryptor128, crypto::AesEncryptor128, false, false>("XTS-AES-128 encrypt (generic)");
+            BenchmarkXts<crypto::AesEncryptor128, crypto::AesEncryptor128, false, true >("XTS-AES-128 encrypt");
+            BenchmarkXts<crypto::AesDecryptor128, crypto::AesEncryptor128, true,  false>("XTS-AES-128 decrypt (generic)");
+            BenchmarkXts<crypto::AesDecryptor128, crypto::AesEncryptor128, true,  true >("XTS-AES-128 decrypt");
+            BenchmarkXts<crypto::AesEncryptor256, crypto::AesEncryptor256, false, false>("XTS-AES-256 encrypt (generic)");
+            BenchmarkXts<crypto::AesEncryptor256, crypto::AesEncryptor256, false, true >("XTS-AES-256 encrypt");
+            BenchmarkXts<crypto::AesDecryptor256, crypto::AesEncryptor256, true,  false>("XTS-AES-256 decrypt (generic)");
+            BenchmarkXts<crypto::AesDecryptor256, crypto::AesEncryptor256, true,  true >("XTS-AES-256 decrypt");
+        }
+
+        template<bool Encrypt>
+        void BenchmarkGcm(const char *name) {
+            constexpr u8 Key[crypto::AesEncryptor128::KeySize] = {};
+            constexpr u8 Iv[12] = {};
+
+            u8 mac[crypto::Aes128GcmEncryptor::MacSize];
+            const auto start = os::GetSystemTick();
+            for (int i = 0; i < BenchmarkIterations; ++i) {
+                ProcessGcm(g_cipher_buffer, mac, Encrypt, Key, Iv, sizeof(Iv), nullptr, 0, g_plain_buffer, BenchmarkBufferSize, BenchmarkBufferSize);
+            }
+            const auto elapsed = (os::GetSystemTick() - start).ToTimeSpan();
+
+            PrintThroughput(name, elapsed);
+        }
+
+        void DoGcmBenchmarks() {
+            BenchmarkGcm<true>("AES-128-GCM encrypt");
+            BenchmarkGcm<false>("AES-128-GCM decrypt");
+        }
+
+    }
+
+    void Main() {
+        printf("Doing crypto tests!\n");
+        DoXtsTests();
+        DoGcmTests();
+        DoSha256Tests();
+
+        printf("Doing crypto benchmarks!\n");
+        DoXtsBenchmarks();
+        DoGcmBenchmarks();
+
+        printf("All tests completed!\n");
+    }
+
+}
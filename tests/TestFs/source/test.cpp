@@ -54,6 +54,25 @@ namespace ams {
         })
 
         u8 g_buffer[64_KB];
+        u8 g_read_buffer[64_KB];
+        u8 g_file_data_cache_buffer[160_KB];
+
+        bool CheckFilePattern(const void *data, s64 offset, size_t size, u8 key) {
+            const u8 *bytes = static_cast<const u8 *>(data);
+            for (size_t i = 0; i < size; ++i) {
+                if (bytes[i] != (static_cast<u8>(offset + i) ^ key)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void FillFilePattern(void *dst, s64 offset, size_t size, u8 key) {
+            u8 *bytes = static_cast<u8 *>(dst);
+            for (size_t i = 0; i < size; ++i) {
+                bytes[i] = static_cast<u8>(offset + i) ^ key;
+            }
+        }
 
         void DoFsTests() {
             /* Declare buffer to hold any work paths we have. */
@@ -847,12 +866,296 @@ namespace ams {
                 }
             }
 
+            /* ==================================================================================================================== */
+            /* Read Batch                                                                                                           */
+            /* ==================================================================================================================== */
+            {
+                /* Create a file whose size isn't block aligned. */
+                constexpr size_t BatchFileSize = 60_KB + 0x123;
+                for (size_t i = 0; i < BatchFileSize; ++i) {
+                    g_buffer[i] = static_cast<u8>(i * 7 + (i >> 8));
+                }
+
+                TEST_R_TRY(fs::CreateFile(FORMAT_PATH("./test_dir/batch.bin"), BatchFileSize));
+                TEST_R_TRY(fs::OpenFile(std::addressof(file), FORMAT_PATH("./test_dir/batch.bin"), fs::OpenMode_Write));
+                TEST_R_TRY(fs::WriteFile(file, 0, g_buffer, BatchFileSize, fs::WriteOption::Flush));
+                fs::CloseFile(file);
+
+                /* Batched reads aren't exposed through the fs api, so open the file through a local file system directly. */
+                fs::Path root_path;
+                TEST_R_TRY(root_path.InitializeAsEmpty());
+
+                fssystem::LocalFileSystem local_fs;
+                TEST_R_TRY(local_fs.Initialize(root_path, fssystem::PathCaseSensitiveMode_CaseSensitive));
+
+                fs::PathFlags path_flags;
+                path_flags.AllowWindowsPath();
+
+                fs::Path file_path;
+                TEST_R_TRY(file_path.Initialize(FORMAT_PATH("./test_dir/batch.bin")));
+                TEST_R_TRY(file_path.Normalize(path_flags));
+
+                std::unique_ptr<fs::fsa::IFile> batch_file;
+                TEST_R_TRY(local_fs.OpenFile(std::addressof(batch_file), file_path, fs::OpenMode_Read));
+
+                /* Scattered, out of order requests; the third and fourth are contiguous, and the last ends exactly at the end of the file. */
+                const fs::ReadRequest requests[] = {
+                    { 0x8000,                g_read_buffer + 0x0000, 0x1000 },
+                    { 0x10,                  g_read_buffer + 0x1000, 0x33   },
+                    { 0x2000,                g_read_buffer + 0x1040, 0x200  },
+                    { 0x2200,                g_read_buffer + 0x1240, 0x1800 },
+                    { 0x5000,                g_read_buffer + 0x2A40, 0      },
+                    { BatchFileSize - 0x100, g_read_buffer + 0x2A40, 0x100  },
+                };
+
+                /* A request which runs past the end of the file can't be satisfied in full. */
+                const fs::ReadRequest short_requests[] = {
+                    { 0,                    g_read_buffer + 0x0000, 0x100 },
+                    { BatchFileSize - 0x80, g_read_buffer + 0x0100, 0x100 },
+                };
+
+                /* Check both io_uring (where the kernel supports it) and the preadv fallback. */
+                for (const bool use_io_uring : { true, false }) {
+                    fssystem::SetLocalFileIoUringEnabledForTest(use_io_uring);
+                    ON_SCOPE_EXIT { fssystem::SetLocalFileIoUringEnabledForTest(true); };
+
+                    std::memset(g_read_buffer, 0xCC, sizeof(g_read_buffer));
+                    TEST_R_TRY(batch_file->ReadBatch(requests, util::size(requests)));
+                    for (const auto &request : requests) {
+                        AMS_ABORT_UNLESS(std::memcmp(request.buffer, g_buffer + request.offset, request.size) == 0);
+                    }
+
+                    /* A single request always takes the synchronous path. */
+                    std::memset(g_read_buffer, 0xCC, sizeof(g_read_buffer));
+                    TEST_R_TRY(batch_file->ReadBatch(requests, 1));
+                    AMS_ABORT_UNLESS(std::memcmp(requests[0].buffer, g_buffer + requests[0].offset, requests[0].size) == 0);
+
+                    TEST_R_EXPECT(batch_file->ReadBatch(short_requests, util::size(short_requests)), fs::ResultOutOfRange);
+                }
+
+                /* Read past the end through a file storage -> fs::ResultOutOfRange */
+                fs::FileStorage file_storage(std::move(batch_file));
+                TEST_R_EXPECT(file_storage.ReadBatch(short_requests, util::size(short_requests)), fs::ResultOutOfRange);
+            }
+
+            /* ==================================================================================================================== */
+            /* File Data Cache                                                                                                      */
+            /* ==================================================================================================================== */
+            {
+                /* NOTE: This must match the cache's page size. */
+                constexpr size_t CachePageSize = 16_KB;
+                constexpr size_t CacheFileSize = 2 * CachePageSize + 0x800;
+
+                constexpr u8 OriginalKey = 0x00;
+                constexpr u8 HostKey     = 0xFF;
+                constexpr u8 WriteKey    = 0x55;
+                constexpr u8 AppendKey   = 0x33;
+                constexpr u8 UnmountKey  = 0x77;
+
+                fs::EnableGlobalFileDataCache(g_file_data_cache_buffer, sizeof(g_file_data_cache_buffer));
+                ON_SCOPE_EXIT { fs::DisableGlobalFileDataCache(); };
+
+                /* Writes through the host path bypass the cache, so changes made there are only seen once the cache drops its pages. */
+                auto WriteThroughHost = [&] (s64 offset, size_t size, u8 key) -> Result {
+                    fs::FileHandle host_file;
+                    R_TRY(fs::OpenFile(std::addressof(host_file), FORMAT_PATH2("./test_dir/cached.bin"), fs::OpenMode_Write));
+                    ON_SCOPE_EXIT { fs::CloseFile(host_file); };
+
+                    FillFilePattern(g_buffer, offset, size, key);
+                    R_RETURN(fs::WriteFile(host_file, offset, g_buffer, size, fs::WriteOption::Flush));
+                };
+
+                /* Mount the test directory with data caching enabled. */
+                auto MountCached = [&] () -> Result {
+                    fs::PathFlags path_flags;
+                    path_flags.AllowWindowsPath();
+
+                    fs::Path root_path;
+                    R_TRY(root_path.Initialize(FORMAT_PATH2("./test_dir/")));
+                    R_TRY(root_path.Normalize(path_flags));
+
+                    auto local_fs = std::make_unique<fssystem::LocalFileSystem>();
+                    AMS_ABORT_UNLESS(local_fs != nullptr);
+                    R_TRY(local_fs->Initialize(root_path, fssystem::PathCaseSensitiveMode_CaseSensitive));
+
+                    R_RETURN(fs::fsa::Register("fdcache", std::move(local_fs), nullptr, true, false, false));
+                };
+
+                TEST_R_TRY(fs::CreateFile(FORMAT_PATH("./test_dir/cached.bin"), CacheFileSize));
+                TEST_R_TRY(WriteThroughHost(0, CacheFileSize, OriginalKey));
+                TEST_R_TRY(MountCached());
+
+                fs::FileHandle cached_file;
+                TEST_R_TRY(fs::OpenFile(std::addressof(cached_file), "fdcache:/cached.bin", fs::OpenMode_ReadWrite | fs::OpenMode_AllowAppend));
+
+                /* Populate the cache with the first two pages. */
+                size_t read_size;
+                TEST_R_TRY(fs::ReadFile(std::addressof(read_size), cached_file, 0x100, g_read_buffer, 0x100));
+                AMS_ABORT_UNLESS(read_size == 0x100 && CheckFilePattern(g_read_buffer, 0x100, 0x100, OriginalKey));
+                TEST_R_TRY(fs::ReadFile(std::addressof(read_size), cached_file, CachePageSize + 0x100, g_read_buffer, 0x100));
+                AMS_ABORT_UNLESS(read_size == 0x100 && CheckFilePattern(g_read_buffer, CachePageSize + 0x100, 0x100, OriginalKey));
+
+                /* Change the whole file behind the cache's back; cache hits still return the data we read before. */
+                TEST_R_TRY(WriteThroughHost(0, CacheFileSize, HostKey));
+                TEST_R_TRY(fs::ReadFile(std::addressof(read_size), cached_file, 0x100, g_read_buffer, 0x100));
+                AMS_ABORT_UNLESS(read_size == 0x100 && CheckFilePattern(g_read_buffer, 0x100, 0x100, OriginalKey));
+
+                /* A write through the cached mount invalidates the page it overlaps, but not the others. */
+                FillFilePattern(g_buffer, 0x180, 0x10, WriteKey);
+                TEST_R_TRY(fs::WriteFile(cached_file, 0x180, g_buffer, 0x10, fs::WriteOption::Flush));
+
+                TEST_R_TRY(fs::ReadFile(std::addressof(read_size), cached_file, 0x100, g_read_buffer, 0x100));
+                AMS_ABORT_UNLESS(read_size == 0x100);
+                AMS_ABORT_UNLESS(CheckFilePattern(g_read_buffer + 0x00, 0x100, 0x80, HostKey));
+                AMS_ABORT_UNLESS(CheckFilePattern(g_read_buffer + 0x80, 0x180, 0x10, WriteKey));
+                AMS_ABORT_UNLESS(CheckFilePattern(g_read_buffer + 0x90, 0x190, 0x70, HostKey));
+
+                TEST_R_TRY(fs::ReadFile(std::addressof(read_size), cached_file, CachePageSize + 0x100, g_read_buffer, 0x100));
+                AMS_ABORT_UNLESS(read_size == 0x100 && CheckFilePattern(g_read_buffer, CachePageSize + 0x100, 0x100, OriginalKey));
+
+                /* Cache the short page at the end of the file. */
+                TEST_R_TRY(fs::ReadFile(std::addressof(read_size), cached_file, CacheFileSize - 0x10, g_read_buffer, 0x20));
+                AMS_ABORT_UNLESS(read_size == 0x10 && CheckFilePattern(g_read_buffer, CacheFileSize - 0x10, 0x10, HostKey));
+
+                /* After an append, a read over the old end of file sees the new data. */
+                FillFilePattern(g_buffer, CacheFileSize, 0x100, AppendKey);
+                TEST_R_TRY(fs::WriteFile(cached_file, CacheFileSize, g_buffer, 0x100, fs::WriteOption::Flush));
+
+                s64 file_size;
+                TEST_R_TRY(fs::GetFileSize(std::addressof(file_size), cached_file));
+                AMS_ABORT_UNLESS(file_size == static_cast<s64>(CacheFileSize + 0x100));
+
+                TEST_R_TRY(fs::ReadFile(std::addressof(read_size), cached_file, CacheFileSize - 0x10, g_read_buffer, 0x20));
+                AMS_ABORT_UNLESS(read_size == 0x20);
+                AMS_ABORT_UNLESS(CheckFilePattern(g_read_buffer + 0x00, CacheFileSize - 0x10, 0x10, HostKey));
+                AMS_ABORT_UNLESS(CheckFilePattern(g_read_buffer + 0x10, CacheFileSize,        0x10, AppendKey));
+
+                fs::CloseFile(cached_file);
+
+                /* Unmounting purges the mount's pages. */
+                /* NOTE: The new mount's accessor is usually allocated where the old one was, so a stale page would be found if the purge were missed. */
+                TEST_R_TRY(WriteThroughHost(CachePageSize, CachePageSize, UnmountKey));
+                fs::Unmount("fdcache");
+                TEST_R_TRY(MountCached());
+                ON_SCOPE_EXIT { fs::Unmount("fdcache"); };
+
+                TEST_R_TRY(fs::OpenFile(std::addressof(cached_file), "fdcache:/cached.bin", fs::OpenMode_Read));
+                ON_SCOPE_EXIT { fs::CloseFile(cached_file); };
+
+                TEST_R_TRY(fs::ReadFile(std::addressof(read_size), cached_file, CachePageSize + 0x100, g_read_buffer, 0x100));
+                AMS_ABORT_UNLESS(read_size == 0x100 && CheckFilePattern(g_read_buffer, CachePageSize + 0x100, 0x100, UnmountKey));
+            }
+
             /* ==================================================================================================================== */
             /* Cleanup                                                                                                              */
             /* ==================================================================================================================== */
             TEST_R_TRY(fs::DeleteDirectoryRecursively(FORMAT_PATH("./test_dir/")));
         }
 
+        /* ==================================================================================================================== */
+        /* Binary Access Log                                                                                                    */
+        /* ==================================================================================================================== */
+
+        /* NOTE: These mirror the batch format read by utilities/fs_access_log_decoder.py. */
+        struct AccessLogBatchHeader {
+            u32 magic;
+            u16 version;
+            u16 name_count;
+            u32 record_count;
+            u32 dropped_count;
+            s64 tick_frequency;
+        };
+        static_assert(sizeof(AccessLogBatchHeader) == 0x18);
+
+        struct AccessLogRecord {
+            s64 start_tick;
+            s64 end_tick;
+            u64 handle;
+            s64 offset;
+            u64 size;
+            u32 result;
+            u8 function_id;
+            u8 priority_id;
+            u8 flags;
+            u8 reserved;
+        };
+        static_assert(sizeof(AccessLogRecord) == 0x30);
+
+        struct AccessLogNameEntry {
+            u16 id;
+            char name[62];
+        };
+        static_assert(sizeof(AccessLogNameEntry) == 0x40);
+
+        constexpr u32    AccessLogBatchMagic     = util::FourCC<'F','S','B','L'>::Code;
+        constexpr size_t AccessLogRecordCountMax = 16;
+        constexpr size_t AccessLogNameCountMax   = 0xFF;
+
+        AccessLogRecord g_access_log_records[AccessLogRecordCountMax];
+        char g_access_log_names[AccessLogNameCountMax][sizeof(AccessLogNameEntry::name)];
+        std::atomic<size_t> g_access_log_record_count;
+
+        void CaptureAccessLogBatch(const void *batch, size_t size) {
+            const u8 *data = static_cast<const u8 *>(batch);
+
+            AccessLogBatchHeader header;
+            std::memcpy(std::addressof(header), data, sizeof(header));
+            AMS_ABORT_UNLESS(header.magic == AccessLogBatchMagic);
+            AMS_ABORT_UNLESS(size == sizeof(header) + header.record_count * sizeof(AccessLogRecord) + header.name_count * sizeof(AccessLogNameEntry));
+
+            /* Names are only sent in the first batch which uses them. */
+            const u8 *names = data + sizeof(header) + header.record_count * sizeof(AccessLogRecord);
+            for (size_t i = 0; i < header.name_count; ++i) {
+                AccessLogNameEntry entry;
+                std::memcpy(std::addressof(entry), names + i * sizeof(entry), sizeof(entry));
+                AMS_ABORT_UNLESS(entry.id < AccessLogNameCountMax);
+                std::memcpy(g_access_log_names[entry.id], entry.name, sizeof(entry.name));
+            }
+
+            size_t record_count = g_access_log_record_count.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < header.record_count && record_count < AccessLogRecordCountMax; ++i) {
+                std::memcpy(std::addressof(g_access_log_records[record_count++]), data + sizeof(header) + i * sizeof(AccessLogRecord), sizeof(AccessLogRecord));
+            }
+            g_access_log_record_count.store(record_count, std::memory_order_release);
+        }
+
+        void OutputAccessLogWithPriorityRaw(fs::PriorityRaw priority, s64 offset) {
+            /* NOTE: Priorities without names are formatted into an IdString on OutputAccessLog's stack, so every call here passes the same buffer. */
+            const auto tick = os::GetSystemTick();
+            fs::impl::OutputAccessLog(ResultSuccess(), priority, tick, tick, "AccessLogTest", nullptr, AMS_FS_IMPL_ACCESS_LOG_FORMAT_OFFSET_AND_SIZE, offset, static_cast<size_t>(0x10));
+        }
+
+        void DoAccessLogTests() {
+            fs::SetLocalAccessLogBinaryOutputForTest(CaptureAccessLogBatch);
+
+            /* Log two unnamed priorities through the same buffer, then a named one. */
+            fs::SetLocalAccessLogBinaryMode(true);
+            OutputAccessLogWithPriorityRaw(static_cast<fs::PriorityRaw>(7), 0x1000);
+            OutputAccessLogWithPriorityRaw(static_cast<fs::PriorityRaw>(8), 0x2000);
+            OutputAccessLogWithPriorityRaw(fs::PriorityRaw_Normal, 0x3000);
+
+            /* Disabling binary mode has the drainer flush promptly. */
+            fs::SetLocalAccessLogBinaryMode(false);
+            for (int i = 0; i < 100 && g_access_log_record_count.load(std::memory_order_acquire) < 3; ++i) {
+                os::SleepThread(TimeSpan::FromMilliSeconds(10));
+            }
+            AMS_ABORT_UNLESS(g_access_log_record_count.load(std::memory_order_acquire) == 3);
+
+            /* Each record must decode to the priority it was logged with. */
+            constexpr const char *ExpectedPriorities[] = { "7", "8", "Normal" };
+            for (size_t i = 0; i < util::size(ExpectedPriorities); ++i) {
+                const auto &record = g_access_log_records[i];
+                AMS_ABORT_UNLESS(record.offset == static_cast<s64>(0x1000 * (i + 1)));
+                AMS_ABORT_UNLESS(record.size == 0x10);
+                AMS_ABORT_UNLESS(std::strcmp(g_access_log_names[record.function_id], "AccessLogTest") == 0);
+                AMS_ABORT_UNLESS(std::strcmp(g_access_log_names[record.priority_id], ExpectedPriorities[i]) == 0);
+            }
+            AMS_ABORT_UNLESS(g_access_log_records[0].function_id == g_access_log_records[1].function_id);
+            AMS_ABORT_UNLESS(g_access_log_records[0].priority_id != g_access_log_records[1].priority_id);
+
+            printf("Binary access log: OK\n");
+        }
+
     }
 
 
@@ -861,6 +1164,7 @@ namespace ams {
 
         printf("Doing FS test!\n");
         DoFsTests();
+        DoAccessLogTests();
         printf("All tests completed!\n");
     }
 
@@ -0,0 +1,920 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+
+namespace ams {
+
+    namespace {
+
+        #define TEST_R_EXPECT(__EXPR__, __EXPECTED__)                                                                                                                        \
+        ({                                                                                                                                                                   \
+            const Result __test_result = (__EXPR__);                                                                                                                         \
+            if (!(__EXPECTED__ ::Includes(__test_result))) {                                                                                                                 \
+                printf("Unexpected result: %s gave 0x%08x (2%03d-%04d)\n", # __EXPR__, __test_result.GetValue(), __test_result.GetModule(), __test_result.GetDescription()); \
+                AMS_ABORT("Test failed");                                                                                                                                    \
+            }                                                                                                                                                                \
+            __test_result;                                                                                                                                                   \
+        })
+
+        #define TEST_R_TRY(__EXPR__)                                                                                                                                         \
+        ({                                                                                                                                                                   \
+            const Result __test_result = (__EXPR__);                                                                                                                         \
+            if (R_FAILED(__test_result)) {                                                                                                                                   \
+                printf("Unexpected result: %s gave 0x%08x (2%03d-%04d)\n", # __EXPR__, __test_result.GetValue(), __test_result.GetModule(), __test_result.GetDescription()); \
+                AMS_ABORT("Test failed");                                                                                                                                    \
+            }                                                                                                                                                                \
+            __test_result;                                                                                                                                                   \
+        })
+
+        alignas(os::MemoryPageSize) constinit u8 g_heap_buffer[8_MB];
+        alignas(os::MemoryPageSize) constinit u8 g_storage_buffer[2_MB];
+
+        mem::StandardAllocator g_allocator(g_heap_buffer, sizeof(g_heap_buffer));
+        sf::StandardAllocatorMemoryResource g_memory_resource(std::addressof(g_allocator));
+
+        /* ==================================================================================================================== */
+        /* BucketTree                                                                                                           */
+        /* ==================================================================================================================== */
+
+        struct BucketTreeTestEntry {
+            s64 offset;
+            s64 value;
+        };
+        static_assert(util::is_pod<BucketTreeTestEntry>::value);
+
+        constexpr size_t BucketTreeTestNodeSize = 1_KB;
+
+        /* With 1KB nodes, an entry set holds 63 entries and a node holds 126 offsets, so 7938 entries is the most an L1 node can address directly. */
+        constexpr s32 BucketTreeTestEntryCounts[] = { 1, 2, 62, 63, 64, 126 * 63, 126 * 63 + 1, 20000 };
+
+        constexpr s64 GetBucketTreeTestEntryOffset(s32 index) {
+            /* Use irregular gaps, so that a search can't succeed by accident. */
+            return static_cast<s64>(index) * 0x100 + (static_cast<s64>(index) * index) % 0xFF;
+        }
+
+        void VerifyBucketTree(fssystem::BucketTree &tree, s32 entry_count, s64 end_offset) {
+            /* Check the offsets. */
+            fssystem::BucketTree::Offsets offsets;
+            TEST_R_TRY(tree.GetOffsets(std::addressof(offsets)));
+            AMS_ABORT_UNLESS(offsets.start_offset == 0);
+            AMS_ABORT_UNLESS(offsets.end_offset   == end_offset);
+
+            /* Check that every entry can be found, both at its start and at its last byte. */
+            for (s32 i = 0; i < entry_count; ++i) {
+                const s64 start = GetBucketTreeTestEntryOffset(i);
+                const s64 last  = (i + 1 < entry_count ? GetBucketTreeTestEntryOffset(i + 1) : end_offset) - 1;
+
+                for (const s64 offset : { start, (start + last) / 2, last }) {
+                    fssystem::BucketTree::Visitor visitor;
+                    TEST_R_TRY(tree.Find(std::addressof(visitor), offset));
+
+                    const auto *entry = visitor.Get<BucketTreeTestEntry>();
+                    AMS_ABORT_UNLESS(entry->offset == start);
+                    AMS_ABORT_UNLESS(entry->value  == i);
+                }
+            }
+
+            /* Check that we can't find anything at or past the end. */
+            {
+                fssystem::BucketTree::Visitor visitor;
+                TEST_R_EXPECT(tree.Find(std::addressof(visitor), end_offset), fs::ResultOutOfRange);
+            }
+
+            /* Check that walking forwards from the first entry visits every entry in order. */
+            {
+                fssystem::BucketTree::Visitor visitor;
+                TEST_R_TRY(tree.Find(std::addressof(visitor), 0));
+
+                for (s32 i = 0; i < entry_count; ++i) {
+                    AMS_ABORT_UNLESS(visitor.Get<BucketTreeTestEntry>()->value == i);
+                    AMS_ABORT_UNLESS(visitor.CanMoveNext() == (i + 1 < entry_count));
+                    if (visitor.CanMoveNext()) {
+                        TEST_R_TRY(visitor.MoveNext());
+                    }
+                }
+            }
+
+            /* Check that walking backwards from the last entry visits every entry in order. */
+            {
+                fssystem::BucketTree::Visitor visitor;
+                TEST_R_TRY(tree.Find(std::addressof(visitor), end_offset - 1));
+
+                for (s32 i = entry_count - 1; i >= 0; --i) {
+                    AMS_ABORT_UNLESS(visitor.Get<BucketTreeTestEntry>()->value == i);
+                    AMS_ABORT_UNLESS(visitor.CanMovePrevious() == (i > 0));
+                    if (visitor.CanMovePrevious()) {
+                        TEST_R_TRY(visitor.MovePrevious());
+                    }
+                }
+            }
+        }
+
+        void TestBucketTreeRoundTrip(s32 entry_count) {
+            /* Determine the storage layout. */
+            const s64 header_size = fssystem::BucketTree::QueryHeaderStorageSize();
+            const s64 node_size   = fssystem::BucketTree::QueryNodeStorageSize(BucketTreeTestNodeSize, sizeof(BucketTreeTestEntry), entry_count);
+            const s64 entry_size  = fssystem::BucketTree::QueryEntryStorageSize(BucketTreeTestNodeSize, sizeof(BucketTreeTestEntry), entry_count);
+            AMS_ABORT_UNLESS(static_cast<size_t>(header_size + node_size + entry_size) <= sizeof(g_storage_buffer));
+
+            /* Fill the storage with garbage, so that anything the builder fails to write is noticed. */
+            std::memset(g_storage_buffer, 0xCC, sizeof(g_storage_buffer));
+
+            fs::MemoryStorage storage(g_storage_buffer, header_size + node_size + entry_size);
+            fs::SubStorage header_storage(std::addressof(storage), 0, header_size);
+            fs::SubStorage node_storage(std::addressof(storage), header_size, node_size);
+            fs::SubStorage entry_storage(std::addressof(storage), header_size + node_size, entry_size);
+
+            /* Build the tree. */
+            const s64 end_offset = GetBucketTreeTestEntryOffset(entry_count);
+            {
+                fssystem::BucketTree::Builder builder;
+                TEST_R_TRY(builder.Initialize(std::addressof(g_memory_resource), header_storage, node_storage, entry_storage, BucketTreeTestNodeSize, sizeof(BucketTreeTestEntry), entry_count));
+
+                for (s32 i = 0; i < entry_count; ++i) {
+                    const BucketTreeTestEntry entry = { GetBucketTreeTestEntryOffset(i), i };
+                    TEST_R_TRY(builder.Add(entry));
+                }
+
+                TEST_R_TRY(builder.Finalize(end_offset));
+            }
+
+            /* Verify the header. */
+            fssystem::BucketTree::Header header;
+            TEST_R_TRY(header_storage.Read(0, std::addressof(header), sizeof(header)));
+            TEST_R_TRY(header.Verify());
+            AMS_ABORT_UNLESS(header.entry_count == entry_count);
+
+            /* Verify the tree, both with and without the lookup index. */
+            fssystem::BucketTree tree;
+            TEST_R_TRY(tree.Initialize(std::addressof(g_memory_resource), node_storage, entry_storage, BucketTreeTestNodeSize, sizeof(BucketTreeTestEntry), header.entry_count));
+            VerifyBucketTree(tree, entry_count, end_offset);
+
+            TEST_R_TRY(tree.InitializeLookupIndex(2));
+            AMS_ABORT_UNLESS(tree.IsLookupIndexEnabled());
+            VerifyBucketTree(tree, entry_count, end_offset);
+        }
+
+        void DoBucketTreeTests() {
+            for (const auto entry_count : BucketTreeTestEntryCounts) {
+                TestBucketTreeRoundTrip(entry_count);
+            }
+
+            /* Check that the builder rejects entries that aren't in increasing order. */
+            {
+                const s64 header_size = fssystem::BucketTree::QueryHeaderStorageSize();
+                const s64 node_size   = fssystem::BucketTree::QueryNodeStorageSize(BucketTreeTestNodeSize, sizeof(BucketTreeTestEntry), 2);
+                const s64 entry_size  = fssystem::BucketTree::QueryEntryStorageSize(BucketTreeTestNodeSize, sizeof(BucketTreeTestEntry), 2);
+
+                fs::MemoryStorage storage(g_storage_buffer, header_size + node_size + entry_size);
+
+                fssystem::BucketTree::Builder builder;
+                TEST_R_TRY(builder.Initialize(std::addressof(g_memory_resource), fs::SubStorage(std::addressof(storage), 0, header_size), fs::SubStorage(std::addressof(storage), header_size, node_size), fs::SubStorage(std::addressof(storage), header_size + node_size, entry_size), BucketTreeTestNodeSize, sizeof(BucketTreeTestEntry), 2));
+
+                const BucketTreeTestEntry first  = { 0x100, 0 };
+                const BucketTreeTestEntry second = { 0x100, 1 };
+                TEST_R_TRY(builder.Add(first));
+                TEST_R_EXPECT(builder.Add(second), fs::ResultInvalidOffset);
+            }
+
+            printf("BucketTree round trip: OK\n");
+        }
+
+        /* ==================================================================================================================== */
+        /* Compression configuration                                                                                            */
+        /* ==================================================================================================================== */
+
+        static_assert(fssystem::CompressionType_Unknown == 4);
+        static_assert(fssystem::CompressionTypeUtility::IsUnknownType(fssystem::CompressionType_Zstd));
+
+        void DoCompressionConfigurationTests() {
+            const auto *official  = fssystem::GetNcaCompressionConfiguration();
+            const auto *extension = fssystem::GetNcaCompressionConfigurationWithExtensions();
+
+            /* Both configurations must decompress the official types. */
+            AMS_ABORT_UNLESS(official->get_decompressor(fssystem::CompressionType_Lz4)  != nullptr);
+            AMS_ABORT_UNLESS(extension->get_decompressor(fssystem::CompressionType_Lz4) != nullptr);
+
+            /* Only the extension configuration may decompress extension types. */
+            AMS_ABORT_UNLESS(official->get_decompressor(fssystem::CompressionType_Zstd)  == nullptr);
+            AMS_ABORT_UNLESS(extension->get_decompressor(fssystem::CompressionType_Zstd) != nullptr);
+
+            /* Neither configuration may decompress unknown types. */
+            AMS_ABORT_UNLESS(official->get_decompressor(fssystem::CompressionType_Unknown)  == nullptr);
+            AMS_ABORT_UNLESS(extension->get_decompressor(fssystem::CompressionType_Unknown) == nullptr);
+
+            printf("Compression configuration: OK\n");
+        }
+
+        /* ==================================================================================================================== */
+        /* CompressedStorage                                                                                                    */
+        /* ==================================================================================================================== */
+
+        constexpr size_t CompressedStorageTestDataSize  = 2_MB;
+        constexpr size_t CompressedStorageTestBlockSize = 64_KB;
+        constexpr size_t CompressedStorageTestTableSize = 64_KB;
+        constexpr s32    CompressedStorageTestWorkerCount = 2;
+        constexpr size_t CompressedStorageTestStoredBlockIndex = 5;
+
+        alignas(os::MemoryPageSize) constinit u8 g_compressed_source[CompressedStorageTestDataSize];
+        alignas(os::MemoryPageSize) constinit u8 g_compressed_data[CompressedStorageTestDataSize + CompressedStorageTestDataSize / CompressedStorageTestBlockSize * fssystem::CompressionBlockAlignment];
+        alignas(os::MemoryPageSize) constinit u8 g_compressed_table[CompressedStorageTestTableSize];
+        alignas(os::MemoryPageSize) constinit u8 g_compressed_header[sizeof(fssystem::BucketTree::Header)];
+        alignas(os::MemoryPageSize) constinit u8 g_compressed_read_buffer[CompressedStorageTestDataSize];
+
+        alignas(os::MemoryPageSize) constinit u8 g_buffer_pool[4_MB];
+        alignas(os::MemoryPageSize) constinit u8 g_buffer_manager_heap[2_MB];
+        alignas(os::ThreadStackAlignment) constinit u8 g_decompression_worker_stack[CompressedStorageTestWorkerCount * 16_KB];
+
+        constinit util::TypedStorage<fssystem::FileSystemBufferManager> g_buffer_manager = {};
+
+        void FillCompressibleData(u8 *dst, size_t size) {
+            /* Repeat short random runs, so that every block compresses, but differently. */
+            u32 state = 0x12345678;
+            for (size_t i = 0; i < size; /* ... */) {
+                state = state * 1103515245 + 12345;
+                const size_t run_size = std::min<size_t>(1 + ((state >> 16) % 32), size - i);
+                const u8 value = static_cast<u8>(state >> 8);
+                std::memset(dst + i, value, run_size);
+                i += run_size;
+            }
+        }
+
+        void TestCompressedStorageRead(fssystem::DecompressionWorkerPool *worker_pool, fssystem::GetDecompressorFunction get_decompressor, const char *name) {
+            /* Set up the compressed storage. */
+            const s32 entry_count = fssystem::CompressedStorageWriter::QueryEntryCount(CompressedStorageTestDataSize, CompressedStorageTestBlockSize);
+            const s64 node_size   = fssystem::CompressedStorage::QueryNodeStorageSize(entry_count);
+            const s64 entry_size  = fssystem::CompressedStorage::QueryEntryStorageSize(entry_count);
+
+            fs::MemoryStorage data_storage(g_compressed_data, sizeof(g_compressed_data));
+            fs::MemoryStorage table_storage(g_compressed_table, sizeof(g_compressed_table));
+
+            fssystem::CompressedStorage storage;
+            TEST_R_TRY(storage.Initialize(std::addressof(g_memory_resource), std::addressof(GetReference(g_buffer_manager)), fs::SubStorage(std::addressof(data_storage), 0, sizeof(g_compressed_data)), fs::SubStorage(std::addressof(table_storage), 0, node_size), fs::SubStorage(std::addressof(table_storage), node_size, entry_size), entry_count, CompressedStorageTestBlockSize, 640_KB, get_decompressor, 16_KB, 16_KB, 32, worker_pool));
+
+            s64 size;
+            TEST_R_TRY(storage.GetSize(std::addressof(size)));
+            AMS_ABORT_UNLESS(size == static_cast<s64>(CompressedStorageTestDataSize));
+
+            /* Read everything at once, so that blocks are decompressed in batches. */
+            std::memset(g_compressed_read_buffer, 0, sizeof(g_compressed_read_buffer));
+
+            const auto start = os::GetSystemTick();
+            TEST_R_TRY(storage.Read(0, g_compressed_read_buffer, CompressedStorageTestDataSize));
+            const auto elapsed = (os::GetSystemTick() - start).ToTimeSpan();
+
+            AMS_ABORT_UNLESS(std::memcmp(g_compressed_read_buffer, g_compressed_source, CompressedStorageTestDataSize) == 0);
+
+            /* Read at unaligned offsets which span block boundaries. */
+            for (size_t offset = CompressedStorageTestBlockSize - 0x123; offset + 3 * CompressedStorageTestBlockSize <= CompressedStorageTestDataSize; offset += 3 * CompressedStorageTestBlockSize + 0x45) {
+                const size_t read_size = 2 * CompressedStorageTestBlockSize + 0x246;
+
+                TEST_R_TRY(storage.Read(offset, g_compressed_read_buffer, read_size));
+                AMS_ABORT_UNLESS(std::memcmp(g_compressed_read_buffer, g_compressed_source + offset, read_size) == 0);
+            }
+
+            /* Read a few bytes either side of the boundaries around the stored block, so that each read needs two entries of different types. */
+            for (const size_t block_index : { CompressedStorageTestStoredBlockIndex, CompressedStorageTestStoredBlockIndex + 1 }) {
+                const size_t offset = block_index * CompressedStorageTestBlockSize - 7;
+
+                TEST_R_TRY(storage.Read(offset, g_compressed_read_buffer, 14));
+                AMS_ABORT_UNLESS(std::memcmp(g_compressed_read_buffer, g_compressed_source + offset, 14) == 0);
+            }
+
+            printf("%s: OK (%" PRId64 " us)\n", name, elapsed.GetMicroSeconds());
+        }
+
+        void TestCompressedStorageRoundTrip(fssystem::CompressionType type, fssystem::GetDecompressorFunction get_decompressor, const char *name) {
+            /* Compress the source data. */
+            {
+                fs::MemoryStorage src_storage(g_compressed_source, sizeof(g_compressed_source));
+                fs::MemoryStorage header_storage(g_compressed_header, sizeof(g_compressed_header));
+                fs::MemoryStorage table_storage(g_compressed_table, sizeof(g_compressed_table));
+                fs::MemoryStorage data_storage(g_compressed_data, sizeof(g_compressed_data));
+
+                const s32 entry_count = fssystem::CompressedStorageWriter::QueryEntryCount(CompressedStorageTestDataSize, CompressedStorageTestBlockSize);
+                AMS_ABORT_UNLESS(fssystem::CompressedStorageWriter::QueryTableStorageSize(entry_count) <= static_cast<s64>(sizeof(g_compressed_table)));
+                AMS_ABORT_UNLESS(fssystem::CompressedStorageWriter::QueryDataStorageSizeMax(CompressedStorageTestDataSize, CompressedStorageTestBlockSize) <= static_cast<s64>(sizeof(g_compressed_data)));
+
+                std::memset(g_compressed_data, 0, sizeof(g_compressed_data));
+
+                s64 data_size;
+                TEST_R_TRY(fssystem::CompressedStorageWriter::Write(std::addressof(data_size), fs::SubStorage(std::addressof(header_storage), 0, sizeof(g_compressed_header)), fs::SubStorage(std::addressof(table_storage), 0, sizeof(g_compressed_table)), fs::SubStorage(std::addressof(data_storage), 0, sizeof(g_compressed_data)), std::addressof(src_storage), CompressedStorageTestDataSize, CompressedStorageTestBlockSize, type, std::addressof(g_memory_resource)));
+                AMS_ABORT_UNLESS(data_size < static_cast<s64>(CompressedStorageTestDataSize));
+            }
+
+            /* Read back without a worker pool. */
+            {
+                char read_name[0x80];
+                util::TSNPrintf(read_name, sizeof(read_name), "CompressedStorage %s read", name);
+
+                TestCompressedStorageRead(nullptr, get_decompressor, read_name);
+            }
+
+            /* Read back through a worker pool. */
+            {
+                fssystem::DecompressionWorkerPool worker_pool;
+                TEST_R_TRY(worker_pool.Initialize(g_decompression_worker_stack, sizeof(g_decompression_worker_stack), CompressedStorageTestWorkerCount, os::DefaultThreadPriority));
+
+                char read_name[0x80];
+                util::TSNPrintf(read_name, sizeof(read_name), "CompressedStorage %s read (worker pool)", name);
+
+                TestCompressedStorageRead(std::addressof(worker_pool), get_decompressor, read_name);
+            }
+        }
+
+        void DoCompressedStorageTests() {
+            /* Initialize the buffer pool and buffer manager, which compressed storage depends on. */
+            TEST_R_TRY(fssystem::InitializeBufferPool(reinterpret_cast<char *>(g_buffer_pool), sizeof(g_buffer_pool)));
+
+            util::ConstructAt(g_buffer_manager);
+            TEST_R_TRY(GetReference(g_buffer_manager).Initialize(1024, reinterpret_cast<uintptr_t>(g_buffer_manager_heap), sizeof(g_buffer_manager_heap), 16_KB));
+
+            /* Generate the source data, with one incompressible block which the writer must store as-is. */
+            FillCompressibleData(g_compressed_source, sizeof(g_compressed_source));
+            {
+                u32 state = 0x87654321;
+                u8 *stored_block = g_compressed_source + CompressedStorageTestStoredBlockIndex * CompressedStorageTestBlockSize;
+                for (size_t i = 0; i < CompressedStorageTestBlockSize; ++i) {
+                    state ^= state << 13;
+                    state ^= state >> 17;
+                    state ^= state << 5;
+                    stored_block[i] = static_cast<u8>(state);
+                }
+            }
+
+            /* Round trip through each supported compression type. */
+            TestCompressedStorageRoundTrip(fssystem::CompressionType_Lz4, fssystem::GetNcaCompressionConfiguration()->get_decompressor, "LZ4");
+            TestCompressedStorageRoundTrip(fssystem::CompressionType_Zstd, fssystem::GetNcaCompressionConfigurationWithExtensions()->get_decompressor, "zstd");
+        }
+
+        /* ==================================================================================================================== */
+        /* IntegrityVerificationStorage                                                                                         */
+        /* ==================================================================================================================== */
+
+        constexpr size_t IntegrityTestBlockSize  = 16_KB;
+        constexpr size_t IntegrityTestBlockCount = 40;
+        constexpr size_t IntegrityTestDataSize   = IntegrityTestBlockSize * IntegrityTestBlockCount;
+        constexpr size_t IntegrityTestHashSize   = crypto::Sha256Generator::HashSize;
+
+        alignas(os::MemoryPageSize) constinit u8 g_integrity_source[IntegrityTestDataSize];
+        alignas(os::MemoryPageSize) constinit u8 g_integrity_data[IntegrityTestDataSize];
+        alignas(os::MemoryPageSize) constinit u8 g_integrity_read_buffer[IntegrityTestDataSize];
+        alignas(os::MemoryPageSize) constinit u8 g_integrity_hash[IntegrityTestBlockCount * IntegrityTestHashSize];
+
+        class CountingHashGeneratorFactory : public fssystem::IHash256GeneratorFactory {
+            private:
+                fssystem::Sha256HashGeneratorFactory m_factory;
+                size_t m_hashed_block_count;
+            public:
+                constexpr CountingHashGeneratorFactory() : m_factory(), m_hashed_block_count(0) { /* ... */ }
+
+                size_t GetHashedBlockCount() const { return m_hashed_block_count; }
+                void ResetHashedBlockCount() { m_hashed_block_count = 0; }
+            protected:
+                virtual Result DoCreate(std::unique_ptr<fssystem::IHash256Generator> *out) override {
+                    R_RETURN(m_factory.Create(out));
+                }
+
+                virtual void DoGenerateHash(void *dst, size_t dst_size, const void *src, size_t src_size) override {
+                    ++m_hashed_block_count;
+                    m_factory.GenerateHash(dst, dst_size, src, src_size);
+                }
+
+                virtual Result DoGenerateHashes(void *dst, size_t dst_size, const void *prefix, size_t prefix_size, const void *src, size_t block_size, size_t block_count) override {
+                    m_hashed_block_count += block_count;
+                    R_RETURN(m_factory.GenerateHashes(dst, dst_size, prefix, prefix_size, src, block_size, block_count));
+                }
+        };
+
+        void VerifyIntegrityReadBuffer(size_t zeroed_block_index) {
+            for (size_t i = 0; i < IntegrityTestBlockCount; ++i) {
+                const u8 *block = g_integrity_read_buffer + i * IntegrityTestBlockSize;
+                if (i == zeroed_block_index) {
+                    for (size_t j = 0; j < IntegrityTestBlockSize; ++j) {
+                        AMS_ABORT_UNLESS(block[j] == 0);
+                    }
+                } else {
+                    AMS_ABORT_UNLESS(std::memcmp(block, g_integrity_source + i * IntegrityTestBlockSize, IntegrityTestBlockSize) == 0);
+                }
+            }
+        }
+
+        void DoIntegrityVerificationStorageTests() {
+            /* NOTE: This relies on the buffer pool set up by DoCompressedStorageTests. */
+            FillCompressibleData(g_integrity_source, sizeof(g_integrity_source));
+
+            fs::MemoryStorage data_storage(g_integrity_data, sizeof(g_integrity_data));
+            fs::MemoryStorage hash_storage(g_integrity_hash, sizeof(g_integrity_hash));
+            CountingHashGeneratorFactory hash_generator_factory;
+
+            /* Check a read-only storage, with hashes computed up front. */
+            {
+                std::memcpy(g_integrity_data, g_integrity_source, sizeof(g_integrity_data));
+                for (size_t i = 0; i < IntegrityTestBlockCount; ++i) {
+                    crypto::GenerateSha256(g_integrity_hash + i * IntegrityTestHashSize, IntegrityTestHashSize, g_integrity_source + i * IntegrityTestBlockSize, IntegrityTestBlockSize);
+                }
+
+                fssystem::IntegrityVerificationStorage storage;
+                storage.Initialize(fs::SubStorage(std::addressof(hash_storage), 0, sizeof(g_integrity_hash)), fs::SubStorage(std::addressof(data_storage), 0, sizeof(g_integrity_data)), IntegrityTestBlockSize, IntegrityTestHashSize, std::addressof(GetReference(g_buffer_manager)), std::addressof(hash_generator_factory), util::nullopt, false, false, false);
+
+                /* Valid hashes verify, and every block is hashed exactly once. */
+                hash_generator_factory.ResetHashedBlockCount();
+                TEST_R_TRY(storage.Read(0, g_integrity_read_buffer, sizeof(g_integrity_read_buffer)));
+                VerifyIntegrityReadBuffer(IntegrityTestBlockCount);
+                AMS_ABORT_UNLESS(hash_generator_factory.GetHashedBlockCount() == IntegrityTestBlockCount);
+
+                /* Corrupted data fails to verify, and only the corrupted block is cleared. */
+                g_integrity_data[21 * IntegrityTestBlockSize + 0x123] ^= 0x01;
+                TEST_R_EXPECT(storage.Read(0, g_integrity_read_buffer, sizeof(g_integrity_read_buffer)), fs::ResultNonRealDataVerificationFailed);
+                VerifyIntegrityReadBuffer(21);
+                g_integrity_data[21 * IntegrityTestBlockSize + 0x123] ^= 0x01;
+
+                /* A corrupted hash fails to verify in the same way. */
+                g_integrity_hash[3 * IntegrityTestHashSize] ^= 0x01;
+                TEST_R_EXPECT(storage.Read(0, g_integrity_read_buffer, sizeof(g_integrity_read_buffer)), fs::ResultNonRealDataVerificationFailed);
+                VerifyIntegrityReadBuffer(3);
+
+                storage.Finalize();
+            }
+
+            /* Check a writable storage, with salted hashes. */
+            {
+                std::memset(g_integrity_data, 0, sizeof(g_integrity_data));
+                std::memset(g_integrity_hash, 0, sizeof(g_integrity_hash));
+
+                fs::HashSalt salt;
+                for (size_t i = 0; i < sizeof(salt.value); ++i) {
+                    salt.value[i] = static_cast<u8>(0xA5 ^ i);
+                }
+
+                fssystem::IntegrityVerificationStorage storage;
+                storage.Initialize(fs::SubStorage(std::addressof(hash_storage), 0, sizeof(g_integrity_hash)), fs::SubStorage(std::addressof(data_storage), 0, sizeof(g_integrity_data)), IntegrityTestBlockSize, IntegrityTestHashSize, std::addressof(GetReference(g_buffer_manager)), std::addressof(hash_generator_factory), salt, true, true, false);
+
+                /* Data we write verifies when read back. */
+                TEST_R_TRY(storage.Write(0, g_integrity_source, sizeof(g_integrity_source)));
+                hash_generator_factory.ResetHashedBlockCount();
+                TEST_R_TRY(storage.Read(0, g_integrity_read_buffer, sizeof(g_integrity_read_buffer)));
+                VerifyIntegrityReadBuffer(IntegrityTestBlockCount);
+                AMS_ABORT_UNLESS(hash_generator_factory.GetHashedBlockCount() == IntegrityTestBlockCount);
+
+                /* A cleared signature reads as zeroes without failing, and its block isn't hashed. */
+                std::memset(g_integrity_hash + 5 * IntegrityTestHashSize, 0, IntegrityTestHashSize);
+                hash_generator_factory.ResetHashedBlockCount();
+                TEST_R_TRY(storage.Read(0, g_integrity_read_buffer, sizeof(g_integrity_read_buffer)));
+                VerifyIntegrityReadBuffer(5);
+                AMS_ABORT_UNLESS(hash_generator_factory.GetHashedBlockCount() == IntegrityTestBlockCount - 1);
+
+                /* A signature which is neither valid nor cleared is rejected. */
+                g_integrity_hash[5 * IntegrityTestHashSize] = 0x01;
+                TEST_R_EXPECT(storage.Read(0, g_integrity_read_buffer, sizeof(g_integrity_read_buffer)), fs::ResultInvalidZeroHash);
+                VerifyIntegrityReadBuffer(5);
+
+                /* Rewriting the block restores its signature. */
+                TEST_R_TRY(storage.Write(5 * IntegrityTestBlockSize, g_integrity_source + 5 * IntegrityTestBlockSize, IntegrityTestBlockSize));
+                TEST_R_TRY(storage.Read(0, g_integrity_read_buffer, sizeof(g_integrity_read_buffer)));
+                VerifyIntegrityReadBuffer(IntegrityTestBlockCount);
+
+                /* Corrupted data fails to verify. */
+                g_integrity_data[30 * IntegrityTestBlockSize] ^= 0x80;
+                TEST_R_EXPECT(storage.Read(0, g_integrity_read_buffer, sizeof(g_integrity_read_buffer)), fs::ResultUnclearedRealDataVerificationFailed);
+                VerifyIntegrityReadBuffer(30);
+
+                storage.Finalize();
+            }
+
+            printf("IntegrityVerificationStorage: OK\n");
+        }
+
+        /* ==================================================================================================================== */
+        /* BufferedStorage read-ahead                                                                                           */
+        /* ==================================================================================================================== */
+
+        constexpr size_t BufferedStorageTestDataSize  = 1_MB;
+        constexpr size_t BufferedStorageTestBlockSize = 16_KB;
+        constexpr s32    BufferedStorageTestCacheCount = 16;
+        constexpr s32    BufferedStorageTestWindow     = 4;
+        constexpr size_t BufferedStorageTestReadSize  = 4_KB;
+
+        alignas(os::MemoryPageSize) constinit u8 g_buffered_source[BufferedStorageTestDataSize];
+        alignas(os::ThreadStackAlignment) constinit u8 g_prefetcher_stack[16_KB];
+
+        void DoBufferedStorageReadAheadTests() {
+            for (size_t i = 0; i < sizeof(g_buffered_source); ++i) {
+                g_buffered_source[i] = static_cast<u8>(i * 7 + (i >> 12));
+            }
+
+            fssystem::BufferedStoragePrefetcher prefetcher;
+            TEST_R_TRY(prefetcher.Initialize(g_prefetcher_stack, sizeof(g_prefetcher_stack), os::DefaultThreadPriority));
+
+            fs::MemoryStorage base_storage(g_buffered_source, sizeof(g_buffered_source));
+
+            fssystem::BufferedStorage storage;
+            TEST_R_TRY(storage.Initialize(fs::SubStorage(std::addressof(base_storage), 0, sizeof(g_buffered_source)), std::addressof(GetReference(g_buffer_manager)), BufferedStorageTestBlockSize, BufferedStorageTestCacheCount));
+            storage.EnableReadAhead(std::addressof(prefetcher), BufferedStorageTestWindow);
+            AMS_ABORT_UNLESS(storage.GetReadAheadWindow() == BufferedStorageTestWindow);
+
+            u8 buffer[BufferedStorageTestReadSize];
+            fssystem::BufferedStorage::ReadAheadStatistics stats;
+
+            auto ReadAndVerify = [&](s64 offset) {
+                TEST_R_TRY(storage.Read(offset, buffer, sizeof(buffer)));
+                AMS_ABORT_UNLESS(std::memcmp(buffer, g_buffered_source + offset, sizeof(buffer)) == 0);
+            };
+
+            /* The first read starts a run, even at offset zero, so two reads aren't yet enough to trigger read-ahead. */
+            ReadAndVerify(0 * BufferedStorageTestReadSize);
+            ReadAndVerify(1 * BufferedStorageTestReadSize);
+            storage.GetReadAheadStatistics(std::addressof(stats));
+            AMS_ABORT_UNLESS(stats.request_count == 0);
+
+            /* The third sequential read should trigger read-ahead of the blocks after the current one. */
+            ReadAndVerify(2 * BufferedStorageTestReadSize);
+            storage.GetReadAheadStatistics(std::addressof(stats));
+            AMS_ABORT_UNLESS(stats.request_count == 1);
+
+            /* Once the prefetcher has caught up, the next block should be a cache hit. */
+            prefetcher.WaitForIdle();
+            storage.GetReadAheadStatistics(std::addressof(stats));
+            AMS_ABORT_UNLESS(stats.prefetch_count == static_cast<u64>(BufferedStorageTestWindow));
+
+            const auto miss_count = stats.miss_count;
+            ReadAndVerify(BufferedStorageTestBlockSize);
+            storage.GetReadAheadStatistics(std::addressof(stats));
+            AMS_ABORT_UNLESS(stats.miss_count == miss_count);
+
+            /* Read the rest of the storage sequentially, checking the data throughout. */
+            for (s64 offset = BufferedStorageTestBlockSize + BufferedStorageTestReadSize; offset < static_cast<s64>(BufferedStorageTestDataSize); offset += BufferedStorageTestReadSize) {
+                ReadAndVerify(offset);
+            }
+
+            prefetcher.WaitForIdle();
+            storage.GetReadAheadStatistics(std::addressof(stats));
+            AMS_ABORT_UNLESS(stats.prefetch_count > static_cast<u64>(BufferedStorageTestWindow));
+            AMS_ABORT_UNLESS(stats.hit_count > stats.miss_count);
+
+            /* A non-sequential read breaks the run. */
+            const auto request_count = stats.request_count;
+            ReadAndVerify(0x12345);
+            storage.GetReadAheadStatistics(std::addressof(stats));
+            AMS_ABORT_UNLESS(stats.request_count == request_count);
+
+            printf("BufferedStorage read-ahead: OK (%" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " prefetched, %" PRIu64 " wasted)\n", stats.hit_count, stats.miss_count, stats.prefetch_count, stats.prefetch_waste_count);
+
+            /* Disabling read-ahead must leave the prefetcher with no reference to the storage. */
+            storage.DisableReadAhead();
+            AMS_ABORT_UNLESS(storage.GetReadAheadWindow() == 0);
+            storage.Finalize();
+        }
+
+        /* ==================================================================================================================== */
+        /* ReadBatch forwarding                                                                                                 */
+        /* ==================================================================================================================== */
+
+        class BatchCountingStorage : public fs::MemoryStorage {
+            private:
+                s32 m_batch_count;
+                s32 m_batch_request_count;
+            public:
+                BatchCountingStorage(void *buffer, s64 size) : fs::MemoryStorage(buffer, size), m_batch_count(0), m_batch_request_count(0) { /* ... */ }
+
+                s32 GetBatchCount() const { return m_batch_count; }
+                s32 GetBatchRequestCount() const { return m_batch_request_count; }
+                void ResetBatchCount() { m_batch_count = 0; m_batch_request_count = 0; }
+
+                virtual Result ReadBatch(const fs::ReadRequest *requests, s32 count) override {
+                    ++m_batch_count;
+                    m_batch_request_count += count;
+                    R_RETURN(fs::MemoryStorage::ReadBatch(requests, count));
+                }
+        };
+
+        alignas(os::MemoryPageSize) constinit u8 g_batch_read_buffer[8 * BufferedStorageTestBlockSize];
+        alignas(os::MemoryPageSize) constinit u8 g_batch_verify_buffer[8 * BufferedStorageTestBlockSize];
+
+        void DoBufferedStorageReadBatchTests() {
+            /* NOTE: g_buffered_source was filled by the read-ahead tests. */
+            BatchCountingStorage base_storage(g_buffered_source, sizeof(g_buffered_source));
+
+            fssystem::BufferedStorage storage;
+            TEST_R_TRY(storage.Initialize(fs::SubStorage(std::addressof(base_storage), 0, sizeof(g_buffered_source)), std::addressof(GetReference(g_buffer_manager)), BufferedStorageTestBlockSize, BufferedStorageTestCacheCount));
+            ON_SCOPE_EXIT { storage.Finalize(); };
+
+            /* Warm the cache over a block which a later request spans, so that the batch has to drop it. */
+            u8 small_buffer[0x100];
+            TEST_R_TRY(storage.Read(4 * BufferedStorageTestBlockSize + 0x10, small_buffer, sizeof(small_buffer)));
+            AMS_ABORT_UNLESS(std::memcmp(small_buffer, g_buffered_source + 4 * BufferedStorageTestBlockSize + 0x10, sizeof(small_buffer)) == 0);
+
+            /* Mix requests which bypass the cache with ones which go through it, out of order. */
+            const fs::ReadRequest requests[] = {
+                { 10 * BufferedStorageTestBlockSize,        g_batch_read_buffer + 0 * BufferedStorageTestBlockSize, 2 * BufferedStorageTestBlockSize },
+                { 0x123,                                    g_batch_read_buffer + 2 * BufferedStorageTestBlockSize, 0x456                            },
+                { 4 * BufferedStorageTestBlockSize,         g_batch_read_buffer + 3 * BufferedStorageTestBlockSize, 3 * BufferedStorageTestBlockSize },
+                { 1 * BufferedStorageTestBlockSize,         g_batch_read_buffer + 6 * BufferedStorageTestBlockSize, 0                                },
+                { 20 * BufferedStorageTestBlockSize + 0x10, g_batch_read_buffer + 6 * BufferedStorageTestBlockSize, BufferedStorageTestBlockSize     },
+            };
+
+            base_storage.ResetBatchCount();
+            std::memset(g_batch_read_buffer, 0xCC, sizeof(g_batch_read_buffer));
+            TEST_R_TRY(storage.ReadBatch(requests, util::size(requests)));
+            for (const auto &request : requests) {
+                AMS_ABORT_UNLESS(std::memcmp(request.buffer, g_buffered_source + request.offset, request.size) == 0);
+            }
+
+            /* The two multi-block aligned requests should have reached the base storage as one batch. */
+            AMS_ABORT_UNLESS(base_storage.GetBatchCount() == 1);
+            AMS_ABORT_UNLESS(base_storage.GetBatchRequestCount() == 2);
+
+            /* A request past the end of the storage fails, as Read would. */
+            const fs::ReadRequest invalid_request = { static_cast<s64>(sizeof(g_buffered_source)) + BufferedStorageTestBlockSize, g_batch_read_buffer, BufferedStorageTestBlockSize };
+            TEST_R_EXPECT(storage.ReadBatch(std::addressof(invalid_request), 1), fs::ResultInvalidOffset);
+
+            printf("BufferedStorage ReadBatch: OK\n");
+        }
+
+        void DoAesCtrStorageReadBatchTests() {
+            constexpr u8 Key[fssystem::AesCtrStorageByPointer::KeySize] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF };
+            u8 iv[fssystem::AesCtrStorageByPointer::IvSize];
+            fssystem::AesCtrStorageByPointer::MakeIv(iv, sizeof(iv), 0x0123456789ABCDEF, 0);
+
+            BatchCountingStorage base_storage(g_buffered_source, sizeof(g_buffered_source));
+            fssystem::AesCtrStorageByPointer storage(std::addressof(base_storage), Key, sizeof(Key), iv, sizeof(iv));
+
+            /* Scattered block-aligned requests, including an empty one. */
+            const fs::ReadRequest requests[] = {
+                { 0x8000,  g_batch_read_buffer + 0x0000, 0x1000 },
+                { 0x10,    g_batch_read_buffer + 0x1000, 0x30   },
+                { 0x40000, g_batch_read_buffer + 0x1030, 0      },
+                { 0x20000, g_batch_read_buffer + 0x1030, 0x2FD0 },
+            };
+
+            base_storage.ResetBatchCount();
+            TEST_R_TRY(storage.ReadBatch(requests, util::size(requests)));
+            AMS_ABORT_UNLESS(base_storage.GetBatchCount() == 1);
+
+            /* Each request must decrypt exactly as a single read of the same range does. */
+            for (const auto &request : requests) {
+                TEST_R_TRY(storage.Read(request.offset, g_batch_verify_buffer, request.size));
+                AMS_ABORT_UNLESS(std::memcmp(request.buffer, g_batch_verify_buffer, request.size) == 0);
+            }
+
+            /* Unaligned requests are rejected before anything is read. */
+            const fs::ReadRequest unaligned_request = { 0x8, g_batch_read_buffer, 0x10 };
+            base_storage.ResetBatchCount();
+            TEST_R_EXPECT(storage.ReadBatch(std::addressof(unaligned_request), 1), fs::ResultInvalidArgument);
+            AMS_ABORT_UNLESS(base_storage.GetBatchCount() == 0);
+
+            printf("AesCtrStorage ReadBatch: OK\n");
+        }
+
+
+        /* ==================================================================================================================== */
+        /* Sharded block cache                                                                                                  */
+        /* ==================================================================================================================== */
+
+        constexpr size_t ShardedCacheTestDataSize      = 1_MB;
+        constexpr size_t ShardedCacheTestBlockSize     = 4_KB;
+        constexpr s64    ShardedCacheTestBlockCount    = ShardedCacheTestDataSize / ShardedCacheTestBlockSize;
+        constexpr s64    ShardedCacheTestHotBlockCount = 48;
+        constexpr s32    ShardedCacheTestCacheEntries  = 64;
+        constexpr s32    ShardedCacheTestThreadCount   = 4;
+        constexpr s32    ShardedCacheTestReadCount     = 2048;
+        constexpr s32    ShardedCacheTestWriteCount    = 512;
+        constexpr s8     ShardedCacheTestBufferLevel   = 0x10;
+
+        alignas(os::MemoryPageSize) constinit u8 g_sharded_source[ShardedCacheTestDataSize];
+        alignas(os::ThreadStackAlignment) constinit u8 g_sharded_thread_stacks[ShardedCacheTestThreadCount + 1][16_KB];
+
+        /* Models the cost of fetching and verifying a block, so that holding a lock across the read is visible. */
+        class LatencyMemoryStorage : public fs::MemoryStorage {
+            public:
+                LatencyMemoryStorage(void *b, s64 sz) : fs::MemoryStorage(b, sz) { /* ... */ }
+
+                virtual Result Read(s64 offset, void *buffer, size_t size) override {
+                    os::SleepThread(TimeSpan::FromMicroSeconds(20));
+                    R_RETURN(fs::MemoryStorage::Read(offset, buffer, size));
+                }
+        };
+
+        struct ShardedCacheTestThreadArgument {
+            fs::IStorage *storage;
+            u32 seed;
+            bool verify;
+        };
+
+        void ShardedCacheTestReaderThread(void *arg) {
+            const auto *argument = static_cast<const ShardedCacheTestThreadArgument *>(arg);
+
+            u32 state = argument->seed;
+            u8 buffer[0x200];
+            for (s32 i = 0; i < ShardedCacheTestReadCount; ++i) {
+                /* Mostly read a hot set of blocks which fits in the cache, so that both hits and misses happen. */
+                state = state * 1103515245 + 12345;
+                const s64 block  = static_cast<s64>(state >> 16) % ((state & 0x300) == 0 ? ShardedCacheTestBlockCount : ShardedCacheTestHotBlockCount);
+                const s64 offset = block * ShardedCacheTestBlockSize + ((state >> 4) & 7) * sizeof(buffer);
+
+                TEST_R_TRY(argument->storage->Read(offset, buffer, sizeof(buffer)));
+                if (argument->verify) {
+                    AMS_ABORT_UNLESS(std::memcmp(buffer, g_sharded_source + offset, sizeof(buffer)) == 0);
+                }
+            }
+        }
+
+        void ShardedCacheTestWriterThread(void *arg) {
+            const auto *argument = static_cast<const ShardedCacheTestThreadArgument *>(arg);
+
+            u32 state = argument->seed;
+            u8 buffer[2 * ShardedCacheTestBlockSize];
+            for (s32 i = 0; i < ShardedCacheTestWriteCount; ++i) {
+                state = state * 1103515245 + 12345;
+                std::memset(buffer, static_cast<u8>(state >> 24), sizeof(buffer));
+
+                /* Alternate between burst writes, which bypass the cache, and partial block writes, which go through it. */
+                const s64 block = static_cast<s64>(state >> 16) % (ShardedCacheTestHotBlockCount - 1);
+                if ((i % 2) == 0) {
+                    TEST_R_TRY(argument->storage->Write(block * ShardedCacheTestBlockSize, buffer, sizeof(buffer)));
+                } else {
+                    TEST_R_TRY(argument->storage->Write(block * ShardedCacheTestBlockSize + 0x180, buffer, 0x100));
+                }
+            }
+        }
+
+        TimeSpan RunShardedCacheTestThreads(fs::IStorage *storage, bool verify, bool with_writer) {
+            os::ThreadType threads[ShardedCacheTestThreadCount + 1];
+            ShardedCacheTestThreadArgument arguments[ShardedCacheTestThreadCount + 1];
+
+            const s32 thread_count = ShardedCacheTestThreadCount + (with_writer ? 1 : 0);
+            for (s32 i = 0; i < thread_count; ++i) {
+                arguments[i] = { storage, 0x9E3779B9u * static_cast<u32>(i + 1), verify };
+                R_ABORT_UNLESS(os::CreateThread(std::addressof(threads[i]), i < ShardedCacheTestThreadCount ? ShardedCacheTestReaderThread : ShardedCacheTestWriterThread, std::addressof(arguments[i]), g_sharded_thread_stacks[i], sizeof(g_sharded_thread_stacks[i]), os::DefaultThreadPriority));
+            }
+
+            const auto start = os::GetSystemTick();
+            for (s32 i = 0; i < thread_count; ++i) {
+                os::StartThread(std::addressof(threads[i]));
+            }
+            for (s32 i = 0; i < thread_count; ++i) {
+                os::WaitThread(std::addressof(threads[i]));
+            }
+            const auto elapsed = (os::GetSystemTick() - start).ToTimeSpan();
+
+            for (s32 i = 0; i < thread_count; ++i) {
+                os::DestroyThread(std::addressof(threads[i]));
+            }
+
+            return elapsed;
+        }
+
+        void DoShardedBlockCacheTests() {
+            for (size_t i = 0; i < sizeof(g_sharded_source); ++i) {
+                g_sharded_source[i] = static_cast<u8>(i * 13 + (i >> 12));
+            }
+
+            LatencyMemoryStorage base_storage(g_sharded_source, sizeof(g_sharded_source));
+            auto *buffer_manager = std::addressof(GetReference(g_buffer_manager));
+
+            /* Benchmark concurrent readers against a single lock and against shards. */
+            TimeSpan block_cache_time, sharded_time;
+            {
+                os::SdkRecursiveMutex mutex;
+                fssystem::BlockCacheBufferedStorage storage;
+                TEST_R_TRY(storage.Initialize(buffer_manager, std::addressof(mutex), std::addressof(base_storage), ShardedCacheTestDataSize, ShardedCacheTestBlockSize, ShardedCacheTestCacheEntries, true, ShardedCacheTestBufferLevel, false, false));
+
+                block_cache_time = RunShardedCacheTestThreads(std::addressof(storage), true, false);
+            }
+            {
+                fssystem::ShardedBlockCacheBufferedStorage storage;
+                TEST_R_TRY(storage.Initialize(buffer_manager, std::addressof(base_storage), ShardedCacheTestDataSize, ShardedCacheTestBlockSize, ShardedCacheTestCacheEntries, fssystem::ShardedBlockCacheBufferedStorage::DefaultShardCount, ShardedCacheTestBufferLevel, false, false));
+
+                sharded_time = RunShardedCacheTestThreads(std::addressof(storage), true, false);
+            }
+
+            printf("Block cache, %d readers: %" PRId64 " us (single lock), %" PRId64 " us (%d shards)\n", ShardedCacheTestThreadCount, block_cache_time.GetMicroSeconds(), sharded_time.GetMicroSeconds(), fssystem::ShardedBlockCacheBufferedStorage::DefaultShardCount);
+
+            /* Race readers against a writer. Loads which overlap a write must not leave stale data in the cache. */
+            {
+                fssystem::ShardedBlockCacheBufferedStorage storage;
+                TEST_R_TRY(storage.Initialize(buffer_manager, std::addressof(base_storage), ShardedCacheTestDataSize, ShardedCacheTestBlockSize, ShardedCacheTestCacheEntries, fssystem::ShardedBlockCacheBufferedStorage::DefaultShardCount, ShardedCacheTestBufferLevel, true, true));
+
+                RunShardedCacheTestThreads(std::addressof(storage), false, true);
+                TEST_R_TRY(storage.Flush());
+
+                u8 buffer[ShardedCacheTestBlockSize];
+                for (s64 offset = 0; offset < static_cast<s64>(ShardedCacheTestDataSize); offset += ShardedCacheTestBlockSize) {
+                    TEST_R_TRY(storage.Read(offset, buffer, sizeof(buffer)));
+                    AMS_ABORT_UNLESS(std::memcmp(buffer, g_sharded_source + offset, sizeof(buffer)) == 0);
+                }
+            }
+
+            printf("Sharded block cache: OK\n");
+        }
+
+        /* ==================================================================================================================== */
+        /* PartitionFileSystemMeta                                                                                              */
+        /* ==================================================================================================================== */
+
+        constexpr s32    PartitionMetaTestEntryCount    = 4096;
+        constexpr size_t PartitionMetaTestNameSize      = 0x10;
+        constexpr size_t PartitionMetaTestHeaderSize    = 0x10;
+        constexpr size_t PartitionMetaTestEntriesSize   = PartitionMetaTestEntryCount * sizeof(fssystem::PartitionFileSystemMeta::PartitionEntry);
+        constexpr size_t PartitionMetaTestNameTableSize = PartitionMetaTestEntryCount * PartitionMetaTestNameSize;
+        constexpr size_t PartitionMetaTestMetaSize      = PartitionMetaTestHeaderSize + PartitionMetaTestEntriesSize + PartitionMetaTestNameTableSize;
+
+        alignas(os::MemoryPageSize) constinit u8 g_partition_meta[PartitionMetaTestMetaSize];
+        alignas(os::MemoryPageSize) constinit u8 g_partition_meta_work[PartitionMetaTestMetaSize];
+
+        void FormatPartitionMetaTestEntryName(char *dst, s32 index) {
+            util::TSNPrintf(dst, PartitionMetaTestNameSize, "%08x.nca", static_cast<u32>(index) * 0x9E3779B1u);
+        }
+
+        void BuildPartitionMeta() {
+            /* Write the header. */
+            const s32 entry_count     = PartitionMetaTestEntryCount;
+            const u32 name_table_size = PartitionMetaTestNameTableSize;
+            std::memcpy(g_partition_meta + 0x0, "PFS0", 4);
+            std::memcpy(g_partition_meta + 0x4, std::addressof(entry_count), sizeof(entry_count));
+            std::memcpy(g_partition_meta + 0x8, std::addressof(name_table_size), sizeof(name_table_size));
+
+            /* Write the entries and their names. */
+            auto *entries    = reinterpret_cast<fssystem::PartitionFileSystemMeta::PartitionEntry *>(g_partition_meta + PartitionMetaTestHeaderSize);
+            char *name_table = reinterpret_cast<char *>(g_partition_meta + PartitionMetaTestHeaderSize + PartitionMetaTestEntriesSize);
+            for (s32 i = 0; i < PartitionMetaTestEntryCount; ++i) {
+                entries[i] = { static_cast<u64>(i) * 0x200, 0x200, static_cast<u32>(i * PartitionMetaTestNameSize), 0 };
+                FormatPartitionMetaTestEntryName(name_table + i * PartitionMetaTestNameSize, i);
+            }
+        }
+
+        TimeSpan TestPartitionMetaLookup(const fssystem::PartitionFileSystemMeta &meta) {
+            AMS_ABORT_UNLESS(meta.GetEntryCount() == PartitionMetaTestEntryCount);
+
+            /* Look up every entry, as a tool opening every file of the partition would. */
+            char name[PartitionMetaTestNameSize];
+            const auto start = os::GetSystemTick();
+            for (s32 n = 0; n < PartitionMetaTestEntryCount; ++n) {
+                const s32 i = static_cast<s32>((static_cast<u32>(n) * 2749) % PartitionMetaTestEntryCount);
+                FormatPartitionMetaTestEntryName(name, i);
+                AMS_ABORT_UNLESS(meta.GetEntryIndex(name) == i);
+            }
+            const auto elapsed = (os::GetSystemTick() - start).ToTimeSpan();
+
+            /* Missing names must not be found. */
+            AMS_ABORT_UNLESS(meta.GetEntryIndex("missing.nca") < 0);
+            AMS_ABORT_UNLESS(meta.GetEntryIndex("") < 0);
+
+            return elapsed;
+        }
+
+        void DoPartitionFileSystemMetaTests() {
+            BuildPartitionMeta();
+
+            fs::MemoryStorage storage(g_partition_meta, sizeof(g_partition_meta));
+
+            /* Without an allocator, lookups scan the name table. */
+            TimeSpan linear_time;
+            {
+                fssystem::PartitionFileSystemMeta meta;
+                TEST_R_TRY(meta.Initialize(std::addressof(storage), g_partition_meta_work, sizeof(g_partition_meta_work)));
+                linear_time = TestPartitionMetaLookup(meta);
+            }
+
+            /* With an allocator, lookups go through the index table. */
+            TimeSpan indexed_time;
+            {
+                fssystem::PartitionFileSystemMeta meta;
+                TEST_R_TRY(meta.Initialize(std::addressof(storage), std::addressof(g_memory_resource)));
+                indexed_time = TestPartitionMetaLookup(meta);
+            }
+
+            printf("PartitionFileSystemMeta, %d lookups: %" PRId64 " us (linear), %" PRId64 " us (indexed)\n", PartitionMetaTestEntryCount, linear_time.GetMicroSeconds(), indexed_time.GetMicroSeconds());
+        }
+
+    }
+
+    void Main() {
+        printf("Doing fssystem tests!\n");
+        DoBucketTreeTests();
+        DoCompressionConfigurationTests();
+        DoCompressedStorageTests();
+        DoIntegrityVerificationStorageTests();
+        DoBufferedStorageReadAheadTests();
+        DoBufferedStorageReadBatchTests();
+        DoAesCtrStorageReadBatchTests();
+        DoShardedBlockCacheTests();
+        DoPartitionFileSystemMetaTests();
+
+        printf("All tests completed!\n");
+    }
+
+}
@@ -0,0 +1,546 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+#include <unistd.h>
+
+#define AMS_TEST_I_HIPC_TEST_SERVICE_INTERFACE_INFO(C, H)                                                                                                  \
+    AMS_SF_METHOD_INFO(C, H, 0, Result, Add,            (sf::Out<u32> out, u32 a, u32 b),                                  (out, a, b))                 \
+    AMS_SF_METHOD_INFO(C, H, 1, Result, ReverseBuffer,  (const sf::OutBuffer &out, const sf::InBuffer &in),                (out, in))                   \
+    AMS_SF_METHOD_INFO(C, H, 2, Result, ReversePointer, (const sf::OutPointerBuffer &out, const sf::InPointerBuffer &in),  (out, in))                   \
+    AMS_SF_METHOD_INFO(C, H, 3, Result, GetProcessId,   (sf::Out<u64> out, const sf::ClientProcessId &client_process_id),  (out, client_process_id))    \
+    AMS_SF_METHOD_INFO(C, H, 4, Result, SignalEvent,    (sf::CopyHandle &&event_handle),                                   (std::move(event_handle)))   \
+    AMS_SF_METHOD_INFO(C, H, 5, Result, GetEvent,       (sf::OutCopyHandle out),                                           (out))
+
+AMS_SF_DEFINE_INTERFACE(ams::test, ITestService, AMS_TEST_I_HIPC_TEST_SERVICE_INTERFACE_INFO, 0x00000000)
+
+namespace ams {
+
+    namespace {
+
+        constexpr size_t RoundTripCount = 0x4000;
+        constexpr u32 RequestDataWordCount = 4;
+
+        constexpr u32 CmifInHeaderMagic  = util::FourCC<'S','F','C','I'>::Code;
+        constexpr u32 CmifOutHeaderMagic = util::FourCC<'S','F','C','O'>::Code;
+
+        alignas(os::MemoryPageSize) constinit u8 g_client_thread_stack[16_KB];
+
+        constinit os::NativeHandle g_client_session_handle = os::InvalidNativeHandle;
+
+        sf::cmif::PointerAndSize GetTlsMessage() {
+            return sf::cmif::PointerAndSize(sf::hipc::GetMessageBufferOnTls(), sf::hipc::TlsMessageBufferSize);
+        }
+
+        void MakeMessage(void *buffer, u32 value) {
+            hipcMakeRequestInline(buffer,
+                .type           = CmifCommandType_Request,
+                .num_data_words = RequestDataWordCount,
+            ).data_words[0] = value;
+        }
+
+        u32 GetMessageValue(void *buffer) {
+            const auto request = hipcParseRequest(buffer);
+            AMS_ABORT_UNLESS(request.meta.num_data_words == RequestDataWordCount);
+            return request.data.data_words[0];
+        }
+
+        Result SendValue(os::NativeHandle session_handle, u32 *out, u32 value) {
+            const auto message = GetTlsMessage();
+
+            MakeMessage(message.GetPointer(), value);
+            R_TRY(sf::hipc::SendSyncRequest(session_handle, message));
+
+            *out = GetMessageValue(message.GetPointer());
+            R_SUCCEED();
+        }
+
+        void ClientThreadFunction(void *) {
+            /* Send our requests, checking that the server incremented each one. */
+            for (u32 i = 0; i < RoundTripCount; ++i) {
+                u32 value;
+                R_ABORT_UNLESS(SendValue(g_client_session_handle, std::addressof(value), i));
+                AMS_ABORT_UNLESS(value == i + 1);
+            }
+
+            /* Close our session, so that the server sees it closed. */
+            os::CloseNativeHandle(g_client_session_handle);
+        }
+
+        void StartClientThread(os::ThreadType *thread, os::NativeHandle client_session_handle) {
+            g_client_session_handle = client_session_handle;
+
+            R_ABORT_UNLESS(os::CreateThread(thread, ClientThreadFunction, nullptr, g_client_thread_stack, sizeof(g_client_thread_stack), os::DefaultThreadPriority));
+            os::SetThreadNamePointer(thread, "HipcClientThread");
+            os::StartThread(thread);
+        }
+
+        void FinishClientThread(os::ThreadType *thread) {
+            os::WaitThread(thread);
+            os::DestroyThread(thread);
+        }
+
+        void DoReceiveReplyTest() {
+            os::NativeHandle server_handle, client_handle;
+            R_ABORT_UNLESS(sf::hipc::CreateSession(std::addressof(server_handle), std::addressof(client_handle)));
+            ON_SCOPE_EXIT { os::CloseNativeHandle(server_handle); };
+
+            os::ThreadType client_thread;
+            StartClientThread(std::addressof(client_thread), client_handle);
+
+            /* Serve each request with explicit Receive/Reply calls. */
+            alignas(0x10) u8 message_buffer[sf::hipc::TlsMessageBufferSize];
+            const sf::cmif::PointerAndSize message(message_buffer, sizeof(message_buffer));
+
+            u32 num_served = 0;
+            const auto start = os::GetSystemTick();
+            while (true) {
+                bool closed;
+                R_ABORT_UNLESS(sf::hipc::Receive(std::addressof(closed), server_handle, message));
+                if (closed) {
+                    break;
+                }
+
+                const u32 value = GetMessageValue(message_buffer);
+                AMS_ABORT_UNLESS(value == num_served);
+                MakeMessage(message_buffer, value + 1);
+                R_ABORT_UNLESS(sf::hipc::Reply(server_handle, message));
+
+                ++num_served;
+            }
+            const auto elapsed = (os::GetSystemTick() - start).ToTimeSpan();
+
+            FinishClientThread(std::addressof(client_thread));
+            AMS_ABORT_UNLESS(num_served == RoundTripCount);
+
+            printf("Receive/Reply, %zu round trips: OK (%" PRId64 " ns per round trip)\n", RoundTripCount, elapsed.GetNanoSeconds() / static_cast<s64>(RoundTripCount));
+        }
+
+        void DoReplyAndReceiveTest() {
+            os::NativeHandle server_handle, client_handle;
+            R_ABORT_UNLESS(sf::hipc::CreateSession(std::addressof(server_handle), std::addressof(client_handle)));
+            ON_SCOPE_EXIT { os::CloseNativeHandle(server_handle); };
+
+            /* Link the session alongside an event which is never signaled, so that we check we receive only from the session. */
+            os::SystemEventType event;
+            R_ABORT_UNLESS(os::CreateSystemEvent(std::addressof(event), os::EventClearMode_ManualClear, true));
+            ON_SCOPE_EXIT { os::DestroySystemEvent(std::addressof(event)); };
+
+            os::MultiWaitType multi_wait;
+            os::MultiWaitHolderType event_holder, session_holder;
+            os::InitializeMultiWait(std::addressof(multi_wait));
+            os::InitializeMultiWaitHolder(std::addressof(event_holder), std::addressof(event));
+            sf::hipc::AttachMultiWaitHolderForReply(std::addressof(session_holder), server_handle);
+            os::LinkMultiWaitHolder(std::addressof(multi_wait), std::addressof(event_holder));
+            os::LinkMultiWaitHolder(std::addressof(multi_wait), std::addressof(session_holder));
+            ON_SCOPE_EXIT {
+                os::UnlinkAllMultiWaitHolder(std::addressof(multi_wait));
+                os::FinalizeMultiWaitHolder(std::addressof(session_holder));
+                os::FinalizeMultiWaitHolder(std::addressof(event_holder));
+                os::FinalizeMultiWait(std::addressof(multi_wait));
+            };
+
+            os::ThreadType client_thread;
+            StartClientThread(std::addressof(client_thread), client_handle);
+
+            /* Serve each request by replying to the previous one while receiving the next into our message buffer. */
+            const auto message = GetTlsMessage();
+
+            u32 num_served = 0;
+            os::NativeHandle reply_target = os::InvalidNativeHandle;
+            const auto start = os::GetSystemTick();
+            while (true) {
+                os::MultiWaitHolderType *signaled_holder = nullptr;
+                const Result result = os::SdkReplyAndReceive(std::addressof(signaled_holder), reply_target, std::addressof(multi_wait));
+                if (os::ResultSessionClosedForReceive::Includes(result)) {
+                    break;
+                }
+                R_ABORT_UNLESS(result);
+                AMS_ABORT_UNLESS(signaled_holder == std::addressof(session_holder));
+
+                const u32 value = GetMessageValue(message.GetPointer());
+                AMS_ABORT_UNLESS(value == num_served);
+                MakeMessage(message.GetPointer(), value + 1);
+
+                reply_target = server_handle;
+                ++num_served;
+            }
+            const auto elapsed = (os::GetSystemTick() - start).ToTimeSpan();
+
+            FinishClientThread(std::addressof(client_thread));
+            AMS_ABORT_UNLESS(num_served == RoundTripCount);
+
+            printf("ReplyAndReceive, %zu round trips: OK (%" PRId64 " ns per round trip)\n", RoundTripCount, elapsed.GetNanoSeconds() / static_cast<s64>(RoundTripCount));
+        }
+
+        void DoPortTest() {
+            os::NativeHandle server_port_handle, client_port_handle;
+            R_ABORT_UNLESS(sf::hipc::CreatePort(std::addressof(server_port_handle), std::addressof(client_port_handle), 1));
+            ON_SCOPE_EXIT {
+                os::CloseNativeHandle(client_port_handle);
+                os::CloseNativeHandle(server_port_handle);
+            };
+
+            os::MultiWaitType multi_wait;
+            os::MultiWaitHolderType port_holder;
+            os::InitializeMultiWait(std::addressof(multi_wait));
+            sf::hipc::AttachMultiWaitHolderForAccept(std::addressof(port_holder), server_port_handle);
+            os::LinkMultiWaitHolder(std::addressof(multi_wait), std::addressof(port_holder));
+            ON_SCOPE_EXIT {
+                os::UnlinkAllMultiWaitHolder(std::addressof(multi_wait));
+                os::FinalizeMultiWaitHolder(std::addressof(port_holder));
+                os::FinalizeMultiWait(std::addressof(multi_wait));
+            };
+
+            /* The port must not be signaled until a client connects. */
+            AMS_ABORT_UNLESS(os::TryWaitAny(std::addressof(multi_wait)) == nullptr);
+
+            os::NativeHandle client_handle;
+            R_ABORT_UNLESS(sf::hipc::ConnectToPort(std::addressof(client_handle), client_port_handle));
+
+            AMS_ABORT_UNLESS(os::WaitAny(std::addressof(multi_wait)) == std::addressof(port_holder));
+
+            os::NativeHandle server_handle;
+            R_ABORT_UNLESS(sf::hipc::AcceptSession(std::addressof(server_handle), server_port_handle));
+            ON_SCOPE_EXIT { os::CloseNativeHandle(server_handle); };
+
+            /* Once accepted, the port is no longer signaled, and the session works as any other. */
+            AMS_ABORT_UNLESS(os::TryWaitAny(std::addressof(multi_wait)) == nullptr);
+
+            os::ThreadType client_thread;
+            StartClientThread(std::addressof(client_thread), client_handle);
+
+            alignas(0x10) u8 message_buffer[sf::hipc::TlsMessageBufferSize];
+            const sf::cmif::PointerAndSize message(message_buffer, sizeof(message_buffer));
+
+            for (u32 i = 0; i < RoundTripCount; ++i) {
+                bool closed;
+                R_ABORT_UNLESS(sf::hipc::Receive(std::addressof(closed), server_handle, message));
+                AMS_ABORT_UNLESS(!closed);
+                MakeMessage(message_buffer, GetMessageValue(message_buffer) + 1);
+                R_ABORT_UNLESS(sf::hipc::Reply(server_handle, message));
+            }
+
+            FinishClientThread(std::addressof(client_thread));
+
+            bool closed;
+            R_ABORT_UNLESS(sf::hipc::Receive(std::addressof(closed), server_handle, message));
+            AMS_ABORT_UNLESS(closed);
+
+            printf("Port connect/accept: OK\n");
+        }
+
+        void DoClosedSessionTest() {
+            os::NativeHandle server_handle, client_handle;
+            R_ABORT_UNLESS(sf::hipc::CreateSession(std::addressof(server_handle), std::addressof(client_handle)));
+            ON_SCOPE_EXIT { os::CloseNativeHandle(client_handle); };
+
+            /* A closed session is reported as such to the client. */
+            os::CloseNativeHandle(server_handle);
+
+            u32 value;
+            AMS_ABORT_UNLESS(svc::ResultSessionClosed::Includes(SendValue(client_handle, std::addressof(value), 0)));
+
+            printf("Closed session: OK\n");
+        }
+
+        class TestService {
+            private:
+                os::SystemEventType m_event;
+            public:
+                TestService() {
+                    R_ABORT_UNLESS(os::CreateSystemEvent(std::addressof(m_event), os::EventClearMode_ManualClear, true));
+                }
+
+                ~TestService() {
+                    os::DestroySystemEvent(std::addressof(m_event));
+                }
+
+                os::SystemEventType *GetEvent() { return std::addressof(m_event); }
+            public:
+                Result Add(sf::Out<u32> out, u32 a, u32 b) {
+                    *out = a + b;
+                    R_SUCCEED();
+                }
+
+                Result ReverseBuffer(const sf::OutBuffer &out, const sf::InBuffer &in) {
+                    R_UNLESS(out.GetSize() == in.GetSize(), sf::ResultPreconditionViolation());
+                    std::reverse_copy(in.GetPointer(), in.GetPointer() + in.GetSize(), out.GetPointer());
+                    R_SUCCEED();
+                }
+
+                Result ReversePointer(const sf::OutPointerBuffer &out, const sf::InPointerBuffer &in) {
+                    R_UNLESS(out.GetSize() == in.GetSize(), sf::ResultPreconditionViolation());
+                    std::reverse_copy(in.GetPointer(), in.GetPointer() + in.GetSize(), out.GetPointer());
+                    R_SUCCEED();
+                }
+
+                Result GetProcessId(sf::Out<u64> out, const sf::ClientProcessId &client_process_id) {
+                    *out = client_process_id.GetValue().value;
+                    R_SUCCEED();
+                }
+
+                Result SignalEvent(sf::CopyHandle &&event_handle) {
+                    /* Signal through our copy of the handle, which is closed when we return. */
+                    os::SystemEventType event;
+                    os::AttachWritableHandleToSystemEvent(std::addressof(event), event_handle.GetOsHandle(), false, os::EventClearMode_ManualClear);
+                    os::SignalSystemEvent(std::addressof(event));
+                    os::DestroySystemEvent(std::addressof(event));
+                    R_SUCCEED();
+                }
+
+                Result GetEvent(sf::OutCopyHandle out) {
+                    out.SetValue(os::GetReadableHandleOfSystemEvent(std::addressof(m_event)), false);
+                    R_SUCCEED();
+                }
+        };
+        static_assert(test::IsITestService<TestService>);
+
+        struct TestServerOptions {
+            static constexpr size_t PointerBufferSize   = 0x400;
+            static constexpr size_t MaxDomains          = 0;
+            static constexpr size_t MaxDomainObjects    = 0;
+            static constexpr bool CanDeferInvokeRequest = false;
+            static constexpr bool CanManageMitmServers  = false;
+        };
+
+        using TestServerManager = sf::hipc::ServerManager<1, TestServerOptions, 2>;
+
+        alignas(os::MemoryPageSize) constinit u8 g_server_thread_stack[64_KB];
+
+        void ServerThreadFunction(void *arg) {
+            static_cast<TestServerManager *>(arg)->LoopProcess();
+        }
+
+        HipcRequest MakeCmifRequest(void *buffer, HipcMetadata meta, u32 command_id, const void *in_data, size_t in_data_size, u16 **out_pointer_sizes = nullptr, size_t num_out_pointer_sizes = 0) {
+            /* Raw data is preceded by 0x10 of alignment padding, and followed by the sizes of any unfixed-size out pointers. */
+            const size_t raw_size = 0x10 + sizeof(CmifInHeader) + in_data_size;
+            meta.type           = CmifCommandType_Request;
+            meta.num_data_words = util::AlignUp(raw_size + num_out_pointer_sizes * sizeof(u16), sizeof(u32)) / sizeof(u32);
+
+            const auto request = hipcMakeRequest(buffer, meta);
+
+            u8 * const raw = reinterpret_cast<u8 *>(util::AlignUp(reinterpret_cast<uintptr_t>(request.data_words), 0x10));
+            const CmifInHeader header = { .magic = CmifInHeaderMagic, .version = 0, .command_id = command_id, .token = 0 };
+            std::memcpy(raw, std::addressof(header), sizeof(header));
+            if (in_data_size > 0) {
+                std::memcpy(raw + sizeof(header), in_data, in_data_size);
+            }
+
+            if (out_pointer_sizes != nullptr) {
+                *out_pointer_sizes = reinterpret_cast<u16 *>(reinterpret_cast<u8 *>(request.data_words) + raw_size);
+            }
+
+            return request;
+        }
+
+        Result SendCmifRequest(HipcResponse *out_response, const void **out_data, os::NativeHandle session_handle) {
+            const auto message = GetTlsMessage();
+            R_TRY(sf::hipc::SendSyncRequest(session_handle, message));
+
+            const auto response = hipcParseResponse(message.GetPointer());
+            const CmifOutHeader *header = reinterpret_cast<const CmifOutHeader *>(util::AlignUp(reinterpret_cast<uintptr_t>(response.data_words), 0x10));
+            AMS_ABORT_UNLESS(header->magic == CmifOutHeaderMagic);
+
+            *out_response = response;
+            *out_data     = header + 1;
+            R_RETURN(header->result);
+        }
+
+        void FillPattern(u8 *buffer, size_t size, u8 seed) {
+            for (size_t i = 0; i < size; ++i) {
+                buffer[i] = static_cast<u8>(seed + i * 7);
+            }
+        }
+
+        bool IsReversedPattern(const u8 *buffer, size_t size, u8 seed) {
+            for (size_t i = 0; i < size; ++i) {
+                if (buffer[size - 1 - i] != static_cast<u8>(seed + i * 7)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void DoServerManagerTest() {
+            /* Serve a test object on a port from its own thread. */
+            os::NativeHandle server_port_handle, client_port_handle;
+            R_ABORT_UNLESS(sf::hipc::CreatePort(std::addressof(server_port_handle), std::addressof(client_port_handle), 1));
+            ON_SCOPE_EXIT {
+                os::CloseNativeHandle(client_port_handle);
+                os::CloseNativeHandle(server_port_handle);
+            };
+
+            sf::UnmanagedServiceObject<test::ITestService, TestService> service_object;
+            TestServerManager server_manager;
+            server_manager.RegisterObjectForServer(service_object.GetShared(), server_port_handle);
+
+            os::ThreadType server_thread;
+            R_ABORT_UNLESS(os::CreateThread(std::addressof(server_thread), ServerThreadFunction, std::addressof(server_manager), g_server_thread_stack, sizeof(g_server_thread_stack), os::DefaultThreadPriority));
+            os::SetThreadNamePointer(std::addressof(server_thread), "HipcServerThread");
+            os::StartThread(std::addressof(server_thread));
+
+            os::NativeHandle session_handle;
+            R_ABORT_UNLESS(sf::hipc::ConnectToPort(std::addressof(session_handle), client_port_handle));
+
+            void * const message_buffer = GetTlsMessage().GetPointer();
+            HipcResponse response;
+            const void *out_data;
+
+            /* In and out raw data. */
+            {
+                const auto start = os::GetSystemTick();
+                for (u32 i = 0; i < RoundTripCount; ++i) {
+                    const u32 in_data[2] = { i, 2 * i + 1 };
+                    MakeCmifRequest(message_buffer, {}, 0, in_data, sizeof(in_data));
+                    R_ABORT_UNLESS(SendCmifRequest(std::addressof(response), std::addressof(out_data), session_handle));
+                    AMS_ABORT_UNLESS(*static_cast<const u32 *>(out_data) == 3 * i + 1);
+                }
+                const auto elapsed = (os::GetSystemTick() - start).ToTimeSpan();
+
+                printf("ServerManager in/out data, %zu round trips: OK (%" PRId64 " ns per round trip)\n", RoundTripCount, elapsed.GetNanoSeconds() / static_cast<s64>(RoundTripCount));
+            }
+
+            /* Map alias buffers are passed through to the server. */
+            {
+                u8 in_buffer[0x1000], out_buffer[sizeof(in_buffer)] = {};
+                FillPattern(in_buffer, sizeof(in_buffer), 0x10);
+
+                const auto request = MakeCmifRequest(message_buffer, { .num_send_buffers = 1, .num_recv_buffers = 1 }, 1, nullptr, 0);
+                request.send_buffers[0] = hipcMakeBuffer(in_buffer,  sizeof(in_buffer),  HipcBufferMode_Normal);
+                request.recv_buffers[0] = hipcMakeBuffer(out_buffer, sizeof(out_buffer), HipcBufferMode_Normal);
+                R_ABORT_UNLESS(SendCmifRequest(std::addressof(response), std::addressof(out_data), session_handle));
+                AMS_ABORT_UNLESS(IsReversedPattern(out_buffer, sizeof(out_buffer), 0x10));
+
+                printf("ServerManager map alias buffers: OK\n");
+            }
+
+            /* Pointer buffers are copied into the server's pointer buffer, and back into our receive list. */
+            {
+                u8 in_buffer[0x180], out_buffer[0x200] = {};
+                FillPattern(in_buffer, sizeof(in_buffer), 0x20);
+
+                u16 *out_pointer_sizes;
+                const auto request = MakeCmifRequest(message_buffer, { .num_send_statics = 1, .num_recv_statics = HIPC_AUTO_RECV_STATIC }, 2, nullptr, 0, std::addressof(out_pointer_sizes), 1);
+                request.send_statics[0] = hipcMakeSendStatic(in_buffer, sizeof(in_buffer), 0);
+                request.recv_list[0]    = hipcMakeRecvStatic(out_buffer, sizeof(out_buffer));
+                out_pointer_sizes[0]    = sizeof(in_buffer);
+                R_ABORT_UNLESS(SendCmifRequest(std::addressof(response), std::addressof(out_data), session_handle));
+
+                AMS_ABORT_UNLESS(response.num_statics == 1);
+                AMS_ABORT_UNLESS(hipcGetStaticAddress(response.statics + 0) == out_buffer);
+                AMS_ABORT_UNLESS(hipcGetStaticSize(response.statics + 0) == sizeof(in_buffer));
+                AMS_ABORT_UNLESS(IsReversedPattern(out_buffer, sizeof(in_buffer), 0x20));
+
+                printf("ServerManager pointer buffers: OK\n");
+            }
+
+            /* A static larger than the server's pointer buffer fails only the request which sent it. */
+            {
+                u8 in_buffer[TestServerOptions::PointerBufferSize + 0x10] = {}, out_buffer[0x10];
+
+                u16 *out_pointer_sizes;
+                const auto request = MakeCmifRequest(message_buffer, { .num_send_statics = 1, .num_recv_statics = HIPC_AUTO_RECV_STATIC }, 2, nullptr, 0, std::addressof(out_pointer_sizes), 1);
+                request.send_statics[0] = hipcMakeSendStatic(in_buffer, sizeof(in_buffer), 0);
+                request.recv_list[0]    = hipcMakeRecvStatic(out_buffer, sizeof(out_buffer));
+                out_pointer_sizes[0]    = sizeof(in_buffer);
+                AMS_ABORT_UNLESS(svc::ResultReceiveListBroken::Includes(SendCmifRequest(std::addressof(response), std::addressof(out_data), session_handle)));
+
+                const u32 in_data[2] = { 5, 6 };
+                MakeCmifRequest(message_buffer, {}, 0, in_data, sizeof(in_data));
+                R_ABORT_UNLESS(SendCmifRequest(std::addressof(response), std::addressof(out_data), session_handle));
+                AMS_ABORT_UNLESS(*static_cast<const u32 *>(out_data) == 11);
+            }
+
+            /* As does a reply static larger than our receive list. */
+            {
+                u8 in_buffer[0x40] = {}, out_buffer[0x20];
+
+                u16 *out_pointer_sizes;
+                const auto request = MakeCmifRequest(message_buffer, { .num_send_statics = 1, .num_recv_statics = HIPC_AUTO_RECV_STATIC }, 2, nullptr, 0, std::addressof(out_pointer_sizes), 1);
+                request.send_statics[0] = hipcMakeSendStatic(in_buffer, sizeof(in_buffer), 0);
+                request.recv_list[0]    = hipcMakeRecvStatic(out_buffer, sizeof(out_buffer));
+                out_pointer_sizes[0]    = sizeof(in_buffer);
+                AMS_ABORT_UNLESS(svc::ResultReceiveListBroken::Includes(SendCmifRequest(std::addressof(response), std::addressof(out_data), session_handle)));
+
+                printf("ServerManager receive list overflow: OK\n");
+            }
+
+            /* The process id is filled in for the server. */
+            {
+                const u64 placeholder = 0;
+                MakeCmifRequest(message_buffer, { .send_pid = 1 }, 3, std::addressof(placeholder), sizeof(placeholder));
+                R_ABORT_UNLESS(SendCmifRequest(std::addressof(response), std::addressof(out_data), session_handle));
+                AMS_ABORT_UNLESS(*static_cast<const u64 *>(out_data) == static_cast<u64>(::getpid()));
+
+                printf("ServerManager process id: OK\n");
+            }
+
+            /* Copy handles are duplicated, so that both sides keep their own. */
+            {
+                os::SystemEventType event;
+                R_ABORT_UNLESS(os::CreateSystemEvent(std::addressof(event), os::EventClearMode_ManualClear, true));
+                ON_SCOPE_EXIT { os::DestroySystemEvent(std::addressof(event)); };
+
+                for (int i = 0; i < 2; ++i) {
+                    const auto request = MakeCmifRequest(message_buffer, { .num_copy_handles = 1 }, 4, nullptr, 0);
+                    request.copy_handles[0] = os::GetWritableHandleOfSystemEvent(std::addressof(event));
+                    R_ABORT_UNLESS(SendCmifRequest(std::addressof(response), std::addressof(out_data), session_handle));
+
+                    AMS_ABORT_UNLESS(os::TryWaitSystemEvent(std::addressof(event)));
+                    os::ClearSystemEvent(std::addressof(event));
+                }
+
+                for (int i = 0; i < 2; ++i) {
+                    MakeCmifRequest(message_buffer, {}, 5, nullptr, 0);
+                    R_ABORT_UNLESS(SendCmifRequest(std::addressof(response), std::addressof(out_data), session_handle));
+                    AMS_ABORT_UNLESS(response.num_copy_handles == 1);
+
+                    const os::NativeHandle readable_handle = response.copy_handles[0];
+                    AMS_ABORT_UNLESS(readable_handle != os::GetReadableHandleOfSystemEvent(service_object.GetImpl().GetEvent()));
+
+                    os::SystemEventType server_event;
+                    os::AttachReadableHandleToSystemEvent(std::addressof(server_event), readable_handle, true, os::EventClearMode_ManualClear);
+                    AMS_ABORT_UNLESS(!os::TryWaitSystemEvent(std::addressof(server_event)));
+                    os::SignalSystemEvent(service_object.GetImpl().GetEvent());
+                    AMS_ABORT_UNLESS(os::TryWaitSystemEvent(std::addressof(server_event)));
+                    os::ClearSystemEvent(service_object.GetImpl().GetEvent());
+                    os::DestroySystemEvent(std::addressof(server_event));
+                }
+
+                printf("ServerManager copy handles: OK\n");
+            }
+
+            /* Close our session, and stop the server. */
+            os::CloseNativeHandle(session_handle);
+            server_manager.RequestStopProcessing();
+            os::WaitThread(std::addressof(server_thread));
+            os::DestroyThread(std::addressof(server_thread));
+        }
+
+    }
+
+    void Main() {
+        printf("Doing hipc tests!\n");
+        DoReceiveReplyTest();
+        DoReplyAndReceiveTest();
+        DoPortTest();
+        DoClosedSessionTest();
+        DoServerManagerTest();
+
+        printf("All tests completed!\n");
+    }
+
+}
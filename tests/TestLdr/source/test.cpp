@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+#include "../../../stratosphere/loader/source/ldr_lz4_stream_decompressor.hpp"
+
+/* NOTE: The decompressor is part of the loader sysmodule rather than a library, so we build its implementation here. */
+#include "../../../stratosphere/loader/source/ldr_lz4_stream_decompressor.cpp"
+
+namespace ams {
+
+    namespace {
+
+        constexpr size_t DecompressedTestSize = 0x40000;
+        constexpr size_t CompressedTestSize   = DecompressedTestSize + DecompressedTestSize / 0xFF + 0x10;
+        constexpr size_t GuardSize            = 0x100;
+        constexpr u8 GuardValue               = 0xCC;
+
+        constexpr size_t RoundTripCount = 32;
+
+        constinit u8 g_original[DecompressedTestSize] = {};
+        constinit u8 g_compressed[CompressedTestSize] = {};
+        constinit u8 g_decompressed[DecompressedTestSize + GuardSize] = {};
+
+        util::TinyMT g_rng;
+
+        void GenerateTestData(u8 *dst, size_t size, u32 kind) {
+            switch (kind % 3) {
+                case 0:
+                    /* Random data, which lz4 will store as (mostly) literals. */
+                    g_rng.GenerateRandomBytes(dst, size);
+                    break;
+                case 1:
+                    /* Repeated short runs, which give overlapping matches. */
+                    for (size_t i = 0; i < size; ++i) {
+                        dst[i] = static_cast<u8>((i / (1 + (kind % 7))) & 0x3);
+                    }
+                    break;
+                case 2:
+                    /* Random fragments copied from earlier in the data, which give long literal and match lengths. */
+                    g_rng.GenerateRandomBytes(dst, std::min<size_t>(size, 0x400));
+                    for (size_t i = 0x400; i < size; /* ... */) {
+                        const size_t fragment_size = std::min<size_t>(size - i, 1 + (g_rng.GenerateRandomU32() % 0x200));
+                        if (g_rng.GenerateRandomU32() % 4 == 0) {
+                            g_rng.GenerateRandomBytes(dst + i, fragment_size);
+                        } else {
+                            const size_t from = g_rng.GenerateRandomU32() % (i - fragment_size + 1);
+                            std::memmove(dst + i, dst + from, fragment_size);
+                        }
+                        i += fragment_size;
+                    }
+                    break;
+            }
+        }
+
+        void ResetDecompressed() {
+            std::memset(g_decompressed, GuardValue, sizeof(g_decompressed));
+        }
+
+        bool IsGuardIntact(const u8 *guard, size_t size) {
+            for (size_t i = 0; i < size; ++i) {
+                if (guard[i] != GuardValue) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        Result DecompressInRandomChunks(ldr::Lz4StreamDecompressor &decompressor, size_t src_size) {
+            /* Make the data available a random amount at a time, sometimes a single byte, sometimes a lot. */
+            for (size_t available = 0; available < src_size; /* ... */) {
+                const u32 kind = g_rng.GenerateRandomU32() % 4;
+                const size_t step = kind == 0 ? 1 : (1 + g_rng.GenerateRandomU32() % (kind == 1 ? 0x10 : 0x4000));
+                available = std::min(src_size, available + step);
+
+                R_TRY(decompressor.Decompress(available));
+            }
+
+            R_SUCCEED();
+        }
+
+        void DoRoundTripTests() {
+            for (size_t i = 0; i < RoundTripCount; ++i) {
+                /* Generate and compress some data. */
+                const size_t size = 1 + g_rng.GenerateRandomU32() % DecompressedTestSize;
+                GenerateTestData(g_original, size, i);
+
+                const int compressed_size = util::CompressLZ4(g_compressed, sizeof(g_compressed), g_original, size);
+                AMS_ABORT_UNLESS(compressed_size > 0);
+
+                /* Decompress it as it streams in. */
+                ResetDecompressed();
+                ldr::Lz4StreamDecompressor decompressor(g_decompressed, size, g_compressed, compressed_size);
+                R_ABORT_UNLESS(DecompressInRandomChunks(decompressor, compressed_size));
+
+                AMS_ABORT_UNLESS(decompressor.IsCompleted());
+                AMS_ABORT_UNLESS(decompressor.GetDecompressedSize() == size);
+                AMS_ABORT_UNLESS(std::memcmp(g_decompressed, g_original, size) == 0);
+                AMS_ABORT_UNLESS(IsGuardIntact(g_decompressed + size, GuardSize));
+            }
+
+            printf("Lz4 stream round trips, %zu buffers: OK\n", RoundTripCount);
+        }
+
+        void DoInPlaceTest() {
+            /* The loader reads a compressed segment into the end of the module's mapping, just past the segment, and decompresses over it. */
+            constexpr size_t InPlaceMargin = 0x10;
+            static_assert(InPlaceMargin <= GuardSize);
+
+            const size_t size = DecompressedTestSize;
+            GenerateTestData(g_original, size, 1);
+
+            const int compressed_size = util::CompressLZ4(g_compressed, sizeof(g_compressed), g_original, size);
+            AMS_ABORT_UNLESS(compressed_size > 0 && static_cast<size_t>(compressed_size) < size);
+
+            ResetDecompressed();
+            u8 *src = g_decompressed + size + InPlaceMargin - compressed_size;
+            std::memcpy(src, g_compressed, compressed_size);
+
+            ldr::Lz4StreamDecompressor decompressor(g_decompressed, size, src, compressed_size);
+            R_ABORT_UNLESS(DecompressInRandomChunks(decompressor, compressed_size));
+
+            AMS_ABORT_UNLESS(decompressor.IsCompleted());
+            AMS_ABORT_UNLESS(decompressor.GetDecompressedSize() == size);
+            AMS_ABORT_UNLESS(std::memcmp(g_decompressed, g_original, size) == 0);
+
+            printf("Lz4 stream in place: OK\n");
+        }
+
+        void CheckMalformed(const char *name, const u8 *src, size_t src_size, size_t dst_size) {
+            /* Feed the data in every way it can be split in two, as well as all at once. */
+            for (size_t split = 0; split <= src_size; ++split) {
+                ResetDecompressed();
+                ldr::Lz4StreamDecompressor decompressor(g_decompressed, dst_size, src, src_size);
+
+                Result result = ResultSuccess();
+                if (split > 0 && split < src_size) {
+                    result = decompressor.Decompress(split);
+                }
+                if (R_SUCCEEDED(result)) {
+                    result = decompressor.Decompress(src_size);
+                }
+
+                AMS_ABORT_UNLESS(ldr::ResultInvalidNso::Includes(result));
+                AMS_ABORT_UNLESS(decompressor.GetDecompressedSize() <= dst_size);
+                AMS_ABORT_UNLESS(IsGuardIntact(g_decompressed + dst_size, sizeof(g_decompressed) - dst_size));
+            }
+
+            printf("Lz4 stream %s: OK\n", name);
+        }
+
+        void DoMalformedTests() {
+            constexpr size_t DstSize = 0x20;
+
+            /* A sequence promising more literals than remain in the data. */
+            {
+                constexpr u8 Data[] = { 0x80, 'A', 'B', 'C', 'D' };
+                CheckMalformed("truncated literals", Data, sizeof(Data), DstSize);
+            }
+
+            /* An extended literal size which runs off the end of the data. */
+            {
+                constexpr u8 Data[] = { 0xF0, 0xFF, 0xFF };
+                CheckMalformed("truncated literal size", Data, sizeof(Data), DstSize);
+            }
+
+            /* A match reaching back before the start of the output. */
+            {
+                constexpr u8 Data[] = { 0x20, 'A', 'B', 0x03, 0x00, 0x10, 'C' };
+                CheckMalformed("match offset past output", Data, sizeof(Data), DstSize);
+            }
+
+            /* A match with offset zero. */
+            {
+                constexpr u8 Data[] = { 0x10, 'A', 0x00, 0x00, 0x10, 'B' };
+                CheckMalformed("zero match offset", Data, sizeof(Data), DstSize);
+            }
+
+            /* A match running past the end of the output. */
+            {
+                constexpr u8 Data[] = { 0x1F, 'A', 0x01, 0x00, 0x20, 0x10, 'B' };
+                CheckMalformed("match past output end", Data, sizeof(Data), DstSize);
+            }
+
+            /* Literals running past the end of the output. */
+            {
+                u8 data[2 + 0x2F];
+                data[0] = 0xF0;
+                data[1] = 0x20;
+                std::memset(data + 2, 'A', 0x2F);
+                CheckMalformed("literals past output end", data, sizeof(data), DstSize);
+            }
+
+            /* A sequence cut off in its match offset. */
+            {
+                constexpr u8 Data[] = { 0x10, 'A', 0x01 };
+                CheckMalformed("truncated match offset", Data, sizeof(Data), DstSize);
+            }
+        }
+
+    }
+
+    void Main() {
+        printf("Doing ldr tests!\n");
+        g_rng.Initialize(0x4C5A3421);
+
+        DoRoundTripTests();
+        DoInPlaceTest();
+        DoMalformedTests();
+
+        printf("All tests completed!\n");
+    }
+
+}
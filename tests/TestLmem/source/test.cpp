@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+
+namespace ams {
+
+    namespace {
+
+        constexpr size_t HeapSize            = 1_MB;
+        constexpr size_t MaxLiveBlocks       = 0x8000;
+        constexpr size_t FragmentationRounds = 0x40000;
+
+        alignas(0x10) constinit u8 g_heap_memory[HeapSize];
+
+        constinit void *g_live_blocks[MaxLiveBlocks];
+        constinit size_t g_num_live_blocks;
+
+        constinit u32 g_random_state;
+
+        u32 GetRandom() {
+            /* xorshift32, so that every run replays the same trace. */
+            g_random_state ^= g_random_state << 13;
+            g_random_state ^= g_random_state >> 17;
+            g_random_state ^= g_random_state << 5;
+            return g_random_state;
+        }
+
+        void FreeLiveBlock(lmem::HeapHandle heap, size_t index) {
+            lmem::FreeToExpHeap(heap, g_live_blocks[index]);
+            g_live_blocks[index] = g_live_blocks[--g_num_live_blocks];
+        }
+
+        void CountAllocatedBlock(void *, lmem::HeapHandle, uintptr_t user_data) {
+            ++*reinterpret_cast<size_t *>(user_data);
+        }
+
+        void DoPlacementTests() {
+            lmem::HeapHandle heap = lmem::CreateExpHeap(g_heap_memory, sizeof(g_heap_memory), lmem::CreateOption_SegregatedFit);
+            AMS_ABORT_UNLESS(heap != nullptr);
+            AMS_ABORT_UNLESS((heap->option & lmem::CreateOption_SegregatedFit) != 0);
+            ON_SCOPE_EXIT { lmem::DestroyExpHeap(heap); };
+
+            const size_t initial_free_size = lmem::GetExpHeapTotalFreeSize(heap);
+
+            /* Allocations from the back must be carved from the end of a block. */
+            {
+                void *back = lmem::AllocateFromExpHeap(heap, 0x100, -0x10);
+                AMS_ABORT_UNLESS(back != nullptr);
+                AMS_ABORT_UNLESS(util::IsAligned(reinterpret_cast<uintptr_t>(back), 0x10));
+                AMS_ABORT_UNLESS(static_cast<u8 *>(back) + lmem::GetExpHeapMemoryBlockSize(back) == heap->heap_end);
+
+                void *front = lmem::AllocateFromExpHeap(heap, 0x100, 0x10);
+                AMS_ABORT_UNLESS(front != nullptr);
+                AMS_ABORT_UNLESS(front < back);
+
+                lmem::FreeToExpHeap(heap, front);
+                lmem::FreeToExpHeap(heap, back);
+                AMS_ABORT_UNLESS(lmem::GetExpHeapTotalFreeSize(heap) == initial_free_size);
+            }
+
+            /* Best-fit must take the smallest free block which can hold the allocation. */
+            {
+                constexpr size_t GapSizes[] = { 0x400, 0x200, 0x108, 0x180 };
+
+                void *gaps[util::size(GapSizes)];
+                void *separators[util::size(GapSizes)];
+                for (size_t i = 0; i < util::size(GapSizes); ++i) {
+                    gaps[i]       = lmem::AllocateFromExpHeap(heap, GapSizes[i]);
+                    separators[i] = lmem::AllocateFromExpHeap(heap, 0x40);
+                    AMS_ABORT_UNLESS(gaps[i] != nullptr && separators[i] != nullptr);
+                }
+                for (auto *gap : gaps) {
+                    lmem::FreeToExpHeap(heap, gap);
+                }
+
+                lmem::SetExpHeapAllocationMode(heap, lmem::AllocationMode_BestFit);
+                void *best = lmem::AllocateFromExpHeap(heap, 0x100);
+                AMS_ABORT_UNLESS(best == gaps[2]);
+                lmem::SetExpHeapAllocationMode(heap, lmem::AllocationMode_FirstFit);
+
+                lmem::FreeToExpHeap(heap, best);
+                for (auto *separator : separators) {
+                    lmem::FreeToExpHeap(heap, separator);
+                }
+                AMS_ABORT_UNLESS(lmem::GetExpHeapTotalFreeSize(heap) == initial_free_size);
+            }
+
+            printf("Indexed placement: OK\n");
+        }
+
+        void DoFragmentationBenchmark(const char *name, u32 option, lmem::AllocationMode mode) {
+            lmem::HeapHandle heap = lmem::CreateExpHeap(g_heap_memory, sizeof(g_heap_memory), option);
+            AMS_ABORT_UNLESS(heap != nullptr);
+            ON_SCOPE_EXIT { lmem::DestroyExpHeap(heap); };
+
+            lmem::SetExpHeapAllocationMode(heap, mode);
+            const size_t initial_free_size = lmem::GetExpHeapTotalFreeSize(heap);
+
+            /* Fragment the heap, by filling it with small blocks and then freeing every other one. */
+            g_random_state    = 0x12345678;
+            g_num_live_blocks = 0;
+            while (g_num_live_blocks < MaxLiveBlocks) {
+                void *block = lmem::AllocateFromExpHeap(heap, 0x10 + GetRandom() % 0x30);
+                if (block == nullptr) {
+                    break;
+                }
+                g_live_blocks[g_num_live_blocks++] = block;
+            }
+            size_t num_kept = 0;
+            for (size_t i = 0; i < g_num_live_blocks; ++i) {
+                if ((i % 2) == 0) {
+                    lmem::FreeToExpHeap(heap, g_live_blocks[i]);
+                } else {
+                    g_live_blocks[num_kept++] = g_live_blocks[i];
+                }
+            }
+            g_num_live_blocks = num_kept;
+
+            /* Replay a mixed trace of allocations (from both ends, with various alignments) and frees. */
+            size_t num_failed = 0;
+            const auto start = os::GetSystemTick();
+            for (size_t i = 0; i < FragmentationRounds; ++i) {
+                const u32 random = GetRandom();
+                if ((random & 1) != 0 && g_num_live_blocks > 0) {
+                    FreeLiveBlock(heap, (random >> 1) % g_num_live_blocks);
+                } else if (g_num_live_blocks < MaxLiveBlocks) {
+                    const s32 alignment = ((random >> 1) % 4 == 0) ? -8 : (((random >> 3) % 8 == 0) ? 0x40 : 8);
+                    if (void *block = lmem::AllocateFromExpHeap(heap, 8 + (random >> 6) % 0x78, alignment); block != nullptr) {
+                        g_live_blocks[g_num_live_blocks++] = block;
+                    } else {
+                        ++num_failed;
+                    }
+                }
+            }
+            const auto elapsed = (os::GetSystemTick() - start).ToTimeSpan();
+
+            /* Free everything, and check that nothing is left allocated. */
+            /* NOTE: The free list drops back margins too small to become free blocks, so its free size may not fully recover. */
+            const size_t num_live = g_num_live_blocks;
+            while (g_num_live_blocks > 0) {
+                FreeLiveBlock(heap, g_num_live_blocks - 1);
+            }
+
+            size_t num_allocated = 0;
+            lmem::VisitExpHeapAllocatedBlocks(heap, CountAllocatedBlock, reinterpret_cast<uintptr_t>(std::addressof(num_allocated)));
+            AMS_ABORT_UNLESS(num_allocated == 0);
+
+            const size_t lost_size = initial_free_size - lmem::GetExpHeapTotalFreeSize(heap);
+            printf("%s, %zu operations: OK (%" PRId64 " ns per operation, %zu live, %zu failed, %zu bytes lost)\n", name, FragmentationRounds, elapsed.GetNanoSeconds() / static_cast<s64>(FragmentationRounds), num_live, num_failed, lost_size);
+        }
+
+    }
+
+    void Main() {
+        printf("Doing lmem tests!\n");
+        DoPlacementTests();
+
+        DoFragmentationBenchmark("Free list, first-fit",      lmem::CreateOption_None,          lmem::AllocationMode_FirstFit);
+        DoFragmentationBenchmark("Free list, best-fit",       lmem::CreateOption_None,          lmem::AllocationMode_BestFit);
+        DoFragmentationBenchmark("Segregated fit, first-fit", lmem::CreateOption_SegregatedFit, lmem::AllocationMode_FirstFit);
+        DoFragmentationBenchmark("Segregated fit, best-fit",  lmem::CreateOption_SegregatedFit, lmem::AllocationMode_BestFit);
+
+        printf("All tests completed!\n");
+    }
+
+}
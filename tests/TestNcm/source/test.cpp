@@ -0,0 +1,398 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+#include "../../../libraries/libstratosphere/source/ncm/ncm_content_storage_impl.hpp"
+#include "../../../libraries/libstratosphere/source/ncm/ncm_file_handle_cache.hpp"
+
+namespace ams {
+
+    namespace fssrv::impl {
+
+        const char *GetExecutionDirectoryPath();
+
+    }
+
+    namespace {
+
+        #define TEST_R_EXPECT(__EXPR__, __EXPECTED__)                                                                                                                        \
+        ({                                                                                                                                                                   \
+            const Result __test_result = (__EXPR__);                                                                                                                         \
+            if (!(__EXPECTED__ ::Includes(__test_result))) {                                                                                                                 \
+                printf("Unexpected result: %s gave 0x%08x (2%03d-%04d)\n", # __EXPR__, __test_result.GetValue(), __test_result.GetModule(), __test_result.GetDescription()); \
+                AMS_ABORT("Test failed");                                                                                                                                    \
+            }                                                                                                                                                                \
+            __test_result;                                                                                                                                                   \
+        })
+
+        #define TEST_R_TRY(__EXPR__)                                                                                                                                         \
+        ({                                                                                                                                                                   \
+            const Result __test_result = (__EXPR__);                                                                                                                         \
+            if (R_FAILED(__test_result)) {                                                                                                                                   \
+                printf("Unexpected result: %s gave 0x%08x (2%03d-%04d)\n", # __EXPR__, __test_result.GetValue(), __test_result.GetModule(), __test_result.GetDescription()); \
+                AMS_ABORT("Test failed");                                                                                                                                    \
+            }                                                                                                                                                                \
+            __test_result;                                                                                                                                                   \
+        })
+
+        constexpr size_t ContentIdTestCount = 37;
+
+        ncm::ContentId MakeContentIdForTest(size_t index) {
+            /* Scramble the leading bytes, so that the sorted order differs from the order the ids are registered in. */
+            ncm::ContentId content_id = {};
+            const u32 scrambled = static_cast<u32>(index) * 0x9E3779B1u;
+            std::memcpy(content_id.uuid.data, std::addressof(scrambled), sizeof(scrambled));
+            content_id.uuid.data[sizeof(content_id.uuid.data) - 1] = static_cast<u8>(index);
+            return content_id;
+        }
+
+        /* ==================================================================================================================== */
+        /* FileHandleCache                                                                                                      */
+        /* ==================================================================================================================== */
+
+        constexpr size_t FileHandleCacheTestEntryCount = 4;
+
+        using FileHandleCacheForTest = ncm::FileHandleCache<ncm::ContentId, FileHandleCacheTestEntryCount>;
+
+        constinit uintptr_t g_closed_handles[0x20];
+        constinit size_t g_closed_handle_count = 0;
+
+        void CloseFileForTest(fs::FileHandle handle) {
+            AMS_ABORT_UNLESS(g_closed_handle_count < util::size(g_closed_handles));
+            g_closed_handles[g_closed_handle_count++] = reinterpret_cast<uintptr_t>(handle.handle);
+        }
+
+        fs::FileHandle MakeFileHandleForTest(uintptr_t value) {
+            return fs::FileHandle{ reinterpret_cast<void *>(value) };
+        }
+
+        void CheckClosedHandles(std::initializer_list<uintptr_t> expected) {
+            AMS_ABORT_UNLESS(g_closed_handle_count == expected.size());
+
+            size_t i = 0;
+            for (const auto value : expected) {
+                AMS_ABORT_UNLESS(g_closed_handles[i++] == value);
+            }
+
+            g_closed_handle_count = 0;
+        }
+
+        void CheckFileCacheState(const ncm::FileCacheStatistics &statistics, u64 hit_count, u64 miss_count, u64 eviction_count) {
+            ncm::FileCacheState state;
+            statistics.GetFileCacheState(std::addressof(state));
+            AMS_ABORT_UNLESS(state.hit_count      == hit_count);
+            AMS_ABORT_UNLESS(state.miss_count     == miss_count);
+            AMS_ABORT_UNLESS(state.eviction_count == eviction_count);
+        }
+
+        /* Acquires the id's handle, opening a new one with the given value on a miss, and releases it. */
+        bool UseFileHandleForTest(FileHandleCacheForTest &cache, const ncm::ContentId &content_id, uintptr_t value_on_miss, uintptr_t *out_value = nullptr) {
+            fs::FileHandle handle;
+            u64 generation;
+            const bool hit = cache.Acquire(std::addressof(handle), std::addressof(generation), content_id);
+            if (!hit) {
+                handle = MakeFileHandleForTest(value_on_miss);
+            }
+
+            if (out_value != nullptr) {
+                *out_value = reinterpret_cast<uintptr_t>(handle.handle);
+            }
+
+            cache.Release(content_id, handle, generation);
+            return hit;
+        }
+
+        void DoFileHandleCacheTests() {
+            ncm::ContentId ids[FileHandleCacheTestEntryCount + 2];
+            for (size_t i = 0; i < util::size(ids); ++i) {
+                ids[i] = MakeContentIdForTest(i);
+            }
+
+            /* A released handle is handed back out for the same id, and only for that id. */
+            {
+                ncm::FileCacheStatistics statistics;
+                FileHandleCacheForTest cache(CloseFileForTest, std::addressof(statistics), FileHandleCacheTestEntryCount);
+
+                uintptr_t value;
+                AMS_ABORT_UNLESS(!UseFileHandleForTest(cache, ids[0], 0x100));
+                AMS_ABORT_UNLESS(UseFileHandleForTest(cache, ids[0], 0x101, std::addressof(value)));
+                AMS_ABORT_UNLESS(value == 0x100);
+                AMS_ABORT_UNLESS(!UseFileHandleForTest(cache, ids[1], 0x200));
+                AMS_ABORT_UNLESS(UseFileHandleForTest(cache, ids[1], 0x201, std::addressof(value)));
+                AMS_ABORT_UNLESS(value == 0x200);
+
+                CheckFileCacheState(statistics, 2, 2, 0);
+                CheckClosedHandles({});
+
+                /* A handle is never shared; while one is checked out, a second user misses, and the redundant handle is closed on release. */
+                fs::FileHandle handle;
+                u64 generation;
+                AMS_ABORT_UNLESS(cache.Acquire(std::addressof(handle), std::addressof(generation), ids[0]));
+                AMS_ABORT_UNLESS(!UseFileHandleForTest(cache, ids[0], 0x102));
+                cache.Release(ids[0], handle, generation);
+                CheckClosedHandles({ 0x100 });
+                AMS_ABORT_UNLESS(UseFileHandleForTest(cache, ids[0], 0x103, std::addressof(value)));
+                AMS_ABORT_UNLESS(value == 0x102);
+            }
+            CheckClosedHandles({ 0x102, 0x200 });
+            printf("FileHandleCache hit: OK\n");
+
+            /* At capacity, the least recently used handle is evicted. */
+            {
+                ncm::FileCacheStatistics statistics;
+                FileHandleCacheForTest cache(CloseFileForTest, std::addressof(statistics), FileHandleCacheTestEntryCount);
+
+                for (size_t i = 0; i < FileHandleCacheTestEntryCount; ++i) {
+                    AMS_ABORT_UNLESS(!UseFileHandleForTest(cache, ids[i], 0x100 * (i + 1)));
+                }
+
+                /* Make the first id the most recently used, so that the second is evicted instead. */
+                AMS_ABORT_UNLESS(UseFileHandleForTest(cache, ids[0], 0));
+                CheckClosedHandles({});
+
+                AMS_ABORT_UNLESS(!UseFileHandleForTest(cache, ids[FileHandleCacheTestEntryCount], 0x1000));
+                CheckClosedHandles({ 0x200 });
+                CheckFileCacheState(statistics, 1, FileHandleCacheTestEntryCount + 1, 1);
+
+                AMS_ABORT_UNLESS(UseFileHandleForTest(cache, ids[0], 0));
+                AMS_ABORT_UNLESS(UseFileHandleForTest(cache, ids[FileHandleCacheTestEntryCount], 0));
+                AMS_ABORT_UNLESS(!UseFileHandleForTest(cache, ids[1], 0x201));
+                CheckClosedHandles({ 0x300 });
+                CheckFileCacheState(statistics, 3, FileHandleCacheTestEntryCount + 2, 2);
+
+                /* Shrinking the cache closes every cached handle, and limits how many are held. */
+                cache.SetEntryCount(1);
+                AMS_ABORT_UNLESS(g_closed_handle_count == FileHandleCacheTestEntryCount);
+                g_closed_handle_count = 0;
+
+                AMS_ABORT_UNLESS(!UseFileHandleForTest(cache, ids[0], 0x2000));
+                AMS_ABORT_UNLESS(!UseFileHandleForTest(cache, ids[1], 0x2001));
+                CheckClosedHandles({ 0x2000 });
+                AMS_ABORT_UNLESS(!UseFileHandleForTest(cache, ids[0], 0x2002));
+                CheckClosedHandles({ 0x2001 });
+            }
+            CheckClosedHandles({ 0x2002 });
+            printf("FileHandleCache eviction: OK\n");
+
+            /* Invalidating an id closes its cached handle, and a handle checked out at the time is closed when released. */
+            {
+                ncm::FileCacheStatistics statistics;
+                FileHandleCacheForTest cache(CloseFileForTest, std::addressof(statistics), FileHandleCacheTestEntryCount);
+
+                AMS_ABORT_UNLESS(!UseFileHandleForTest(cache, ids[0], 0x100));
+                AMS_ABORT_UNLESS(!UseFileHandleForTest(cache, ids[1], 0x200));
+                cache.Invalidate(ids[0]);
+                CheckClosedHandles({ 0x100 });
+                AMS_ABORT_UNLESS(!UseFileHandleForTest(cache, ids[0], 0x101));
+                AMS_ABORT_UNLESS(UseFileHandleForTest(cache, ids[1], 0));
+
+                /* Check a handle out of the cache, and invalidate its id while it's out. */
+                fs::FileHandle handle;
+                u64 generation;
+                AMS_ABORT_UNLESS(cache.Acquire(std::addressof(handle), std::addressof(generation), ids[0]));
+                AMS_ABORT_UNLESS(reinterpret_cast<uintptr_t>(handle.handle) == 0x101);
+                cache.Invalidate(ids[0]);
+                CheckClosedHandles({});
+                cache.Release(ids[0], handle, generation);
+                CheckClosedHandles({ 0x101 });
+                AMS_ABORT_UNLESS(!UseFileHandleForTest(cache, ids[0], 0x102));
+
+                /* Likewise for a handle opened after a miss. */
+                AMS_ABORT_UNLESS(!cache.Acquire(std::addressof(handle), std::addressof(generation), ids[2]));
+                cache.InvalidateAll();
+                CheckClosedHandles({ 0x102, 0x200 });
+                cache.Release(ids[2], MakeFileHandleForTest(0x300), generation);
+                CheckClosedHandles({ 0x300 });
+                AMS_ABORT_UNLESS(!UseFileHandleForTest(cache, ids[2], 0x301));
+            }
+            CheckClosedHandles({ 0x301 });
+            printf("FileHandleCache invalidate: OK\n");
+        }
+
+        /* ==================================================================================================================== */
+        /* ContentStorage                                                                                                       */
+        /* ==================================================================================================================== */
+
+        bool IsContentIdLess(const ncm::ContentId &lhs, const ncm::ContentId &rhs) {
+            return std::memcmp(lhs.uuid.data, rhs.uuid.data, sizeof(lhs.uuid.data)) < 0;
+        }
+
+        void RegisterContentForTest(ncm::ContentStorageImpl &storage, const ncm::ContentId &content_id) {
+            ncm::PlaceHolderId placeholder_id;
+            TEST_R_TRY(storage.GeneratePlaceHolderId(std::addressof(placeholder_id)));
+            TEST_R_TRY(storage.CreatePlaceHolder(placeholder_id, content_id, sizeof(content_id)));
+            TEST_R_TRY(storage.WritePlaceHolder(placeholder_id, 0, sf::InBuffer(std::addressof(content_id), sizeof(content_id))));
+            TEST_R_TRY(storage.Register(placeholder_id, content_id));
+        }
+
+        void CheckContentIdPaging(ncm::ContentStorageImpl &storage, const ncm::ContentId *expected, size_t expected_count) {
+            /* Check the count. */
+            s32 count;
+            TEST_R_TRY(storage.GetContentCount(std::addressof(count)));
+            AMS_ABORT_UNLESS(static_cast<size_t>(count) == expected_count);
+
+            /* Page through the ids with a variety of page sizes, including ones that don't divide the count. */
+            ncm::ContentId ids[ContentIdTestCount + 1];
+            for (const size_t page_size : { static_cast<size_t>(1), static_cast<size_t>(5), static_cast<size_t>(8), ContentIdTestCount + 1 }) {
+                size_t listed = 0;
+                while (true) {
+                    TEST_R_TRY(storage.ListContentId(std::addressof(count), sf::OutArray<ncm::ContentId>(ids, page_size), static_cast<s32>(listed)));
+                    AMS_ABORT_UNLESS(static_cast<size_t>(count) <= page_size);
+
+                    /* Each page must continue exactly where the previous one ended. */
+                    for (s32 i = 0; i < count; ++i) {
+                        AMS_ABORT_UNLESS(listed + i < expected_count);
+                        AMS_ABORT_UNLESS(ids[i] == expected[listed + i]);
+                    }
+                    listed += count;
+
+                    if (static_cast<size_t>(count) < page_size) {
+                        break;
+                    }
+                }
+                AMS_ABORT_UNLESS(listed == expected_count);
+            }
+
+            /* Check a page starting in the middle of the list. */
+            const size_t offset = expected_count / 2;
+            TEST_R_TRY(storage.ListContentId(std::addressof(count), sf::OutArray<ncm::ContentId>(ids, 3), static_cast<s32>(offset)));
+            AMS_ABORT_UNLESS(static_cast<size_t>(count) == std::min<size_t>(3, expected_count - offset));
+            for (s32 i = 0; i < count; ++i) {
+                AMS_ABORT_UNLESS(ids[i] == expected[offset + i]);
+            }
+
+            /* Check that offsets at or past the end list nothing, and that negative offsets are rejected. */
+            TEST_R_TRY(storage.ListContentId(std::addressof(count), sf::OutArray<ncm::ContentId>(ids, util::size(ids)), static_cast<s32>(expected_count)));
+            AMS_ABORT_UNLESS(count == 0);
+            TEST_R_TRY(storage.ListContentId(std::addressof(count), sf::OutArray<ncm::ContentId>(ids, util::size(ids)), static_cast<s32>(expected_count + 10)));
+            AMS_ABORT_UNLESS(count == 0);
+            TEST_R_EXPECT(storage.ListContentId(std::addressof(count), sf::OutArray<ncm::ContentId>(ids, util::size(ids)), -1), ncm::ResultInvalidOffset);
+        }
+
+        void DoContentStorageListTests() {
+            /* Create an empty content storage. */
+            char root_path[fs::EntryNameLengthMax + 1];
+            util::SNPrintf(root_path, sizeof(root_path), "%s%s", fssrv::impl::GetExecutionDirectoryPath(), "ncm_test_storage");
+            fs::DeleteDirectoryRecursively(root_path);
+            TEST_R_TRY(fs::CreateDirectory(root_path));
+            TEST_R_TRY(ncm::ContentStorageImpl::InitializeBase(root_path));
+
+            {
+                ncm::ContentStorageImpl storage;
+                TEST_R_TRY(storage.Initialize(root_path, ncm::MakeFlatContentFilePath, ncm::MakeFlatPlaceHolderFilePath, false, nullptr));
+
+                /* Register the first half of the contents, and list them; this builds the id list from the directory. */
+                ncm::ContentId expected[ContentIdTestCount];
+                size_t expected_count = 0;
+                for (/* ... */; expected_count < ContentIdTestCount / 2; ++expected_count) {
+                    expected[expected_count] = MakeContentIdForTest(expected_count);
+                    RegisterContentForTest(storage, expected[expected_count]);
+                }
+                std::sort(expected, expected + expected_count, IsContentIdLess);
+                CheckContentIdPaging(storage, expected, expected_count);
+                printf("List built contents: OK\n");
+
+                /* Register the rest; these are inserted into the existing list. */
+                for (/* ... */; expected_count < ContentIdTestCount; ++expected_count) {
+                    expected[expected_count] = MakeContentIdForTest(expected_count);
+                    RegisterContentForTest(storage, expected[expected_count]);
+                }
+                std::sort(expected, expected + expected_count, IsContentIdLess);
+                CheckContentIdPaging(storage, expected, expected_count);
+                printf("List inserted contents: OK\n");
+
+                /* Registering a content twice must not duplicate it. */
+                {
+                    ncm::PlaceHolderId placeholder_id;
+                    TEST_R_TRY(storage.GeneratePlaceHolderId(std::addressof(placeholder_id)));
+                    TEST_R_TRY(storage.CreatePlaceHolder(placeholder_id, expected[0], sizeof(expected[0])));
+                    TEST_R_EXPECT(storage.Register(placeholder_id, expected[0]), ncm::ResultContentAlreadyExists);
+                    TEST_R_TRY(storage.DeletePlaceHolder(placeholder_id));
+                }
+                CheckContentIdPaging(storage, expected, expected_count);
+                printf("List duplicate content: OK\n");
+
+                /* Delete the first, last, and a middle content. */
+                for (const size_t index : { expected_count - 1, expected_count / 2, static_cast<size_t>(0) }) {
+                    TEST_R_TRY(storage.Delete(expected[index]));
+                    std::memmove(expected + index, expected + index + 1, (expected_count - index - 1) * sizeof(expected[0]));
+                    --expected_count;
+                }
+                CheckContentIdPaging(storage, expected, expected_count);
+                printf("List after delete: OK\n");
+
+                /* Reads of a content reuse its handle, and are counted in the file cache report. */
+                {
+                    ncm::FileCacheReport before;
+                    ncm::GetFileCacheReport(std::addressof(before));
+
+                    for (size_t i = 0; i < 3; ++i) {
+                        ncm::ContentId read_id;
+                        TEST_R_TRY(storage.ReadContentIdFile(sf::OutBuffer(std::addressof(read_id), sizeof(read_id)), expected[0], 0));
+                        AMS_ABORT_UNLESS(read_id == expected[0]);
+                    }
+
+                    ncm::FileCacheReport after;
+                    ncm::GetFileCacheReport(std::addressof(after));
+                    AMS_ABORT_UNLESS(after.content_file_cache_state.miss_count == before.content_file_cache_state.miss_count + 1);
+                    AMS_ABORT_UNLESS(after.content_file_cache_state.hit_count  == before.content_file_cache_state.hit_count + 2);
+
+                    /* Deleting the content invalidates its handle. */
+                    TEST_R_TRY(storage.Delete(expected[0]));
+                    ncm::ContentId read_id;
+                    TEST_R_EXPECT(storage.ReadContentIdFile(sf::OutBuffer(std::addressof(read_id), sizeof(read_id)), expected[0], 0), ncm::ResultContentNotFound);
+                    RegisterContentForTest(storage, expected[0]);
+                }
+                printf("Read content file cache: OK\n");
+            }
+
+            /* A fresh storage over the same directory must list the same ids, in the same order. */
+            {
+                ncm::ContentStorageImpl storage;
+                TEST_R_TRY(storage.Initialize(root_path, ncm::MakeFlatContentFilePath, ncm::MakeFlatPlaceHolderFilePath, false, nullptr));
+
+                ncm::ContentId expected[ContentIdTestCount];
+                size_t expected_count = 0;
+                for (size_t i = 0; i < ContentIdTestCount; ++i) {
+                    const auto content_id = MakeContentIdForTest(i);
+
+                    bool has = false;
+                    TEST_R_TRY(storage.Has(std::addressof(has), content_id));
+                    if (has) {
+                        expected[expected_count++] = content_id;
+                    }
+                }
+                AMS_ABORT_UNLESS(expected_count == ContentIdTestCount - 3);
+
+                std::sort(expected, expected + expected_count, IsContentIdLess);
+                CheckContentIdPaging(storage, expected, expected_count);
+                printf("List after reopen: OK\n");
+            }
+
+            TEST_R_TRY(fs::DeleteDirectoryRecursively(root_path));
+        }
+
+    }
+
+    void Main() {
+        fs::SetEnabledAutoAbort(false);
+
+        printf("Doing NCM test!\n");
+        DoFileHandleCacheTests();
+        DoContentStorageListTests();
+        printf("All tests completed!\n");
+    }
+
+}
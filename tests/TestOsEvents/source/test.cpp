@@ -15,6 +15,10 @@
  */
 #include <stratosphere.hpp>
 
+#if defined(ATMOSPHERE_OS_LINUX)
+#include <poll.h>
+#endif
+
 namespace ams {
 
     namespace {
@@ -422,6 +426,147 @@ namespace ams {
             os::SignalEvent(std::addressof(sync.reader_ready_event));
         }
 
+        /* Many handles in one multi wait, as a busy server would have; kept within the usual 1024 descriptor limit, since each event takes two. */
+        constexpr size_t ManyHandlesEventCount = 384;
+        constexpr size_t ManyHandlesRounds     = 0x1000;
+
+        constinit os::SystemEventType g_many_handles_events[ManyHandlesEventCount] = {};
+        constinit os::MultiWaitHolderType g_many_handles_holders[ManyHandlesEventCount] = {};
+
+        TimeSpan DoManyHandlesWaitBenchmark(size_t count) {
+            /* Link the first count events. */
+            os::MultiWaitType mw;
+            os::InitializeMultiWait(std::addressof(mw));
+            for (size_t i = 0; i < count; ++i) {
+                os::LinkMultiWaitHolder(std::addressof(mw), g_many_handles_holders + i);
+            }
+            ON_SCOPE_EXIT {
+                os::UnlinkAllMultiWaitHolder(std::addressof(mw));
+                os::FinalizeMultiWait(std::addressof(mw));
+            };
+
+            /* Signal and wait for events scattered across the multi wait. */
+            const auto start = os::GetSystemTick();
+            for (size_t round = 0; round < ManyHandlesRounds; ++round) {
+                const size_t i = (round * 97) % count;
+                os::SignalSystemEvent(g_many_handles_events + i);
+                AMS_ABORT_UNLESS(os::WaitAny(std::addressof(mw)) == g_many_handles_holders + i);
+                os::ClearSystemEvent(g_many_handles_events + i);
+            }
+            return (os::GetSystemTick() - start).ToTimeSpan();
+        }
+
+        #if defined(ATMOSPHERE_OS_LINUX)
+        TimeSpan DoManyHandlesPollBenchmark(size_t count) {
+            /* Wait as the poll-based multi wait did: rebuild the descriptor array for every wait, then scan it for the signaled index. */
+            const auto start = os::GetSystemTick();
+            for (size_t round = 0; round < ManyHandlesRounds; ++round) {
+                const size_t i = (round * 97) % count;
+                os::SignalSystemEvent(g_many_handles_events + i);
+
+                struct pollfd pfds[ManyHandlesEventCount];
+                for (size_t j = 0; j < count; ++j) {
+                    pfds[j] = { .fd = os::GetReadableHandleOfSystemEvent(g_many_handles_events + j), .events = POLLIN, .revents = 0 };
+                }
+                AMS_ABORT_UNLESS(::ppoll(pfds, count, nullptr, nullptr) > 0);
+
+                size_t signaled = count;
+                for (size_t j = 0; j < count; ++j) {
+                    if (pfds[j].revents & POLLIN) {
+                        signaled = j;
+                        break;
+                    }
+                }
+                AMS_ABORT_UNLESS(signaled == i);
+
+                os::ClearSystemEvent(g_many_handles_events + i);
+            }
+            return (os::GetSystemTick() - start).ToTimeSpan();
+        }
+        #endif
+
+        void DoManyHandlesTests() {
+            for (size_t i = 0; i < ManyHandlesEventCount; ++i) {
+                R_ABORT_UNLESS(os::CreateSystemEvent(g_many_handles_events + i, os::EventClearMode_ManualClear, true));
+                os::InitializeMultiWaitHolder(g_many_handles_holders + i, g_many_handles_events + i);
+            }
+            ON_SCOPE_EXIT {
+                for (size_t i = 0; i < ManyHandlesEventCount; ++i) {
+                    os::FinalizeMultiWaitHolder(g_many_handles_holders + i);
+                    os::DestroySystemEvent(g_many_handles_events + i);
+                }
+            };
+
+            /* Check that the lowest signaled index wins, and that it survives unlinking (and relinking) holders around it. */
+            {
+                os::MultiWaitType mw;
+                os::InitializeMultiWait(std::addressof(mw));
+                for (size_t i = 0; i < ManyHandlesEventCount; ++i) {
+                    os::LinkMultiWaitHolder(std::addressof(mw), g_many_handles_holders + i);
+                }
+
+                os::SignalSystemEvent(g_many_handles_events + 300);
+                os::SignalSystemEvent(g_many_handles_events + 200);
+                AMS_ABORT_UNLESS(os::TryWaitAny(std::addressof(mw)) == g_many_handles_holders + 200);
+
+                os::UnlinkMultiWaitHolder(g_many_handles_holders + 200);
+                os::UnlinkMultiWaitHolder(g_many_handles_holders + 100);
+                AMS_ABORT_UNLESS(os::TryWaitAny(std::addressof(mw)) == g_many_handles_holders + 300);
+
+                os::LinkMultiWaitHolder(std::addressof(mw), g_many_handles_holders + 200);
+                AMS_ABORT_UNLESS(os::TryWaitAny(std::addressof(mw)) == g_many_handles_holders + 300);
+                os::ClearSystemEvent(g_many_handles_events + 300);
+                AMS_ABORT_UNLESS(os::TryWaitAny(std::addressof(mw)) == g_many_handles_holders + 200);
+                os::ClearSystemEvent(g_many_handles_events + 200);
+                AMS_ABORT_UNLESS(os::TryWaitAny(std::addressof(mw)) == nullptr);
+
+                os::UnlinkAllMultiWaitHolder(std::addressof(mw));
+                os::FinalizeMultiWait(std::addressof(mw));
+            }
+
+            /* Check that the lowest signaled index wins even when more handles are signaled than are collected in one batch. */
+            {
+                /* NOTE: The linux implementation collects 16 ready handles per epoll_wait. */
+                constexpr size_t SignaledCount = 48;
+
+                os::MultiWaitType mw;
+                os::InitializeMultiWait(std::addressof(mw));
+                for (size_t i = 0; i < ManyHandlesEventCount; ++i) {
+                    os::LinkMultiWaitHolder(std::addressof(mw), g_many_handles_holders + i);
+                }
+
+                /* Signal from the top down, so that the lowest indices are the last to become ready. */
+                for (size_t i = 0; i < SignaledCount; ++i) {
+                    os::SignalSystemEvent(g_many_handles_events + (ManyHandlesEventCount - 1 - i * 7));
+                }
+
+                for (size_t i = SignaledCount; i > 0; --i) {
+                    const size_t expected = ManyHandlesEventCount - 1 - (i - 1) * 7;
+                    AMS_ABORT_UNLESS(os::TryWaitAny(std::addressof(mw)) == g_many_handles_holders + expected);
+                    AMS_ABORT_UNLESS(os::WaitAny(std::addressof(mw)) == g_many_handles_holders + expected);
+                    os::ClearSystemEvent(g_many_handles_events + expected);
+                }
+                AMS_ABORT_UNLESS(os::TryWaitAny(std::addressof(mw)) == nullptr);
+
+                os::UnlinkAllMultiWaitHolder(std::addressof(mw));
+                os::FinalizeMultiWait(std::addressof(mw));
+            }
+
+            /* Waiting should cost about the same however many handles are linked. */
+            const auto few_time  = DoManyHandlesWaitBenchmark(64);
+            const auto many_time = DoManyHandlesWaitBenchmark(ManyHandlesEventCount);
+
+            printf("Multi wait, %zu signal/wait rounds: OK (%" PRId64 " us with 64 handles, %" PRId64 " us with %zu handles)\n", ManyHandlesRounds, few_time.GetMicroSeconds(), many_time.GetMicroSeconds(), ManyHandlesEventCount);
+
+            #if defined(ATMOSPHERE_OS_LINUX)
+            /* Compare against rebuilding a poll array for every wait, which costs more the more handles there are. */
+            const auto few_poll_time  = DoManyHandlesPollBenchmark(64);
+            const auto many_poll_time = DoManyHandlesPollBenchmark(ManyHandlesEventCount);
+
+            printf("Poll, %zu signal/wait rounds: %" PRId64 " us with 64 handles, %" PRId64 " us with %zu handles\n", ManyHandlesRounds, few_poll_time.GetMicroSeconds(), many_poll_time.GetMicroSeconds(), ManyHandlesEventCount);
+            #endif
+        }
+
     }
 
 
@@ -470,6 +615,8 @@ namespace ams {
             os::WaitThread(std::addressof(reader_thread));
             os::WaitThread(std::addressof(writer_thread));
         }
+        DoManyHandlesTests();
+
         printf("All tests completed!\n");
     }
 
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+#include "../../../stratosphere/ro/source/impl/ro_nro_hash_index.hpp"
+
+namespace ams {
+
+    namespace {
+
+        using Sha256Hash = ro::impl::Sha256Hash;
+
+        /* ro indexes up to 0x400 hashes per process; benchmark a single NRR listing 1000 NROs. */
+        constexpr size_t NroHashIndexTestCapacity  = 0x400;
+        constexpr size_t NroHashIndexTestNumHashes = 1000;
+        constexpr size_t NroHashIndexTestLookups   = 0x1000;
+
+        using TestNroHashIndex = ro::impl::NroHashIndex<NroHashIndexTestCapacity>;
+
+        constinit TestNroHashIndex g_index;
+        constinit Sha256Hash g_hashes[NroHashIndexTestNumHashes] = {};
+        constinit Sha256Hash g_table_hash = {};
+
+        Sha256Hash MakeTestHash(size_t index) {
+            Sha256Hash hash;
+            crypto::GenerateSha256(std::addressof(hash), sizeof(hash), std::addressof(index), sizeof(index));
+            return hash;
+        }
+
+        /* Checks that exactly the hashes in [begin, end) of g_hashes are found in the table indexed at offset. */
+        void VerifyTable(size_t offset, size_t begin, size_t end) {
+            const size_t num_hashes = end - begin;
+            for (size_t i = 0; i < NroHashIndexTestNumHashes; ++i) {
+                AMS_ABORT_UNLESS(g_index.Contains(offset, num_hashes, g_hashes[i]) == (begin <= i && i < end));
+            }
+
+            /* Hashes that sort before, between, and after the table's hashes must miss. */
+            Sha256Hash hash = g_hashes[begin];
+            hash.hash[sizeof(hash.hash) - 1] ^= 1;
+            AMS_ABORT_UNLESS(!g_index.Contains(offset, num_hashes, hash));
+            std::memset(std::addressof(hash), 0x00, sizeof(hash));
+            AMS_ABORT_UNLESS(!g_index.Contains(offset, num_hashes, hash));
+            std::memset(std::addressof(hash), 0xFF, sizeof(hash));
+            AMS_ABORT_UNLESS(!g_index.Contains(offset, num_hashes, hash));
+        }
+
+        void DoNroHashIndexTests() {
+            /* Make a sorted hash table, as an NRR would contain. */
+            for (size_t i = 0; i < NroHashIndexTestNumHashes; ++i) {
+                g_hashes[i] = MakeTestHash(i);
+            }
+            std::sort(g_hashes, g_hashes + NroHashIndexTestNumHashes);
+            crypto::GenerateSha256(std::addressof(g_table_hash), sizeof(g_table_hash), g_hashes, sizeof(g_hashes));
+
+            /* Index three tables: a small one, the large one, and another small one, filling the index exactly. */
+            AMS_ABORT_UNLESS(g_index.Stage(g_hashes, 10) != nullptr);
+            const size_t first_offset = g_index.Commit(10);
+            AMS_ABORT_UNLESS(g_index.Stage(g_hashes + 10, NroHashIndexTestNumHashes - 10) != nullptr);
+            const size_t large_offset = g_index.Commit(NroHashIndexTestNumHashes - 10);
+            AMS_ABORT_UNLESS(g_index.Stage(g_hashes + 100, 24) != nullptr);
+            const size_t last_offset  = g_index.Commit(24);
+            AMS_ABORT_UNLESS(g_index.GetCount() == NroHashIndexTestCapacity);
+
+            /* Each table must find only its own hashes. */
+            VerifyTable(first_offset, 0, 10);
+            VerifyTable(large_offset, 10, NroHashIndexTestNumHashes);
+            VerifyTable(last_offset, 100, 124);
+            printf("NroHashIndex hit/miss: OK\n");
+
+            /* A full index must not stage anything more. */
+            AMS_ABORT_UNLESS(g_index.Stage(g_hashes, 1) == nullptr);
+            AMS_ABORT_UNLESS(g_index.GetCount() == NroHashIndexTestCapacity);
+
+            /* Removing the last table frees exactly its space. */
+            g_index.Remove(last_offset, 24);
+            AMS_ABORT_UNLESS(g_index.GetCount() == NroHashIndexTestCapacity - 24);
+            AMS_ABORT_UNLESS(g_index.Stage(g_hashes, 25) == nullptr);
+            AMS_ABORT_UNLESS(g_index.Stage(g_hashes, 24) != nullptr);
+
+            /* Empty or unsorted tables must not be staged; staging alone must not change the count. */
+            AMS_ABORT_UNLESS(g_index.Stage(g_hashes, 0) == nullptr);
+            {
+                Sha256Hash unsorted[2] = { g_hashes[1], g_hashes[0] };
+                AMS_ABORT_UNLESS(g_index.Stage(unsorted, 2) == nullptr);
+            }
+            AMS_ABORT_UNLESS(g_index.GetCount() == NroHashIndexTestCapacity - 24);
+            printf("NroHashIndex capacity: OK\n");
+
+            /* Remove the first table, and check that the large one is found where it moved to, and the first table's hashes are gone. */
+            g_index.Remove(first_offset, 10);
+            const size_t moved_offset = large_offset - 10;
+            VerifyTable(moved_offset, 10, NroHashIndexTestNumHashes);
+            g_index.Remove(moved_offset, NroHashIndexTestNumHashes - 10);
+            AMS_ABORT_UNLESS(g_index.GetCount() == 0);
+            printf("NroHashIndex removal: OK\n");
+
+            /* Index the whole table. */
+            AMS_ABORT_UNLESS(g_index.Stage(g_hashes, NroHashIndexTestNumHashes) != nullptr);
+            const size_t offset = g_index.Commit(NroHashIndexTestNumHashes);
+            VerifyTable(offset, 0, NroHashIndexTestNumHashes);
+
+            /* Time looking up hashes by re-validating the table (as unindexed NRRs do, by hashing it), and through the index. */
+            auto DoLookups = [](auto find) -> TimeSpan {
+                size_t found = 0;
+
+                const auto start = os::GetSystemTick();
+                for (size_t i = 0; i < NroHashIndexTestLookups; ++i) {
+                    found += find(g_hashes[(i * 7) % NroHashIndexTestNumHashes]);
+                }
+                const auto elapsed = (os::GetSystemTick() - start).ToTimeSpan();
+
+                AMS_ABORT_UNLESS(found == NroHashIndexTestLookups);
+                return elapsed;
+            };
+
+            const auto validate_time = DoLookups([](const Sha256Hash &hash) {
+                const Sha256Hash *lower_bound = std::lower_bound(g_hashes, g_hashes + NroHashIndexTestNumHashes, hash);
+                if (lower_bound == g_hashes + NroHashIndexTestNumHashes || *lower_bound != hash) {
+                    return false;
+                }
+
+                Sha256Hash table_hash;
+                crypto::GenerateSha256(std::addressof(table_hash), sizeof(table_hash), g_hashes, sizeof(g_hashes));
+                return table_hash == g_table_hash;
+            });
+            const auto indexed_time  = DoLookups([offset](const Sha256Hash &hash) { return g_index.Contains(offset, NroHashIndexTestNumHashes, hash); });
+
+            printf("NroHashIndex, %zu lookups in %zu hashes: %" PRId64 " us (validating), %" PRId64 " us (indexed)\n", NroHashIndexTestLookups, NroHashIndexTestNumHashes, validate_time.GetMicroSeconds(), indexed_time.GetMicroSeconds());
+        }
+
+    }
+
+    void Main() {
+        printf("Doing ro tests!\n");
+        DoNroHashIndexTests();
+
+        printf("All tests completed!\n");
+    }
+
+}
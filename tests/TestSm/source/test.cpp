@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+#include "../../../stratosphere/sm/source/impl/sm_info_index.hpp"
+
+namespace ams {
+
+    namespace {
+
+        /* sm keeps up to 0x180 services; test the index completely full, which is its worst case. */
+        constexpr size_t InfoIndexTestCount  = 0x180;
+        constexpr size_t InfoIndexTestRounds = 0x400;
+
+        struct TestInfo {
+            sm::ServiceName name;
+        };
+
+        constexpr u64 GetTestInfoKey(const TestInfo &info) {
+            return std::bit_cast<u64>(info.name);
+        }
+
+        using TestInfoIndex = sm::impl::InfoIndex<TestInfo, InfoIndexTestCount, GetTestInfoKey>;
+
+        constinit std::array<TestInfo, InfoIndexTestCount> g_infos = {};
+        constinit TestInfoIndex g_index;
+
+        sm::ServiceName MakeTestServiceName(size_t index) {
+            char name[sizeof(sm::ServiceName) + 1];
+            util::SNPrintf(name, sizeof(name), "svc:%04zx", index);
+            return sm::ServiceName::Encode(name);
+        }
+
+        TestInfo *FindLinear(u64 key) {
+            for (auto &info : g_infos) {
+                if (GetTestInfoKey(info) == key) {
+                    return std::addressof(info);
+                }
+            }
+            return nullptr;
+        }
+
+        void VerifyIndex(size_t begin, size_t end) {
+            /* Every entry in [begin, end) must be found at its own position; every other entry, and names which were never inserted, must not be. */
+            for (size_t i = 0; i < InfoIndexTestCount; ++i) {
+                const auto *expected = (begin <= i && i < end) ? std::addressof(g_infos[i]) : nullptr;
+                AMS_ABORT_UNLESS(g_index.Find(g_infos, GetTestInfoKey(g_infos[i])) == expected);
+            }
+            for (size_t i = InfoIndexTestCount; i < 2 * InfoIndexTestCount; ++i) {
+                AMS_ABORT_UNLESS(g_index.Find(g_infos, std::bit_cast<u64>(MakeTestServiceName(i))) == nullptr);
+            }
+        }
+
+        void DoInfoIndexTests() {
+            for (size_t i = 0; i < InfoIndexTestCount; ++i) {
+                g_infos[i].name = MakeTestServiceName(i);
+            }
+
+            /* An empty index finds nothing. */
+            VerifyIndex(0, 0);
+
+            /* Fill the index one entry at a time, up to its capacity; each lookup must hit exactly the inserted entries. */
+            for (size_t i = 0; i < InfoIndexTestCount; ++i) {
+                g_index.Insert(g_infos, std::addressof(g_infos[i]));
+                AMS_ABORT_UNLESS(g_index.Find(g_infos, GetTestInfoKey(g_infos[i])) == std::addressof(g_infos[i]));
+                if (i + 1 < InfoIndexTestCount) {
+                    AMS_ABORT_UNLESS(g_index.Find(g_infos, GetTestInfoKey(g_infos[i + 1])) == nullptr);
+                }
+            }
+            VerifyIndex(0, InfoIndexTestCount);
+            printf("InfoIndex hit/miss at capacity: OK\n");
+
+            /* Remove and re-insert entries in a scattered order, so that removal has to shift back probe runs. */
+            for (size_t round = 0; round < 8; ++round) {
+                for (size_t i = round; i < InfoIndexTestCount; i += 3) {
+                    g_index.Remove(g_infos, std::addressof(g_infos[i]));
+                    AMS_ABORT_UNLESS(g_index.Find(g_infos, GetTestInfoKey(g_infos[i])) == nullptr);
+                }
+                for (size_t i = 0; i < InfoIndexTestCount; ++i) {
+                    const bool removed = (i >= round) && ((i - round) % 3) == 0;
+                    AMS_ABORT_UNLESS(g_index.Find(g_infos, GetTestInfoKey(g_infos[i])) == (removed ? nullptr : std::addressof(g_infos[i])));
+                }
+                for (size_t i = round; i < InfoIndexTestCount; i += 3) {
+                    g_index.Insert(g_infos, std::addressof(g_infos[i]));
+                }
+                VerifyIndex(0, InfoIndexTestCount);
+            }
+            printf("InfoIndex scattered removal: OK\n");
+
+            /* Reuse a position for a new name, as sm does when a service is unregistered and another registered; only the new name may be found. */
+            {
+                const auto old_name = g_infos[5].name;
+                g_index.Remove(g_infos, std::addressof(g_infos[5]));
+                g_infos[5].name = MakeTestServiceName(2 * InfoIndexTestCount);
+                g_index.Insert(g_infos, std::addressof(g_infos[5]));
+
+                AMS_ABORT_UNLESS(g_index.Find(g_infos, std::bit_cast<u64>(old_name)) == nullptr);
+                AMS_ABORT_UNLESS(g_index.Find(g_infos, GetTestInfoKey(g_infos[5])) == std::addressof(g_infos[5]));
+
+                g_index.Remove(g_infos, std::addressof(g_infos[5]));
+                g_infos[5].name = old_name;
+                g_index.Insert(g_infos, std::addressof(g_infos[5]));
+                VerifyIndex(0, InfoIndexTestCount);
+            }
+            printf("InfoIndex reuse: OK\n");
+
+            /* Time looking up every service, as GetServiceHandle would, by scanning the list and through the index. */
+            auto DoLookups = [](auto find) -> TimeSpan {
+                size_t found = 0;
+
+                const auto start = os::GetSystemTick();
+                for (size_t round = 0; round < InfoIndexTestRounds; ++round) {
+                    for (size_t i = 0; i < InfoIndexTestCount; ++i) {
+                        found += find(GetTestInfoKey(g_infos[(i * 7 + round) % InfoIndexTestCount])) != nullptr;
+                    }
+                }
+                const auto elapsed = (os::GetSystemTick() - start).ToTimeSpan();
+
+                AMS_ABORT_UNLESS(found == InfoIndexTestRounds * InfoIndexTestCount);
+                return elapsed;
+            };
+
+            const auto linear_time  = DoLookups([](u64 key) { return FindLinear(key); });
+            const auto indexed_time = DoLookups([](u64 key) { return g_index.Find(g_infos, key); });
+
+            printf("InfoIndex, %zu lookups at %zu entries: %" PRId64 " us (linear), %" PRId64 " us (indexed)\n", InfoIndexTestRounds * InfoIndexTestCount, InfoIndexTestCount, linear_time.GetMicroSeconds(), indexed_time.GetMicroSeconds());
+
+            /* Empty the index from the middle outwards; the remaining entries must be found after every removal. */
+            for (size_t i = 0; i < InfoIndexTestCount / 2; ++i) {
+                const size_t lo = InfoIndexTestCount / 2 - 1 - i;
+                const size_t hi = InfoIndexTestCount / 2 + i;
+                g_index.Remove(g_infos, std::addressof(g_infos[lo]));
+                g_index.Remove(g_infos, std::addressof(g_infos[hi]));
+                if ((i % 0x20) == 0 || i + 1 == InfoIndexTestCount / 2) {
+                    for (size_t j = 0; j < InfoIndexTestCount; ++j) {
+                        const bool present = j < lo || j > hi;
+                        AMS_ABORT_UNLESS(g_index.Find(g_infos, GetTestInfoKey(g_infos[j])) == (present ? std::addressof(g_infos[j]) : nullptr));
+                    }
+                }
+            }
+            VerifyIndex(0, 0);
+            printf("InfoIndex removal to empty: OK\n");
+        }
+
+        constexpr size_t ProcessIndexTestCount = 0x40;
+
+        struct TestProcessInfo {
+            u64 process_id;
+        };
+
+        constexpr u64 GetTestProcessInfoKey(const TestProcessInfo &info) {
+            return info.process_id;
+        }
+
+        using TestProcessInfoIndex = sm::impl::InfoIndex<TestProcessInfo, ProcessIndexTestCount, GetTestProcessInfoKey>;
+
+        constinit std::array<TestProcessInfo, ProcessIndexTestCount> g_process_infos = {};
+        constinit TestProcessInfoIndex g_process_index;
+
+        void DoProcessInfoIndexTests() {
+            /* Process ids are small and sequential, unlike service names, so check that such keys index correctly too. */
+            /* Fill the index with sequential process ids, in a list order that doesn't match them. */
+            for (size_t i = 0; i < ProcessIndexTestCount; ++i) {
+                g_process_infos[i].process_id = 0x50 + ((i * 5) % ProcessIndexTestCount);
+                g_process_index.Insert(g_process_infos, std::addressof(g_process_infos[i]));
+            }
+
+            for (size_t i = 0; i < ProcessIndexTestCount; ++i) {
+                AMS_ABORT_UNLESS(g_process_index.Find(g_process_infos, g_process_infos[i].process_id) == std::addressof(g_process_infos[i]));
+            }
+            for (u64 process_id = 0; process_id < 0x50; ++process_id) {
+                AMS_ABORT_UNLESS(g_process_index.Find(g_process_infos, process_id) == nullptr);
+            }
+            for (u64 process_id = 0x50 + ProcessIndexTestCount; process_id < 0x200; ++process_id) {
+                AMS_ABORT_UNLESS(g_process_index.Find(g_process_infos, process_id) == nullptr);
+            }
+
+            /* Processes exit and new ones are created with fresh ids, reusing list positions. */
+            for (size_t i = 0; i < ProcessIndexTestCount; i += 2) {
+                const u64 old_process_id = g_process_infos[i].process_id;
+                g_process_index.Remove(g_process_infos, std::addressof(g_process_infos[i]));
+                AMS_ABORT_UNLESS(g_process_index.Find(g_process_infos, old_process_id) == nullptr);
+
+                g_process_infos[i].process_id = old_process_id + ProcessIndexTestCount;
+                g_process_index.Insert(g_process_infos, std::addressof(g_process_infos[i]));
+            }
+            for (size_t i = 0; i < ProcessIndexTestCount; ++i) {
+                AMS_ABORT_UNLESS(g_process_index.Find(g_process_infos, g_process_infos[i].process_id) == std::addressof(g_process_infos[i]));
+            }
+
+            printf("InfoIndex process ids: OK\n");
+        }
+
+    }
+
+    void Main() {
+        printf("Doing sm tests!\n");
+        DoInfoIndexTests();
+        DoProcessInfoIndexTests();
+
+        printf("All tests completed!\n");
+    }
+
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) Atmosphère-NX
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+
+namespace ams {
+
+    namespace {
+
+        constexpr size_t ObjectManagerTestMaxObjects = 256;
+        constexpr size_t ObjectManagerTestRounds     = 0x4000;
+
+        constinit os::SystemEventType g_events[ObjectManagerTestMaxObjects] = {};
+        constinit tipc::NativeHandle g_handles[ObjectManagerTestMaxObjects] = {};
+
+        constinit tipc::ObjectManager<64>  g_object_manager_64;
+        constinit tipc::ObjectManager<256> g_object_manager_256;
+
+        tipc::ServiceObjectBase *GetTestObject(size_t index) {
+            /* The objects are unmanaged and never invoked, so a distinct fake pointer per index identifies which entry a lookup found. */
+            return reinterpret_cast<tipc::ServiceObjectBase *>(0x10000 + index * 0x10);
+        }
+
+        void AddTestObject(tipc::ObjectManagerBase &manager, size_t index) {
+            tipc::ObjectHolder object;
+            object.InitializeAsSession(g_handles[index], false, GetTestObject(index));
+            manager.AddObject(object);
+        }
+
+        void VerifyTestObject(tipc::ObjectManagerBase &manager, size_t index, bool present) {
+            tipc::ObjectHolder object;
+            AMS_ABORT_UNLESS(manager.GetObjectForTest(std::addressof(object), g_handles[index]) == present);
+            if (present) {
+                AMS_ABORT_UNLESS(object.GetHandle() == g_handles[index]);
+                AMS_ABORT_UNLESS(object.GetType() == tipc::ObjectHolder::ObjectType_Session);
+                AMS_ABORT_UNLESS(object.GetObject() == GetTestObject(index));
+            }
+        }
+
+        template<size_t MaxObjects>
+        void DoObjectManagerTest(tipc::ObjectManager<MaxObjects> &manager) {
+            static_assert(MaxObjects <= ObjectManagerTestMaxObjects);
+
+            os::MultiWaitType multi_wait;
+            os::InitializeMultiWait(std::addressof(multi_wait));
+            ON_SCOPE_EXIT { os::FinalizeMultiWait(std::addressof(multi_wait)); };
+
+            manager.Initialize(std::addressof(multi_wait));
+
+            /* An empty manager finds nothing. */
+            for (size_t i = 0; i < ObjectManagerTestMaxObjects; ++i) {
+                VerifyTestObject(manager, i, false);
+            }
+
+            /* Fill the manager to capacity; adding aborts if no free entry can be found. */
+            for (size_t i = 0; i < MaxObjects; ++i) {
+                AddTestObject(manager, i);
+                VerifyTestObject(manager, i, true);
+            }
+            for (size_t i = 0; i < ObjectManagerTestMaxObjects; ++i) {
+                VerifyTestObject(manager, i, i < MaxObjects);
+            }
+            printf("ObjectManager<%zu> hit/miss at capacity: OK\n", MaxObjects);
+
+            /* Close every third object, and check that exactly those are gone; then re-add them into the freed entries. */
+            for (size_t i = 0; i < MaxObjects; i += 3) {
+                manager.CloseObject(g_handles[i]);
+                VerifyTestObject(manager, i, false);
+            }
+            for (size_t i = 0; i < MaxObjects; ++i) {
+                VerifyTestObject(manager, i, (i % 3) != 0);
+            }
+            for (size_t i = 0; i < MaxObjects; i += 3) {
+                AddTestObject(manager, i);
+            }
+            for (size_t i = 0; i < ObjectManagerTestMaxObjects; ++i) {
+                VerifyTestObject(manager, i, i < MaxObjects);
+            }
+            printf("ObjectManager<%zu> removal: OK\n", MaxObjects);
+
+            /* Close and re-add objects in a scattered order at full occupancy; closing aborts if the handle can't be found. */
+            const auto start = os::GetSystemTick();
+            for (size_t round = 0; round < ObjectManagerTestRounds; ++round) {
+                const size_t index = (round * 37 + (round >> 4)) % MaxObjects;
+                manager.CloseObject(g_handles[index]);
+                AddTestObject(manager, index);
+            }
+            const auto elapsed = (os::GetSystemTick() - start).ToTimeSpan();
+
+            for (size_t i = 0; i < ObjectManagerTestMaxObjects; ++i) {
+                VerifyTestObject(manager, i, i < MaxObjects);
+            }
+
+            /* Close everything, checking that the remaining objects are still found after each close. */
+            for (size_t i = 0; i < MaxObjects; ++i) {
+                manager.CloseObject(g_handles[i]);
+                if ((i % 16) == 0) {
+                    for (size_t j = 0; j < MaxObjects; ++j) {
+                        VerifyTestObject(manager, j, j > i);
+                    }
+                }
+            }
+            for (size_t i = 0; i < ObjectManagerTestMaxObjects; ++i) {
+                VerifyTestObject(manager, i, false);
+            }
+
+            printf("ObjectManager<%zu>, %zu close/add pairs: OK (%" PRId64 " ns per pair)\n", MaxObjects, ObjectManagerTestRounds, elapsed.GetNanoSeconds() / static_cast<s64>(ObjectManagerTestRounds));
+        }
+
+        void DoObjectManagerTests() {
+            /* The multi wait registers each handle with the kernel, so the objects need real handles. */
+            for (size_t i = 0; i < ObjectManagerTestMaxObjects; ++i) {
+                R_ABORT_UNLESS(os::CreateSystemEvent(std::addressof(g_events[i]), os::EventClearMode_ManualClear, true));
+                g_handles[i] = os::GetReadableHandleOfSystemEvent(std::addressof(g_events[i]));
+            }
+
+            DoObjectManagerTest(g_object_manager_64);
+            DoObjectManagerTest(g_object_manager_256);
+
+            for (size_t i = 0; i < ObjectManagerTestMaxObjects; ++i) {
+                os::DestroySystemEvent(std::addressof(g_events[i]));
+            }
+        }
+
+    }
+
+    void Main() {
+        printf("Doing tipc tests!\n");
+        DoObjectManagerTests();
+
+        printf("All tests completed!\n");
+    }
+
+}
@@ -0,0 +1,99 @@
+#
+# Copyright (c) Atmosphère-NX
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms and conditions of the GNU General Public License,
+# version 2, as published by the Free Software Foundation.
+#
+# This program is distributed in the hope it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+# more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# fs_access_log_decoder.py: Renders binary fs access log batches (fs::SetLocalAccessLogBinaryMode) as text access log lines.
+
+import sys
+from struct import unpack_from as up
+
+BATCH_MAGIC   = b'FSBL'
+BATCH_VERSION = 1
+
+HEADER_FORMAT = '<4sHHIIq'
+HEADER_SIZE   = 0x18
+RECORD_FORMAT = '<qqQqQIBBBB'
+RECORD_SIZE   = 0x30
+NAME_FORMAT   = '<H62s'
+NAME_SIZE     = 0x40
+
+RECORD_FLAG_HAS_OFFSET = (1 << 0)
+RECORD_FLAG_HAS_SIZE   = (1 << 1)
+
+INVALID_NAME_ID = 0xFF
+
+def ticks_to_ms(ticks, frequency):
+    return (ticks * 1000) // frequency
+
+def render_record(record, names, frequency):
+    start, end, handle, offset, size, result, function_id, priority_id, flags, _ = record
+
+    function = names.get(function_id, 'Unknown') if function_id != INVALID_NAME_ID else 'Unknown'
+    priority = names.get(priority_id, 'Unknown') if priority_id != INVALID_NAME_ID else 'Unknown'
+
+    extra = ''
+    if flags & RECORD_FLAG_HAS_OFFSET:
+        extra += ', offset: %d' % offset
+    if flags & RECORD_FLAG_HAS_SIZE:
+        extra += ', size: %d' % size
+
+    return 'FS_ACCESS { start: %9d, end: %9d, result: 0x%08X, handle: 0x%016X, priority: %s, function: "%s"%s }' % (ticks_to_ms(start, frequency), ticks_to_ms(end, frequency), result, handle, priority, function, extra)
+
+def decode(data, out):
+    names = {}
+    ofs = 0
+    while ofs < len(data):
+        if data[ofs:ofs + 4] == BATCH_MAGIC and ofs + HEADER_SIZE <= len(data):
+            # Parse the batch header.
+            magic, version, name_count, record_count, dropped_count, frequency = up(HEADER_FORMAT, data, ofs)
+            if version != BATCH_VERSION:
+                raise ValueError('Unsupported batch version %d at offset 0x%X' % (version, ofs))
+
+            records_ofs = ofs + HEADER_SIZE
+            names_ofs   = records_ofs + record_count * RECORD_SIZE
+            end_ofs     = names_ofs + name_count * NAME_SIZE
+            if end_ofs > len(data):
+                raise ValueError('Truncated batch at offset 0x%X' % ofs)
+
+            # Names follow the records, but may be used by them.
+            for i in range(name_count):
+                name_id, name = up(NAME_FORMAT, data, names_ofs + i * NAME_SIZE)
+                names[name_id] = name.split(b'\0', 1)[0].decode('utf-8', 'replace')
+
+            for i in range(record_count):
+                out.write(render_record(up(RECORD_FORMAT, data, records_ofs + i * RECORD_SIZE), names, frequency) + '\n')
+
+            if dropped_count != 0:
+                out.write('FS_ACCESS: { dropped_record_count: %d }\n' % dropped_count)
+
+            ofs = end_ofs
+        else:
+            # Pass text lines (e.g. the start log) through unchanged.
+            nl = data.find(b'\n', ofs)
+            if nl < 0:
+                nl = len(data) - 1
+            out.write(data[ofs:nl + 1].decode('utf-8', 'replace'))
+            ofs = nl + 1
+
+def main(argc, argv):
+    if argc != 2:
+        print('Usage: %s access_log_file' % argv[0])
+        return 1
+    with open(argv[1], 'rb') as f:
+        data = f.read()
+    decode(data, sys.stdout)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main(len(sys.argv), sys.argv))